@@ -8,18 +8,14 @@
  * 
  * @param game Puntatore alla struttura Game da inizializzare
  * 
- * @note La griglia viene riempita con PLAYER_NONE (spazi vuoti)
+ * @note La griglia parte vuota (nessuna cella occupata), nella variante
+ *       del Tris classico: le altre si impostano poi con board_init()
  * @note Il giocatore iniziale è sempre PLAYER_X
  * @note Lo stato iniziale è GAME_STATE_WAITING
  */
 void game_init(Game *game) {
     memset(game, 0, sizeof(Game));
-    
-    for (int i = 0; i < BOARD_SIZE; i++) {
-        for (int j = 0; j < BOARD_SIZE; j++) {
-            game->board[i][j] = PLAYER_NONE;
-        }
-    }
+    board_init(&game->board, BOARD_SIDE, BOARD_SIDE, BOARD_SIDE);
     
     game->current_player = PLAYER_X;
     game->state = GAME_STATE_WAITING;
@@ -34,14 +30,11 @@ void game_init(Game *game) {
  * @param game Puntatore alla struttura Game da reinizializzare
  * 
  * @note Resetta solo il board, non tocca stato, giocatori o altre impostazioni
+ * @note Mantiene la variante del tabellone (righe, colonne e allineamento)
  * @note Utile per i rematch dove si mantiene la configurazione esistente
  */
 void game_init_board(Game *game) {
-    for (int i = 0; i < BOARD_SIZE; i++) {
-        for (int j = 0; j < BOARD_SIZE; j++) {
-            game->board[i][j] = PLAYER_NONE;
-        }
-    }
+    board_clear(&game->board);
 }
 
 /**
@@ -49,8 +42,8 @@ void game_init_board(Game *game) {
  * Piazza il simbolo del giocatore corrente, controlla la vittoria e cambia turno.
  * 
  * @param game Puntatore alla struttura Game
- * @param row Riga della mossa (0-2)
- * @param col Colonna della mossa (0-2)
+ * @param row Riga della mossa (da 0)
+ * @param col Colonna della mossa (da 0)
  * @return 1 se la mossa è stata eseguita con successo, 0 se non valida
  * 
  * @note Valida automaticamente la mossa prima di eseguirla
@@ -58,12 +51,10 @@ void game_init_board(Game *game) {
  * @note Cambia automaticamente il turno se il gioco continua
  */
 int game_make_move(Game *game, int row, int col) {
-    if (!game_is_valid_move(game, row, col)) {
+    if (!board_place(&game->board, row, col, (char)game->current_player)) {
         return 0;
     }
     
-    game->board[row][col] = (char)game->current_player;
-    
     game_check_winner(game);
     
     if (game->state == GAME_STATE_PLAYING) {
@@ -78,64 +69,31 @@ int game_make_move(Game *game, int row, int col) {
  * Controlla che le coordinate siano nel range e che la cella sia vuota.
  * 
  * @param game Puntatore alla struttura Game (sola lettura)
- * @param row Riga da verificare (0-2)
- * @param col Colonna da verificare (0-2)
+ * @param row Riga da verificare (da 0)
+ * @param col Colonna da verificare (da 0)
  * @return 1 se la mossa è valida, 0 altrimenti
  * 
  * @note Non modifica lo stato del gioco, solo validazione
- * @note Controlla i bounds della griglia 3x3
+ * @note Controlla i bounds della griglia righe x colonne
  */
 int game_is_valid_move(const Game *game, int row, int col) {
-    if (row < 0 || row >= BOARD_SIZE || col < 0 || col >= BOARD_SIZE) {
-        return 0;
-    }
-    
-    return (game->board[row][col] == PLAYER_NONE);
+    return board_is_free(&game->board, row, col);
 }
 
 /**
  * Controlla se c'è un vincitore o un pareggio e aggiorna lo stato del gioco.
- * Verifica tutte le combinazioni possibili: righe, colonne e diagonali.
+ * Il vincitore è calcolato da board_place() a ogni mossa, controllando solo
+ * le linee che passano per la cella occupata (vedi board.h).
  * 
  * @param game Puntatore alla struttura Game da controllare
  * 
- * @note Controlla prima le righe, poi le colonne, infine le diagonali
  * @note Se non c'è vincitore ma il tabellone è pieno, dichiara pareggio
  * @note Aggiorna automaticamente lo stato del gioco a GAME_STATE_OVER se finita
  */
 void game_check_winner(Game *game) {
-    for (int i = 0; i < BOARD_SIZE; i++) {
-        if (game->board[i][0] != PLAYER_NONE &&
-            game->board[i][0] == game->board[i][1] && 
-            game->board[i][1] == game->board[i][2]) {
-            game->winner = (PlayerSymbol)game->board[i][0];
-            game->state = GAME_STATE_OVER;
-            return;
-        }
-    }
-    
-    for (int j = 0; j < BOARD_SIZE; j++) {
-        if (game->board[0][j] != PLAYER_NONE &&
-            game->board[0][j] == game->board[1][j] && 
-            game->board[1][j] == game->board[2][j]) {
-            game->winner = (PlayerSymbol)game->board[0][j];
-            game->state = GAME_STATE_OVER;
-            return;
-        }
-    }
-    
-    if (game->board[0][0] != PLAYER_NONE &&
-        game->board[0][0] == game->board[1][1] && 
-        game->board[1][1] == game->board[2][2]) {
-        game->winner = (PlayerSymbol)game->board[0][0];
-        game->state = GAME_STATE_OVER;
-        return;
-    }
-    
-    if (game->board[0][2] != PLAYER_NONE &&
-        game->board[0][2] == game->board[1][1] && 
-        game->board[1][1] == game->board[2][0]) {
-        game->winner = (PlayerSymbol)game->board[0][2];
+    char winner = board_winner(&game->board);
+    if (winner != PLAYER_NONE) {
+        game->winner = (PlayerSymbol)winner;
         game->state = GAME_STATE_OVER;
         return;
     }
@@ -152,18 +110,20 @@ void game_check_winner(Game *game) {
  * 
  * @param game Puntatore alla struttura Game da resettare
  * 
- * @note Chiama game_init() per azzerare tutto
+ * @note Chiama game_init() per azzerare tutto, mantenendo la variante del tabellone
  * @note Imposta lo stato direttamente a GAME_STATE_PLAYING (partita attiva)
  * @note Utilizzata per iniziare una nuova partita o un rematch
  */
 void game_reset(Game *game) {
+    Board variant = game->board;
     game_init(game);
+    board_init(&game->board, variant.rows, variant.cols, variant.k);
     game->state = GAME_STATE_PLAYING;
 }
 
 /**
  * Stampa il tabellone di gioco in formato ASCII art nella console.
- * Visualizza una griglia 3x3 con separatori grafici tra le celle.
+ * Visualizza una griglia righe x colonne con separatori grafici tra le celle.
  * 
  * @param game Puntatore alla struttura Game da visualizzare (sola lettura)
  * 
@@ -178,17 +138,17 @@ void game_reset(Game *game) {
  */
 void game_print_board(const Game *game) {
     printf("\n");
-    for (int i = 0; i < BOARD_SIZE; i++) {
-        for (int j = 0; j < BOARD_SIZE; j++) {
-            printf(" %c ", game->board[i][j]);
-            if (j < BOARD_SIZE - 1) printf("|");
+    for (int i = 0; i < game->board.rows; i++) {
+        for (int j = 0; j < game->board.cols; j++) {
+            printf(" %c ", board_get(&game->board, i, j));
+            if (j < game->board.cols - 1) printf("|");
         }
         printf("\n");
         
-        if (i < BOARD_SIZE - 1) {
-            for (int j = 0; j < BOARD_SIZE; j++) {
+        if (i < game->board.rows - 1) {
+            for (int j = 0; j < game->board.cols; j++) {
                 printf("---");
-                if (j < BOARD_SIZE - 1) printf("+");
+                if (j < game->board.cols - 1) printf("+");
             }
             printf("\n");
         }
@@ -204,101 +164,62 @@ void game_print_board(const Game *game) {
  * @return 1 se il tabellone è pieno (nessuna cella vuota), 0 altrimenti
  * 
  * @note Utilizzata per determinare condizioni di pareggio
- * @note Scorre tutte le 9 celle del tabellone 3x3
- * @note Ritorna 0 appena trova la prima cella vuota (ottimizzazione)
+ * @note Un solo confronto tra le mosse giocate e il numero di celle
  */
 int game_is_board_full(const Game *game) {
-    for (int i = 0; i < BOARD_SIZE; i++) {
-        for (int j = 0; j < BOARD_SIZE; j++) {
-            if (game->board[i][j] == PLAYER_NONE) {
-                return 0;
-            }
-        }
-    }
-   
-    return 1;
+    return board_is_full(&game->board);
 }
 
 /**
- * Elabora un messaggio ricevuto dalla rete e aggiorna lo stato del gioco.
- * Gestisce diversi tipi di messaggi: mosse, reset, rematch e fine partita.
+ * Applica al gioco un messaggio del server già decodificato.
+ * Gestisce le mosse, il reset e la fine della partita.
  * 
  * @param game Puntatore alla struttura Game da aggiornare
- * @param message Messaggio ricevuto dal server da elaborare
+ * @param msg Messaggio ricevuto dal server (vedi message_decode())
  * @return 1 se il messaggio è stato elaborato con successo, 0 altrimenti
  * 
  * @note Tipi di messaggi supportati:
- *       - "MOVE:row,col:symbol" - Mossa dell'avversario
- *       - "GAME_RESET" o "RESET" - Reset della partita
- *       - "REMATCH" - Richiesta di rematch
- *       - "GAME_OVER:WINNER:X/O" - Fine partita con vincitore
- *       - "GAME_OVER:DRAW" - Fine partita con pareggio
+ *       - SMSG_MOVE ("MOVE:row,col:symbol") - Mossa di uno dei giocatori
+ *       - SMSG_GAME_RESET - Reset della partita
+ *       - SMSG_GAME_OVER ("GAME_OVER:WINNER:X/O" o "GAME_OVER:DRAW") - Fine partita
  * @note Stampa messaggi di debug per tracciare l'elaborazione
  * @note Aggiorna automaticamente il turno dopo le mosse valide
  */
-int game_process_network_message(Game *game, const char *message) {
-    if (!game || !message) return 0;
-
-    printf("Processando messaggio: %s\n", message);
+int game_process_network_message(Game *game, const Message *msg) {
+    if (!game || !msg) return 0;
 
-    if (strncmp(message, "MOVE:", 5) == 0) {
-        
-        int row, col;
-        char symbol;
-        if (sscanf(message + 5, "%d,%d:%c", &row, &col, &symbol) == 3) {
-            printf("Mossa estratta: riga=%d, col=%d, simbolo=%c\n", row, col, symbol);
+    switch (msg->type) {
+        case SMSG_MOVE:
+            printf("Mossa estratta: riga=%d, col=%d, simbolo=%c\n", msg->row, msg->col, msg->symbol);
+            if (!board_place(&game->board, msg->row, msg->col, msg->symbol)) {
+                printf("Mossa non applicabile: row=%d, col=%d, simbolo=%c\n", msg->row, msg->col, msg->symbol);
+                return 0;
+            }
+            printf("Board aggiornato alla posizione [%d][%d] = %c\n", msg->row, msg->col, msg->symbol);
             
-            if (row >= 0 && row < BOARD_SIZE && col >= 0 && col < BOARD_SIZE) {
-                
-                game->board[row][col] = symbol;
-                printf("Board aggiornato alla posizione [%d][%d] = %c\n", row, col, symbol);
-                
-                
-                game_check_winner(game);
-                
-                
-                if (game->state == GAME_STATE_PLAYING) {
-                    game->current_player = (game->current_player == PLAYER_X) ? PLAYER_O : PLAYER_X;
-                    printf("Turno cambiato. Ora tocca a: %c\n", game->current_player);
-                }
-                
-                return 1;
-            } else {
-                printf("Coordinate non valide: row=%d, col=%d\n", row, col);
+            game_check_winner(game);
+            
+            if (game->state == GAME_STATE_PLAYING) {
+                game->current_player = (game->current_player == PLAYER_X) ? PLAYER_O : PLAYER_X;
+                printf("Turno cambiato. Ora tocca a: %c\n", game->current_player);
             }
-        } else {
-            printf("Formato messaggio MOVE non valido: %s\n", message);
-        }
-    }
-    else if (strcmp(message, "GAME_RESET") == 0 || strcmp(message, "RESET") == 0) {
-        printf("Reset del gioco ricevuto\n");
-        game_reset(game);
-        return 1;
-    }
-    else if (strcmp(message, "REMATCH") == 0) {
-        printf("Richiesta rematch ricevuta\n");
-        game->state = GAME_STATE_REMATCH;
-        return 1;
-    }
-    else if (strncmp(message, "GAME_OVER:", 10) == 0) {
-        printf("Messaggio fine gioco ricevuto: %s\n", message);
-        
-        if (strstr(message, "WINNER:")) {
-            char winner;
-            if (sscanf(message, "GAME_OVER:WINNER:%c", &winner) == 1) {
-                printf("Vincitore identificato: %c\n", winner);
-                game->winner = (PlayerSymbol)winner;
-                game->state = GAME_STATE_OVER;
-                return 1;
+            return 1;
+        case SMSG_GAME_RESET:
+            printf("Reset del gioco ricevuto\n");
+            game_reset(game);
+            return 1;
+        case SMSG_GAME_OVER:
+            if (msg->symbol == MESSAGE_DRAW) {
+                printf("Pareggio identificato\n");
+                game->is_draw = 1;
+            } else {
+                printf("Vincitore identificato: %c\n", msg->symbol);
+                game->winner = (PlayerSymbol)msg->symbol;
             }
-        } else if (strstr(message, "DRAW")) {
-            printf("Pareggio identificato\n");
-            game->is_draw = 1;
             game->state = GAME_STATE_OVER;
             return 1;
-        }
+        default:
+            printf("Messaggio non riconosciuto: %.*s\n", (int)msg->text_len, msg->text);
+            return 0;
     }
-    
-    printf("Messaggio non riconosciuto: %s\n", message);
-    return 0;
 }
\ No newline at end of file
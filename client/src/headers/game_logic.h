@@ -13,9 +13,12 @@
  * Supporta modalità multiplayer con comunicazione di rete.
  */
 
+#include "messages.h"
+#include "board.h"
+
 // ========== COSTANTI ==========
 
-#define BOARD_SIZE 3                    // Dimensione del tabellone (3x3)
+#define BOARD_SIZE BOARD_SIDE           // Dimensione del tabellone del Tris classico (3x3)
 
 // ========== ENUMERAZIONI ==========
 
@@ -45,7 +48,7 @@ typedef enum {
  * Contiene il tabellone, i giocatori e tutte le informazioni necessarie.
  */
 typedef struct {
-    char board[BOARD_SIZE][BOARD_SIZE];  // Tabellone di gioco 3x3
+    Board board;                         // Tabellone m,n,k (bitboard, 3x3 nel Tris classico)
     PlayerSymbol current_player;         // Giocatore che deve fare la mossa
     GameState state;                     // Stato attuale del gioco
     PlayerSymbol winner;                 // Vincitore della partita (se presente)
@@ -69,6 +72,6 @@ int game_is_board_full(const Game *game);
 
 // ========== FUNZIONI DI COMUNICAZIONE ==========
 
-int game_process_network_message(Game *game, const char *message);
+int game_process_network_message(Game *game, const Message *msg);
 
 #endif 
\ No newline at end of file
@@ -0,0 +1,83 @@
+#ifndef LOBBY_LIST_H
+#define LOBBY_LIST_H
+
+/*
+ * HEADER LOBBY_LIST - COPIA LOCALE DELLA LISTA PARTITE
+ *
+ * Questo header definisce la copia locale di una pagina della lista partite
+ * del server (filtro per stato, offset e numero di voci).
+ *
+ * Il client riceve la pagina ("GAMES:<seq>:<offset>:<totale>:<voci>") solo
+ * quando la richiede con LIST_GAMES; mentre è nella lobby il server invia
+ * poi solo gli aggiornamenti ("LIST_UPDATE:<seq>:ADD|UPDATE|REMOVE:..."),
+ * che vengono applicati alle voci della pagina. Un salto nella sequenza
+ * (aggiornamenti persi) o una partita che entra nel filtro rende la copia
+ * non sincronizzata: alla prossima visualizzazione il client richiede di
+ * nuovo la pagina.
+ */
+
+#include <stddef.h>
+#include "messages.h"
+
+// ========== COSTANTI ==========
+
+#define LOBBY_PAGE_SIZE 8               // Partite richieste per pagina
+#define LOBBY_NAME_LEN 50               // Lunghezza massima di un nome giocatore
+#define LOBBY_FILTER_ALL -1             // Filtro: partite in qualsiasi stato
+
+// ========== ENUMERAZIONI ==========
+
+/**
+ * Stato di una partita come riportato nella lista del server.
+ */
+typedef enum {
+    LOBBY_GAME_WAITING,     // In attesa di un avversario (si può chiedere di unirsi)
+    LOBBY_GAME_PENDING,     // Richiesta di join in attesa di approvazione
+    LOBBY_GAME_PLAYING,     // Partita in corso
+    LOBBY_GAME_REMATCH      // Rivincita in corso
+} LobbyGameState;
+
+// ========== STRUTTURE DATI ==========
+
+/**
+ * Voce della lista partite.
+ */
+typedef struct {
+    int game_id;                        // ID della partita
+    LobbyGameState state;               // Stato della partita
+    char variant[16];                   // Variante "<righe>x<colonne>x<k>" (vuota per il Tris classico)
+    char player1[LOBBY_NAME_LEN];       // Creatore della partita
+    char player2[LOBBY_NAME_LEN];       // Avversario o richiedente (vuoto se in attesa)
+} LobbyGame;
+
+/**
+ * Copia locale di una pagina della lista partite.
+ */
+typedef struct {
+    LobbyGame games[LOBBY_PAGE_SIZE];   // Partite della pagina, nell'ordine del server
+    int count;                          // Partite presenti
+    int filter;                         // Stato mostrato (LobbyGameState o LOBBY_FILTER_ALL)
+    int offset;                         // Posizione della prima voce nella lista filtrata
+    int total;                          // Partite che soddisfano il filtro sul server
+    unsigned long seq;                  // Sequenza dell'ultimo aggiornamento applicato
+    int synced;                         // 1 se la copia segue gli aggiornamenti del server
+} LobbyList;
+
+// ========== FUNZIONI DI GESTIONE ==========
+
+void lobby_list_init(LobbyList *list);
+void lobby_list_set_view(LobbyList *list, int filter, int offset);
+void lobby_list_invalidate(LobbyList *list);
+int lobby_list_is_synced(const LobbyList *list);
+int lobby_list_format_request(const LobbyList *list, char *buffer, size_t size);
+
+// ========== FUNZIONI DI AGGIORNAMENTO ==========
+
+int lobby_list_handle_message(LobbyList *list, const Message *msg);
+
+// ========== FUNZIONI DI UTILITÀ ==========
+
+const char* lobby_list_state_name(LobbyGameState state);
+const char* lobby_list_filter_name(int filter);
+
+#endif
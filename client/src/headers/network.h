@@ -10,6 +10,15 @@
  * Supporta sia connessioni TCP che UDP, con gestione keep-alive
  * e threading per ricezione asincrona dei messaggi.
  *
+ * Dopo la registrazione il client apre il canale UDP affidabile del
+ * server (UDP_SESSION / UDP_REGISTER); ogni datagramma inviato inizia con
+ * il token di sessione, così il canale sopravvive a un cambio di indirizzo
+ * (NAT, cambio di rete). Le mosse partono su UDP con numero
+ * di sequenza e vengono ritrasmesse fino all'ACK, mentre MOVE e GAME_OVER
+ * arrivano su UDP e vengono confermati. network_wait_message() e
+ * network_receive_message() servono entrambi i canali; senza canale UDP
+ * tutto passa da TCP.
+ *
  * Compatibile con Windows e Linux.
  */
 
@@ -17,6 +26,7 @@
 #define TIMEOUT_SEC 5
 #endif
 #include <pthread.h>
+#include "messages.h"
 
 // ========== CONFIGURAZIONE CROSS-PLATFORM ==========
 
@@ -53,6 +63,13 @@
 #define MAX_MSG_SIZE 1024              // Dimensione massima messaggio
 #define TIMEOUT_SEC 5                  // Timeout per operazioni di rete
 #define KEEP_ALIVE_INTERVAL 30         // Intervallo keep-alive in secondi
+#define RX_BUFFER_SIZE 4096            // Buffer circolare di ricezione TCP (potenza di 2)
+#define MSG_DELIMITER '\n'             // Terminatore di ogni messaggio TCP
+#define UDP_EVENT_SIZE 128             // Dimensione massima di un messaggio del canale UDP affidabile
+#define UDP_RTO_MS 200                 // Attesa dell'ACK prima della prima ritrasmissione
+#define UDP_MAX_RETRIES 5              // Ritrasmissioni prima di ripiegare su TCP
+#define UDP_REGISTER_ATTEMPTS 3        // Tentativi di UDP_REGISTER
+#define UDP_REGISTER_WAIT_MS 300       // Attesa di UDP_REGISTERED per tentativo
 
 // ========== STRUTTURE DATI ==========
 
@@ -71,6 +88,21 @@ typedef struct {
     pthread_t keep_alive_thread;    // Thread keep-alive (Linux)
 #endif
     int keep_alive_active;          // Flag per controllo keep-alive
+    char rx_buf[RX_BUFFER_SIZE];    // Buffer circolare dei dati TCP ricevuti
+    size_t rx_head;                 // Inizio del prossimo messaggio (contatore monotono)
+    size_t rx_tail;                 // Fine dei dati ricevuti (contatore monotono)
+    size_t rx_scan;                 // Posizione fino a cui è stato cercato il terminatore
+    unsigned long long udp_token;   // Token di sessione ricevuto con UDP_SESSION (0 = nessuno)
+    int udp_active;                 // Canale UDP affidabile aperto (UDP_REGISTERED ricevuto)
+    unsigned long udp_send_seq;     // Ultima sequenza inviata sul canale UDP
+    unsigned long udp_recv_seq;     // Ultima sequenza ricevuta in ordine dal server
+    char udp_pending[UDP_EVENT_SIZE]; // Comando in attesa di ACK ("SEQ:<n>:<comando>"), vuoto se nessuno
+    size_t udp_pending_text;        // Inizio del comando incapsulato (per il ripiego su TCP)
+    long long udp_pending_sent;     // Ultimo invio del comando in attesa (millisecondi)
+    int udp_pending_retries;        // Ritrasmissioni già eseguite
+    char udp_event[UDP_EVENT_SIZE]; // Evento ricevuto su UDP non ancora consegnato
+    int udp_event_len;              // Lunghezza di udp_event (0 = nessuno)
+    int udp_in_game;                // GAME_START ricevuto: udp_event si consegna solo durante una partita
 } NetworkConnection;
 
 // ========== FUNZIONI DI GESTIONE KEEP-ALIVE ==========
@@ -89,9 +121,9 @@ void network_disconnect(NetworkConnection *conn);
 // ========== FUNZIONI DI COMUNICAZIONE GIOCO ==========
 
 int network_register_name(NetworkConnection *conn, const char *name);
-int network_create_game(NetworkConnection *conn);
+int network_create_game(NetworkConnection *conn, int rows, int cols, int k);
 int network_join_game(NetworkConnection *conn, int game_id);
-int network_send_move(NetworkConnection *conn, int move);
+int network_send_move(NetworkConnection *conn, int row, int col);
 int network_request_rematch(NetworkConnection *conn);
 int network_approve_join(NetworkConnection *conn, int approve);
 
@@ -99,7 +131,9 @@ int network_approve_join(NetworkConnection *conn, int approve);
 
 int network_send(NetworkConnection *conn, const char *message, int use_udp);
 int network_receive(NetworkConnection *conn, char *buffer, size_t buf_size, int use_udp);
+int network_receive_message(NetworkConnection *conn, char *buffer, size_t buf_size, Message *msg);
 int network_flush_receive_buffer(NetworkConnection *conn);
+int network_wait_message(NetworkConnection *conn, int timeout_ms);
 
 const char *network_get_error();
 
@@ -14,6 +14,9 @@
  * L'interfaccia è completamente testuale e user-friendly.
  */
 
+#include "lobby_list.h"
+#include "board.h"
+
 // ========== CONFIGURAZIONE CROSS-PLATFORM INPUT ==========
 
 #ifndef _WIN32
@@ -42,16 +45,20 @@ void ui_show_waiting_screen();
 
 // ========== FUNZIONI DI VISUALIZZAZIONE GIOCO ==========
 
-void ui_show_board(const char board[3][3]);
+void ui_show_board(const Board *board);
 
 int ui_get_player_move();
 
+int ui_get_player_cell(const Board *board, int *row, int *col);
+
 // ========== FUNZIONI DI MESSAGGISTICA ==========
 
 void ui_show_message(const char *message);
 
 void ui_show_error(const char *error);
 
+void ui_show_game_list(const LobbyList *list);
+
 // ========== FUNZIONI DI UTILITÀ SCHERMO ==========
 
 void ui_clear_screen();
@@ -60,6 +67,8 @@ void ui_clear_screen();
 
 int ui_get_player_name(char *name, int max_length);
 
+int ui_get_game_variant(int *rows, int *cols, int *k);
+
 void ui_show_waiting_screen(void);
 
 #endif
\ No newline at end of file
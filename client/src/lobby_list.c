@@ -0,0 +1,271 @@
+#include "headers/lobby_list.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * Nomi degli stati come appaiono nei messaggi del server.
+ */
+static const char *state_names[] = { "WAITING", "PENDING", "PLAYING", "REMATCH" };
+
+/**
+ * Inizializza una lista vuota, non ancora sincronizzata con il server.
+ * La vista iniziale è la prima pagina delle partite in attesa.
+ *
+ * @param list Lista da inizializzare
+ */
+void lobby_list_init(LobbyList *list) {
+    memset(list, 0, sizeof(LobbyList));
+    list->filter = LOBBY_GAME_WAITING;
+}
+
+/**
+ * Cambia la pagina mostrata. Se filtro o offset cambiano la copia locale
+ * non è più valida e va richiesta di nuovo.
+ *
+ * @param list Lista da aggiornare
+ * @param filter Stato da mostrare (LobbyGameState o LOBBY_FILTER_ALL)
+ * @param offset Posizione della prima voce (negativo = 0)
+ */
+void lobby_list_set_view(LobbyList *list, int filter, int offset) {
+    if (offset < 0) offset = 0;
+    if (list->filter == filter && list->offset == offset) return;
+    list->filter = filter;
+    list->offset = offset;
+    list->synced = 0;
+}
+
+/**
+ * Segna la lista come non sincronizzata: gli aggiornamenti successivi
+ * vengono ignorati finché non arriva una nuova pagina.
+ * Da chiamare quando il client smette di ricevere gli aggiornamenti
+ * (es. entrando in una partita).
+ *
+ * @param list Lista da invalidare
+ */
+void lobby_list_invalidate(LobbyList *list) {
+    list->synced = 0;
+}
+
+/**
+ * Verifica se la lista locale segue gli aggiornamenti del server.
+ *
+ * @param list Lista da controllare
+ * @return 1 se sincronizzata, 0 se serve richiedere di nuovo la pagina
+ */
+int lobby_list_is_synced(const LobbyList *list) {
+    return list->synced;
+}
+
+/**
+ * Scrive la richiesta LIST_GAMES per la pagina corrente:
+ * "LIST_GAMES:<filtro>:<offset>:<limite>".
+ *
+ * @param list Lista di cui richiedere la pagina
+ * @param buffer Buffer di destinazione
+ * @param size Dimensione del buffer
+ * @return 1 in caso di successo, 0 se il buffer è troppo piccolo
+ */
+int lobby_list_format_request(const LobbyList *list, char *buffer, size_t size) {
+    const char *filter = list->filter == LOBBY_FILTER_ALL ? "ALL" : state_names[list->filter];
+    return command_encode_list_games(buffer, size, "%s:%d:%d", filter, list->offset, LOBBY_PAGE_SIZE) > 0;
+}
+
+/**
+ * Restituisce il nome di un filtro da mostrare all'utente.
+ *
+ * @param filter Stato mostrato (LobbyGameState o LOBBY_FILTER_ALL)
+ * @return Nome del filtro
+ */
+const char* lobby_list_filter_name(int filter) {
+    return filter == LOBBY_FILTER_ALL ? "Tutte" : lobby_list_state_name((LobbyGameState)filter);
+}
+
+/**
+ * Restituisce il nome di uno stato da mostrare all'utente.
+ *
+ * @param state Stato della partita
+ * @return Nome dello stato
+ */
+const char* lobby_list_state_name(LobbyGameState state) {
+    switch (state) {
+        case LOBBY_GAME_WAITING: return "In attesa";
+        case LOBBY_GAME_PENDING: return "Richiesta in corso";
+        case LOBBY_GAME_PLAYING: return "In corso";
+        case LOBBY_GAME_REMATCH: return "Rivincita";
+    }
+    return "?";
+}
+
+/**
+ * Copia la parola successiva (fino a spazio o fine stringa).
+ *
+ * @param p Posizione corrente nel testo
+ * @param out Buffer di destinazione
+ * @param size Dimensione del buffer
+ * @return Posizione dopo la parola, NULL se non c'è nessuna parola
+ */
+static const char* next_word(const char *p, char *out, size_t size) {
+    while (*p == ' ') p++;
+    size_t len = strcspn(p, " ");
+    if (len == 0 || len >= size) return NULL;
+    memcpy(out, p, len);
+    out[len] = '\0';
+    return p + len;
+}
+
+/**
+ * Legge una voce "<id> <stato>[/<variante>] <nome> [<nome>]". Le partite in
+ * attesa hanno solo il creatore, le altre anche il secondo giocatore.
+ *
+ * @param p Inizio della voce
+ * @param game Voce da riempire
+ * @return Posizione dopo la voce, NULL se la voce non è valida
+ */
+static const char* parse_entry(const char *p, LobbyGame *game) {
+    char word[LOBBY_NAME_LEN];
+
+    p = next_word(p, word, sizeof(word));
+    if (!p) return NULL;
+    game->game_id = atoi(word);
+    if (game->game_id <= 0) return NULL;
+
+    p = next_word(p, word, sizeof(word));
+    if (!p) return NULL;
+    char *slash = strchr(word, '/');
+    game->variant[0] = '\0';
+    if (slash) {
+        *slash++ = '\0';
+        if (strlen(slash) >= sizeof(game->variant)) return NULL;
+        strcpy(game->variant, slash);
+    }
+    int state = -1;
+    for (int i = 0; i < (int)(sizeof(state_names) / sizeof(state_names[0])); i++) {
+        if (strcmp(word, state_names[i]) == 0) state = i;
+    }
+    if (state < 0) return NULL;
+    game->state = (LobbyGameState)state;
+
+    p = next_word(p, game->player1, sizeof(game->player1));
+    if (!p) return NULL;
+
+    game->player2[0] = '\0';
+    if (game->state != LOBBY_GAME_WAITING) {
+        p = next_word(p, game->player2, sizeof(game->player2));
+    }
+    return p;
+}
+
+/**
+ * Cerca una partita nella lista.
+ *
+ * @return Indice della partita, -1 se assente
+ */
+static int find_game(const LobbyList *list, int game_id) {
+    for (int i = 0; i < list->count; i++) {
+        if (list->games[i].game_id == game_id) return i;
+    }
+    return -1;
+}
+
+/**
+ * Verifica se una partita nello stato indicato rientra nel filtro della lista.
+ */
+static int matches_filter(const LobbyList *list, LobbyGameState state) {
+    return list->filter == LOBBY_FILTER_ALL || list->filter == (int)state;
+}
+
+/**
+ * Rimuove una voce della pagina mantenendo l'ordine delle altre.
+ */
+static void remove_at(LobbyList *list, int index) {
+    memmove(&list->games[index], &list->games[index + 1],
+            (size_t)(list->count - index - 1) * sizeof(LobbyGame));
+    list->count--;
+    if (list->total > 0) list->total--;
+}
+
+/**
+ * Sostituisce la pagina con quella inviata dal server.
+ * Le risposte a una pagina diversa da quella mostrata vengono ignorate.
+ */
+static void apply_page(LobbyList *list, unsigned long seq, const char *rest) {
+    LobbyGame game;
+    int offset, total, consumed;
+
+    if (sscanf(rest, "%d:%d:%n", &offset, &total, &consumed) != 2) return;
+    if (offset != list->offset) return;
+
+    const char *entries = rest + consumed;
+    list->count = 0;
+    while (*entries && list->count < LOBBY_PAGE_SIZE) {
+        entries = parse_entry(entries, &game);
+        if (!entries) break;
+        list->games[list->count++] = game;
+    }
+    list->total = total;
+    list->seq = seq;
+    list->synced = 1;
+}
+
+/**
+ * Applica un aggiornamento incrementale alla pagina. Gli aggiornamenti già
+ * inclusi vengono ignorati; se ne manca qualcuno la lista diventa non
+ * sincronizzata. Le voci della pagina vengono aggiornate o rimosse sul posto;
+ * una partita che entra nel filtro e non è nella pagina rende necessaria una
+ * nuova richiesta, perché il client non sa in che posizione la elenca il server.
+ */
+static void apply_delta(LobbyList *list, unsigned long seq, const char *op) {
+    if (!list->synced || seq <= list->seq) return;
+
+    if (seq != list->seq + 1) {
+        // Aggiornamenti persi: serve una nuova richiesta
+        list->synced = 0;
+        return;
+    }
+    list->seq = seq;
+
+    if (strncmp(op, "REMOVE:", 7) == 0) {
+        int index = find_game(list, atoi(op + 7));
+        if (index >= 0) remove_at(list, index);
+        return;
+    }
+
+    int is_add = strncmp(op, "ADD:", 4) == 0;
+    if (!is_add && strncmp(op, "UPDATE:", 7) != 0) return;
+
+    LobbyGame game;
+    if (!parse_entry(strchr(op, ':') + 1, &game)) return;
+
+    int index = find_game(list, game.game_id);
+    if (index >= 0) {
+        if (matches_filter(list, game.state)) list->games[index] = game;
+        else remove_at(list, index);
+    } else if (matches_filter(list, game.state) && (is_add || list->filter != LOBBY_FILTER_ALL)) {
+        list->synced = 0;
+    }
+}
+
+/**
+ * Applica alla lista un messaggio del server, se riguarda la lista partite.
+ *
+ * @param list Lista da aggiornare
+ * @param msg Messaggio ricevuto dal server (vedi message_decode())
+ * @return 1 se il messaggio era GAMES: o LIST_UPDATE: (anche se ignorato), 0 altrimenti
+ *
+ * @note Un messaggio LIST_UPDATE: con un salto di sequenza, o che porta nel
+ *       filtro una partita fuori dalla pagina, rende la lista non
+ *       sincronizzata (vedi lobby_list_is_synced())
+ */
+int lobby_list_handle_message(LobbyList *list, const Message *msg) {
+    switch (msg->type) {
+        case SMSG_GAMES:
+            apply_page(list, msg->seq, msg->text);
+            return 1;
+        case SMSG_LIST_UPDATE:
+            apply_delta(list, msg->seq, msg->text);
+            return 1;
+        default:
+            return 0;
+    }
+}
@@ -48,10 +48,16 @@
 #include "headers/game_logic.h"
 #include "headers/ui.h"
 #include "headers/network.h"
+#include "headers/lobby_list.h"
 
 #define MAX_NAME_LEN 50
+#define LIST_TIMEOUT 10         // Secondi di attesa massima per la lista partite completa
 
 static volatile int keep_running = 1;
+static LobbyList lobby_list;    // Copia locale della lista partite del server
+static int variant_rows = BOARD_SIDE;   // Variante della partita corrente: righe,
+static int variant_cols = BOARD_SIDE;   // colonne e simboli da allineare
+static int variant_k = BOARD_SIDE;      // (scelta alla creazione o da GAME_VARIANT)
 
 /**
  * Pulisce il buffer di input standard rimuovendo tutti i caratteri fino al newline.
@@ -66,6 +72,74 @@ void clear_stdin_buffer() {
     while ((c = getchar()) != '\n' && c != EOF);
 }
 
+/**
+ * Mostra il livello del bot riportato nella nota di GAME_START, presente
+ * solo nelle partite contro il bot del server.
+ * 
+ * @param msg GAME_START decodificato
+ */
+static void show_bot_level(const Message *msg) {
+    if (msg->text_len > 0) {
+        printf("Avversario: bot del server (livello %.*s)\n", (int)msg->text_len, msg->text);
+    }
+}
+
+/**
+ * Legge il livello del bot che segue B e invia PLAY_BOT. Senza scelta il
+ * server usa il livello predefinito della sua configurazione.
+ * 
+ * @param conn Connessione di rete attiva con il server
+ * 
+ * @note Su Unix il terminale è in modalità canonica: il livello va scritto
+ *       sulla stessa riga di B ("B2" e Invio) e il resto della riga è scartato
+ */
+static void request_bot_game(NetworkConnection *conn) {
+    static const char *levels[] = { "random", "heuristic", "perfect" };
+    char msg[64];
+    int key;
+    
+    printf("Livello del bot: 1 random, 2 heuristic, 3 perfect (Invio per il predefinito)\n");
+    key = getch();
+#ifndef _WIN32
+    if (key != '\n' && key != EOF) clear_stdin_buffer();
+#endif
+    if (key >= '1' && key <= '3') {
+        printf("Richiesta partita contro il bot (livello %s)\n", levels[key - '1']);
+        if (command_encode_play_bot(msg, sizeof(msg), "%s", levels[key - '1'])) network_send(conn, msg, 0);
+        return;
+    }
+    printf("Richiesta partita contro il bot\n");
+    network_send(conn, command_verb(CMD_PLAY_BOT), 0);
+}
+
+/**
+ * Riceve il GAME_START che segue REMATCH_ACCEPTED e restituisce il simbolo
+ * del giocatore per la nuova partita (i simboli si alternano a ogni rivincita).
+ * Il GAME_VARIANT che lo precede nelle varianti non classiche viene saltato:
+ * la rivincita mantiene il tabellone della partita.
+ * 
+ * @param conn Connessione di rete attiva con il server
+ * @param current Simbolo attuale, mantenuto se GAME_START non arriva
+ * @return Simbolo assegnato per la nuova partita
+ */
+static PlayerSymbol receive_rematch_symbol(NetworkConnection *conn, PlayerSymbol current) {
+    char message[MAX_MSG_SIZE];
+    Message msg;
+    int bytes;
+    
+    do {
+        bytes = network_receive_message(conn, message, sizeof(message), &msg);
+    } while (bytes > 0 && msg.type == SMSG_GAME_VARIANT);
+    
+    if (bytes > 0 && msg.type == SMSG_GAME_START) {
+        printf("Nuovo GAME_START ricevuto: %s\n", message);
+        printf("Nuovo simbolo assegnato: %c\n", msg.symbol);
+        show_bot_level(&msg);
+        return (PlayerSymbol)msg.symbol;
+    }
+    return current;
+}
+
 /**
  * Gestisce la fine della partita e le richieste di rematch.
  * Coordina il flusso di comunicazione tra client e server per gestire
@@ -82,7 +156,7 @@ void clear_stdin_buffer() {
 int handle_game_end(NetworkConnection *conn, Game *game, PlayerSymbol *player_symbol) {
     
     if (keep_running && game->state == GAME_STATE_OVER) {
-        ui_show_board(game->board);
+        ui_show_board(&game->board);
         
         if (game->winner != PLAYER_NONE) {
             if (game->winner == *player_symbol) {
@@ -113,49 +187,23 @@ int handle_game_end(NetworkConnection *conn, Game *game, PlayerSymbol *player_sy
                 printf("Richiesta inviata. In attesa dell'avversario...\n");
                 
                 
-                int rematch_handled = 0;
                 int rematch_requested_by_me = 1; 
                 time_t start_time = time(NULL);
                 
-                characters, indicating that it is a multi-line comment.
-                The actual code logic is not present in this snippet. */
-                while (!rematch_handled && difftime(time(NULL), start_time) < 30) {
+                while (difftime(time(NULL), start_time) < 30) {
                     char message[MAX_MSG_SIZE];
-                    int bytes = network_receive(conn, message, sizeof(message), 0);
+                    Message msg;
+                    int bytes = network_receive_message(conn, message, sizeof(message), &msg);
                     
-                    if (bytes > 0) {
-                        if (strstr(message, "REMATCH_ACCEPTED:")) {
+                    if (bytes <= 0) {
+                        sleep(1); 
+                        continue;
+                    }
+                    
+                    switch (msg.type) {
+                        case SMSG_REMATCH_ACCEPTED:
                             printf("Altra partita accettata! Nuova partita inizia...\n");
-                            
-                            
-                            char *game_start_pos = strstr(message, "GAME_START:");
-                            if (game_start_pos) {
-                                printf("GAME_START trovato nel messaggio combinato: %s\n", message);
-                                char new_symbol;
-                                if (sscanf(game_start_pos, "GAME_START:%c", &new_symbol) == 1) {
-                                    
-                                    *player_symbol = (PlayerSymbol)new_symbol;
-                                    printf("Nuovo simbolo assegnato: %c\n", *player_symbol);
-                                    printf("Premi INVIO 2 volte per continuare...\n");
-                                    
-                                    getchar();
-
-                                }
-                            } else {
-                                
-                                char start_msg[MAX_MSG_SIZE];
-                                int start_bytes = network_receive(conn, start_msg, sizeof(start_msg), 0);
-                                if (start_bytes > 0 && strstr(start_msg, "GAME_START:")) {
-                                    printf("Nuovo GAME_START ricevuto: %s\n", start_msg);
-                                    char new_symbol;
-                                    if (sscanf(start_msg, "GAME_START:%c", &new_symbol) == 1) {
-                                        
-                                        *player_symbol = (PlayerSymbol)new_symbol;
-                                        printf("Nuovo simbolo assegnato: %c\n", *player_symbol);
-                                    }
-                                }
-                            }
-                            
+                            *player_symbol = receive_rematch_symbol(conn, *player_symbol);
                             
                             game_init_board(game);
                             game->state = GAME_STATE_PLAYING;
@@ -179,11 +227,10 @@ int handle_game_end(NetworkConnection *conn, Game *game, PlayerSymbol *player_sy
                                 return 0; 
                             }
                             
-                            ui_show_board(game->board);
-                            rematch_handled = 1;
+                            ui_show_board(&game->board);
                             return 1; 
-                        } 
-                        else if (strstr(message, "REMATCH_REQUEST:")) {
+                        
+                        case SMSG_REMATCH_REQUEST:
                             if (!rematch_requested_by_me) {
                                 
                                 printf("L'avversario ha richiesto un'altra partita.\n");
@@ -197,78 +244,61 @@ int handle_game_end(NetworkConnection *conn, Game *game, PlayerSymbol *player_sy
                                     
                                     
                                     clear_stdin_buffer();
-                                    
-                                    
                                 } else {
                                     printf("Altra partita rifiutata.\n");
-                                    rematch_handled = 1;
                                     return 0; 
                                 }
                             } else {
                                 
                                 printf("In attesa che l'avversario risponda...\n");
                             }
-                        }
-                        else if (strstr(message, "REMATCH_SENT:")) {
+                            break;
+                        
+                        case SMSG_REMATCH_SENT:
                             printf("In attesa che l'avversario risponda alla richiesta...\n");
-                        }
-                        else if (strstr(message, "NEW_GAME_REQUEST")) {
-                            
-                            printf("L'avversario vuole iniziare un'altra partita.\n");
-                            printf("Tornando al menu principale...\n");
-                            rematch_handled = 1;
-                            return 0; 
-                        }
-                        else if (strstr(message, "REMATCH_CANCELLED:")) {
-                            printf("La richiesta è stata cancellata: %s\n", message + 17);
+                            break;
+                        
+                        case SMSG_REMATCH_CANCELLED:
+                            printf("La richiesta è stata cancellata: %s\n", msg.text);
                             printf("Tornando al menu principale...\n");
-                            rematch_handled = 1;
                             return 0; 
-                        }
-                        else if (strstr(message, "REMATCH_DECLINED:")) {
+                        
+                        case SMSG_REMATCH_DECLINED:
                             printf("L'avversario ha rifiutato l'altra partita.\n");
                             printf("Premi INVIO per tornare al menu principale...\n");
                             
                             getchar();
-                            rematch_handled = 1;
                             return 0; 
-                        }
-                        else if (strstr(message, "REMATCH_DECLINE_CONFIRMED:")) {
-                            printf("%s\n", message + 26); 
+                        
+                        case SMSG_REMATCH_DECLINE_CONFIRMED:
+                            printf("%s\n", msg.text); 
                             printf("Premi INVIO per tornare al menu principale...\n");
                             
                             getchar();
-                            rematch_handled = 1;
                             return 0; 
-                        }
-                        else if (strstr(message, "OPPONENT_LEFT:")) {
-                            printf("L'avversario ha abbandonato la partita: %s\n", message + 14);
+                        
+                        case SMSG_OPPONENT_LEFT:
+                            printf("L'avversario ha abbandonato la partita: %s\n", msg.text);
                             printf("Tornando al menu principale...\n");
-                            rematch_handled = 1;
                             return 0; 
-                        }
-                        else if (strstr(message, "ERROR:")) {
-                            printf("Errore: %s\n", message);
-                            rematch_handled = 1;
+                        
+                        case SMSG_ERROR:
+                            printf("Errore: %s\n", msg.text);
                             return 0; 
-                        }
-                        else if (strstr(message, "SERVER_SHUTDOWN:")) {
-                            printf("Server in spegnimento: %s\n", message + 16);
+                        
+                        case SMSG_SERVER_SHUTDOWN:
+                            printf("Server in spegnimento: %s\n", msg.text);
                             printf("Connessione interrotta.\n");
                             keep_running = 0; 
-                            rematch_handled = 1;
                             return 0;
-                        }
-                    }
-                    else {
-                        sleep(1); 
+                        
+                        default:
+                            break;
                     }
                 }
                 
-                if (!rematch_handled) {
-                    printf("Timeout - l'avversario non ha risposto.\n");
-                    return 0; 
-                }
+                printf("Timeout - l'avversario non ha risposto.\n");
+                return 0; 
             } else {
                 ui_show_error("Errore nell'invio richiesta");
                 return 0; 
@@ -276,14 +306,15 @@ int handle_game_end(NetworkConnection *conn, Game *game, PlayerSymbol *player_sy
         } else if (response == 'n' || response == 'N') {
             
             printf("Rifiutando altra partita...\n");
-            network_send(conn, "REMATCH_DECLINE", 0); 
+            network_send(conn, command_verb(CMD_REMATCH_DECLINE), 0); 
             
             
             char confirm_msg[MAX_MSG_SIZE];
-            int confirm_bytes = network_receive(conn, confirm_msg, sizeof(confirm_msg), 0);
+            Message confirm;
+            int confirm_bytes = network_receive_message(conn, confirm_msg, sizeof(confirm_msg), &confirm);
             if (confirm_bytes > 0) {
-                if (strstr(confirm_msg, "REMATCH_DECLINE_CONFIRMED:")) {
-                    printf("%s\n", confirm_msg + 26); 
+                if (confirm.type == SMSG_REMATCH_DECLINE_CONFIRMED) {
+                    printf("%s\n", confirm.text); 
                 } else {
                     printf("Conferma server: %s\n", confirm_msg);
                 }
@@ -334,6 +365,104 @@ void get_board_position(int move, int* row, int* col) {
     *col = (move - 1) % 3;
 }
 
+/**
+ * Legge i messaggi già arrivati dal server senza attendere.
+ * Gli aggiornamenti della lista partite vengono applicati alla copia locale,
+ * gli altri messaggi (residui di partite precedenti) vengono scartati.
+ * 
+ * @param conn Connessione di rete attiva con il server
+ * @return Numero di messaggi scartati, -1 in caso di errore di connessione
+ */
+static int drain_pending_messages(NetworkConnection* conn) {
+    char message[MAX_MSG_SIZE];
+    Message msg;
+    int discarded = 0;
+    
+    while (network_wait_message(conn, 0) > 0) {
+        if (network_receive_message(conn, message, sizeof(message), &msg) <= 0) {
+            return -1;
+        }
+        if (!lobby_list_handle_message(&lobby_list, &msg)) {
+            discarded++;
+        }
+    }
+    return discarded;
+}
+
+/**
+ * Porta la pagina locale della lista partite allo stato del server.
+ * Se la pagina segue già gli aggiornamenti non serve alcuna richiesta;
+ * altrimenti (prima visualizzazione, cambio di pagina o filtro, ritorno da
+ * una partita, aggiornamenti persi) la richiede con LIST_GAMES.
+ * 
+ * @param conn Connessione di rete attiva con il server
+ * @return 1 se la lista è sincronizzata, 0 in caso di errore
+ * 
+ * @note Gli aggiornamenti arrivati prima della pagina vengono ignorati
+ */
+static int sync_lobby_list(NetworkConnection* conn) {
+    char message[MAX_MSG_SIZE];
+    Message msg;
+    char request[64];
+    
+    if (drain_pending_messages(conn) < 0) {
+        ui_show_error(network_get_error());
+        return 0;
+    }
+    if (lobby_list_is_synced(&lobby_list)) {
+        return 1;
+    }
+    
+    printf("Richiesta lista partite...\n");
+    lobby_list_format_request(&lobby_list, request, sizeof(request));
+    if (!network_send(conn, request, 0)) {
+        ui_show_error("Errore nell'invio richiesta lista partite");
+        return 0;
+    }
+    
+    time_t start_time = time(NULL);
+    while (!lobby_list_is_synced(&lobby_list)) {
+        if (difftime(time(NULL), start_time) > LIST_TIMEOUT) {
+            ui_show_error("Timeout nella ricezione della lista partite");
+            return 0;
+        }
+        
+        int select_result = network_wait_message(conn, 1000);
+        if (select_result == 0) continue;
+        if (select_result < 0 || network_receive_message(conn, message, sizeof(message), &msg) <= 0) {
+            ui_show_error(network_get_error());
+            return 0;
+        }
+        
+        if (msg.type == SMSG_ERROR) {
+            ui_show_error(msg.text);
+            return 0;
+        }
+        // I messaggi estranei alla lista (residui di partite precedenti) vengono ignorati
+        lobby_list_handle_message(&lobby_list, &msg);
+    }
+    return 1;
+}
+
+/**
+ * Riceve la prossima risposta del server a un comando. Gli aggiornamenti
+ * della lista partite arrivati nel frattempo vengono applicati alla copia
+ * locale invece di essere scambiati per la risposta.
+ * 
+ * @param conn Connessione di rete attiva con il server
+ * @param message Buffer per il testo del messaggio
+ * @param size Dimensione del buffer
+ * @param msg Messaggio decodificato, valido solo se il risultato è > 0
+ * @return Come network_receive_message()
+ */
+static int receive_reply(NetworkConnection* conn, char *message, size_t size, Message *msg) {
+    int bytes;
+    do {
+        bytes = network_receive_message(conn, message, size, msg);
+    } while (bytes > 0 && lobby_list_handle_message(&lobby_list, msg));
+    return bytes;
+}
+
 /**
  * Gestisce la creazione di una nuova partita e l'attesa di un avversario.
  * Invia la richiesta al server, attende la conferma e poi si mette in attesa
@@ -349,20 +478,28 @@ void get_board_position(int move, int* row, int* col) {
 PlayerSymbol handle_create_game(NetworkConnection* conn) {
     PlayerSymbol assigned_symbol = PLAYER_NONE;
     char message[MAX_MSG_SIZE];
+    Message msg;
     int bytes;
     int game_started = 0;
     time_t start_time = time(NULL);
 
     
-    int flushed = network_flush_receive_buffer(conn);
-    if (flushed > 0) {
-        printf("[DEBUG] Buffer pulito: %d bytes di messaggi precedenti rimossi\n", flushed);
+    // La variante si chiede prima di pulire il buffer: durante la scelta possono arrivare aggiornamenti della lista
+    if (!ui_get_game_variant(&variant_rows, &variant_cols, &variant_k)) {
+        return PLAYER_NONE;
+    }
+    
+    int discarded = drain_pending_messages(conn);
+    if (discarded > 0) {
+        printf("[DEBUG] Buffer pulito: %d messaggi precedenti scartati\n", discarded);
     }
 
-    if (!network_create_game(conn)) {
+    if (!network_create_game(conn, variant_rows, variant_cols, variant_k)) {
         ui_show_error(network_get_error());
         return PLAYER_NONE;
     }
+    // Durante la partita il server non invia aggiornamenti della lista
+    lobby_list_invalidate(&lobby_list);
 
     printf("[DEBUG] Richiesta creazione partita inviata...\n");
     fflush(stdout);
@@ -370,7 +507,7 @@ PlayerSymbol handle_create_game(NetworkConnection* conn) {
     
     printf("[DEBUG] Attendo risposta GAME_CREATED...\n");
     fflush(stdout);
-    bytes = network_receive(conn, message, sizeof(message), 0);
+    bytes = receive_reply(conn, message, sizeof(message), &msg);
     if (bytes <= 0) {
         printf("[DEBUG] ERRORE: bytes ricevuti=%d\n", bytes);
         ui_show_error("Nessuna risposta dal server");
@@ -380,30 +517,30 @@ PlayerSymbol handle_create_game(NetworkConnection* conn) {
     printf("[DEBUG] Risposta server: %s\n", message);
     fflush(stdout);
     
-    if (!strstr(message, "GAME_CREATED:")) {
-        printf("[DEBUG] ERRORE: Messaggio non contiene GAME_CREATED: %s\n", message);
-        ui_show_error("Errore creazione partita");
+    if (msg.type != SMSG_GAME_CREATED) {
+        printf("[DEBUG] ERRORE: Atteso GAME_CREATED, ricevuto: %s\n", message);
+        if (msg.type == SMSG_ERROR) {
+            ui_show_error(msg.text);
+        } else {
+            // La partita può essere stata creata comunque: non deve restare aperta sul server
+            network_send(conn, command_verb(CMD_CANCEL), 0);
+            ui_show_error("Errore creazione partita");
+        }
         return PLAYER_NONE;
     }
     
     
-    if (strstr(message, "WAITING_OPPONENT")) {
-        printf("[DEBUG] GAME_CREATED e WAITING_OPPONENT ricevuti insieme\n");
-        
-    } else {
-        
-        printf("[DEBUG] Attendo messaggio WAITING_OPPONENT separato...\n");
-        fflush(stdout);
-        bytes = network_receive(conn, message, sizeof(message), 0);
-        if (bytes <= 0) {
-            printf("[DEBUG] ERRORE: bytes ricevuti per WAITING_OPPONENT=%d\n", bytes);
-            ui_show_error("Errore ricezione stato attesa");
-            return PLAYER_NONE;
-        }
-        
-        printf("[DEBUG] Stato attesa: %s\n", message);
-        fflush(stdout);
+    printf("[DEBUG] Attendo messaggio WAITING_OPPONENT...\n");
+    fflush(stdout);
+    bytes = receive_reply(conn, message, sizeof(message), &msg);
+    if (bytes <= 0) {
+        printf("[DEBUG] ERRORE: bytes ricevuti per WAITING_OPPONENT=%d\n", bytes);
+        ui_show_error("Errore ricezione stato attesa");
+        return PLAYER_NONE;
     }
+    
+    printf("[DEBUG] Stato attesa: %s\n", message);
+    fflush(stdout);
     ui_show_waiting_screen();
     
 retry_waiting:
@@ -411,25 +548,16 @@ retry_waiting:
         
         if (difftime(time(NULL), start_time) > 300) {
             ui_show_message("Timeout: nessun avversario trovato");
-            network_send(conn, "CANCEL", 0);
+            network_send(conn, command_verb(CMD_CANCEL), 0);
             return PLAYER_NONE;
         }
         
         
-        fd_set pre_check;
-        FD_ZERO(&pre_check);
-        FD_SET(conn->tcp_sock, &pre_check);
-        struct timeval instant = {0, 0}; 
-        
-#ifdef _WIN32
-        int pre_result = select(0, &pre_check, NULL, NULL, &instant);
-#else
-        int pre_result = select(conn->tcp_sock + 1, &pre_check, NULL, NULL, &instant);
-#endif
+        int pre_result = network_wait_message(conn, 0);
         
         if (pre_result > 0) {
             printf(">>> MESSAGGIO IMMEDIATAMENTE DISPONIBILE!\n");
-            bytes = network_receive(conn, message, sizeof(message), 0);
+            bytes = network_receive_message(conn, message, sizeof(message), &msg);
             if (bytes > 0) {
                 printf(">>> Messaggio ricevuto (pre-check): %s\n", message);
                 goto process_message;
@@ -437,25 +565,10 @@ retry_waiting:
         }
         
         
-        fd_set read_fds;
-        FD_ZERO(&read_fds);
-        FD_SET(conn->tcp_sock, &read_fds);
-        
-        struct timeval tv;
-        tv.tv_sec = 0;  
-        tv.tv_usec = 100000; 
-        
-        int select_result;
-        do {
-#ifdef _WIN32
-            select_result = select(0, &read_fds, NULL, NULL, &tv);
-#else
-            select_result = select(conn->tcp_sock + 1, &read_fds, NULL, NULL, &tv);
-#endif
-        } while (select_result == -1 && errno == EINTR);  
+        int select_result = network_wait_message(conn, 100);
 
-        if (select_result > 0 && FD_ISSET(conn->tcp_sock, &read_fds)) {
-            bytes = network_receive(conn, message, sizeof(message), 0);
+        if (select_result > 0) {
+            bytes = network_receive_message(conn, message, sizeof(message), &msg);
             
             if (bytes > 0) {
                 printf(">>> Messaggio ricevuto: %s\n", message);
@@ -480,9 +593,13 @@ retry_waiting:
             int key = getch();
             if (key == 27) { 
                 printf("Cancellazione richiesta dall'utente\n");
-                network_send(conn, "CANCEL", 0);
+                network_send(conn, command_verb(CMD_CANCEL), 0);
                 return PLAYER_NONE;
             }
+            if (key == 'b' || key == 'B') {
+                // Il bot del server diventa l'avversario: GAME_START arriva subito
+                request_bot_game(conn);
+            }
         }
         
         
@@ -490,24 +607,15 @@ retry_waiting:
         time_t now = time(NULL);
         if (difftime(now, last_update) >= 3) {
             ui_show_waiting_screen();
-            printf("In attesa di avversario... (ESC per annullare)\n");
+            printf("In attesa di avversario... (ESC per annullare, B per giocare contro il bot, B1-B3 per sceglierne il livello)\n");
             printf(">>> Controllo attivo messaggi dal server...\n");
             last_update = now;
             
             
-            fd_set quick_check;
-            FD_ZERO(&quick_check);
-            FD_SET(conn->tcp_sock, &quick_check);
-            struct timeval quick_tv = {0, 0}; 
-            
-#ifdef _WIN32
-            int quick_result = select(0, &quick_check, NULL, NULL, &quick_tv);
-#else
-            int quick_result = select(conn->tcp_sock + 1, &quick_check, NULL, NULL, &quick_tv);
-#endif
+            int quick_result = network_wait_message(conn, 0);
             if (quick_result > 0) {
                 printf(">>> MESSAGGIO DISPONIBILE! Leggendo...\n");
-                bytes = network_receive(conn, message, sizeof(message), 0);
+                bytes = network_receive_message(conn, message, sizeof(message), &msg);
                 if (bytes > 0) {
                     printf(">>> Messaggio trovato nel controllo aggiuntivo: %s\n", message);
                     goto process_message; 
@@ -529,13 +637,10 @@ continue_waiting:
 
 process_message:
     
-    if (strstr(message, "JOIN_REQUEST:")) {
-        
-        char player_name[MAX_NAME_LEN];
-        int game_id;
-        if (sscanf(message, "JOIN_REQUEST:%49[^:]:%d", player_name, &game_id) == 2) {
+    switch (msg.type) {
+        case SMSG_JOIN_REQUEST:
             printf("\n=== RICHIESTA DI JOIN ===\n");
-            printf("Il giocatore '%s' vuole unirsi alla tua partita.\n", player_name);
+            printf("Il giocatore '%.*s' vuole unirsi alla tua partita.\n", (int)msg.text_len, msg.text);
             printf("Accetti? (s/n): ");
             fflush(stdout);
             
@@ -543,51 +648,60 @@ process_message:
             scanf(" %c", &response);
             
             if (response == 's' || response == 'S') {
-                network_send(conn, "APPROVE:1", 0);
+                network_approve_join(conn, 1);
                 printf("Richiesta approvata. In attesa che il gioco inizi...\n");
             } else {
-                network_send(conn, "APPROVE:0", 0);
+                network_approve_join(conn, 0);
                 printf("Richiesta rifiutata. In attesa di altri giocatori...\n");
             }
-        }
+            goto continue_waiting;
         
-        goto continue_waiting;
-    }
-    else if (strstr(message, "JOIN_APPROVED_BY_YOU")) {
-        printf("Hai approvato il join. La partita sta iniziando...\n");
-        goto continue_waiting;
-    }
-    else if (strstr(message, "JOIN_REJECTED_BY_YOU")) {
-        printf("Hai rifiutato il join. In attesa di altri giocatori...\n");
-        goto continue_waiting;
-    }
-    else if (strstr(message, "JOIN_CANCELLED:")) {
-        printf("Il giocatore ha annullato la richiesta di join.\n");
-        goto continue_waiting;
-    }
-    else if (strstr(message, "OPPONENT_JOINED")) {
-        printf("Avversario si è unito!\n");
-        goto continue_waiting; 
-    }
-    else if (strstr(message, "GAME_START:")) {
-        char symbol;
-        if (sscanf(message, "GAME_START:%c", &symbol) == 1) {
-            assigned_symbol = (PlayerSymbol)symbol;
+        case SMSG_JOIN_APPROVED_BY_YOU:
+            printf("Hai approvato il join. La partita sta iniziando...\n");
+            goto continue_waiting;
+        
+        case SMSG_JOIN_REJECTED_BY_YOU:
+            printf("Hai rifiutato il join. In attesa di altri giocatori...\n");
+            goto continue_waiting;
+        
+        case SMSG_JOIN_CANCELLED:
+            printf("Il giocatore ha annullato la richiesta di join.\n");
+            goto continue_waiting;
+        
+        case SMSG_BOT_OFFER:
+            // Offerta del server dopo un'attesa lunga: B accetta, continuare ad attendere la ignora
+            printf("\n=== NESSUN AVVERSARIO ===\n");
+            printf("%s\n", msg.text);
+            printf("Premi B (o B1-B3 per il livello) per giocare contro il bot, oppure continua ad attendere.\n");
+            goto continue_waiting;
+        
+        case SMSG_GAME_VARIANT:
+            // Conferma della variante scelta alla creazione
+            variant_rows = msg.row;
+            variant_cols = msg.col;
+            variant_k = msg.value;
+            goto continue_waiting;
+        
+        case SMSG_GAME_START:
+            assigned_symbol = (PlayerSymbol)msg.symbol;
             printf("Partita iniziata! Il tuo simbolo è: %c\n", assigned_symbol);
             ui_clear_screen();
+            show_bot_level(&msg);
             ui_show_message("Avversario trovato! La partita inizia...");
             game_started = 1;
             return assigned_symbol;
-        }
-    }
-    else if (strstr(message, "ERROR:")) {
-        ui_show_error(message);
-        return PLAYER_NONE;
-    }
-    else if (strstr(message, "SERVER_SHUTDOWN:")) {
-        printf("Server in spegnimento: %s\n", message + 16);
-        keep_running = 0;
-        return PLAYER_NONE;
+        
+        case SMSG_ERROR:
+            ui_show_error(message);
+            return PLAYER_NONE;
+        
+        case SMSG_SERVER_SHUTDOWN:
+            printf("Server in spegnimento: %s\n", msg.text);
+            keep_running = 0;
+            return PLAYER_NONE;
+        
+        default:
+            break;
     }
 
     return assigned_symbol;
@@ -601,6 +715,8 @@ process_message:
  * @param conn Connessione di rete attiva con il server
  * @return Simbolo assegnato al giocatore (X o O), PLAYER_NONE in caso di errore
  * 
+ * @note La lista è mostrata a pagine di LOBBY_PAGE_SIZE partite, filtrate per stato
+ *       (inizialmente solo quelle in attesa)
  * @note Richiede l'approvazione del creatore della partita
  * @note Include timeout per l'attesa dell'approvazione
  * @note Il giocatore che si unisce ottiene generalmente il simbolo O
@@ -608,100 +724,76 @@ process_message:
 PlayerSymbol handle_join_game(NetworkConnection* conn) {
     PlayerSymbol assigned_symbol = PLAYER_NONE;
     char message[MAX_MSG_SIZE];
+    Message msg;
     int bytes;
     
     
-    int flushed = network_flush_receive_buffer(conn);
-    if (flushed > 0) {
-        printf("[DEBUG] Buffer svuotato: %d bytes di vecchi messaggi rimossi\n", flushed);
-    }
-    
-    
-    printf("Richiesta lista partite...\n");
-    if (!network_send(conn, "LIST_GAMES", 0)) {
-        ui_show_error("Errore nell'invio richiesta lista partite");
-        return PLAYER_NONE;
-    }
-
-    
-    bytes = network_receive(conn, message, sizeof(message), 0);
-    if (bytes <= 0) {
-        ui_show_error(network_get_error());
-        return PLAYER_NONE;
-    }
-    
-    printf("Lista partite ricevuta: %s\n", message);
-    
+    // Senza GAME_VARIANT prima di GAME_START la partita è un Tris classico
+    variant_rows = variant_cols = variant_k = BOARD_SIDE;
     
-    if (!strstr(message, "GAMES:")) {
-        ui_show_error("Risposta server non valida per lista partite");
-        return PLAYER_NONE;
-    }
+    // Si parte dalla prima pagina del filtro scelto l'ultima volta
+    lobby_list_set_view(&lobby_list, lobby_list.filter, 0);
     
-    ui_clear_screen();
-    ui_show_message(message);
-
-    
-    {
-        fd_set read_fds;
-        struct timeval tv;
-        while (1) {
-            FD_ZERO(&read_fds);
-            FD_SET(conn->tcp_sock, &read_fds);
-            tv.tv_sec = 0;
-            tv.tv_usec = 100000; 
-#ifdef _WIN32
-            int sel = select(0, &read_fds, NULL, NULL, &tv);
-#else
-            int sel = select(conn->tcp_sock + 1, &read_fds, NULL, NULL, &tv);
-#endif
-            if (sel > 0 && FD_ISSET(conn->tcp_sock, &read_fds)) {
-                char tmp[MAX_MSG_SIZE];
-                int r = network_receive(conn, tmp, sizeof(tmp), 0);
-                if (r > 0) {
-                    if (strncmp(tmp, "GAMES:", 6) == 0) {
-                        printf("[DEBUG] Drained extra GAMES: %s\n", tmp);
-                        continue; 
-                    }
-                    
-                    printf("[DEBUG] Ignoro messaggio inatteso prima del JOIN: %s\n", tmp);
-                    continue;
-                }
+    int game_id;
+    while (1) {
+        // La pagina locale segue gli aggiornamenti del server: viene
+        // richiesta solo se non è sincronizzata
+        if (!sync_lobby_list(conn)) {
+            return PLAYER_NONE;
+        }
+        if (lobby_list.count == 0 && lobby_list.offset > 0) {
+            // La pagina si è svuotata: torna all'inizio della lista
+            lobby_list_set_view(&lobby_list, lobby_list.filter, 0);
+            continue;
+        }
+        
+        ui_clear_screen();
+        ui_show_game_list(&lobby_list);
+        
+        printf("\nInserisci ID partita (0 per annullare, n/p pagina successiva/precedente, f cambia filtro): ");
+        fflush(stdout);
+        
+        char input[10];
+        if (fgets(input, sizeof(input), stdin) == NULL) {
+            ui_show_error("Errore lettura input");
+            return PLAYER_NONE;
+        }
+        
+        if (input[0] == 'n' || input[0] == 'N') {
+            int next = lobby_list.offset + lobby_list.count;
+            if (next < lobby_list.total) {
+                lobby_list_set_view(&lobby_list, lobby_list.filter, next);
             }
-            break; 
+            continue;
         }
+        if (input[0] == 'p' || input[0] == 'P') {
+            lobby_list_set_view(&lobby_list, lobby_list.filter, lobby_list.offset - LOBBY_PAGE_SIZE);
+            continue;
+        }
+        if (input[0] == 'f' || input[0] == 'F') {
+            // Ciclo: tutte, in attesa, richiesta in corso, in corso, rivincita
+            int filter = lobby_list.filter == LOBBY_GAME_REMATCH ? LOBBY_FILTER_ALL : lobby_list.filter + 1;
+            lobby_list_set_view(&lobby_list, filter, 0);
+            continue;
+        }
+        
+        game_id = atoi(input);
+        break;
     }
     
-    
-    if (strstr(message, "Nessuna partita disponibile")) {
-        ui_show_message("Nessuna partita disponibile al momento");
-        return PLAYER_NONE;
-    }
-    
-    
-    printf("\nInserisci ID partita (0 per annullare): ");
-    fflush(stdout);
-    
-    char input[10];
-    if (fgets(input, sizeof(input), stdin) == NULL) {
-        ui_show_error("Errore lettura input");
-        return PLAYER_NONE;
-    }
-    
-    int game_id = atoi(input);
     if (game_id == 0) {
         printf("Operazione annullata\n");
         return PLAYER_NONE;
     }
     
     
-    char join_msg[32];
-    snprintf(join_msg, sizeof(join_msg), "JOIN:%d", game_id);
-    printf("Invio richiesta: %s\n", join_msg);
-    if (!network_send(conn, join_msg, 0)) {
+    printf("Invio richiesta: %s:%d\n", command_verb(CMD_JOIN), game_id);
+    if (!network_join_game(conn, game_id)) {
         ui_show_error("Errore nell'invio richiesta join");
         return PLAYER_NONE;
     }
+    // Durante la partita il server non invia aggiornamenti della lista
+    lobby_list_invalidate(&lobby_list);
 
     printf("Richiesta inviata, in attesa di risposta...\n");
     printf("Connessione alla partita in corso...\n");
@@ -716,22 +808,7 @@ PlayerSymbol handle_join_game(NetworkConnection* conn) {
         }
         
         
-        fd_set read_fds;
-        FD_ZERO(&read_fds);
-        FD_SET(conn->tcp_sock, &read_fds);
-        
-        struct timeval tv;
-        tv.tv_sec = 2;  
-        tv.tv_usec = 0;
-        
-        int select_result;
-        do {
-#ifdef _WIN32
-            select_result = select(0, &read_fds, NULL, NULL, &tv);
-#else
-            select_result = select(conn->tcp_sock + 1, &read_fds, NULL, NULL, &tv);
-#endif
-        } while (select_result == -1 && errno == EINTR);  
+        int select_result = network_wait_message(conn, 2000);
         
         if (select_result == 0) {
             
@@ -744,7 +821,7 @@ PlayerSymbol handle_join_game(NetworkConnection* conn) {
             return PLAYER_NONE;
         }
         
-        bytes = network_receive(conn, message, sizeof(message), 0);
+        bytes = network_receive_message(conn, message, sizeof(message), &msg);
         if (bytes <= 0) {
             ui_show_error("Errore ricezione risposta");
             return PLAYER_NONE;
@@ -753,63 +830,62 @@ PlayerSymbol handle_join_game(NetworkConnection* conn) {
         printf("Risposta ricevuta: %s\n", message);
         
         
-        if (strstr(message, "ERROR:")) {
-            ui_show_error(message);
-            return PLAYER_NONE;
-        }
-        else if (strstr(message, "SERVER_SHUTDOWN:")) {
-            printf("Server in spegnimento: %s\n", message + 16);
-            keep_running = 0;
-            return PLAYER_NONE;
-        }
-        else if (strstr(message, "JOIN_PENDING:")) {
-            printf("Richiesta inviata al creatore. In attesa di approvazione...\n");
-            continue; 
-        }
-        else if (strstr(message, "JOIN_APPROVED:")) {
-            char symbol;
-            if (sscanf(message, "JOIN_APPROVED:%c", &symbol) == 1) {
-                assigned_symbol = (PlayerSymbol)symbol;
+        switch (msg.type) {
+            case SMSG_ERROR:
+                ui_show_error(message);
+                return PLAYER_NONE;
+            
+            case SMSG_SERVER_SHUTDOWN:
+                printf("Server in spegnimento: %s\n", msg.text);
+                keep_running = 0;
+                return PLAYER_NONE;
+            
+            case SMSG_JOIN_PENDING:
+                printf("Richiesta inviata al creatore. In attesa di approvazione...\n");
+                continue; 
+            
+            case SMSG_JOIN_APPROVED:
+                assigned_symbol = (PlayerSymbol)msg.symbol;
                 printf("Join approvato! Il tuo simbolo è: %c\n", assigned_symbol);
                 printf("In attesa che la partita inizi...\n");
                 continue; 
-            }
-        }
-        else if (strstr(message, "JOIN_REJECTED:")) {
-            ui_show_error("La tua richiesta è stata rifiutata dal creatore");
-            return PLAYER_NONE;
-        }
-        else if (strncmp(message, "GAMES:", 6) == 0) {
             
-            printf("[DEBUG] Ignoro GAMES arrivato dopo JOIN\n");
-            continue;
-        }
-        else if (strstr(message, "JOIN_ACCEPTED")) {
-            printf("Join accettato! In attesa del messaggio GAME_START...\n");
-            printf("Unito alla partita! In attesa di inizio...\n");
-            continue; 
-        }
-        else if (strstr(message, "GAME_START:")) {
-            char symbol;
-            if (sscanf(message, "GAME_START:%c", &symbol) == 1) {
-                assigned_symbol = (PlayerSymbol)symbol;
+            case SMSG_JOIN_REJECTED:
+                ui_show_error("La tua richiesta è stata rifiutata dal creatore");
+                return PLAYER_NONE;
+            
+            case SMSG_GAME_VARIANT:
+                variant_rows = msg.row;
+                variant_cols = msg.col;
+                variant_k = msg.value;
+                printf("Variante della partita: %dx%d, allineamento %d\n", variant_rows, variant_cols, variant_k);
+                continue;
+            
+            case SMSG_GAMES:
+            case SMSG_LIST_UPDATE:
+                // Dopo JOIN la lista serve solo a restare sincronizzati
+                lobby_list_handle_message(&lobby_list, &msg);
+                continue;
+            
+            case SMSG_GAME_START:
+                assigned_symbol = (PlayerSymbol)msg.symbol;
                 printf("Partita iniziata! Il tuo simbolo è: %c\n", assigned_symbol);
                 ui_clear_screen();
                 printf("Partita iniziata!\n");
                 return assigned_symbol;
-            }
-        }
-        else if (strcmp(message, "PING") == 0) {
-            network_send(conn, "PONG", 0);
-            continue;
-        }
-        else if (strstr(message, "OPPONENT_LEFT") || strstr(message, "GAME_CANCELLED")) {
-            ui_show_error(message);
-            return PLAYER_NONE;
-        }
-        else {
-            printf("Messaggio non riconosciuto durante JOIN: %s\n", message);
-            continue; 
+            
+            case SMSG_OPPONENT_LEFT:
+            case SMSG_GAME_CANCELLED:
+                ui_show_error(message);
+                return PLAYER_NONE;
+            
+            default:
+                if (strcmp(message, "PING") == 0) {
+                    network_send(conn, "PONG", 0);
+                    continue;
+                }
+                printf("Messaggio non riconosciuto durante JOIN: %s\n", message);
+                continue; 
         }
     }
     
@@ -824,41 +900,49 @@ PlayerSymbol handle_join_game(NetworkConnection* conn) {
  * 
  * @param conn Connessione di rete attiva con il server
  * @param game Struttura dati del gioco corrente
- * @param player_symbol Simbolo del giocatore (X o O)
+ * @param player_symbol Simbolo del giocatore (X o O), aggiornato se una rivincita lo cambia
  * 
  * @note Gestisce timeout per le mosse e disconnessioni
  * @note Include validazione delle mosse e sincronizzazione con il server
  * @note Gestisce automaticamente la fine partita e le richieste di rematch
  */
-void game_loop(NetworkConnection* conn, Game* game, PlayerSymbol player_symbol) {
-    printf("Iniziando game loop. Il tuo simbolo è: %c\n", player_symbol);
+void game_loop(NetworkConnection* conn, Game* game, PlayerSymbol *player_symbol) {
+    printf("Iniziando game loop. Il tuo simbolo è: %c\n", *player_symbol);
     
     // ========== INIZIALIZZAZIONE PARTITA ==========
     game->state = GAME_STATE_PLAYING;
     game->current_player = PLAYER_X; // X inizia sempre
     
     while (keep_running && game->state != GAME_STATE_OVER) {
-        ui_show_board(game->board);
+        ui_show_board(&game->board);
         
         // ========== DETERMINAZIONE TURNO ==========
-        int is_my_turn = (game->current_player == player_symbol);
+        int is_my_turn = (game->current_player == *player_symbol);
         
         if (is_my_turn) {
             // ========== GESTIONE TURNO GIOCATORE ==========
             printf("\n=== IL TUO TURNO ===\n");
-            printf("Simbolo corrente: %c (il tuo: %c)\n", game->current_player, player_symbol);
-            
-            // Input e validazione mossa
-            int move = ui_get_player_move();
-            if (move == 0) {
-                printf("Uscita richiesta dall'utente\n");
-                keep_running = 0;
-                break;
-            }
+            printf("Simbolo corrente: %c (il tuo: %c)\n", game->current_player, *player_symbol);
             
+            // Input e validazione mossa (cella 1-9 nel Tris classico, riga e colonna altrimenti)
             int row, col;
-            get_board_position(move, &row, &col);
-            printf("Mossa selezionata: cella %d -> riga %d, colonna %d\n", move, row, col);
+            if (board_is_classic(&game->board)) {
+                int move = ui_get_player_move();
+                if (move == 0) {
+                    printf("Uscita richiesta dall'utente\n");
+                    keep_running = 0;
+                    break;
+                }
+                get_board_position(move, &row, &col);
+                printf("Mossa selezionata: cella %d -> riga %d, colonna %d\n", move, row, col);
+            } else {
+                if (!ui_get_player_cell(&game->board, &row, &col)) {
+                    printf("Uscita richiesta dall'utente\n");
+                    keep_running = 0;
+                    break;
+                }
+                printf("Mossa selezionata: riga %d, colonna %d\n", row, col);
+            }
             
             
             if (!game_is_valid_move(game, row, col)) {
@@ -867,11 +951,9 @@ void game_loop(NetworkConnection* conn, Game* game, PlayerSymbol player_symbol)
             }
             
             // ========== INVIO MOSSA AL SERVER ==========
-            char move_msg[32];
-            snprintf(move_msg, sizeof(move_msg), "MOVE:%d,%d", row, col);
-            printf("Invio mossa: %s\n", move_msg);
+            printf("Invio mossa: riga %d, colonna %d\n", row, col);
             
-            if (!network_send(conn, move_msg, 0)) {
+            if (!network_send_move(conn, row, col)) {
                 ui_show_error("Errore nell'invio della mossa");
                 keep_running = 0;
                 break;
@@ -881,7 +963,8 @@ void game_loop(NetworkConnection* conn, Game* game, PlayerSymbol player_symbol)
             
             // ========== RICEZIONE RISPOSTA SERVER ==========
             char message[MAX_MSG_SIZE];
-            int bytes = network_receive(conn, message, sizeof(message), 0);
+            Message msg;
+            int bytes = network_receive_message(conn, message, sizeof(message), &msg);
             
             if (bytes <= 0) {
                 ui_show_error("Errore ricezione risposta mossa");
@@ -892,16 +975,16 @@ void game_loop(NetworkConnection* conn, Game* game, PlayerSymbol player_symbol)
             printf("Risposta server: %s\n", message);
             
             // ========== ELABORAZIONE RISPOSTA ==========
-            if (strstr(message, "ERROR:")) {
+            if (msg.type == SMSG_ERROR) {
                 ui_show_error(message);
                 
                 
                 break; 
             }
-            else if (strstr(message, "MOVE:")) {
+            else if (msg.type == SMSG_MOVE) {
                 
-                if (game_process_network_message(game, message)) {
-                    ui_show_board(game->board);
+                if (game_process_network_message(game, &msg)) {
+                    ui_show_board(&game->board);
                     printf("Board aggiornato dopo la mossa\n");
                 } else {
                     printf("Errore nell'aggiornamento del board\n");
@@ -909,34 +992,24 @@ void game_loop(NetworkConnection* conn, Game* game, PlayerSymbol player_symbol)
                 
                 
                 
-                fd_set read_fds;
-                struct timeval tv;
-                FD_ZERO(&read_fds);
-                FD_SET(conn->tcp_sock, &read_fds);
-                tv.tv_sec = 0;
-                tv.tv_usec = 200000; 
-                
-#ifdef _WIN32
-                int sel = select(0, &read_fds, NULL, NULL, &tv);
-#else
-                int sel = select(conn->tcp_sock + 1, &read_fds, NULL, NULL, &tv);
-#endif
+                int sel = network_wait_message(conn, 200);
                 
-                if (sel > 0 && FD_ISSET(conn->tcp_sock, &read_fds)) {
+                if (sel > 0) {
                     char extra_msg[MAX_MSG_SIZE];
-                    int extra_bytes = network_receive(conn, extra_msg, sizeof(extra_msg), 0);
+                    Message extra;
+                    int extra_bytes = network_receive_message(conn, extra_msg, sizeof(extra_msg), &extra);
                     if (extra_bytes > 0) {
                         printf("Messaggio immediato dopo la mossa: %s\n", extra_msg);
-                        if (strstr(extra_msg, "MOVE:")) {
-                            if (game_process_network_message(game, extra_msg)) {
-                                ui_show_board(game->board);
+                        if (extra.type == SMSG_MOVE) {
+                            if (game_process_network_message(game, &extra)) {
+                                ui_show_board(&game->board);
                                 printf("Mossa avversario processata immediatamente\n");
                             }
                         }
-                        else if (strstr(extra_msg, "GAME_OVER:")) {
-                            if (game_process_network_message(game, extra_msg)) {
+                        else if (extra.type == SMSG_GAME_OVER) {
+                            if (game_process_network_message(game, &extra)) {
                                 printf("Partita terminata!\n");
-                                if (!handle_game_end(conn, game, &player_symbol)) {
+                                if (!handle_game_end(conn, game, player_symbol)) {
                                     game->state = GAME_STATE_OVER; 
                                 }
                                 return;
@@ -946,21 +1019,15 @@ void game_loop(NetworkConnection* conn, Game* game, PlayerSymbol player_symbol)
                 }
                 
             }
-            else if (strstr(message, "GAME_OVER:")) {
-                if (game_process_network_message(game, message)) {
+            else if (msg.type == SMSG_GAME_OVER) {
+                if (game_process_network_message(game, &msg)) {
                     printf("Partita terminata!\n");
-                    if (!handle_game_end(conn, game, &player_symbol)) {
+                    if (!handle_game_end(conn, game, player_symbol)) {
                         game->state = GAME_STATE_OVER; 
                     }
                     return; 
                 }
             }
-            else if (strstr(message, "ERROR:")) {
-                printf("Errore dal server: %s\n", message);
-                ui_show_error(message);
-                
-                continue;
-            }
             else if (strcmp(message, "PING") == 0) {
                 network_send(conn, "PONG", 0);
                 continue; 
@@ -973,32 +1040,18 @@ void game_loop(NetworkConnection* conn, Game* game, PlayerSymbol player_symbol)
         else {
             // ========== GESTIONE TURNO AVVERSARIO ==========
             printf("\n=== TURNO AVVERSARIO ===\n");
-            printf("Simbolo corrente: %c (il tuo: %c)\n", game->current_player, player_symbol);
+            printf("Simbolo corrente: %c (il tuo: %c)\n", game->current_player, *player_symbol);
             printf("Aspettando mossa avversario... (ESC per uscire)\n");
             
             // Loop di attesa mossa avversario
-            while (keep_running && game->current_player != player_symbol) {
-                
-                fd_set read_fds;
-                FD_ZERO(&read_fds);
-                FD_SET(conn->tcp_sock, &read_fds);
+            while (keep_running && game->current_player != *player_symbol) {
                 
-                struct timeval tv;
-                tv.tv_sec = 1;  
-                tv.tv_usec = 0;
-                
-                int select_result;
-                do {
-#ifdef _WIN32
-                    select_result = select(0, &read_fds, NULL, NULL, &tv);
-#else
-                    select_result = select(conn->tcp_sock + 1, &read_fds, NULL, NULL, &tv);
-#endif
-                } while (select_result == -1 && errno == EINTR);  
+                int select_result = network_wait_message(conn, 1000);
 
-                if (select_result > 0 && FD_ISSET(conn->tcp_sock, &read_fds)) {
+                if (select_result > 0) {
                     char message[MAX_MSG_SIZE];
-                    int bytes = network_receive(conn, message, sizeof(message), 0);
+                    Message msg;
+                    int bytes = network_receive_message(conn, message, sizeof(message), &msg);
                     
                     if (bytes <= 0) {
                         ui_show_error("Connessione persa");
@@ -1008,37 +1061,37 @@ void game_loop(NetworkConnection* conn, Game* game, PlayerSymbol player_symbol)
                     
                     printf("Messaggio ricevuto durante attesa: %s\n", message);
                     
-                    if (strstr(message, "MOVE:")) {
+                    if (msg.type == SMSG_MOVE) {
                         
-                        if (game_process_network_message(game, message)) {
-                            ui_show_board(game->board);
+                        if (game_process_network_message(game, &msg)) {
+                            ui_show_board(&game->board);
                             printf("Mossa avversario processata\n");
                             break;  
                         }
                     }
-                    else if (strstr(message, "GAME_OVER:")) {
-                        if (game_process_network_message(game, message)) {
+                    else if (msg.type == SMSG_GAME_OVER) {
+                        if (game_process_network_message(game, &msg)) {
                             printf("Partita terminata!\n");
-                            if (!handle_game_end(conn, game, &player_symbol)) {
+                            if (!handle_game_end(conn, game, player_symbol)) {
                                 game->state = GAME_STATE_OVER; 
                             }
                             return; 
                         }
                     }
-                    else if (strstr(message, "ERROR:")) {
+                    else if (msg.type == SMSG_ERROR) {
                         printf("Errore dal server: %s\n", message);
                         
                         
-                        if (strstr(message, "rematch") || strstr(message, "REMATCH")) {
+                        if (strstr(msg.text, "rematch") || strstr(msg.text, "REMATCH")) {
                             printf("Errore rematch ignorato durante partita in corso\n");
                             continue;
                         }
                         
                         
-                        ui_show_error(message + 6); 
+                        ui_show_error(msg.text); 
                         continue;
                     }
-                    else if (strstr(message, "OPPONENT_LEFT")) {
+                    else if (msg.type == SMSG_OPPONENT_LEFT) {
                         ui_show_message("L'avversario ha abbandonato la partita");
                         keep_running = 0;
                         break;
@@ -1047,7 +1100,7 @@ void game_loop(NetworkConnection* conn, Game* game, PlayerSymbol player_symbol)
                         network_send(conn, "PONG", 0);
                         continue; 
                     }
-                    else if (strstr(message, "REMATCH_ACCEPTED:")) {
+                    else if (msg.type == SMSG_REMATCH_ACCEPTED) {
                         printf("Rematch accettato da entrambi! Nuova partita inizia...\n");
                         
                         game_init_board(game);
@@ -1055,18 +1108,9 @@ void game_loop(NetworkConnection* conn, Game* game, PlayerSymbol player_symbol)
                         game->current_player = PLAYER_X;
                         
                         
-                        char start_msg[MAX_MSG_SIZE];
-                        int start_bytes = network_receive(conn, start_msg, sizeof(start_msg), 0);
-                        if (start_bytes > 0 && strstr(start_msg, "GAME_START:")) {
-                            printf("Nuovo GAME_START ricevuto: %s\n", start_msg);
-                            char new_symbol;
-                            if (sscanf(start_msg, "GAME_START:%c", &new_symbol) == 1) {
-                                player_symbol = (PlayerSymbol)new_symbol;
-                                printf("Nuovo simbolo assegnato: %c\n", player_symbol);
-                            }
-                        }
+                        *player_symbol = receive_rematch_symbol(conn, *player_symbol);
                         
-                        printf("Nuova partita iniziata! Il tuo simbolo: %c\n", player_symbol);
+                        printf("Nuova partita iniziata! Il tuo simbolo: %c\n", *player_symbol);
                         break; 
                     }
                     else {
@@ -1089,7 +1133,7 @@ void game_loop(NetworkConnection* conn, Game* game, PlayerSymbol player_symbol)
                     int key = getch();
                     if (key == 27) { 
                         printf("Uscita richiesta dall'utente\n");
-                        network_send(conn, "LEAVE", 0);
+                        network_send(conn, command_verb(CMD_LEAVE), 0);
                         keep_running = 0;
                         break;
                     }
@@ -1104,10 +1148,10 @@ void game_loop(NetworkConnection* conn, Game* game, PlayerSymbol player_symbol)
     
     
     if (keep_running && game->state == GAME_STATE_OVER) {
-        ui_show_board(game->board);
+        ui_show_board(&game->board);
         
         if (game->winner != PLAYER_NONE) {
-            if (game->winner == player_symbol) {
+            if (game->winner == *player_symbol) {
                 ui_show_message("HAI VINTO!");
             } else {
                 ui_show_message("HAI PERSO!");
@@ -1122,7 +1166,7 @@ void game_loop(NetworkConnection* conn, Game* game, PlayerSymbol player_symbol)
         
         printf("\n=== PARTITA TERMINATA ===\n");
         if (game->winner != PLAYER_NONE) {
-            if (game->winner == player_symbol) {
+            if (game->winner == *player_symbol) {
                 ui_show_message("HAI VINTO!");
             } else {
                 ui_show_message("HAI PERSO!");
@@ -1153,35 +1197,13 @@ void game_loop(NetworkConnection* conn, Game* game, PlayerSymbol player_symbol)
                 
                 while (!rematch_handled && difftime(time(NULL), start_time) < 30) {
                     char message[MAX_MSG_SIZE];
-                    int bytes = network_receive(conn, message, sizeof(message), 0);
+                    Message msg;
+                    int bytes = network_receive_message(conn, message, sizeof(message), &msg);
                     
                     if (bytes > 0) {
-                        if (strstr(message, "REMATCH_ACCEPTED:")) {
+                        if (msg.type == SMSG_REMATCH_ACCEPTED) {
                             printf("Rivincita accettata! Nuova partita inizia...\n");
-                            
-                            
-                            char *game_start_pos = strstr(message, "GAME_START:");
-                            if (game_start_pos) {
-                                
-                                printf("GAME_START trovato nel messaggio combinato: %s\n", message);
-                                char new_symbol;
-                                if (sscanf(game_start_pos, "GAME_START:%c", &new_symbol) == 1) {
-                                    player_symbol = (PlayerSymbol)new_symbol;
-                                    printf("Nuovo simbolo assegnato: %c\n", player_symbol);
-                                }
-                            } else {
-                                
-                                char start_msg[MAX_MSG_SIZE];
-                                int start_bytes = network_receive(conn, start_msg, sizeof(start_msg), 0);
-                                if (start_bytes > 0 && strstr(start_msg, "GAME_START:")) {
-                                    printf("Nuovo GAME_START ricevuto: %s\n", start_msg);
-                                    char new_symbol;
-                                    if (sscanf(start_msg, "GAME_START:%c", &new_symbol) == 1) {
-                                        player_symbol = (PlayerSymbol)new_symbol;
-                                        printf("Nuovo simbolo assegnato: %c\n", player_symbol);
-                                    }
-                                }
-                            }
+                            *player_symbol = receive_rematch_symbol(conn, *player_symbol);
                             
                             
                             game_init_board(game);
@@ -1190,11 +1212,11 @@ void game_loop(NetworkConnection* conn, Game* game, PlayerSymbol player_symbol)
                             game->winner = PLAYER_NONE;
                             game->is_draw = 0;
                             
-                            printf("Rivincita iniziata! Il tuo simbolo: %c\n", player_symbol);
+                            printf("Rivincita iniziata! Il tuo simbolo: %c\n", *player_symbol);
                             rematch_handled = 1;
                             return; 
                         } 
-                        else if (strstr(message, "REMATCH_REQUEST:")) {
+                        else if (msg.type == SMSG_REMATCH_REQUEST) {
                             if (!rematch_requested_by_me) {
                                 
                                 printf("L'avversario ha richiesto una rivincita.\n");
@@ -1215,10 +1237,10 @@ void game_loop(NetworkConnection* conn, Game* game, PlayerSymbol player_symbol)
                                 
                             }
                         }
-                        else if (strstr(message, "REMATCH_SENT:")) {
+                        else if (msg.type == SMSG_REMATCH_SENT) {
                             printf("In attesa che l'avversario risponda alla rivincita...\n");
                         }
-                        else if (strstr(message, "ERROR:")) {
+                        else if (msg.type == SMSG_ERROR) {
                             printf("Errore rivincita: %s\n", message);
                             rematch_handled = 1;
                         }
@@ -1287,16 +1309,19 @@ int main() {
         return 1;
     }
 
+    lobby_list_init(&lobby_list);
+
     ui_clear_screen();
     printf("\nRegistrazione completata come %s\n", player_name);
     sleep(1);
 
     // ========== LOOP PRINCIPALE DEL MENU ==========
     while (keep_running) {
-        // Pulizia buffer per evitare messaggi residui
-        int flushed = network_flush_receive_buffer(&conn);
-        if (flushed > 0) {
-            printf("[DEBUG] Buffer menu pulito: %d bytes rimossi\n", flushed);
+        // Pulizia buffer per evitare messaggi residui (gli aggiornamenti
+        // della lista partite vengono applicati alla copia locale)
+        int discarded = drain_pending_messages(&conn);
+        if (discarded > 0) {
+            printf("[DEBUG] Buffer menu pulito: %d messaggi scartati\n", discarded);
         }
         
         int choice = ui_show_main_menu();
@@ -1308,12 +1333,13 @@ int main() {
 
                 Game game;
                 game_init(&game);
+                board_init(&game.board, variant_rows, variant_cols, variant_k);
                 game.state = GAME_STATE_PLAYING;
                 game.current_player = PLAYER_X;  // Il primo giocatore inizia sempre
                 
                 // Loop di gioco per partite multiple (rematch)
                 while (keep_running) {
-                    game_loop(&conn, &game, my_symbol);
+                    game_loop(&conn, &game, &my_symbol);
                     
                     // Se la partita è terminata definitivamente, esci dal loop
                     if (game.state == GAME_STATE_OVER) {
@@ -1329,12 +1355,13 @@ int main() {
 
                 Game game;
                 game_init(&game);
+                board_init(&game.board, variant_rows, variant_cols, variant_k);
                 game.state = GAME_STATE_PLAYING;
                 game.current_player = PLAYER_X;  // Il primo giocatore inizia sempre
                 
                 // Loop di gioco per partite multiple (rematch)
                 while (keep_running) {
-                    game_loop(&conn, &game, my_symbol);
+                    game_loop(&conn, &game, &my_symbol);
                     
                     // Se la partita è terminata definitivamente, esci dal loop
                     if (game.state == GAME_STATE_OVER) {
@@ -3,9 +3,14 @@
 #include "headers/ui.h"
 #include "headers/game_logic.h"
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include <sys/time.h>
 #include <unistd.h>
+#ifndef _WIN32
+    #include <sys/select.h>
+#endif
 
 #ifdef _WIN32
     #define WIN32_LEAN_AND_MEAN
@@ -22,6 +27,8 @@
 
 static char last_error[256] = {0};
 
+static int network_udp_register(NetworkConnection *conn);
+
 
 /**
  * Imposta il messaggio di errore globale con informazioni di sistema specifiche per piattaforma.
@@ -263,29 +270,34 @@ void* message_receiver_thread(void* arg) {
 }
 
 void handle_server_message(const char* message) {
+    Message msg;
+    message_decode(message, strlen(message), &msg);
     
-    
-    
-    if (strncmp(message, "GAMES:", 6) == 0) {
-        printf("\n=== PARTITE DISPONIBILI ===\n");
-        printf("%s\n", message + 6);
-        printf("===========================\n");
-    }
-    else if (strncmp(message, "OK:", 3) == 0) {
-        printf("✓ %s\n", message + 3);
-    }
-    else if (strncmp(message, "ERROR:", 6) == 0) {
-        printf("❌ Errore: %s\n", message + 6);
-    }
-    else if (strcmp(message, "PONG") != 0) {
-        
-        if (strncmp(message, "GAME_START:", 11) != 0 &&
-            strncmp(message, "JOIN_ACCEPTED:", 14) != 0 &&
-            strncmp(message, "MOVE:", 5) != 0 &&
-            strncmp(message, "GAME_OVER:", 10) != 0 &&
-            strncmp(message, "OPPONENT_", 9) != 0) {
+    switch (msg.type) {
+        case SMSG_GAMES:
+            printf("\n=== PARTITE DISPONIBILI ===\n");
+            printf("%s\n", msg.text);
+            printf("===========================\n");
+            break;
+        case SMSG_LIST_UPDATE:
+            // Applicato alla lista da lobby_list_handle_message(), senza stampe
+            break;
+        case SMSG_OK:
+            printf("✓ %s\n", msg.text);
+            break;
+        case SMSG_ERROR:
+            printf("❌ Errore: %s\n", msg.text);
+            break;
+        case SMSG_PONG:
+        case SMSG_GAME_START:
+        case SMSG_GAME_VARIANT:
+        case SMSG_MOVE:
+        case SMSG_GAME_OVER:
+        case SMSG_OPPONENT_LEFT:
+            break;
+        default:
             printf("[DEBUG] Messaggio ricevuto dal thread: %s\n", message);
-        }
+            break;
     }
 }
 
@@ -405,9 +417,12 @@ int network_register_name(NetworkConnection *conn, const char *name) {
     }
 
     char msg[MAX_MSG_SIZE];
-    snprintf(msg, sizeof(msg), "REGISTER:%s", name);
+    if (!command_encode_register(msg, sizeof(msg), "%s", name)) {
+        set_error("Nome troppo lungo");
+        return 0;
+    }
 
-    if (send(conn->tcp_sock, msg, strlen(msg), 0) == SOCKET_ERROR_VALUE) {
+    if (!network_send(conn, msg, 0)) {
         set_error("Invio nome fallito");
         return 0;
     }
@@ -416,7 +431,14 @@ int network_register_name(NetworkConnection *conn, const char *name) {
     network_set_timeout(conn->tcp_sock, 10); 
 
     char response[MAX_MSG_SIZE];
-    int bytes = recv(conn->tcp_sock, response, sizeof(response) - 1, 0);
+    Message reply;
+    int bytes = network_receive_message(conn, response, sizeof(response), &reply);
+    
+    // Alla prima registrazione il token del canale UDP precede la conferma
+    if (bytes > 0 && reply.type == SMSG_UDP_SESSION) {
+        conn->udp_token = strtoull(reply.text, NULL, 16);
+        bytes = network_receive_message(conn, response, sizeof(response), &reply);
+    }
     if (bytes <= 0) {
         char err_msg[256];
 #ifdef _WIN32
@@ -428,10 +450,9 @@ int network_register_name(NetworkConnection *conn, const char *name) {
         set_error(err_msg);
         return 0;
     }
-    response[bytes] = '\0';
 
     
-    if (strstr(response, "OK:") != NULL || strstr(response, "OK") != NULL) {
+    if (reply.type == SMSG_OK) {
         
         if (network_set_timeout(conn->tcp_sock, 60) != 0) {
             set_error("Impossibile impostare timeout connessione");
@@ -440,9 +461,13 @@ int network_register_name(NetworkConnection *conn, const char *name) {
         
         strncpy(conn->player_name, name, sizeof(conn->player_name) - 1);
         conn->player_name[sizeof(conn->player_name) - 1] = '\0';
+        
+        if (!network_udp_register(conn)) {
+            printf("Canale UDP non disponibile, mosse ed eventi passano da TCP\n");
+        }
         return 1;
     } 
-    else if (strstr(response, "ERROR") != NULL) {
+    else if (reply.type == SMSG_ERROR) {
         
         set_error(response);
         return 0;
@@ -456,9 +481,16 @@ int network_register_name(NetworkConnection *conn, const char *name) {
     }
 }
 
-int network_create_game(NetworkConnection *conn) {
-    const char *msg = "CREATE_GAME";
-    if (send(conn->tcp_sock, msg, strlen(msg), 0) == SOCKET_ERROR_VALUE) {
+int network_create_game(NetworkConnection *conn, int rows, int cols, int k) {
+    char msg[MAX_MSG_SIZE];
+    // Il Tris classico è la variante predefinita del server: basta il verbo
+    if (rows == BOARD_SIDE && cols == BOARD_SIDE && k == BOARD_SIDE) {
+        snprintf(msg, sizeof(msg), "%s", command_verb(CMD_CREATE_GAME));
+    } else {
+        command_encode_create_game(msg, sizeof(msg), rows, cols, k);
+    }
+    
+    if (!network_send(conn, msg, 0)) {
         set_error("Invio richiesta creazione partita fallito");
         return 0;
     }
@@ -467,37 +499,223 @@ int network_create_game(NetworkConnection *conn) {
 
 int network_join_game(NetworkConnection *conn, int game_id) {
     char msg[MAX_MSG_SIZE];
-    snprintf(msg, sizeof(msg), "JOIN_GAME:%d", game_id);
+    command_encode_join(msg, sizeof(msg), game_id);
     
-    if (send(conn->tcp_sock, msg, strlen(msg), 0) == SOCKET_ERROR_VALUE) {
+    if (!network_send(conn, msg, 0)) {
         set_error("Invio richiesta join partita fallito");
         return 0;
     }
     return 1;
 }
 
-int network_send_move(NetworkConnection *conn, int move) {
-    if (conn->udp_sock == INVALID_SOCKET_VALUE) {
-        set_error("Connessione UDP non inizializzata");
-        return 0;
-    }
+/**
+ * Restituisce il tempo monotono in millisecondi (ritrasmissioni UDP).
+ */
+static long long network_now_ms(void) {
+#ifdef _WIN32
+    return (long long)GetTickCount64();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+#endif
+}
 
-    struct sockaddr_in server_addr;
-    memset(&server_addr, 0, sizeof(server_addr));
-    server_addr.sin_family = AF_INET;
-    server_addr.sin_port = htons(SERVER_PORT);
-    inet_pton(AF_INET, SERVER_IP, &server_addr.sin_addr);
+/**
+ * Legge il timeout di ricezione impostato su un socket (SO_RCVTIMEO).
+ * 
+ * @param sock Socket da interrogare
+ * @return Timeout in millisecondi, -1 se assente (attesa illimitata)
+ */
+static int network_get_timeout_ms(socket_t sock) {
+#ifdef _WIN32
+    DWORD timeout = 0;
+    int len = sizeof(timeout);
+    if (getsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, (char*)&timeout, &len) != 0 || timeout == 0) return -1;
+    return (int)timeout;
+#else
+    struct timeval tv;
+    socklen_t len = sizeof(tv);
+    if (getsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &tv, &len) != 0 || (tv.tv_sec == 0 && tv.tv_usec == 0)) return -1;
+    return (int)(tv.tv_sec * 1000 + tv.tv_usec / 1000);
+#endif
+}
 
-    char msg[16];
-    snprintf(msg, sizeof(msg), "MOVE:%d", move);
+/**
+ * Conferma al server l'ultima sequenza ricevuta in ordine sul canale UDP.
+ */
+static void udp_send_ack(NetworkConnection *conn) {
+    char ack[32];
+    if (command_encode_ack(ack, sizeof(ack), (int)conn->udp_recv_seq)) {
+        network_send(conn, ack, 1);
+    }
+}
 
-    ssize_t result;
+/**
+ * Legge un datagramma dal socket UDP (già leggibile) e lo gestisce:
+ * un evento SEQ nuovo viene confermato e conservato in udp_event, un
+ * duplicato viene solo confermato, un ACK chiude il comando in attesa.
+ * 
+ * @param conn Connessione di rete
+ * @return 1 se è disponibile un nuovo evento, 0 altrimenti
+ */
+static int udp_receive_datagram(NetworkConnection *conn) {
+    char buffer[UDP_EVENT_SIZE];
+    struct sockaddr_in from_addr;
+    socklen_t from_len = sizeof(from_addr);
+    int bytes;
+    
     do {
-        result = sendto(conn->udp_sock, msg, strlen(msg), 0, 
-                       (struct sockaddr *)&server_addr, sizeof(server_addr));
-    } while (result == -1 && errno == EINTR);  
+        bytes = recvfrom(conn->udp_sock, buffer, sizeof(buffer) - 1, 0,
+                         (struct sockaddr*)&from_addr, &from_len);
+    } while (bytes == -1 && errno == EINTR);
+    if (bytes <= 0) return 0;
+    buffer[bytes] = '\0';
+    
+    Message msg;
+    message_decode(buffer, (size_t)bytes, &msg);
+    switch (msg.type) {
+        case SMSG_SEQ:
+            // Solo l'evento successivo all'ultimo ricevuto e con udp_event libero (un evento
+            // trattenuto fino a GAME_START non va sovrascritto): il server ritrasmette gli altri
+            if (msg.seq == conn->udp_recv_seq + 1 && conn->udp_event_len == 0 &&
+                msg.text_len < sizeof(conn->udp_event)) {
+                conn->udp_recv_seq = msg.seq;
+                memcpy(conn->udp_event, msg.text, msg.text_len);
+                conn->udp_event[msg.text_len] = '\0';
+                conn->udp_event_len = (int)msg.text_len;
+            }
+            udp_send_ack(conn);
+            return conn->udp_event_len > 0 && conn->udp_in_game;
+        case SMSG_ACK:
+            if (conn->udp_pending[0] && (unsigned long)msg.value >= conn->udp_send_seq) {
+                conn->udp_pending[0] = '\0';
+            }
+            return 0;
+        default:
+            // Altri messaggi sul canale UDP: ignorati
+            return 0;
+    }
+}
+
+/**
+ * Calcola quanto manca alla ritrasmissione del comando in attesa di ACK
+ * (l'attesa raddoppia a ogni tentativo).
+ * 
+ * @param conn Connessione di rete
+ * @return Millisecondi alla scadenza (0 se già scaduta), -1 se non ci sono comandi in attesa
+ */
+static int udp_retransmit_due_ms(NetworkConnection *conn) {
+    if (!conn->udp_pending[0]) return -1;
+    
+    long long due = conn->udp_pending_sent + ((long long)UDP_RTO_MS << conn->udp_pending_retries);
+    long long left = due - network_now_ms();
+    return left > 0 ? (int)left : 0;
+}
+
+/**
+ * Ritrasmette il comando in attesa di ACK se il suo timeout è scaduto.
+ * Dopo UDP_MAX_RETRIES ritrasmissioni il comando viene inviato su TCP.
+ * 
+ * @param conn Connessione di rete
+ */
+static void udp_check_retransmit(NetworkConnection *conn) {
+    if (udp_retransmit_due_ms(conn) != 0) return;
+    
+    if (conn->udp_pending_retries >= UDP_MAX_RETRIES) {
+        network_send(conn, conn->udp_pending + conn->udp_pending_text, 0);
+        conn->udp_pending[0] = '\0';
+        return;
+    }
     
-    if (result == SOCKET_ERROR_VALUE) {
+    conn->udp_pending_retries++;
+    conn->udp_pending_sent = network_now_ms();
+    network_send(conn, conn->udp_pending, 1);
+}
+
+/**
+ * Apre il canale UDP affidabile ("<token>:UDP_REGISTER"): il token
+ * ricevuto con UDP_SESSION identifica il client, come in ogni datagramma
+ * successivo (vedi network_send()).
+ * 
+ * @param conn Connessione registrata
+ * @return 1 se il server ha confermato con UDP_REGISTERED, 0 altrimenti
+ *         (il client continua solo su TCP)
+ */
+static int network_udp_register(NetworkConnection *conn) {
+    char msg[MAX_MSG_SIZE];
+    if (!conn->udp_token || conn->udp_sock == INVALID_SOCKET_VALUE ||
+        !command_encode_udp_register(msg, sizeof(msg))) {
+        return 0;
+    }
+    
+    for (int attempt = 0; attempt < UDP_REGISTER_ATTEMPTS; attempt++) {
+        if (!network_send(conn, msg, 1)) return 0;
+        
+        fd_set read_fds;
+        FD_ZERO(&read_fds);
+        FD_SET(conn->udp_sock, &read_fds);
+        struct timeval tv;
+        tv.tv_sec = 0;
+        tv.tv_usec = UDP_REGISTER_WAIT_MS * 1000;
+        if (select(conn->udp_sock + 1, &read_fds, NULL, NULL, &tv) <= 0) continue;
+        
+        char reply[UDP_EVENT_SIZE];
+        int bytes = recvfrom(conn->udp_sock, reply, sizeof(reply) - 1, 0, NULL, NULL);
+        if (bytes <= 0) continue;
+        reply[bytes] = '\0';
+        
+        Message answer;
+        message_decode(reply, (size_t)bytes, &answer);
+        if (answer.type == SMSG_UDP_REGISTERED) {
+            // Le sequenze proseguono dalla base del server: i datagrammi ritardatari restano vecchi
+            unsigned long base = (unsigned long)answer.value;
+            conn->udp_active = 1;
+            if (conn->udp_send_seq < base) conn->udp_send_seq = base;
+            conn->udp_recv_seq = base;
+            conn->udp_pending[0] = '\0';
+            conn->udp_event_len = 0;
+            return 1;
+        }
+        if (answer.type == SMSG_ERROR) {
+            set_error(reply);
+            return 0;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Invia una mossa. Con il canale UDP aperto parte come comando
+ * sequenziato ("SEQ:<n>:MOVE:<riga>,<colonna>") e viene ritrasmessa fino
+ * all'ACK dal ciclo di ricezione; altrimenti viaggia su TCP.
+ * 
+ * @param conn Connessione di rete
+ * @param row Riga della mossa (0-2)
+ * @param col Colonna della mossa (0-2)
+ * @return 1 se la mossa è stata inviata, 0 in caso di errore
+ * 
+ * @note Un solo comando alla volta è in attesa di ACK: se il precedente
+ *       non è ancora confermato la nuova mossa passa da TCP
+ */
+int network_send_move(NetworkConnection *conn, int row, int col) {
+    char msg[32];
+    command_encode_move(msg, sizeof(msg), row, col);
+    
+    if (conn->udp_active && !conn->udp_pending[0]) {
+        int len = command_encode_seq(conn->udp_pending, sizeof(conn->udp_pending),
+                                     conn->udp_send_seq + 1, "%s", msg);
+        if (len > 0 && network_send(conn, conn->udp_pending, 1)) {
+            conn->udp_send_seq++;
+            conn->udp_pending_text = (size_t)len - strlen(msg);
+            conn->udp_pending_sent = network_now_ms();
+            conn->udp_pending_retries = 0;
+            return 1;
+        }
+        conn->udp_pending[0] = '\0';
+    }
+    
+    if (!network_send(conn, msg, 0)) {
         set_error("Invio mossa fallito");
         return 0;
     }
@@ -505,6 +723,137 @@ int network_send_move(NetworkConnection *conn, int move) {
 }
 
 
+/**
+ * Estrae il prossimo messaggio completo dal buffer circolare di ricezione.
+ * 
+ * @param conn Connessione di rete
+ * @param buffer Buffer di destinazione (messaggio senza terminatore)
+ * @param buf_size Dimensione del buffer di destinazione
+ * @return Lunghezza del messaggio, 0 se non c'è un messaggio completo,
+ *         -1 se il messaggio in attesa non entra nel buffer
+ * 
+ * @note Rimuove un eventuale '\r' finale e salta le righe vuote
+ */
+static int rx_next_message(NetworkConnection *conn, char *buffer, size_t buf_size) {
+    for (;;) {
+        if (conn->rx_scan < conn->rx_head) conn->rx_scan = conn->rx_head;
+        
+        while (conn->rx_scan < conn->rx_tail &&
+               conn->rx_buf[conn->rx_scan & (RX_BUFFER_SIZE - 1)] != MSG_DELIMITER) {
+            conn->rx_scan++;
+        }
+        
+        if (conn->rx_scan == conn->rx_tail) {
+            return (conn->rx_tail - conn->rx_head >= RX_BUFFER_SIZE) ? -1 : 0;
+        }
+        
+        size_t len = conn->rx_scan - conn->rx_head;
+        if (len >= buf_size) {
+            return -1;
+        }
+        
+        for (size_t i = 0; i < len; i++) {
+            buffer[i] = conn->rx_buf[(conn->rx_head + i) & (RX_BUFFER_SIZE - 1)];
+        }
+        if (len > 0 && buffer[len - 1] == '\r') len--;
+        buffer[len] = '\0';
+        
+        conn->rx_head = conn->rx_scan + 1;
+        conn->rx_scan = conn->rx_head;
+        
+        if (len > 0) return (int)len;
+    }
+}
+
+/**
+ * Verifica se nel buffer circolare è già presente un messaggio completo.
+ * 
+ * @param conn Connessione di rete
+ * @return 1 se c'è almeno un messaggio completo, 0 altrimenti
+ */
+static int rx_has_message(NetworkConnection *conn) {
+    for (size_t i = conn->rx_head; i < conn->rx_tail; i++) {
+        if (conn->rx_buf[i & (RX_BUFFER_SIZE - 1)] == MSG_DELIMITER) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Attende che sia disponibile un messaggio dal server.
+ * Sostituisce select() sul socket TCP: un messaggio può essere già nel
+ * buffer di ricezione (arrivato insieme ad altri) senza che il socket
+ * risulti leggibile.
+ * Con il canale UDP aperto attende anche i datagrammi: gli eventi vengono
+ * confermati e conservati per network_receive_message(), gli ACK chiudono
+ * la mossa in attesa, che intanto viene ritrasmessa se necessario.
+ * 
+ * @param conn Connessione di rete
+ * @param timeout_ms Attesa massima in millisecondi (0 = controllo immediato,
+ *                   negativo = nessun limite)
+ * @return 1 se un messaggio è pronto o il socket è leggibile, 0 in caso di timeout,
+ *         -1 in caso di errore
+ */
+int network_wait_message(NetworkConnection *conn, int timeout_ms) {
+    if (!conn || conn->tcp_sock == INVALID_SOCKET_VALUE) {
+        set_error("Connessione non valida");
+        return -1;
+    }
+    
+    if ((conn->udp_event_len > 0 && conn->udp_in_game) || rx_has_message(conn)) {
+        return 1;
+    }
+    
+    int use_udp = conn->udp_active && conn->udp_sock != INVALID_SOCKET_VALUE;
+    long long deadline = network_now_ms() + timeout_ms;
+    for (;;) {
+        int wait_ms = timeout_ms;
+        if (timeout_ms > 0) {
+            long long left = deadline - network_now_ms();
+            wait_ms = left > 0 ? (int)left : 0;
+        }
+        int retransmit_ms = use_udp ? udp_retransmit_due_ms(conn) : -1;
+        if (retransmit_ms >= 0 && (wait_ms < 0 || retransmit_ms < wait_ms)) {
+            wait_ms = retransmit_ms;
+        }
+        
+        fd_set read_fds;
+        FD_ZERO(&read_fds);
+        FD_SET(conn->tcp_sock, &read_fds);
+        if (use_udp) FD_SET(conn->udp_sock, &read_fds);
+        socket_t max_fd = (use_udp && conn->udp_sock > conn->tcp_sock) ? conn->udp_sock : conn->tcp_sock;
+        
+        struct timeval tv;
+        tv.tv_sec = wait_ms / 1000;
+        tv.tv_usec = (wait_ms % 1000) * 1000;
+        
+        int result;
+#ifdef _WIN32
+        result = select(0, &read_fds, NULL, NULL, wait_ms < 0 ? NULL : &tv);
+#else
+        result = select(max_fd + 1, &read_fds, NULL, NULL, wait_ms < 0 ? NULL : &tv);
+#endif
+        if (result == -1 && errno == EINTR) continue;
+        if (result < 0) {
+            set_error("Errore in select");
+            return -1;
+        }
+        
+        if (result > 0 && use_udp && FD_ISSET(conn->udp_sock, &read_fds) && udp_receive_datagram(conn)) {
+            return 1;
+        }
+        if (result > 0 && FD_ISSET(conn->tcp_sock, &read_fds)) {
+            return 1;
+        }
+        // Dopo la lettura: un ACK già arrivato evita la ritrasmissione
+        if (use_udp) udp_check_retransmit(conn);
+        if (timeout_ms == 0 || (timeout_ms > 0 && network_now_ms() >= deadline)) {
+            return 0;
+        }
+    }
+}
+
 int network_flush_receive_buffer(NetworkConnection *conn) {
     if (conn->tcp_sock == INVALID_SOCKET_VALUE) {
         set_error("Connessione non inizializzata");
@@ -512,16 +861,20 @@ int network_flush_receive_buffer(NetworkConnection *conn) {
     }
 
     
+    // Scarta anche i dati già accumulati nel buffer circolare e l'evento UDP in attesa
+    int total_flushed = (int)(conn->rx_tail - conn->rx_head);
+    conn->rx_head = conn->rx_scan = conn->rx_tail;
+    conn->udp_event_len = 0;
+    
     int flags = fcntl(conn->tcp_sock, F_GETFL, 0);
     fcntl(conn->tcp_sock, F_SETFL, flags | O_NONBLOCK);
     
     char temp_buffer[1024];
-    int total_flushed = 0;
     int bytes_read;
     
     
     do {
-        bytes_read = recv(conn->tcp_sock, temp_buffer, sizeof(temp_buffer), 0);
+        bytes_read = recv(conn->tcp_sock, temp_buffer, sizeof(temp_buffer) - 1, 0);
         if (bytes_read > 0) {
             total_flushed += bytes_read;
             temp_buffer[bytes_read] = '\0';
@@ -547,86 +900,153 @@ int network_receive(NetworkConnection *conn, char *buffer, size_t buf_size, int
         return -1;
     }
 
-retry_receive:
-    socket_t sock = use_udp ? conn->udp_sock : conn->tcp_sock;
     int bytes;
     
-    
     if (use_udp) {
+        // UDP: ogni datagramma è già un messaggio completo
         struct sockaddr_in from_addr;
         socklen_t from_len = sizeof(from_addr);
         do {
-            bytes = recvfrom(sock, buffer, buf_size - 1, 0, 
+            bytes = recvfrom(conn->udp_sock, buffer, buf_size - 1, 0, 
                            (struct sockaddr*)&from_addr, &from_len);
-        } while (bytes == -1 && errno == EINTR);  
+        } while (bytes == -1 && errno == EINTR);
+        
+        if (bytes > 0) {
+            buffer[bytes] = '\0';
+            buffer[strcspn(buffer, "\r\n")] = '\0';
+            return strlen(buffer);
+        }
+        if (bytes == 0) return 0;
     } else {
-        do {
-            bytes = recv(sock, buffer, buf_size - 1, 0);
-            if (bytes == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+        // TCP: estrae un messaggio alla volta dal buffer circolare,
+        // leggendo dal socket solo quando non ce ne sono di completi
+        for (;;) {
+            int len = rx_next_message(conn, buffer, buf_size);
+            if (len < 0) {
+                set_error("Messaggio dal server troppo lungo");
+                return -1;
+            }
+            if (len > 0) {
+                printf("[DEBUG_RECV] Ricevuto: '%s'\n", buffer);
                 
-                usleep(10000); 
+                if (strcmp(buffer, "PING") == 0) {
+                    printf("[DEBUG_RECV] Auto-risposta a PING\n");
+                    network_send(conn, "PONG", use_udp);
+                    continue;
+                }
+                if (strcmp(buffer, "PONG") == 0) {
+                    printf("[DEBUG_RECV] Ignoro PONG\n");
+                    continue;
+                }
+                return len;
             }
-        } while (bytes == -1 && (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK));
-    }
-    
-    if (bytes > 0) {
-        buffer[bytes] = '\0';  
-        
-        
-        char *newline = strchr(buffer, '\n');
-        if (newline) *newline = '\0';
-        
-        
-        printf("[DEBUG_RECV] Ricevuto: '%s'\n", buffer);
-        
-        
-        if (strcmp(buffer, "PING") == 0) {
-            printf("[DEBUG_RECV] Auto-risposta a PING\n");
-            network_send(conn, "PONG", use_udp);
-            goto retry_receive; 
-        }
-        if (strcmp(buffer, "PONG") == 0) {
-            printf("[DEBUG_RECV] Ignoro PONG\n");
-            goto retry_receive; 
+            
+            size_t start = conn->rx_tail & (RX_BUFFER_SIZE - 1);
+            size_t space = RX_BUFFER_SIZE - (conn->rx_tail - conn->rx_head);
+            if (space > RX_BUFFER_SIZE - start) space = RX_BUFFER_SIZE - start;
+            
+            do {
+                bytes = recv(conn->tcp_sock, conn->rx_buf + start, space, 0);
+            } while (bytes == -1 && errno == EINTR);
+            
+            if (bytes <= 0) break;
+            conn->rx_tail += (size_t)bytes;
         }
-
-        return strlen(buffer);  
-    } 
-    else if (bytes == 0) {
         
-        if (!use_udp) {
+        if (bytes == 0) {
             set_error("Connessione chiusa dal server");
             strcpy(buffer, "SERVER_DOWN");
+            return 0;
         }
-        return 0;
-    } 
-    else {
-        
+    }
+    
 #ifdef _WIN32
-        int error = WSAGetLastError();
-        if (error == WSAEWOULDBLOCK || error == WSAETIMEDOUT) {
-            return 0;  
-        }
-        char err_msg[256];
-        snprintf(err_msg, sizeof(err_msg), "Errore ricezione: %d", error);
-        set_error(err_msg);
+    int error = WSAGetLastError();
+    if (error == WSAEWOULDBLOCK || error == WSAETIMEDOUT) {
+        return 0;  
+    }
+    char err_msg[256];
+    snprintf(err_msg, sizeof(err_msg), "Errore ricezione: %d", error);
+    set_error(err_msg);
 #else
-        if (errno == EAGAIN || errno == EWOULDBLOCK) {
-            return 0;  
-        }
-        if (errno == EINTR) {
-            
-            printf("[DEBUG] System call interrotta da segnale, riprovo...\n");
-            goto retry_receive;
-        }
-        char err_msg[256];
-        snprintf(err_msg, sizeof(err_msg), "Errore ricezione: %s", strerror(errno));
-        set_error(err_msg);
+    if (errno == EAGAIN || errno == EWOULDBLOCK) {
+        return 0;  
+    }
+    char err_msg[256];
+    snprintf(err_msg, sizeof(err_msg), "Errore ricezione: %s", strerror(errno));
+    set_error(err_msg);
 #endif
-        return -1;
+    return -1;
+}
+
+/**
+ * Tiene traccia dell'inizio e della fine delle partite. Il primo evento
+ * UDP di una partita può precedere GAME_START, che viaggia su TCP: fino a
+ * GAME_START l'evento resta in udp_event e viene consegnato subito dopo.
+ * 
+ * @param conn Connessione di rete
+ * @param msg Messaggio appena consegnato
+ */
+static void udp_track_game(NetworkConnection *conn, const Message *msg) {
+    switch (msg->type) {
+        case SMSG_GAME_START:
+            conn->udp_in_game = 1;
+            break;
+        case SMSG_GAME_OVER:
+        case SMSG_OPPONENT_LEFT:
+        case SMSG_LEFT_GAME:
+        case SMSG_GAME_CANCELED:
+        case SMSG_GAME_CANCELLED:
+            // Gli eventi successivi appartengono alla prossima partita (anche una rivincita)
+            conn->udp_in_game = 0;
+            break;
+        default:
+            break;
     }
 }
 
+/**
+ * Riceve il prossimo messaggio del server e lo decodifica: un evento del
+ * canale UDP affidabile se disponibile, altrimenti un messaggio TCP.
+ * 
+ * @param conn Connessione di rete
+ * @param buffer Buffer per il testo del messaggio (i campi di msg puntano qui dentro)
+ * @param buf_size Dimensione del buffer
+ * @param msg Messaggio decodificato, valido solo se il risultato è > 0
+ * @return Come network_receive()
+ * 
+ * @note Con il canale UDP aperto l'attesa rispetta il timeout di ricezione
+ *       del socket TCP (SO_RCVTIMEO) e serve intanto ACK e ritrasmissioni
+ * @note Gli eventi UDP arrivati prima di GAME_START vengono consegnati dopo
+ *       di esso (vedi udp_track_game())
+ */
+int network_receive_message(NetworkConnection *conn, char *buffer, size_t buf_size, Message *msg) {
+    if (conn && conn->udp_active) {
+        int ready = network_wait_message(conn, network_get_timeout_ms(conn->tcp_sock));
+        if (ready <= 0) return ready;
+        
+        if (conn->udp_event_len > 0 && conn->udp_in_game) {
+            if ((size_t)conn->udp_event_len >= buf_size) {
+                set_error("Messaggio dal server troppo lungo");
+                return -1;
+            }
+            int len = conn->udp_event_len;
+            memcpy(buffer, conn->udp_event, (size_t)len + 1);
+            conn->udp_event_len = 0;
+            message_decode(buffer, (size_t)len, msg);
+            udp_track_game(conn, msg);
+            return len;
+        }
+    }
+    
+    int len = network_receive(conn, buffer, buf_size, 0);
+    if (len > 0) {
+        message_decode(buffer, (size_t)len, msg);
+        udp_track_game(conn, msg);
+    }
+    return len;
+}
+
 int network_send(NetworkConnection *conn, const char *message, int use_udp) {
     if (!conn || !message) {
         return 0;
@@ -642,9 +1062,19 @@ int network_send(NetworkConnection *conn, const char *message, int use_udp) {
         server_addr.sin_port = htons(SERVER_PORT);
         inet_pton(AF_INET, SERVER_IP, &server_addr.sin_addr);
         
+        // Il token di sessione apre ogni datagramma: il server riconosce il
+        // client anche se il suo indirizzo UDP cambia (NAT, cambio di rete)
+        char datagram[MAX_MSG_SIZE];
+        int len = conn->udp_token
+            ? snprintf(datagram, sizeof(datagram), "%0*llx:%s", UDP_TOKEN_DIGITS, conn->udp_token, message)
+            : snprintf(datagram, sizeof(datagram), "%s", message);
+        if (len < 0 || (size_t)len >= sizeof(datagram)) {
+            return 0;
+        }
+        
         ssize_t result;
         do {
-            result = sendto(conn->udp_sock, message, strlen(message), 0,
+            result = sendto(conn->udp_sock, datagram, (size_t)len, 0,
                            (struct sockaddr*)&server_addr, sizeof(server_addr));
         } while (result == -1 && errno == EINTR);  
         
@@ -687,9 +1117,7 @@ const char *network_get_error() {
 }
 
 int network_request_rematch(NetworkConnection *conn) {
-    const char *msg = "REMATCH";
-    
-    if (send(conn->tcp_sock, msg, strlen(msg), 0) == SOCKET_ERROR_VALUE) {
+    if (!network_send(conn, command_verb(CMD_REMATCH), 0)) {
         set_error("Invio richiesta rematch fallito");
         return 0;
     }
@@ -698,9 +1126,9 @@ int network_request_rematch(NetworkConnection *conn) {
 
 int network_approve_join(NetworkConnection *conn, int approve) {
     char msg[32];
-    snprintf(msg, sizeof(msg), "APPROVE:%d", approve);
+    command_encode_approve(msg, sizeof(msg), approve ? 1 : 0);
     
-    if (send(conn->tcp_sock, msg, strlen(msg), 0) == SOCKET_ERROR_VALUE) {
+    if (!network_send(conn, msg, 0)) {
         set_error("Invio approvazione join fallito");
         return 0;
     }
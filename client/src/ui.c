@@ -105,30 +105,117 @@ int ui_show_main_menu() {
 
 /**
  * Visualizza il tabellone di gioco in formato grafico ASCII.
- * Mostra una griglia 3x3 con i simboli dei giocatori e separatori.
+ * Mostra una griglia righe x colonne con i simboli dei giocatori e separatori.
  * 
- * @param board Tabellone 3x3 da visualizzare
+ * @param board Tabellone da visualizzare (vedi board.h)
  * 
  * @note Pulisce lo schermo prima di mostrare il tabellone
- * @note Formato di output:
+ * @note Formato di output del Tris classico:
  *        X | O |   
  *       ---+---+---
  *        O | X | X
  *       ---+---+---
  *          | O |   
+ * @note Le altre varianti numerano righe e colonne (da 1) per l'inserimento
+ *       della mossa con ui_get_player_cell()
  * @note Aggiunge spazi e righe vuote per migliorare la leggibilità
  */
-void ui_show_board(const char board[3][3]) {
+void ui_show_board(const Board *board) {
+    int classic = board_is_classic(board);
+    
     ui_clear_screen();
     printf("\n");
-    printf(" %c | %c | %c \n", board[0][0], board[0][1], board[0][2]);
-    printf("---+---+---\n");
-    printf(" %c | %c | %c \n", board[1][0], board[1][1], board[1][2]);
-    printf("---+---+---\n");
-    printf(" %c | %c | %c \n", board[2][0], board[2][1], board[2][2]);
+    if (!classic) {
+        printf("    ");
+        for (int col = 0; col < board->cols; col++) printf(" %-3d", col + 1);
+        printf("\n");
+    }
+    for (int row = 0; row < board->rows; row++) {
+        if (!classic) printf("%3d ", row + 1);
+        for (int col = 0; col < board->cols; col++) {
+            printf(" %c %s", board_get(board, row, col), col < board->cols - 1 ? "|" : "\n");
+        }
+        if (row < board->rows - 1) {
+            if (!classic) printf("    ");
+            for (int col = 0; col < board->cols; col++) printf("---%s", col < board->cols - 1 ? "+" : "\n");
+        }
+    }
     printf("\n");
 }
 
+/**
+ * Richiede la mossa come riga e colonna (varianti diverse dal Tris classico).
+ * 
+ * @param board Tabellone della partita (per i limiti delle coordinate)
+ * @param row Riga scelta (da 0)
+ * @param col Colonna scelta (da 0)
+ * @return 1 se è stata scelta una cella, 0 per uscire
+ * 
+ * @note L'utente inserisce le coordinate da 1 come mostrate da ui_show_board()
+ * @note Non verifica che la cella sia libera: lo fa game_is_valid_move()
+ */
+int ui_get_player_cell(const Board *board, int *row, int *col) {
+    char input[32];
+    
+    while (1) {
+        printf("\nInserisci riga e colonna (es. 3 5) o 0 per uscire: ");
+        fflush(stdout);
+        
+        if (fgets(input, sizeof(input), stdin) == NULL) {
+            return 0;
+        }
+        
+        int r, c;
+        int fields = sscanf(input, "%d %d", &r, &c);
+        if (fields >= 1 && r == 0) {
+            return 0;
+        }
+        if (fields == 2 && r >= 1 && r <= board->rows && c >= 1 && c <= board->cols) {
+            *row = r - 1;
+            *col = c - 1;
+            return 1;
+        }
+        
+        printf("Coordinate non valide! Righe 1-%d, colonne 1-%d.\n", board->rows, board->cols);
+    }
+}
+
+/**
+ * Richiede la variante della partita da creare.
+ * 
+ * @param rows Righe scelte
+ * @param cols Colonne scelte
+ * @param k Simboli da allineare scelti
+ * @return 1 se è stata scelta una variante valida, 0 in caso di errore di input
+ * 
+ * @note Invio senza valori sceglie il Tris classico (3x3, allineamento 3)
+ * @note Ripete la richiesta finché la variante non è valida (vedi board_variant_valid())
+ */
+int ui_get_game_variant(int *rows, int *cols, int *k) {
+    char input[32];
+    
+    while (1) {
+        printf("\nVariante: righe colonne allineamento (es. 15 15 5 per il Gomoku),\n");
+        printf("Invio per il Tris classico: ");
+        fflush(stdout);
+        
+        if (fgets(input, sizeof(input), stdin) == NULL) {
+            return 0;
+        }
+        
+        if (input[strspn(input, " \t\r\n")] == '\0') {
+            *rows = *cols = *k = BOARD_SIDE;
+            return 1;
+        }
+        if (sscanf(input, "%d %d %d", rows, cols, k) == 3 && board_variant_valid(*rows, *cols, *k)) {
+            return 1;
+        }
+        
+        printf("Variante non valida! Lati tra %d e %d, allineamento tra %d e il lato maggiore.\n",
+               BOARD_MIN_SIDE, BOARD_MAX_SIDE, BOARD_MIN_SIDE);
+    }
+}
+
 // Sostituisci la funzione ui_get_player_move in ui.c
 
 /**
@@ -184,6 +271,36 @@ void ui_show_message(const char *message) {
     getch();
 }
 
+/**
+ * Mostra la pagina della lista partite nota al client.
+ * Per ogni partita riporta ID, stato e giocatori; solo le partite in attesa
+ * accettano richieste di join.
+ * 
+ * @param list Copia locale della pagina
+ * 
+ * @note Non attende la pressione di un tasto: di solito segue la richiesta dell'ID
+ */
+void ui_show_game_list(const LobbyList *list) {
+    printf("\n=== PARTITE DISPONIBILI (%s) ===\n", lobby_list_filter_name(list->filter));
+    if (list->count == 0) {
+        printf("Nessuna partita disponibile al momento\n");
+    } else {
+        printf("Partite %d-%d di %d\n", list->offset + 1, list->offset + list->count, list->total);
+    }
+    for (int i = 0; i < list->count; i++) {
+        const LobbyGame *game = &list->games[i];
+        const char *variant = game->variant[0] ? game->variant : "3x3x3";
+        if (game->state == LOBBY_GAME_WAITING) {
+            printf("  %d - %s (%s, %s)\n", game->game_id, game->player1,
+                   lobby_list_state_name(game->state), variant);
+        } else {
+            printf("  %d - %s vs %s (%s, %s)\n", game->game_id, game->player1, game->player2,
+                   lobby_list_state_name(game->state), variant);
+        }
+    }
+    printf("===========================\n");
+}
+
 /**
  * Mostra un messaggio di errore con formattazione speciale e attende conferma.
  * Evidenzia il messaggio come errore con il prefisso "ERRORE:".
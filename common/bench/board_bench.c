@@ -0,0 +1,294 @@
+/*
+ * MICROBENCHMARK DEL TABELLONE A BITBOARD
+ *
+ * Confronta il controllo di vittoria e di tabellone pieno su char[3][3]
+ * (8 confronti di linea e scansione delle 9 celle, come prima di board.h)
+ * con la tabella delle vittorie di board_mask_wins() e il confronto delle
+ * maschere con BOARD_FULL_MASK. Prima della misura verifica che le due
+ * versioni diano lo stesso risultato su tutte le 3^9 disposizioni, anche
+ * rispetto al vincitore calcolato mossa per mossa da board_place().
+ *
+ * La seconda parte confronta la scansione completa di board_scan() (vincitore
+ * e minacce) con la stessa scansione cella per cella su char[][], su
+ * posizioni casuali di diverse varianti m,n,k, poi misura sul 15x15x5 la
+ * versione cella per cella e ogni implementazione supportata dalla CPU.
+ *
+ * Compilazione: make bench (da server/), oppure
+ *   gcc -O2 -std=c99 -I.. board_bench.c ../board.c ../board_scan.c -o board_bench
+ */
+
+#include "board.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define BENCH_POSITIONS 19683           // 3^9 disposizioni delle celle
+#define BENCH_ROUNDS 2000               // Passate su tutte le disposizioni
+#define SCAN_POSITIONS 4096             // Posizioni casuali per variante
+#define SCAN_ROUNDS 50                  // Passate sulle posizioni del 15x15x5
+
+static char grids[BENCH_POSITIONS][3][3];
+static unsigned short masks_x[BENCH_POSITIONS];
+static unsigned short masks_o[BENCH_POSITIONS];
+static Board boards[BENCH_POSITIONS];
+static Board scan_boards[SCAN_POSITIONS];
+static char scan_grids[SCAN_POSITIONS][BOARD_MAX_SIDE][BOARD_MAX_SIDE];
+
+/**
+ * Varianti su cui si verifica la scansione; l'ultima è quella misurata.
+ */
+static const int scan_variants[][3] = {
+    { 3, 3, 3 }, { 4, 4, 3 }, { 6, 7, 4 }, { 15, 10, 7 }, { 9, 15, 15 }, { 15, 15, 5 }
+};
+
+/**
+ * Controllo di vittoria su char[3][3] (versione precedente).
+ */
+static char grid_winner(char g[3][3]) {
+    for (int i = 0; i < 3; i++) {
+        if (g[i][0] != BOARD_EMPTY && g[i][0] == g[i][1] && g[i][1] == g[i][2]) return g[i][0];
+    }
+    for (int j = 0; j < 3; j++) {
+        if (g[0][j] != BOARD_EMPTY && g[0][j] == g[1][j] && g[1][j] == g[2][j]) return g[0][j];
+    }
+    if (g[0][0] != BOARD_EMPTY && g[0][0] == g[1][1] && g[1][1] == g[2][2]) return g[0][0];
+    if (g[0][2] != BOARD_EMPTY && g[0][2] == g[1][1] && g[1][1] == g[2][0]) return g[0][2];
+    return BOARD_EMPTY;
+}
+
+/**
+ * Controllo di tabellone pieno su char[3][3] (versione precedente).
+ */
+static int grid_is_full(char g[3][3]) {
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 3; j++) {
+            if (g[i][j] == BOARD_EMPTY) return 0;
+        }
+    }
+    return 1;
+}
+
+/**
+ * Prepara tutte le disposizioni nelle due rappresentazioni.
+ */
+static void bench_fill(void) {
+    static const char symbols[3] = { BOARD_EMPTY, BOARD_X, BOARD_O };
+
+    for (int n = 0; n < BENCH_POSITIONS; n++) {
+        board_init(&boards[n], BOARD_SIDE, BOARD_SIDE, BOARD_SIDE);
+        int code = n;
+        for (int cell = 0; cell < BOARD_CELLS; cell++, code /= 3) {
+            char symbol = symbols[code % 3];
+            grids[n][cell / 3][cell % 3] = symbol;
+            if (symbol == BOARD_X) masks_x[n] |= (unsigned short)(1u << cell);
+            if (symbol == BOARD_O) masks_o[n] |= (unsigned short)(1u << cell);
+            if (symbol != BOARD_EMPTY) board_place(&boards[n], cell / 3, cell % 3, symbol);
+        }
+    }
+}
+
+/**
+ * Vincitore secondo la tabella delle vittorie.
+ */
+static char mask_winner(int n) {
+    if (board_mask_wins(masks_x[n])) return BOARD_X;
+    if (board_mask_wins(masks_o[n])) return BOARD_O;
+    return BOARD_EMPTY;
+}
+
+/**
+ * Verifica che le versioni concordino su ogni disposizione. Con entrambi
+ * i giocatori vincenti (disposizione impossibile in partita) conta solo
+ * che tutte riconoscano una vittoria: l'ordine di controllo differisce.
+ *
+ * @return Numero di disposizioni in disaccordo
+ */
+static int bench_verify(void) {
+    int mismatches = 0;
+    for (int n = 0; n < BENCH_POSITIONS; n++) {
+        char old_winner = grid_winner(grids[n]);
+        char table_winner = mask_winner(n);
+        char move_winner = board_winner(&boards[n]);
+        int both_win = board_mask_wins(masks_x[n]) && board_mask_wins(masks_o[n]);
+        int full = grid_is_full(grids[n]);
+        if (both_win ? (old_winner == BOARD_EMPTY || move_winner == BOARD_EMPTY)
+                     : (old_winner != table_winner || old_winner != move_winner)) {
+            mismatches++;
+        } else if (full != ((masks_x[n] | masks_o[n]) == BOARD_FULL_MASK) || full != board_is_full(&boards[n])) {
+            mismatches++;
+        }
+    }
+    return mismatches;
+}
+
+static double bench_elapsed_ms(clock_t start) {
+    return (double)(clock() - start) * 1000.0 / CLOCKS_PER_SEC;
+}
+
+/**
+ * Scansione completa cella per cella su char[][] (riferimento).
+ */
+static void grid_scan(char g[BOARD_MAX_SIDE][BOARD_MAX_SIDE], int rows, int cols, int k, BoardScan *scan) {
+    static const int directions[4][2] = { { 0, 1 }, { 1, 0 }, { 1, 1 }, { 1, -1 } };
+    int win_x = 0, win_o = 0;
+
+    scan->threats_x = scan->threats_o = 0;
+    for (int r = 0; r < rows; r++) {
+        for (int c = 0; c < cols; c++) {
+            for (int d = 0; d < 4; d++) {
+                int end_r = r + directions[d][0] * (k - 1), end_c = c + directions[d][1] * (k - 1);
+                if (end_r >= rows || end_c < 0 || end_c >= cols) continue;
+                int x = 0, o = 0;
+                for (int i = 0; i < k; i++) {
+                    char cell = g[r + directions[d][0] * i][c + directions[d][1] * i];
+                    if (cell == BOARD_X) x++;
+                    else if (cell == BOARD_O) o++;
+                }
+                if (x == k) win_x = 1;
+                if (o == k) win_o = 1;
+                if (x == k - 1 && o == 0) scan->threats_x++;
+                if (o == k - 1 && x == 0) scan->threats_o++;
+            }
+        }
+    }
+    scan->winner = win_x ? BOARD_X : win_o ? BOARD_O : BOARD_EMPTY;
+}
+
+/**
+ * Prepara posizioni casuali di una variante nelle due rappresentazioni
+ * (circa un terzo delle celle per giocatore, senza badare all'ordine delle mosse).
+ */
+static void scan_fill(int rows, int cols, int k) {
+    for (int n = 0; n < SCAN_POSITIONS; n++) {
+        board_init(&scan_boards[n], rows, cols, k);
+        for (int r = 0; r < rows; r++) {
+            for (int c = 0; c < cols; c++) {
+                int roll = rand() % 3;
+                char symbol = roll == 0 ? BOARD_X : roll == 1 ? BOARD_O : BOARD_EMPTY;
+                scan_grids[n][r][c] = symbol;
+                if (symbol != BOARD_EMPTY) board_place(&scan_boards[n], r, c, symbol);
+            }
+        }
+    }
+}
+
+/**
+ * Verifica l'implementazione della scansione in uso su tutte le posizioni.
+ *
+ * @return Numero di posizioni in disaccordo con grid_scan()
+ */
+static int scan_verify(int rows, int cols, int k) {
+    int mismatches = 0;
+    for (int n = 0; n < SCAN_POSITIONS; n++) {
+        BoardScan expected, actual;
+        grid_scan(scan_grids[n], rows, cols, k, &expected);
+        board_scan(&scan_boards[n], &actual);
+        if (expected.winner != actual.winner || expected.threats_x != actual.threats_x ||
+            expected.threats_o != actual.threats_o) {
+            mismatches++;
+        }
+    }
+    return mismatches;
+}
+
+/**
+ * Verifica e misura la scansione completa.
+ *
+ * @return 1 se tutte le implementazioni concordano con il riferimento, 0 altrimenti
+ */
+static int bench_scan(void) {
+    static const char *impls[] = { "scalar", "sse2", "avx2" };
+    int variant_count = (int)(sizeof(scan_variants) / sizeof(scan_variants[0]));
+    volatile unsigned long sink = 0;
+    BoardScan scan;
+
+    srand(12345);
+    for (int v = 0; v < variant_count; v++) {
+        int rows = scan_variants[v][0], cols = scan_variants[v][1], k = scan_variants[v][2];
+        scan_fill(rows, cols, k);
+        for (int i = 0; i < 3; i++) {
+            if (!board_scan_select(impls[i])) continue;
+            int mismatches = scan_verify(rows, cols, k);
+            if (mismatches > 0) {
+                printf("ERRORE: scansione %s, variante %dx%dx%d: %d posizioni con risultato diverso\n",
+                       impls[i], rows, cols, k, mismatches);
+                return 0;
+            }
+        }
+    }
+    printf("Verifica scansione: %d varianti x %d posizioni, risultati identici\n", variant_count, SCAN_POSITIONS);
+
+    // Le posizioni rimaste sono quelle dell'ultima variante (15x15x5)
+    double positions = (double)SCAN_ROUNDS * SCAN_POSITIONS;
+    clock_t start = clock();
+    for (int r = 0; r < SCAN_ROUNDS; r++) {
+        for (int n = 0; n < SCAN_POSITIONS; n++) {
+            grid_scan(scan_grids[n], BOARD_MAX_SIDE, BOARD_MAX_SIDE, 5, &scan);
+            sink += (unsigned long)scan.threats_x;
+        }
+    }
+    double grid_ms = bench_elapsed_ms(start);
+    printf("scansione char[][]: %8.1f ms (%.0f ns per posizione)\n", grid_ms, grid_ms * 1e6 / positions);
+
+    for (int i = 0; i < 3; i++) {
+        if (!board_scan_select(impls[i])) continue;
+        start = clock();
+        for (int r = 0; r < SCAN_ROUNDS; r++) {
+            for (int n = 0; n < SCAN_POSITIONS; n++) {
+                board_scan(&scan_boards[n], &scan);
+                sink += (unsigned long)scan.threats_x;
+            }
+        }
+        double ms = bench_elapsed_ms(start);
+        printf("scansione %-8s: %8.1f ms (%.0f ns per posizione, %.1fx)\n",
+               impls[i], ms, ms * 1e6 / positions, ms > 0 ? grid_ms / ms : 0.0);
+    }
+
+    board_scan_select(NULL);
+    printf("Implementazione scelta per questa CPU: %s\n", board_scan_impl());
+    (void)sink;
+    return 1;
+}
+
+int main(void) {
+    bench_fill();
+
+    int mismatches = bench_verify();
+    if (mismatches > 0) {
+        printf("ERRORE: %d disposizioni con risultato diverso\n", mismatches);
+        return EXIT_FAILURE;
+    }
+    printf("Verifica: %d disposizioni, risultati identici\n", BENCH_POSITIONS);
+
+    // I risultati vengono accumulati perché il compilatore non elimini i cicli
+    volatile unsigned long sink = 0;
+    unsigned long acc = 0;
+
+    clock_t start = clock();
+    for (int r = 0; r < BENCH_ROUNDS; r++) {
+        for (int n = 0; n < BENCH_POSITIONS; n++) {
+            acc += (unsigned long)grid_winner(grids[n]) + (unsigned long)grid_is_full(grids[n]);
+        }
+    }
+    double grid_ms = bench_elapsed_ms(start);
+    sink += acc;
+
+    acc = 0;
+    start = clock();
+    for (int r = 0; r < BENCH_ROUNDS; r++) {
+        for (int n = 0; n < BENCH_POSITIONS; n++) {
+            acc += (unsigned long)mask_winner(n) + (unsigned long)((masks_x[n] | masks_o[n]) == BOARD_FULL_MASK);
+        }
+    }
+    double board_ms = bench_elapsed_ms(start);
+    sink += acc;
+
+    double checks = (double)BENCH_ROUNDS * BENCH_POSITIONS;
+    printf("char[3][3]: %8.1f ms (%.2f ns per controllo)\n", grid_ms, grid_ms * 1e6 / checks);
+    printf("bitboard:   %8.1f ms (%.2f ns per controllo)\n", board_ms, board_ms * 1e6 / checks);
+    if (board_ms > 0) printf("Accelerazione: %.1fx\n", grid_ms / board_ms);
+    (void)sink;
+
+    printf("\n");
+    return bench_scan() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,200 @@
+#include "board.h"
+#include <string.h>
+
+/**
+ * Tabella delle vittorie: il bit m è a 1 se la maschera m (9 bit) contiene
+ * una delle 8 linee vincenti (righe 0x007 0x038 0x1C0, colonne 0x049 0x092
+ * 0x124, diagonali 0x111 0x054). 512 bit in 8 parole da 64.
+ */
+static const unsigned long long board_win_table[8] = {
+    0xff80808080808080ULL, 0xfff0aa80faf0aa80ULL,
+    0xffcc8080cccc8080ULL, 0xfffcaa80fefcaa80ULL,
+    0xfffaf0f0aaaa8080ULL, 0xfffafaf0fafaaa80ULL,
+    0xfffef0f0eeee8080ULL, 0xffffffffffffffffULL
+};
+
+/**
+ * Verifica che una variante m,n,k sia ammessa.
+ *
+ * @param rows Righe
+ * @param cols Colonne
+ * @param k Simboli da allineare
+ * @return 1 se lati e allineamento sono tra BOARD_MIN_SIDE e BOARD_MAX_SIDE
+ *         e k non supera il lato maggiore, 0 altrimenti
+ */
+int board_variant_valid(int rows, int cols, int k) {
+    if (rows < BOARD_MIN_SIDE || rows > BOARD_MAX_SIDE) return 0;
+    if (cols < BOARD_MIN_SIDE || cols > BOARD_MAX_SIDE) return 0;
+    return k >= BOARD_MIN_SIDE && k <= (rows > cols ? rows : cols);
+}
+
+/**
+ * Prepara un tabellone vuoto della variante indicata.
+ *
+ * @param board Tabellone da preparare
+ * @param rows Righe
+ * @param cols Colonne
+ * @param k Simboli da allineare
+ * @return 1 in caso di successo, 0 se la variante non è valida (tabellone invariato)
+ */
+int board_init(Board *board, int rows, int cols, int k) {
+    if (!board_variant_valid(rows, cols, k)) return 0;
+
+    memset(board, 0, sizeof(Board));
+    board->rows = (unsigned char)rows;
+    board->cols = (unsigned char)cols;
+    board->k = (unsigned char)k;
+    board->winner = BOARD_EMPTY;
+    return 1;
+}
+
+/**
+ * Verifica se il tabellone è quello del Tris classico (3,3,3).
+ *
+ * @param board Tabellone
+ * @return 1 per la variante 3,3,3, 0 altrimenti
+ */
+int board_is_classic(const Board *board) {
+    return board->rows == BOARD_SIDE && board->cols == BOARD_SIDE && board->k == BOARD_SIDE;
+}
+
+/**
+ * Svuota il tabellone mantenendone la variante (rematch).
+ *
+ * @param board Tabellone da svuotare
+ */
+void board_clear(Board *board) {
+    memset(board->x, 0, sizeof(board->x));
+    memset(board->o, 0, sizeof(board->o));
+    board->moves = 0;
+    board->winner = BOARD_EMPTY;
+}
+
+/**
+ * Conta le celle consecutive di un giocatore a partire da (row, col)
+ * esclusa, nella direzione (dr, dc), fino a un massimo di limit.
+ */
+static int board_run(const Board *board, const unsigned short *cells, int row, int col,
+                     int dr, int dc, int limit) {
+    int count = 0;
+    for (row += dr, col += dc;
+         count < limit && row >= 0 && row < board->rows && col >= 0 && col < board->cols &&
+         ((cells[row] >> col) & 1u);
+         row += dr, col += dc) {
+        count++;
+    }
+    return count;
+}
+
+/**
+ * Verifica se la cella appena occupata completa un allineamento di k simboli.
+ * Esamina solo le quattro linee che passano per la cella.
+ *
+ * @param board Tabellone
+ * @param cells Righe di bit del giocatore che ha mosso
+ * @param row Riga della mossa
+ * @param col Colonna della mossa
+ * @return 1 se la mossa è vincente, 0 altrimenti
+ */
+static int board_wins_through(const Board *board, const unsigned short *cells, int row, int col) {
+    static const int directions[4][2] = { { 0, 1 }, { 1, 0 }, { 1, 1 }, { 1, -1 } };
+
+    if (board_is_classic(board)) {
+        return board_mask_wins(cells[0] | (cells[1] << 3) | (cells[2] << 6));
+    }
+
+    int need = board->k - 1;
+    for (int d = 0; d < 4; d++) {
+        int dr = directions[d][0], dc = directions[d][1];
+        int run = board_run(board, cells, row, col, dr, dc, need);
+        if (run + board_run(board, cells, row, col, -dr, -dc, need - run) >= need) return 1;
+    }
+    return 0;
+}
+
+/**
+ * Occupa una cella con il simbolo di un giocatore e aggiorna l'esito.
+ *
+ * @param board Tabellone
+ * @param row Riga (da 0)
+ * @param col Colonna (da 0)
+ * @param symbol BOARD_X o BOARD_O
+ * @return 1 se la cella era libera ed è stata occupata, 0 se le coordinate
+ *         o il simbolo non sono validi o la cella è già occupata
+ *
+ * @note Costo O(k): vedi board_wins_through()
+ */
+int board_place(Board *board, int row, int col, char symbol) {
+    unsigned short *cells;
+    if (symbol == BOARD_X) cells = board->x;
+    else if (symbol == BOARD_O) cells = board->o;
+    else return 0;
+    if (!board_is_free(board, row, col)) return 0;
+
+    cells[row] |= (unsigned short)(1u << col);
+    board->moves++;
+    if (board->winner == BOARD_EMPTY && board_wins_through(board, cells, row, col)) {
+        board->winner = symbol;
+    }
+    return 1;
+}
+
+/**
+ * Verifica che le coordinate siano nel tabellone e la cella sia libera.
+ *
+ * @param board Tabellone
+ * @param row Riga
+ * @param col Colonna
+ * @return 1 se la cella esiste ed è libera, 0 altrimenti
+ */
+int board_is_free(const Board *board, int row, int col) {
+    if (row < 0 || row >= board->rows || col < 0 || col >= board->cols) return 0;
+    return !(((board->x[row] | board->o[row]) >> col) & 1u);
+}
+
+/**
+ * Restituisce il contenuto di una cella (per la visualizzazione).
+ *
+ * @param board Tabellone
+ * @param row Riga
+ * @param col Colonna
+ * @return BOARD_X, BOARD_O o BOARD_EMPTY (anche per coordinate non valide)
+ */
+char board_get(const Board *board, int row, int col) {
+    if (row < 0 || row >= board->rows || col < 0 || col >= board->cols) return BOARD_EMPTY;
+
+    if ((board->x[row] >> col) & 1u) return BOARD_X;
+    if ((board->o[row] >> col) & 1u) return BOARD_O;
+    return BOARD_EMPTY;
+}
+
+/**
+ * Verifica se una maschera di celle contiene una linea vincente.
+ *
+ * @param mask Celle di un giocatore (9 bit)
+ * @return 1 se la maschera contiene una riga, colonna o diagonale completa
+ */
+int board_mask_wins(unsigned int mask) {
+    mask &= BOARD_FULL_MASK;
+    return (int)((board_win_table[mask >> 6] >> (mask & 63u)) & 1u);
+}
+
+/**
+ * Restituisce il vincitore della partita, calcolato da board_place().
+ *
+ * @param board Tabellone
+ * @return BOARD_X o BOARD_O se ha completato un allineamento, BOARD_EMPTY altrimenti
+ */
+char board_winner(const Board *board) {
+    return board->winner;
+}
+
+/**
+ * Verifica se tutte le celle sono occupate.
+ *
+ * @param board Tabellone
+ * @return 1 se il tabellone è pieno, 0 altrimenti
+ */
+int board_is_full(const Board *board) {
+    return board->moves == board->rows * board->cols;
+}
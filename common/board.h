@@ -0,0 +1,86 @@
+#ifndef BOARD_H
+#define BOARD_H
+
+/*
+ * HEADER BOARD - TABELLONE M,N,K A BITBOARD
+ *
+ * Questo header, condiviso da client e server, definisce il tabellone di
+ * una partita m,n,k: righe x colonne celle, vince chi allinea k simboli in
+ * orizzontale, verticale o diagonale. Il Tris classico è la variante 3,3,3;
+ * il Gomoku è 15,15,5.
+ *
+ * Ogni giocatore ha una riga di bit per riga del tabellone (bit = colonna).
+ * La vittoria viene verificata a ogni mossa soltanto sulle quattro linee
+ * che passano per la cella appena occupata, al più 2(k-1) celle per linea:
+ * il costo è O(k) a qualsiasi dimensione e il vincitore resta memorizzato
+ * nel tabellone. Per la variante 3,3,3 basta una lettura di una tabella di
+ * 512 bit indicizzata dalla maschera di 9 bit del giocatore (bit a 1 se la
+ * maschera contiene una delle 8 linee vincenti). Il tabellone è pieno
+ * quando il numero di mosse raggiunge il numero di celle.
+ *
+ * Per valutare una posizione qualsiasi (bot, analisi) board_scan() esamina
+ * invece tutto il tabellone: vincitore e minacce, cioè finestre di k celle
+ * con k-1 simboli di un giocatore e una cella vuota. Le righe di bit di un
+ * giocatore (al più 15 da 16 bit) entrano in un registro AVX2 o in due
+ * SSE2: ogni direzione è una sequenza di k scorrimenti e AND su tutte le
+ * righe insieme. L'implementazione viene scelta all'avvio secondo la CPU,
+ * con una versione scalare per le altre architetture (vedi board_scan.c).
+ */
+
+// ========== CONFIGURAZIONI ==========
+
+#define BOARD_SIDE 3                    // Righe, colonne e allineamento del Tris classico
+#define BOARD_CELLS 9                   // Celle del Tris classico
+#define BOARD_FULL_MASK 0x1FFu          // Maschera 3x3 con tutte le celle occupate
+#define BOARD_MIN_SIDE 3                // Lato minimo e allineamento minimo
+#define BOARD_MAX_SIDE 15               // Lato massimo (una cella resta un byte nel protocollo binario)
+
+#define BOARD_EMPTY ' '                 // Cella vuota (come PLAYER_NONE)
+#define BOARD_X 'X'                     // Simbolo del primo giocatore
+#define BOARD_O 'O'                     // Simbolo del secondo giocatore
+
+// ========== STRUTTURE DATI ==========
+
+/**
+ * Tabellone di gioco: variante, celle occupate da ciascun giocatore ed
+ * esito calcolato dall'ultima mossa.
+ */
+typedef struct {
+    unsigned char rows;             // Righe (m)
+    unsigned char cols;             // Colonne (n)
+    unsigned char k;                // Simboli da allineare per vincere
+    char winner;                    // BOARD_X o BOARD_O dopo la mossa vincente, BOARD_EMPTY altrimenti
+    unsigned short moves;           // Celle occupate
+    unsigned short x[BOARD_MAX_SIDE]; // Celle di X, una riga di bit per riga
+    unsigned short o[BOARD_MAX_SIDE]; // Celle di O
+} Board;
+
+/**
+ * Risultato della scansione completa di un tabellone (vedi board_scan()).
+ */
+typedef struct {
+    char winner;                    // Giocatore con un allineamento di k simboli, BOARD_EMPTY se nessuno
+    int threats_x;                  // Finestre di k celle con k-1 simboli di X e una cella vuota
+    int threats_o;                  // Finestre di k celle con k-1 simboli di O e una cella vuota
+} BoardScan;
+
+// ========== FUNZIONI DEL TABELLONE ==========
+
+int board_variant_valid(int rows, int cols, int k);
+int board_init(Board *board, int rows, int cols, int k);
+int board_is_classic(const Board *board);
+void board_clear(Board *board);
+int board_place(Board *board, int row, int col, char symbol);
+int board_is_free(const Board *board, int row, int col);
+char board_get(const Board *board, int row, int col);
+char board_winner(const Board *board);
+int board_is_full(const Board *board);
+int board_mask_wins(unsigned int mask);
+
+// ========== SCANSIONE COMPLETA ==========
+
+void board_scan(const Board *board, BoardScan *scan);
+int board_scan_select(const char *name);
+const char* board_scan_impl(void);
+
+#endif
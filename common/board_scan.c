@@ -0,0 +1,289 @@
+#include "board.h"
+#include <string.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    #define BOARD_SCAN_X86 1
+    #include <immintrin.h>
+#endif
+
+// ========== CONFIGURAZIONI ==========
+
+#define SCAN_LANES 16                   // Righe esaminate insieme (una per corsia da 16 bit)
+#define SCAN_PADDED (2 * SCAN_LANES)    // Righe più spazio per leggere fino a k-1 righe oltre
+#define SCAN_DIRECTIONS 4               // Orizzontale, verticale, diagonale, antidiagonale
+
+/**
+ * Direzione di una finestra di k celle a partire da (riga, colonna): la
+ * cella i sta nella riga riga + row_step * i e nella colonna colonna + shift * i.
+ * Leggere la riga e farla scorrere di shift * i bit porta quella cella sul
+ * bit della colonna di partenza.
+ */
+static const struct {
+    int row_step;
+    int shift;                      // > 0: verso destra, < 0: verso sinistra
+} scan_directions[SCAN_DIRECTIONS] = {
+    { 0, 1 }, { 1, 0 }, { 1, 1 }, { 1, -1 }
+};
+
+/**
+ * Nucleo di scansione: per ogni direzione e per ogni cella di partenza
+ * (bit c della corsia r) calcola se le k celle sono tutte del giocatore
+ * e se gli manca esattamente una cella libera.
+ *
+ * @param own Righe del giocatore, SCAN_PADDED voci (zero oltre il tabellone)
+ * @param avail Righe delle celle del tabellone non occupate dall'avversario
+ * @param k Simboli da allineare
+ * @param wins Partenze di allineamenti completi, unite sulle quattro direzioni
+ * @param threats Partenze di minacce, una riga di SCAN_LANES per direzione
+ */
+typedef void (*BoardScanKernel)(const unsigned short *own, const unsigned short *avail, int k,
+                                unsigned short *wins, unsigned short threats[][SCAN_LANES]);
+
+// ========== NUCLEI DI SCANSIONE ==========
+
+/**
+ * Versione scalare: una riga alla volta, tutte le colonne insieme.
+ * Per ogni finestra all = tutte le k celle del giocatore, missing_one =
+ * ne manca esattamente una, room = nessuna cella dell'avversario o fuori
+ * dal tabellone.
+ */
+static void board_scan_scalar(const unsigned short *own, const unsigned short *avail, int k,
+                              unsigned short *wins, unsigned short threats[][SCAN_LANES]) {
+    memset(wins, 0, SCAN_LANES * sizeof(unsigned short));
+    for (int d = 0; d < SCAN_DIRECTIONS; d++) {
+        for (int r = 0; r < SCAN_LANES; r++) {
+            unsigned int all = 0xFFFFu, missing_one = 0, room = 0xFFFFu;
+            for (int i = 0; i < k; i++) {
+                int row = r + scan_directions[d].row_step * i;
+                int shift = scan_directions[d].shift * i;
+                unsigned int t = own[row], ta = avail[row];
+                if (shift > 0) {
+                    t >>= shift;
+                    ta >>= shift;
+                } else if (shift < 0) {
+                    t = (t << -shift) & 0xFFFFu;
+                    ta = (ta << -shift) & 0xFFFFu;
+                }
+                missing_one = (missing_one & t) | (all & ~t);
+                all &= t;
+                room &= ta;
+            }
+            wins[r] |= (unsigned short)all;
+            threats[d][r] = (unsigned short)(missing_one & room);
+        }
+    }
+}
+
+#ifdef BOARD_SCAN_X86
+
+/**
+ * Versione SSE2: le 16 righe in due registri da 8 corsie.
+ */
+__attribute__((target("sse2")))
+static void board_scan_sse2(const unsigned short *own, const unsigned short *avail, int k,
+                            unsigned short *wins, unsigned short threats[][SCAN_LANES]) {
+    const __m128i ones = _mm_set1_epi16(-1);
+
+    for (int half = 0; half < SCAN_LANES; half += 8) {
+        __m128i any = _mm_setzero_si128();
+        for (int d = 0; d < SCAN_DIRECTIONS; d++) {
+            __m128i all = ones, missing_one = _mm_setzero_si128(), room = ones;
+            for (int i = 0; i < k; i++) {
+                int row = half + scan_directions[d].row_step * i;
+                int shift = scan_directions[d].shift * i;
+                __m128i t = _mm_loadu_si128((const __m128i*)(own + row));
+                __m128i ta = _mm_loadu_si128((const __m128i*)(avail + row));
+                if (shift > 0) {
+                    t = _mm_srl_epi16(t, _mm_cvtsi32_si128(shift));
+                    ta = _mm_srl_epi16(ta, _mm_cvtsi32_si128(shift));
+                } else if (shift < 0) {
+                    t = _mm_sll_epi16(t, _mm_cvtsi32_si128(-shift));
+                    ta = _mm_sll_epi16(ta, _mm_cvtsi32_si128(-shift));
+                }
+                missing_one = _mm_or_si128(_mm_and_si128(missing_one, t), _mm_andnot_si128(t, all));
+                all = _mm_and_si128(all, t);
+                room = _mm_and_si128(room, ta);
+            }
+            any = _mm_or_si128(any, all);
+            _mm_storeu_si128((__m128i*)(threats[d] + half), _mm_and_si128(missing_one, room));
+        }
+        _mm_storeu_si128((__m128i*)(wins + half), any);
+    }
+}
+
+/**
+ * Versione AVX2: tutte le righe del tabellone in un solo registro.
+ */
+__attribute__((target("avx2")))
+static void board_scan_avx2(const unsigned short *own, const unsigned short *avail, int k,
+                            unsigned short *wins, unsigned short threats[][SCAN_LANES]) {
+    const __m256i ones = _mm256_set1_epi16(-1);
+    __m256i any = _mm256_setzero_si256();
+
+    for (int d = 0; d < SCAN_DIRECTIONS; d++) {
+        __m256i all = ones, missing_one = _mm256_setzero_si256(), room = ones;
+        for (int i = 0; i < k; i++) {
+            int row = scan_directions[d].row_step * i;
+            int shift = scan_directions[d].shift * i;
+            __m256i t = _mm256_loadu_si256((const __m256i*)(own + row));
+            __m256i ta = _mm256_loadu_si256((const __m256i*)(avail + row));
+            if (shift > 0) {
+                t = _mm256_srl_epi16(t, _mm_cvtsi32_si128(shift));
+                ta = _mm256_srl_epi16(ta, _mm_cvtsi32_si128(shift));
+            } else if (shift < 0) {
+                t = _mm256_sll_epi16(t, _mm_cvtsi32_si128(-shift));
+                ta = _mm256_sll_epi16(ta, _mm_cvtsi32_si128(-shift));
+            }
+            missing_one = _mm256_or_si256(_mm256_and_si256(missing_one, t), _mm256_andnot_si256(t, all));
+            all = _mm256_and_si256(all, t);
+            room = _mm256_and_si256(room, ta);
+        }
+        any = _mm256_or_si256(any, all);
+        _mm256_storeu_si256((__m256i*)threats[d], _mm256_and_si256(missing_one, room));
+    }
+    _mm256_storeu_si256((__m256i*)wins, any);
+}
+
+static int board_scan_has_sse2(void) {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("sse2");
+}
+
+static int board_scan_has_avx2(void) {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+}
+
+#endif
+
+// ========== SELEZIONE DELL'IMPLEMENTAZIONE ==========
+
+/**
+ * Implementazioni disponibili, dalla più veloce. supported() è NULL se
+ * l'implementazione non richiede istruzioni particolari.
+ */
+static const struct {
+    const char *name;
+    BoardScanKernel kernel;
+    int (*supported)(void);
+} scan_impls[] = {
+#ifdef BOARD_SCAN_X86
+    { "avx2", board_scan_avx2, board_scan_has_avx2 },
+    { "sse2", board_scan_sse2, board_scan_has_sse2 },
+#endif
+    { "scalar", board_scan_scalar, NULL }
+};
+
+#define SCAN_IMPL_COUNT (int)(sizeof(scan_impls) / sizeof(scan_impls[0]))
+
+static int scan_selected = -1;          // Indice in scan_impls, -1 finché non è scelto
+
+/**
+ * Sceglie l'implementazione della scansione.
+ *
+ * @param name "avx2", "sse2" o "scalar"; NULL per la più veloce supportata dalla CPU
+ * @return 1 se l'implementazione è stata scelta, 0 se non esiste o la CPU non la supporta
+ *
+ * @note Senza chiamate esplicite la scelta avviene alla prima board_scan();
+ *       cambiare implementazione con scansioni in corso in altri thread è
+ *       ammesso (il risultato non cambia), serve ai benchmark
+ */
+int board_scan_select(const char *name) {
+    for (int i = 0; i < SCAN_IMPL_COUNT; i++) {
+        if (name && strcmp(name, scan_impls[i].name) != 0) continue;
+        if (scan_impls[i].supported && !scan_impls[i].supported()) {
+            if (name) return 0;
+            continue;
+        }
+        __atomic_store_n(&scan_selected, i, __ATOMIC_RELAXED);
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * Restituisce l'indice dell'implementazione in uso, scegliendola se serve.
+ */
+static int board_scan_current(void) {
+    int index = __atomic_load_n(&scan_selected, __ATOMIC_RELAXED);
+    if (index < 0) {
+        board_scan_select(NULL);
+        index = __atomic_load_n(&scan_selected, __ATOMIC_RELAXED);
+    }
+    return index;
+}
+
+/**
+ * Restituisce il nome dell'implementazione della scansione in uso.
+ *
+ * @return "avx2", "sse2" o "scalar"
+ */
+const char* board_scan_impl(void) {
+    return scan_impls[board_scan_current()].name;
+}
+
+// ========== SCANSIONE ==========
+
+/**
+ * Conta i bit a 1 dei risultati di un nucleo (quattro direzioni).
+ */
+static int board_scan_count(unsigned short threats[][SCAN_LANES]) {
+    unsigned long long words[SCAN_DIRECTIONS * SCAN_LANES / 4];
+    int count = 0;
+
+    memcpy(words, threats, sizeof(words));
+    for (size_t i = 0; i < sizeof(words) / sizeof(words[0]); i++) {
+        count += __builtin_popcountll(words[i]);
+    }
+    return count;
+}
+
+/**
+ * Verifica se un risultato contiene almeno un allineamento.
+ */
+static int board_scan_any(const unsigned short *wins) {
+    for (int r = 0; r < SCAN_LANES; r++) {
+        if (wins[r]) return 1;
+    }
+    return 0;
+}
+
+/**
+ * Esamina tutto il tabellone: vincitore e minacce di ciascun giocatore.
+ * A differenza di board_winner() non dipende dall'ordine delle mosse, quindi
+ * vale anche per posizioni costruite direttamente (analisi, ricerca dei bot).
+ *
+ * @param board Tabellone da esaminare
+ * @param scan Risultato della scansione
+ *
+ * @note Una minaccia è una finestra di k celle in riga, colonna o diagonale
+ *       con k-1 simboli del giocatore e una cella vuota: la cella vuota è una
+ *       mossa vincente. Finestre diverse che condividono la cella vuota
+ *       contano separatamente (un quattro aperto del Gomoku vale due)
+ * @note Se entrambi i giocatori hanno un allineamento (posizione impossibile
+ *       in partita) il vincitore riportato è X
+ */
+void board_scan(const Board *board, BoardScan *scan) {
+    unsigned short x[SCAN_PADDED] = { 0 }, o[SCAN_PADDED] = { 0 };
+    unsigned short avail_x[SCAN_PADDED] = { 0 }, avail_o[SCAN_PADDED] = { 0 };
+    unsigned short wins_x[SCAN_LANES], wins_o[SCAN_LANES];
+    unsigned short threats[SCAN_DIRECTIONS][SCAN_LANES];
+    unsigned short cells = (unsigned short)((1u << board->cols) - 1);
+    BoardScanKernel kernel = scan_impls[board_scan_current()].kernel;
+
+    for (int r = 0; r < board->rows; r++) {
+        x[r] = board->x[r];
+        o[r] = board->o[r];
+        avail_x[r] = (unsigned short)(cells & ~board->o[r]);
+        avail_o[r] = (unsigned short)(cells & ~board->x[r]);
+    }
+
+    kernel(x, avail_x, board->k, wins_x, threats);
+    scan->threats_x = board_scan_count(threats);
+    kernel(o, avail_o, board->k, wins_o, threats);
+    scan->threats_o = board_scan_count(threats);
+
+    if (board_scan_any(wins_x)) scan->winner = BOARD_X;
+    else if (board_scan_any(wins_o)) scan->winner = BOARD_O;
+    else scan->winner = BOARD_EMPTY;
+}
@@ -0,0 +1,324 @@
+#include "messages.h"
+#include <limits.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+/**
+ * Verbo e forma dei dati dei messaggi del server, indicizzati per ServerMsgId.
+ */
+static const struct {
+    const char *verb;
+    size_t len;
+    MessagePayload payload;
+} message_specs[SMSG_COUNT] = {
+    [SMSG_TEXT] = { "", 0, PAYLOAD_TEXT },
+#define MESSAGE_SPEC(name, lower, payload) [SMSG_##name] = { #name, sizeof(#name) - 1, PAYLOAD_##payload },
+    SERVER_MESSAGES(MESSAGE_SPEC)
+#undef MESSAGE_SPEC
+};
+
+/**
+ * Verbi dei comandi, indicizzati per CommandId.
+ */
+static const char *command_verbs[CMD_COUNT] = {
+    [CMD_UNKNOWN] = "",
+#define COMMAND_VERB(name, lower, payload) [CMD_##name] = #name,
+    CLIENT_COMMANDS(COMMAND_VERB)
+#undef COMMAND_VERB
+};
+
+// ========== CODIFICA ==========
+
+/**
+ * Aggiunge testo formattato in fondo a un messaggio già scritto.
+ *
+ * @param buf Buffer del messaggio
+ * @param size Dimensione del buffer
+ * @param len Lunghezza attuale del messaggio (0 = scrittura già fallita)
+ * @param format Formato printf (NULL = nessun testo)
+ * @param args Argomenti del formato
+ * @return Nuova lunghezza, 0 se il testo non entra nel buffer
+ */
+static int message_vappend(char *buf, size_t size, int len, const char *format, va_list args) {
+    if (len <= 0 || !format) return len;
+
+    int written = vsnprintf(buf + len, size - (size_t)len, format, args);
+    if (written < 0 || (size_t)written >= size - (size_t)len) return 0;
+    return len + written;
+}
+
+/**
+ * Scrive "VERBO" oppure "VERBO:<testo formattato>".
+ *
+ * @param buf Buffer di destinazione
+ * @param size Dimensione del buffer
+ * @param verb Verbo del messaggio
+ * @param format Formato printf dei dati (NULL = solo il verbo)
+ * @param args Argomenti del formato
+ * @return Lunghezza del messaggio, 0 se non entra nel buffer
+ */
+static int message_vprintf(char *buf, size_t size, const char *verb, const char *format, va_list args) {
+    size_t verb_len = strlen(verb);
+    if (verb_len + 1 >= size) return 0;
+
+    memcpy(buf, verb, verb_len);
+    buf[verb_len] = '\0';
+    if (!format) return (int)verb_len;
+
+    buf[verb_len] = ':';
+    buf[verb_len + 1] = '\0';
+    return message_vappend(buf, size, (int)verb_len + 1, format, args);
+}
+
+/**
+ * Come message_vprintf(), con argomenti variabili.
+ */
+static int message_printf(char *buf, size_t size, const char *verb, const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    int len = message_vprintf(buf, size, verb, format, args);
+    va_end(args);
+    return len;
+}
+
+// Corpo delle funzioni di codifica per forma dei dati (vedi MESSAGE_ENCODER_*)
+#define MESSAGE_BODY_VARIADIC(verb) \
+    va_list args; \
+    va_start(args, format); \
+    int len = message_vprintf(buf, size, verb, format, args); \
+    va_end(args); \
+    return len;
+#define MESSAGE_BODY_NONE(verb)     return message_printf(buf, size, verb, NULL);
+#define MESSAGE_BODY_NOTE(verb)     MESSAGE_BODY_VARIADIC(verb)
+#define MESSAGE_BODY_TEXT(verb)     MESSAGE_BODY_VARIADIC(verb)
+#define MESSAGE_BODY_INT(verb)      return message_printf(buf, size, verb, "%d", value);
+#define MESSAGE_BODY_SYMBOL(verb)   return message_printf(buf, size, verb, "%c", symbol);
+#define MESSAGE_BODY_MOVE(verb)     return message_printf(buf, size, verb, "%d,%d:%c", row, col, symbol);
+#define MESSAGE_BODY_RESULT(verb) \
+    if (winner == MESSAGE_DRAW) return message_printf(buf, size, verb, "DRAW"); \
+    return message_printf(buf, size, verb, "WINNER:%c", winner);
+#define MESSAGE_BODY_REQUEST(verb)  return message_printf(buf, size, verb, "%s:%d", name, game_id);
+#define MESSAGE_BODY_LIST(verb) \
+    va_list args; \
+    int len = message_printf(buf, size, verb, "%lu:", seq); \
+    va_start(args, format); \
+    len = message_vappend(buf, size, len, format, args); \
+    va_end(args); \
+    return len;
+#define MESSAGE_BODY_CELL(verb)     return message_printf(buf, size, verb, "%d,%d", row, col);
+#define MESSAGE_BODY_VARIANT(verb)  return message_printf(buf, size, verb, "%d,%d,%d", rows, cols, k);
+
+#define MESSAGE_DEFINE_ENCODER(name, lower, payload) \
+    MESSAGE_ENCODER_##payload(message_encode_##lower) { MESSAGE_BODY_##payload(#name) }
+#define COMMAND_DEFINE_ENCODER(name, lower, payload) \
+    MESSAGE_ENCODER_##payload(command_encode_##lower) { MESSAGE_BODY_##payload(#name) }
+SERVER_MESSAGES(MESSAGE_DEFINE_ENCODER)
+CLIENT_COMMANDS(COMMAND_DEFINE_ENCODER)
+
+/**
+ * Scrive un messaggio del server senza dati strutturati scegliendolo per
+ * tipo, quando il testo non è un formato printf.
+ *
+ * @param id Tipo del messaggio (forma dei dati NONE, NOTE o TEXT)
+ * @param buf Buffer di destinazione
+ * @param size Dimensione del buffer
+ * @param text Testo dopo il verbo, NULL per il solo verbo
+ * @return Lunghezza del messaggio, 0 se non entra nel buffer o il tipo ha dati strutturati
+ */
+int message_write(ServerMsgId id, char *buf, size_t size, const char *text) {
+    if (id <= SMSG_TEXT || id >= SMSG_COUNT) return 0;
+    switch (message_specs[id].payload) {
+        case PAYLOAD_NONE:
+            if (text) return 0;
+            return message_printf(buf, size, message_specs[id].verb, NULL);
+        case PAYLOAD_NOTE:
+        case PAYLOAD_TEXT:
+            return text ? message_printf(buf, size, message_specs[id].verb, "%s", text)
+                        : message_printf(buf, size, message_specs[id].verb, NULL);
+        default:
+            return 0;
+    }
+}
+
+// ========== DECODIFICA ==========
+
+/**
+ * Legge un intero decimale non negativo da un testo non terminato.
+ *
+ * @return Posizione dopo le cifre, NULL se non ci sono cifre o il valore non sta in 32 bit
+ */
+static const char* message_scan_uint(const char *p, const char *end, unsigned long *value) {
+    unsigned long result = 0;
+    const char *start = p;
+
+    while (p < end && *p >= '0' && *p <= '9') {
+        result = result * 10 + (unsigned long)(*p++ - '0');
+        if (result > 0xFFFFFFFFUL) return NULL;
+    }
+    if (p == start) return NULL;
+    *value = result;
+    return p;
+}
+
+/**
+ * Cerca il tipo di un messaggio dal suo verbo.
+ *
+ * @param verb Inizio del verbo (non null-terminato)
+ * @param len Lunghezza del verbo
+ * @return Tipo del messaggio, SMSG_TEXT se il verbo non esiste
+ */
+static ServerMsgId message_lookup(const char *verb, size_t len) {
+    for (int id = SMSG_TEXT + 1; id < SMSG_COUNT; id++) {
+        if (message_specs[id].len == len && memcmp(message_specs[id].verb, verb, len) == 0) {
+            return (ServerMsgId)id;
+        }
+    }
+    return SMSG_TEXT;
+}
+
+/**
+ * Legge i dati di un messaggio secondo la forma del suo tipo.
+ *
+ * @param payload Forma dei dati attesa
+ * @param p Testo dopo "VERBO:" (vuoto se il messaggio non ha dati)
+ * @param end Fine del messaggio
+ * @param msg Messaggio da completare
+ * @return 1 se i dati hanno la forma attesa, 0 altrimenti
+ */
+static int message_decode_payload(MessagePayload payload, const char *p, const char *end, Message *msg) {
+    unsigned long row, col, value;
+    const char *colon;
+
+    msg->text = p;
+    msg->text_len = (size_t)(end - p);
+
+    switch (payload) {
+        case PAYLOAD_NONE:
+        case PAYLOAD_NOTE:
+        case PAYLOAD_TEXT:
+            return 1;
+        case PAYLOAD_INT:
+            p = message_scan_uint(p, end, &value);
+            if (!p || p != end || value > INT_MAX) return 0;
+            msg->value = (int)value;
+            return 1;
+        case PAYLOAD_SYMBOL:
+            // Simbolo, eventualmente seguito da ":<nota>"
+            if (end - p < 1 || (end - p > 1 && p[1] != ':')) return 0;
+            msg->symbol = *p;
+            msg->text = end - p > 1 ? p + 2 : end;
+            msg->text_len = (size_t)(end - msg->text);
+            return 1;
+        case PAYLOAD_MOVE:
+            p = message_scan_uint(p, end, &row);
+            if (!p || p == end || *p++ != ',') return 0;
+            p = message_scan_uint(p, end, &col);
+            if (!p || row > INT_MAX || col > INT_MAX || end - p != 2 || p[0] != ':') return 0;
+            msg->row = (int)row;
+            msg->col = (int)col;
+            msg->symbol = p[1];
+            return 1;
+        case PAYLOAD_RESULT:
+            if (end - p == 4 && memcmp(p, "DRAW", 4) == 0) {
+                msg->symbol = MESSAGE_DRAW;
+                return 1;
+            }
+            if (end - p == 8 && memcmp(p, "WINNER:", 7) == 0) {
+                msg->symbol = p[7];
+                return 1;
+            }
+            return 0;
+        case PAYLOAD_REQUEST:
+            // Il nome non contiene ':' ma si cerca comunque l'ultimo separatore
+            for (colon = end; colon > p && colon[-1] != ':'; colon--);
+            if (colon - 1 <= p) return 0;
+            if (message_scan_uint(colon, end, &value) != end || value > INT_MAX) return 0;
+            msg->text_len = (size_t)(colon - 1 - p);
+            msg->value = (int)value;
+            return 1;
+        case PAYLOAD_LIST:
+            p = message_scan_uint(p, end, &value);
+            if (!p || p == end || *p != ':') return 0;
+            msg->seq = value;
+            msg->text = p + 1;
+            msg->text_len = (size_t)(end - p - 1);
+            return 1;
+        case PAYLOAD_VARIANT:
+            p = message_scan_uint(p, end, &row);
+            if (!p || p == end || *p++ != ',') return 0;
+            p = message_scan_uint(p, end, &col);
+            if (!p || p == end || *p++ != ',') return 0;
+            p = message_scan_uint(p, end, &value);
+            if (p != end || row > INT_MAX || col > INT_MAX || value > INT_MAX) return 0;
+            msg->row = (int)row;
+            msg->col = (int)col;
+            msg->value = (int)value;
+            return 1;
+        case PAYLOAD_CELL:
+            return 0;
+    }
+    return 0;
+}
+
+/**
+ * Decodifica un messaggio del server "VERBO[:dati]" in una sola passata.
+ * Un messaggio sconosciuto, o con dati di forma inattesa, diventa SMSG_TEXT
+ * con il testo intero, così chi lo riceve può comunque mostrarlo.
+ *
+ * @param text Messaggio ricevuto (senza terminatore di riga, non necessariamente null-terminato)
+ * @param len Lunghezza del messaggio
+ * @param msg Messaggio da riempire; i testi puntano dentro text
+ * @return 1 se il messaggio è stato riconosciuto, 0 se è SMSG_TEXT
+ */
+int message_decode(const char *text, size_t len, Message *msg) {
+    const char *end = text + len;
+    const char *colon = memchr(text, ':', len);
+    size_t verb_len = colon ? (size_t)(colon - text) : len;
+
+    memset(msg, 0, sizeof(Message));
+    msg->type = message_lookup(text, verb_len);
+    if (msg->type != SMSG_TEXT &&
+        message_decode_payload(message_specs[msg->type].payload, colon ? colon + 1 : end, end, msg)) {
+        return 1;
+    }
+
+    memset(msg, 0, sizeof(Message));
+    msg->type = SMSG_TEXT;
+    msg->text = text;
+    msg->text_len = len;
+    return 0;
+}
+
+/**
+ * Restituisce la forma dei dati di un tipo di messaggio.
+ *
+ * @param id Tipo del messaggio
+ * @return Forma dei dati (PAYLOAD_TEXT per SMSG_TEXT o un tipo non valido)
+ */
+MessagePayload message_payload(ServerMsgId id) {
+    if (id <= SMSG_TEXT || id >= SMSG_COUNT) return PAYLOAD_TEXT;
+    return message_specs[id].payload;
+}
+
+/**
+ * Restituisce il verbo di un messaggio del server (per i log).
+ *
+ * @param id Tipo del messaggio
+ * @return Verbo, "?" se il tipo non è valido
+ */
+const char* message_verb(ServerMsgId id) {
+    if (id <= SMSG_TEXT || id >= SMSG_COUNT) return "?";
+    return message_specs[id].verb;
+}
+
+/**
+ * Restituisce il verbo di un comando.
+ *
+ * @param id Codice del comando
+ * @return Verbo, "?" se il codice non è valido
+ */
+const char* command_verb(CommandId id) {
+    if (id <= CMD_UNKNOWN || id >= CMD_COUNT) return "?";
+    return command_verbs[id];
+}
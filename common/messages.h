@@ -0,0 +1,216 @@
+#ifndef MESSAGES_H
+#define MESSAGES_H
+
+/*
+ * HEADER MESSAGES - DEFINIZIONE DEI MESSAGGI CLIENT/SERVER
+ *
+ * Questo header, condiviso da client e server, è l'unica definizione dei
+ * messaggi scambiati tra i due programmi. Le tabelle SERVER_MESSAGES e
+ * CLIENT_COMMANDS elencano ogni messaggio con il suo verbo e la forma dei
+ * dati che lo seguono; da esse vengono generati gli enum dei tipi, le
+ * funzioni di codifica (una per messaggio, con i parametri tipizzati) e la
+ * decodifica dei messaggi del server. Aggiungere o modificare un messaggio
+ * qui aggiorna entrambi i programmi.
+ *
+ * Forma testuale: "VERBO[:dati]". Le voci hanno la forma
+ * X(VERBO, nome_funzione, DATI), dove DATI è uno di:
+ *   NONE     nessun dato
+ *   NOTE     testo descrittivo facoltativo (omesso dal protocollo binario)
+ *   TEXT     testo libero
+ *   INT      intero non negativo
+ *   SYMBOL   simbolo del giocatore, con una nota facoltativa "<simbolo>:<nota>"
+ *            (GAME_START contro il bot: il livello del bot)
+ *   MOVE     "<riga>,<colonna>:<simbolo>"
+ *   RESULT   "WINNER:<simbolo>" o "DRAW"
+ *   REQUEST  "<nome>:<id partita>"
+ *   LIST     "<sequenza>:<testo>"
+ *   CELL     "<riga>,<colonna>" (solo comandi)
+ *   VARIANT  "<righe>,<colonne>,<allineamento>" (facoltativo in CREATE_GAME)
+ *
+ * Canale UDP affidabile: SEQ:<sequenza>:<messaggio> incapsula un messaggio
+ * (MOVE, GAME_OVER dal server; MOVE dal client) che il destinatario conferma
+ * con ACK:<ultima sequenza ricevuta in ordine>; i duplicati vengono solo
+ * confermati. Ogni datagramma inviato dal client inizia con il token di
+ * UDP_SESSION, "<token>:<comando>", che lo identifica a prescindere
+ * dall'indirizzo di provenienza; solo PING è ammesso senza token.
+ * UDP_REGISTERED:<base> apre (o riapre) il canale: le sequenze di entrambe
+ * le direzioni proseguono da base, quindi conferme e datagrammi ritardatari
+ * di una sessione precedente (sequenze <= base) non toccano la nuova.
+ *
+ * L'ordine delle voci fissa gli opcode del protocollo binario: nuove voci
+ * vanno aggiunte in fondo alle tabelle.
+ */
+
+#include <stddef.h>
+
+// ========== TABELLE DEI MESSAGGI ==========
+
+/**
+ * Messaggi inviati dal server ai client (TCP e risposte UDP).
+ */
+#define SERVER_MESSAGES(X) \
+    X(OK,                        ok,                        TEXT)    \
+    X(ERROR,                     error,                     TEXT)    \
+    X(PONG,                      pong,                      NONE)    \
+    X(GAME_CREATED,              game_created,              INT)     \
+    X(WAITING_OPPONENT,          waiting_opponent,          NONE)    \
+    X(JOIN_REQUEST,              join_request,              REQUEST) \
+    X(JOIN_PENDING,              join_pending,              NOTE)    \
+    X(JOIN_APPROVED,             join_approved,             SYMBOL)  \
+    X(JOIN_APPROVED_BY_YOU,      join_approved_by_you,      NONE)    \
+    X(JOIN_REJECTED,             join_rejected,             NOTE)    \
+    X(JOIN_REJECTED_BY_YOU,      join_rejected_by_you,      NONE)    \
+    X(JOIN_CANCELLED,            join_cancelled,            NOTE)    \
+    X(GAME_START,                game_start,                SYMBOL)  \
+    X(MOVE,                      move,                      MOVE)    \
+    X(GAME_OVER,                 game_over,                 RESULT)  \
+    X(GAME_RESET,                game_reset,                NONE)    \
+    X(OPPONENT_LEFT,             opponent_left,             NOTE)    \
+    X(LEFT_GAME,                 left_game,                 NONE)    \
+    X(GAME_CANCELED,             game_canceled,             NONE)    \
+    X(GAME_CANCELLED,            game_cancelled,            NOTE)    \
+    X(REMATCH_SENT,              rematch_sent,              NOTE)    \
+    X(REMATCH_REQUEST,           rematch_request,           NOTE)    \
+    X(REMATCH_ACCEPTED,          rematch_accepted,          NOTE)    \
+    X(REMATCH_DECLINED,          rematch_declined,          NOTE)    \
+    X(REMATCH_DECLINE_CONFIRMED, rematch_decline_confirmed, NOTE)    \
+    X(REMATCH_CANCELLED,         rematch_cancelled,         NOTE)    \
+    X(GAMES,                     games,                     LIST)    \
+    X(LIST_UPDATE,               list_update,               LIST)    \
+    X(SERVER_SHUTDOWN,           server_shutdown,           NOTE)    \
+    X(UDP_REGISTERED,            udp_registered,            INT)     \
+    X(MOVE_ACCEPTED,             move_accepted,             NONE)    \
+    X(GAME_STATE,                game_state,                TEXT)    \
+    X(UDP_DISCONNECTED,          udp_disconnected,          NONE)    \
+    X(UDP_SESSION,               udp_session,               TEXT)    \
+    X(SEQ,                       seq,                       LIST)    \
+    X(ACK,                       ack,                       INT)     \
+    X(GAME_VARIANT,              game_variant,              VARIANT) \
+    X(BOT_OFFER,                 bot_offer,                 NOTE)
+
+/**
+ * Comandi inviati dai client al server. Il server li analizza con
+ * protocol_parse() (server/src/protocol.c), che riconosce i verbi a
+ * partire da questa tabella.
+ */
+#define CLIENT_COMMANDS(X) \
+    X(REGISTER,                  register,                  TEXT)    \
+    X(PING,                      ping,                      NONE)    \
+    X(CREATE_GAME,               create_game,               VARIANT) \
+    X(LIST_GAMES,                list_games,                TEXT)    \
+    X(JOIN,                      join,                      INT)     \
+    X(MOVE,                      move,                      CELL)    \
+    X(LEAVE,                     leave,                     NONE)    \
+    X(REMATCH,                   rematch,                   NONE)    \
+    X(REMATCH_DECLINE,           rematch_decline,           NONE)    \
+    X(APPROVE,                   approve,                   INT)     \
+    X(CANCEL,                    cancel,                    NONE)    \
+    X(UDP_REGISTER,              udp_register,              NONE)    \
+    X(GET_GAME_STATE,            get_game_state,            NONE)    \
+    X(UDP_DISCONNECT,            udp_disconnect,            NONE)    \
+    X(SEQ,                       seq,                       LIST)    \
+    X(ACK,                       ack,                       INT)     \
+    X(PLAY_BOT,                  play_bot,                  TEXT)
+
+#define MESSAGE_DRAW 'D'            // Esito di GAME_OVER in caso di pareggio
+#define UDP_TOKEN_DIGITS 16         // Cifre esadecimali (minuscole) del token di sessione UDP
+
+// ========== ENUMERAZIONI ==========
+
+/**
+ * Forma dei dati che seguono il verbo (vedi l'intestazione del file).
+ */
+typedef enum {
+    PAYLOAD_NONE,
+    PAYLOAD_NOTE,
+    PAYLOAD_TEXT,
+    PAYLOAD_INT,
+    PAYLOAD_SYMBOL,
+    PAYLOAD_MOVE,
+    PAYLOAD_RESULT,
+    PAYLOAD_REQUEST,
+    PAYLOAD_LIST,
+    PAYLOAD_CELL,
+    PAYLOAD_VARIANT
+} MessagePayload;
+
+/**
+ * Tipi dei messaggi del server. SMSG_TEXT indica un messaggio sconosciuto
+ * o con dati non validi; nel protocollo binario il valore è l'opcode.
+ */
+typedef enum {
+    SMSG_TEXT,
+#define MESSAGE_ENUM(name, lower, payload) SMSG_##name,
+    SERVER_MESSAGES(MESSAGE_ENUM)
+#undef MESSAGE_ENUM
+    SMSG_COUNT
+} ServerMsgId;
+
+/**
+ * Comandi dei client. Nel protocollo binario il valore è l'opcode.
+ */
+typedef enum {
+    CMD_UNKNOWN,
+#define COMMAND_ENUM(name, lower, payload) CMD_##name,
+    CLIENT_COMMANDS(COMMAND_ENUM)
+#undef COMMAND_ENUM
+    CMD_COUNT
+} CommandId;
+
+// ========== STRUTTURE DATI ==========
+
+/**
+ * Messaggio del server decodificato. I campi validi dipendono dalla forma
+ * dei dati del tipo; text punta dentro il messaggio ricevuto, che deve
+ * restare valido finché il messaggio è in uso.
+ */
+typedef struct {
+    ServerMsgId type;               // Tipo del messaggio
+    const char *text;               // NOTE/TEXT: testo; LIST: testo dopo la sequenza; SYMBOL: nota;
+                                    // REQUEST: nome (non terminato); SMSG_TEXT: messaggio intero
+    size_t text_len;                // Lunghezza di text
+    int value;                      // INT: valore; REQUEST: ID della partita; VARIANT: allineamento
+    int row;                        // MOVE: riga; VARIANT: righe
+    int col;                        // MOVE: colonna; VARIANT: colonne
+    char symbol;                    // SYMBOL, MOVE: simbolo; RESULT: vincitore o MESSAGE_DRAW
+    unsigned long seq;              // LIST: numero di sequenza
+} Message;
+
+// ========== FUNZIONI DI CODIFICA ==========
+
+/*
+ * Firme delle funzioni di codifica per forma dei dati. Ogni funzione scrive
+ * il messaggio completo (senza terminatore di riga) e restituisce la sua
+ * lunghezza, 0 se non entra nel buffer. Per NOTE, TEXT e LIST il testo è un
+ * formato printf; un formato NULL in NOTE e TEXT scrive il solo verbo.
+ */
+#define MESSAGE_ENCODER_NONE(fn)    int fn(char *buf, size_t size)
+#define MESSAGE_ENCODER_NOTE(fn)    int fn(char *buf, size_t size, const char *format, ...)
+#define MESSAGE_ENCODER_TEXT(fn)    int fn(char *buf, size_t size, const char *format, ...)
+#define MESSAGE_ENCODER_INT(fn)     int fn(char *buf, size_t size, int value)
+#define MESSAGE_ENCODER_SYMBOL(fn)  int fn(char *buf, size_t size, char symbol)
+#define MESSAGE_ENCODER_MOVE(fn)    int fn(char *buf, size_t size, int row, int col, char symbol)
+#define MESSAGE_ENCODER_RESULT(fn)  int fn(char *buf, size_t size, char winner)
+#define MESSAGE_ENCODER_REQUEST(fn) int fn(char *buf, size_t size, const char *name, int game_id)
+#define MESSAGE_ENCODER_LIST(fn)    int fn(char *buf, size_t size, unsigned long seq, const char *format, ...)
+#define MESSAGE_ENCODER_CELL(fn)    int fn(char *buf, size_t size, int row, int col)
+#define MESSAGE_ENCODER_VARIANT(fn) int fn(char *buf, size_t size, int rows, int cols, int k)
+
+// message_encode_<nome>() per ogni messaggio del server, command_encode_<nome>() per ogni comando
+#define MESSAGE_DECLARE_ENCODER(name, lower, payload) MESSAGE_ENCODER_##payload(message_encode_##lower);
+#define COMMAND_DECLARE_ENCODER(name, lower, payload) MESSAGE_ENCODER_##payload(command_encode_##lower);
+SERVER_MESSAGES(MESSAGE_DECLARE_ENCODER)
+CLIENT_COMMANDS(COMMAND_DECLARE_ENCODER)
+#undef MESSAGE_DECLARE_ENCODER
+#undef COMMAND_DECLARE_ENCODER
+
+int message_write(ServerMsgId id, char *buf, size_t size, const char *text);
+
+// ========== FUNZIONI DI DECODIFICA ==========
+
+int message_decode(const char *text, size_t len, Message *msg);
+MessagePayload message_payload(ServerMsgId id);
+const char* message_verb(ServerMsgId id);
+const char* command_verb(CommandId id);
+
+#endif
@@ -0,0 +1,263 @@
+#include "headers/bot.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// ========== CONFIGURAZIONI ==========
+
+#define BOT_UNSOLVED (-128)             // Posizione non ancora valutata
+#define BOT_WIN_SCORE (BOARD_CELLS + 1) // Valore di una vittoria alla mossa 0 (decresce con le mosse)
+
+static signed char bot_scores[BOT_POSITIONS];   // Valore per chi deve muovere (> 0 vince, 0 pareggia)
+static signed char bot_moves[BOT_POSITIONS];    // Cella migliore (riga * 3 + colonna), -1 se la partita è finita
+static unsigned short bot_ternary[1 << BOARD_CELLS]; // Maschera di 9 bit -> cifre in base 3 (0 o 1)
+static int bot_ready = 0;
+static unsigned long long bot_random_state;     // Stato del generatore casuale (atomico)
+
+static const char *bot_level_names[BOT_LEVEL_COUNT] = { "random", "heuristic", "perfect" };
+
+// ========== CALCOLO DELLA TABELLA ==========
+
+/**
+ * Indice di una posizione: cifra 1 per le celle di X, 2 per quelle di O.
+ */
+static int bot_index(unsigned int x, unsigned int o) {
+    return bot_ternary[x] + 2 * bot_ternary[o];
+}
+
+/**
+ * Valuta una posizione con negamax e memorizza valore e mossa migliore.
+ * Chi muove si ricava dal numero di simboli (X muove per primo).
+ *
+ * @param x Celle di X (9 bit)
+ * @param o Celle di O (9 bit)
+ * @return Valore per chi deve muovere: BOT_WIN_SCORE - mosse totali della
+ *         vittoria, il suo opposto per una sconfitta, 0 per un pareggio
+ */
+static int bot_solve(unsigned int x, unsigned int o) {
+    int index = bot_index(x, o);
+    if (bot_scores[index] != BOT_UNSOLVED) return bot_scores[index];
+
+    int moves = __builtin_popcount(x | o);
+    unsigned int opponent = (moves & 1) ? x : o;   // Ha mosso per ultimo
+    int best = 0, best_cell = -1;
+
+    if (board_mask_wins(opponent)) {
+        best = moves - BOT_WIN_SCORE;
+    } else if (moves < BOARD_CELLS) {
+        best = -BOT_WIN_SCORE;
+        for (int cell = 0; cell < BOARD_CELLS; cell++) {
+            unsigned int bit = 1u << cell;
+            if ((x | o) & bit) continue;
+
+            int score = (moves & 1) ? -bot_solve(x, o | bit) : -bot_solve(x | bit, o);
+            if (score > best) {
+                best = score;
+                best_cell = cell;
+            }
+        }
+    }
+
+    bot_scores[index] = (signed char)best;
+    bot_moves[index] = (signed char)best_cell;
+    return best;
+}
+
+/**
+ * Calcola la tabella delle mosse su tutte le posizioni raggiungibili.
+ * Va chiamata una volta all'avvio, prima che i thread del server giochino;
+ * le chiamate successive non fanno nulla.
+ */
+void bot_init(void) {
+    if (bot_ready) return;
+
+    for (unsigned int mask = 0; mask < (1u << BOARD_CELLS); mask++) {
+        unsigned int digits = 0;
+        for (int cell = BOARD_CELLS - 1; cell >= 0; cell--) {
+            digits = digits * 3 + ((mask >> cell) & 1u);
+        }
+        bot_ternary[mask] = (unsigned short)digits;
+    }
+    memset(bot_scores, BOT_UNSOLVED, sizeof(bot_scores));
+    memset(bot_moves, -1, sizeof(bot_moves));
+    bot_random_state = (unsigned long long)time(NULL);
+
+    bot_solve(0, 0);
+    bot_ready = 1;
+
+    int reachable = 0;
+    for (int i = 0; i < BOT_POSITIONS; i++) {
+        if (bot_scores[i] != BOT_UNSOLVED) reachable++;
+    }
+    printf("Bot inizializzato (%d posizioni raggiungibili su %d)\n", reachable, BOT_POSITIONS);
+}
+
+// ========== LIVELLI ==========
+
+/**
+ * Converte il nome di un livello di gioco.
+ *
+ * @param name "random", "heuristic" o "perfect"
+ * @param level Livello corrispondente
+ * @return 1 se il nome è valido, 0 altrimenti (level invariato)
+ */
+int bot_parse_level(const char *name, BotLevel *level) {
+    for (int i = 0; i < BOT_LEVEL_COUNT; i++) {
+        if (strcmp(name, bot_level_names[i]) == 0) {
+            *level = (BotLevel)i;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Restituisce il nome di un livello di gioco.
+ *
+ * @param level Livello
+ * @return Nome del livello, "?" se non valido
+ */
+const char* bot_level_name(BotLevel level) {
+    return (level >= 0 && level < BOT_LEVEL_COUNT) ? bot_level_names[level] : "?";
+}
+
+/**
+ * Numero casuale in [0, limit): splitmix64 su un contatore atomico, così
+ * i thread del server non condividono lo stato di rand().
+ */
+static int bot_random(int limit) {
+    unsigned long long z = __atomic_add_fetch(&bot_random_state, 0x9E3779B97F4A7C15ULL, __ATOMIC_RELAXED);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    z ^= z >> 31;
+    return (int)(z % (unsigned long long)limit);
+}
+
+/**
+ * Livello casuale: una cella libera scelta in modo uniforme.
+ */
+static int bot_move_random(const Board *board, int *row, int *col) {
+    int free_cells = board->rows * board->cols - board->moves;
+    if (free_cells <= 0) return 0;
+
+    int pick = bot_random(free_cells);
+    for (int r = 0; r < board->rows; r++) {
+        for (int c = 0; c < board->cols; c++) {
+            if (!board_is_free(board, r, c) || pick-- > 0) continue;
+            *row = r;
+            *col = c;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Livello euristico, per qualsiasi variante. Per ogni cella libera prova
+ * la mossa su una copia del tabellone: una mossa vincente viene giocata
+ * subito, una cella in cui vincerebbe l'avversario viene bloccata;
+ * altrimenti vale 4 punti per minaccia propria e -2 per minaccia
+ * dell'avversario dopo la mossa (board_scan()), meno la distanza dal
+ * centro. A parità di punteggio sceglie a caso.
+ */
+static int bot_move_heuristic(const Board *board, char symbol, int *row, int *col) {
+    char opponent = (symbol == BOARD_X) ? BOARD_O : BOARD_X;
+    int best = 0, ties = 0, block_row = -1, block_col = -1;
+
+    for (int r = 0; r < board->rows; r++) {
+        for (int c = 0; c < board->cols; c++) {
+            if (!board_is_free(board, r, c)) continue;
+
+            Board trial = *board;
+            board_place(&trial, r, c, symbol);
+            if (board_winner(&trial) == symbol) {
+                *row = r;
+                *col = c;
+                return 1;
+            }
+
+            Board reply = *board;
+            board_place(&reply, r, c, opponent);
+            if (board_winner(&reply) == opponent) {
+                block_row = r;
+                block_col = c;
+                continue;
+            }
+            if (block_row >= 0) continue;
+
+            BoardScan scan;
+            board_scan(&trial, &scan);
+            int own = (symbol == BOARD_X) ? scan.threats_x : scan.threats_o;
+            int other = (symbol == BOARD_X) ? scan.threats_o : scan.threats_x;
+            int score = 4 * own - 2 * other - abs(2 * r - (board->rows - 1)) - abs(2 * c - (board->cols - 1));
+
+            // Scelta uniforme tra le celle a pari punteggio (reservoir sampling)
+            if (ties == 0 || score > best) {
+                best = score;
+                ties = 1;
+                *row = r;
+                *col = c;
+            } else if (score == best && bot_random(++ties) == 0) {
+                *row = r;
+                *col = c;
+            }
+        }
+    }
+
+    if (block_row >= 0) {
+        *row = block_row;
+        *col = block_col;
+        return 1;
+    }
+    return ties > 0;
+}
+
+/**
+ * Livello perfetto nel Tris classico: una lettura della tabella.
+ */
+static int bot_move_perfect(const Board *board, int *row, int *col) {
+    unsigned int x = board->x[0] | (board->x[1] << 3) | (board->x[2] << 6);
+    unsigned int o = board->o[0] | (board->o[1] << 3) | (board->o[2] << 6);
+
+    int cell = bot_moves[bot_index(x, o)];
+    if (cell < 0) return 0;
+
+    *row = cell / BOARD_SIDE;
+    *col = cell % BOARD_SIDE;
+    return 1;
+}
+
+// ========== SCELTA DELLA MOSSA ==========
+
+/**
+ * Sceglie la mossa del bot per il livello indicato.
+ *
+ * @param board Tabellone della partita
+ * @param symbol Simbolo del bot (BOARD_X o BOARD_O)
+ * @param level Livello di gioco (BOT_PERFECT è euristico fuori dal Tris classico)
+ * @param row Riga della mossa scelta (da 0)
+ * @param col Colonna della mossa scelta (da 0)
+ * @return 1 se è stata scelta una mossa, 0 se non è il turno di symbol
+ *         o la partita è finita
+ *
+ * @note Costo: una lettura della tabella nel Tris classico al livello
+ *       perfetto; al livello euristico una scansione completa (board_scan())
+ *       per cella libera
+ */
+int bot_choose_move(const Board *board, char symbol, BotLevel level, int *row, int *col) {
+    if (board_winner(board) != BOARD_EMPTY || board_is_full(board)) return 0;
+
+    char to_move = (board->moves & 1) ? BOARD_O : BOARD_X;
+    if (symbol != to_move) return 0;
+
+    switch (level) {
+        case BOT_RANDOM:
+            return bot_move_random(board, row, col);
+        case BOT_PERFECT:
+            if (bot_ready && board_is_classic(board)) return bot_move_perfect(board, row, col);
+            return bot_move_heuristic(board, symbol, row, col);
+        default:
+            return bot_move_heuristic(board, symbol, row, col);
+    }
+}
@@ -0,0 +1,303 @@
+#include "headers/client_index.h"
+#include "headers/game_manager.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static char tombstone_marker;
+#define INDEX_TOMBSTONE ((Client*)(void*)&tombstone_marker)
+
+static ClientIndex name_index;
+static ClientIndex token_index;
+static mutex_t index_mutex;     // Protegge entrambe le tabelle
+
+// ========== FUNZIONI HASH ==========
+
+/**
+ * Hash FNV-1a di un nome giocatore.
+ */
+static unsigned int hash_name(const char *name) {
+    unsigned int hash = 2166136261u;
+    while (*name) {
+        hash ^= (unsigned char)*name++;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+/**
+ * Hash di un token di sessione UDP. I token sono già mescolati
+ * (vedi udp_channel_new_token()): basta ripiegarli su 32 bit.
+ */
+static unsigned int hash_token(unsigned long long token) {
+    return (unsigned int)(token ^ (token >> 32));
+}
+
+// ========== TABELLE (chiamare con index_mutex acquisito) ==========
+
+/**
+ * Verifica se la chiave del client in una cella coincide con quella cercata.
+ *
+ * @param index Tabella di appartenenza
+ * @param client Client nella cella
+ * @param key Nome (const char*) o token (const unsigned long long*)
+ */
+static int index_key_matches(const ClientIndex *index, const Client *client, const void *key) {
+    if (index->by_token) {
+        return client->udp_token == *(const unsigned long long*)key;
+    }
+    return strcmp(client->name, (const char*)key) == 0;
+}
+
+/**
+ * Cerca la cella che contiene la chiave.
+ *
+ * @return Indice della cella, -1 se la chiave non è presente
+ */
+static long index_lookup(const ClientIndex *index, const void *key, unsigned int hash) {
+    if (!index->slots) return -1;
+
+    size_t mask = index->capacity - 1;
+    for (size_t i = hash & mask, probes = 0; probes < index->capacity; i = (i + 1) & mask, probes++) {
+        Client *client = index->slots[i].client;
+        if (!client) return -1;
+        if (client != INDEX_TOMBSTONE && index->slots[i].hash == hash &&
+            index_key_matches(index, client, key)) {
+            return (long)i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * Inserisce un client senza controlli di duplicato né ridimensionamento.
+ * Riutilizza la prima tombstone incontrata lungo la sequenza di probing.
+ */
+static void index_place(ClientIndex *index, Client *client, unsigned int hash) {
+    size_t mask = index->capacity - 1;
+    size_t i = hash & mask;
+    while (index->slots[i].client && index->slots[i].client != INDEX_TOMBSTONE) {
+        i = (i + 1) & mask;
+    }
+    if (index->slots[i].client == INDEX_TOMBSTONE) index->tombstones--;
+    index->slots[i].client = client;
+    index->slots[i].hash = hash;
+    index->used++;
+}
+
+/**
+ * Ricostruisce la tabella con la capacità indicata eliminando le tombstone.
+ *
+ * @return 1 in caso di successo, 0 se l'allocazione fallisce (tabella invariata)
+ */
+static int index_rebuild(ClientIndex *index, size_t capacity) {
+    ClientIndexSlot *slots = (ClientIndexSlot*)calloc(capacity, sizeof(ClientIndexSlot));
+    if (!slots) return 0;
+
+    ClientIndexSlot *old_slots = index->slots;
+    size_t old_capacity = index->capacity;
+
+    index->slots = slots;
+    index->capacity = capacity;
+    index->used = 0;
+    index->tombstones = 0;
+
+    for (size_t i = 0; i < old_capacity; i++) {
+        Client *client = old_slots[i].client;
+        if (client && client != INDEX_TOMBSTONE) {
+            index_place(index, client, old_slots[i].hash);
+        }
+    }
+    free(old_slots);
+    return 1;
+}
+
+/**
+ * Inserisce un client nella tabella, ricostruendola se troppo piena.
+ *
+ * @return 1 in caso di successo, 0 se la chiave è già presente o manca memoria
+ */
+static int index_insert(ClientIndex *index, Client *client, const void *key, unsigned int hash) {
+    if (index_lookup(index, key, hash) >= 0) return 0;
+
+    if ((index->used + index->tombstones + 1) * 100 > index->capacity * CLIENT_INDEX_MAX_LOAD) {
+        size_t capacity = index->capacity;
+        // Raddoppia solo se sono i client a riempire la tabella, non le tombstone
+        while ((index->used + 1) * 100 > capacity * CLIENT_INDEX_MAX_LOAD / 2) {
+            capacity *= 2;
+        }
+        if (!index_rebuild(index, capacity) &&
+            index->used + index->tombstones + 1 >= index->capacity) {
+            return 0;
+        }
+    }
+
+    index_place(index, client, hash);
+    return 1;
+}
+
+/**
+ * Rimuove la chiave dalla tabella lasciando una tombstone.
+ */
+static void index_delete(ClientIndex *index, const void *key, unsigned int hash) {
+    long i = index_lookup(index, key, hash);
+    if (i < 0) return;
+    index->slots[i].client = INDEX_TOMBSTONE;
+    index->used--;
+    index->tombstones++;
+}
+
+// ========== API PUBBLICA ==========
+
+/**
+ * Inizializza gli indici dei client.
+ *
+ * @param expected_clients Numero di client previsto (dimensionamento iniziale)
+ * @return 1 in caso di successo, 0 in caso di errore
+ */
+int client_index_init(size_t expected_clients) {
+    size_t capacity = CLIENT_INDEX_MIN_CAPACITY;
+    while (capacity * CLIENT_INDEX_MAX_LOAD < expected_clients * 100 * 2) {
+        capacity *= 2;
+    }
+
+    memset(&name_index, 0, sizeof(name_index));
+    memset(&token_index, 0, sizeof(token_index));
+    token_index.by_token = 1;
+
+    if (mutex_init(&index_mutex) != 0) return 0;
+    if (!index_rebuild(&name_index, capacity) || !index_rebuild(&token_index, capacity)) {
+        client_index_cleanup();
+        return 0;
+    }
+    return 1;
+}
+
+/**
+ * Libera le tabelle degli indici.
+ */
+void client_index_cleanup(void) {
+    free(name_index.slots);
+    free(token_index.slots);
+    memset(&name_index, 0, sizeof(name_index));
+    memset(&token_index, 0, sizeof(token_index));
+    mutex_destroy(&index_mutex);
+}
+
+/**
+ * Indicizza un client appena entrato nella lobby (per nome e, se
+ * assegnato, per token di sessione UDP).
+ *
+ * @param client Client da indicizzare
+ * @return 1 in caso di successo, 0 se il nome è già in uso
+ *
+ * @note Il token non cambia finché il client resta nella lobby
+ */
+int client_index_add(Client *client) {
+    mutex_lock(&index_mutex);
+    int ok = index_insert(&name_index, client, client->name, hash_name(client->name));
+    if (ok && client->udp_token) {
+        index_insert(&token_index, client, &client->udp_token, hash_token(client->udp_token));
+    }
+    mutex_unlock(&index_mutex);
+    return ok;
+}
+
+/**
+ * Rimuove un client da entrambi gli indici.
+ *
+ * @param client Client in uscita dalla lobby
+ */
+void client_index_remove(Client *client) {
+    mutex_lock(&index_mutex);
+    long i = index_lookup(&name_index, client->name, hash_name(client->name));
+    if (i >= 0 && name_index.slots[i].client == client) {
+        index_delete(&name_index, client->name, hash_name(client->name));
+    }
+    if (client->udp_token) {
+        i = index_lookup(&token_index, &client->udp_token, hash_token(client->udp_token));
+        if (i >= 0 && token_index.slots[i].client == client) {
+            index_delete(&token_index, &client->udp_token, hash_token(client->udp_token));
+        }
+    }
+    mutex_unlock(&index_mutex);
+}
+
+/**
+ * Cambia il nome di un client registrato aggiornando l'indice.
+ *
+ * @param client Client da rinominare (già indicizzato)
+ * @param new_name Nuovo nome
+ * @return 1 in caso di successo, 0 se il nuovo nome è già in uso
+ */
+int client_index_rename(Client *client, const char *new_name) {
+    mutex_lock(&index_mutex);
+    unsigned int new_hash = hash_name(new_name);
+    long existing = index_lookup(&name_index, new_name, new_hash);
+    if (existing >= 0 && name_index.slots[existing].client != client) {
+        mutex_unlock(&index_mutex);
+        return 0;
+    }
+
+    index_delete(&name_index, client->name, hash_name(client->name));
+    strncpy(client->name, new_name, sizeof(client->name) - 1);
+    client->name[sizeof(client->name) - 1] = '\0';
+    index_insert(&name_index, client, client->name, hash_name(client->name));
+    mutex_unlock(&index_mutex);
+    return 1;
+}
+
+/**
+ * Cerca un client registrato per nome.
+ *
+ * @param name Nome da cercare
+ * @return Client trovato, NULL altrimenti
+ *
+ * @note Il puntatore non è protetto da un riferimento: va usato solo come
+ *       controllo di esistenza. Per usare il client c'è client_index_acquire_by_name()
+ */
+Client* client_index_find_by_name(const char *name) {
+    if (!name) return NULL;
+
+    mutex_lock(&index_mutex);
+    long i = index_lookup(&name_index, name, hash_name(name));
+    Client *found = i >= 0 ? name_index.slots[i].client : NULL;
+    mutex_unlock(&index_mutex);
+    return found;
+}
+
+/**
+ * Cerca un client registrato per nome e ne prende un riferimento.
+ *
+ * @param name Nome da cercare
+ * @return Client trovato (da rilasciare con network_release_client()), NULL altrimenti
+ */
+Client* client_index_acquire_by_name(const char *name) {
+    if (!name) return NULL;
+
+    mutex_lock(&index_mutex);
+    long i = index_lookup(&name_index, name, hash_name(name));
+    Client *found = i >= 0 ? name_index.slots[i].client : NULL;
+    network_retain_client(found);
+    mutex_unlock(&index_mutex);
+    return found;
+}
+
+/**
+ * Cerca un client per token di sessione UDP e ne prende un riferimento.
+ * Il riferimento è preso sotto index_mutex: il client non può tornare al
+ * pool tra la ricerca e l'uso, anche se si disconnette nel frattempo.
+ *
+ * @param token Token che apre il datagramma
+ * @return Client trovato (da rilasciare con network_release_client()), NULL altrimenti
+ */
+Client* client_index_acquire_by_token(unsigned long long token) {
+    if (!token) return NULL;
+
+    mutex_lock(&index_mutex);
+    long i = index_lookup(&token_index, &token, hash_token(token));
+    Client *found = i >= 0 ? token_index.slots[i].client : NULL;
+    network_retain_client(found);
+    mutex_unlock(&index_mutex);
+    return found;
+}
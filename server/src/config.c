@@ -0,0 +1,207 @@
+#include "headers/config.h"
+#include "headers/bot.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+ServerConfig server_config = {
+    DEFAULT_PORT,
+    DEFAULT_MAX_CLIENTS,
+    DEFAULT_MAX_CLIENTS / DEFAULT_GAMES_PER_CLIENT_DIV,
+    DEFAULT_OUT_HIGH_WATERMARK,
+    DEFAULT_OUT_LOW_WATERMARK,
+    DEFAULT_OUT_MAX_BYTES,
+    DEFAULT_SLOW_CLIENT_TIMEOUT,
+    DEFAULT_LOBBY_TICK_MS,
+    DEFAULT_UDP_THREADS,
+    DEFAULT_BOT_FILL_DELAY,
+    DEFAULT_WAITING_TIMEOUT,
+    DEFAULT_BOT_LEVEL
+};
+
+/**
+ * Legge un intero positivo da una variabile d'ambiente.
+ *
+ * @param name Nome della variabile d'ambiente
+ * @param fallback Valore restituito se la variabile manca o non è valida
+ * @return Valore letto o fallback
+ */
+static long config_env_long(const char *name, long fallback) {
+    const char *value = getenv(name);
+    if (!value || *value == '\0') return fallback;
+
+    char *end;
+    long parsed = strtol(value, &end, 10);
+    if (*end != '\0' || parsed <= 0) {
+        printf("Valore non valido per %s: '%s' (uso %ld)\n", name, value, fallback);
+        return fallback;
+    }
+    return parsed;
+}
+
+/**
+ * Legge un intero positivo da un argomento della riga di comando.
+ *
+ * @param option Nome dell'opzione (per i messaggi di errore)
+ * @param value Testo dell'argomento, NULL se mancante
+ * @param fallback Valore restituito se l'argomento manca o non è valido
+ * @return Valore letto o fallback
+ */
+static long config_arg_long(const char *option, const char *value, long fallback) {
+    if (!value || *value == '\0') {
+        printf("Valore mancante per %s (uso %ld)\n", option, fallback);
+        return fallback;
+    }
+
+    char *end;
+    long parsed = strtol(value, &end, 10);
+    if (*end != '\0' || parsed <= 0) {
+        printf("Valore non valido per %s: '%s' (uso %ld)\n", option, value, fallback);
+        return fallback;
+    }
+    return parsed;
+}
+
+/**
+ * Imposta il livello del bot dal suo nome.
+ *
+ * @param option Variabile o opzione di provenienza (per i messaggi di errore)
+ * @param value Nome del livello, NULL se mancante
+ */
+static void config_set_bot_level(const char *option, const char *value) {
+    BotLevel level;
+    if (!value || *value == '\0') {
+        printf("Valore mancante per %s (uso %s)\n", option,
+               bot_level_name((BotLevel)server_config.bot_level));
+    } else if (bot_parse_level(value, &level)) {
+        server_config.bot_level = (int)level;
+    } else {
+        printf("Valore non valido per %s: '%s' (uso %s)\n", option, value,
+               bot_level_name((BotLevel)server_config.bot_level));
+    }
+}
+
+/**
+ * Applica le opzioni della riga di comando, che prevalgono sull'ambiente.
+ * Opzioni riconosciute: --port N (-p), --max-clients N (-c), --max-games N (-g),
+ * --lobby-tick MS, --udp-threads N, --bot-delay S, --wait-timeout S,
+ * --bot-level NOME, anche nella forma --opzione=N.
+ * Un argomento che inizia con '-' è l'opzione successiva, non un valore:
+ * i valori ammessi sono tutti positivi.
+ *
+ * @param argc Numero di argomenti
+ * @param argv Argomenti del programma
+ * @param games_set Impostato a 1 se --max-games è stato indicato
+ */
+static void config_parse_args(int argc, char *argv[], int *games_set) {
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        const char *value = NULL;
+        const char *eq = strchr(arg, '=');
+        size_t name_len = eq ? (size_t)(eq - arg) : strlen(arg);
+
+        if (eq) value = eq + 1;
+        else if (i + 1 < argc && argv[i + 1][0] != '-') value = argv[i + 1];
+
+        int consumed = (!eq && value) ? 1 : 0;
+        if ((name_len == 6 && strncmp(arg, "--port", 6) == 0) || strcmp(arg, "-p") == 0) {
+            server_config.port = (int)config_arg_long("--port", value, server_config.port);
+        } else if ((name_len == 13 && strncmp(arg, "--max-clients", 13) == 0) || strcmp(arg, "-c") == 0) {
+            server_config.max_clients = (int)config_arg_long("--max-clients", value, server_config.max_clients);
+        } else if ((name_len == 11 && strncmp(arg, "--max-games", 11) == 0) || strcmp(arg, "-g") == 0) {
+            server_config.max_games = (int)config_arg_long("--max-games", value, server_config.max_games);
+            *games_set = 1;
+        } else if (name_len == 12 && strncmp(arg, "--lobby-tick", 12) == 0) {
+            server_config.lobby_tick_ms = (int)config_arg_long("--lobby-tick", value, server_config.lobby_tick_ms);
+        } else if (name_len == 13 && strncmp(arg, "--udp-threads", 13) == 0) {
+            server_config.udp_threads = (int)config_arg_long("--udp-threads", value, server_config.udp_threads);
+        } else if (name_len == 11 && strncmp(arg, "--bot-delay", 11) == 0) {
+            server_config.bot_fill_delay = (int)config_arg_long("--bot-delay", value, server_config.bot_fill_delay);
+        } else if (name_len == 14 && strncmp(arg, "--wait-timeout", 14) == 0) {
+            server_config.waiting_timeout = (int)config_arg_long("--wait-timeout", value, server_config.waiting_timeout);
+        } else if (name_len == 11 && strncmp(arg, "--bot-level", 11) == 0) {
+            config_set_bot_level("--bot-level", value);
+        } else {
+            printf("Opzione sconosciuta ignorata: %s\n", arg);
+            consumed = 0;
+        }
+        i += consumed;
+    }
+}
+
+/**
+ * Carica la configurazione dalle variabili d'ambiente e dalla riga di comando.
+ * Variabili riconosciute: PORT, MAX_CLIENTS, MAX_GAMES, OUT_HIGH_WATERMARK,
+ * OUT_LOW_WATERMARK, OUT_MAX_BYTES, SLOW_CLIENT_TIMEOUT, LOBBY_TICK_MS, UDP_THREADS,
+ * BOT_FILL_DELAY, WAITING_TIMEOUT, BOT_LEVEL.
+ *
+ * @param argc Numero di argomenti del programma
+ * @param argv Argomenti del programma (vedi config_parse_args())
+ *
+ * @note Se MAX_GAMES non è indicato vale MAX_CLIENTS / DEFAULT_GAMES_PER_CLIENT_DIV
+ * @note Se le soglie non rispettano low < high <= max vengono ripristinati i default
+ * @note LOBBY_TICK_MS oltre LOBBY_TICK_MS_MAX viene ridotto al massimo
+ * @note Con BOT_FILL_DELAY pari o superiore a WAITING_TIMEOUT il bot non
+ *       viene offerto (PLAY_BOT resta disponibile)
+ */
+void config_load(int argc, char *argv[]) {
+    int games_set = getenv("MAX_GAMES") && *getenv("MAX_GAMES");
+
+    server_config.port = (int)config_env_long("PORT", DEFAULT_PORT);
+    server_config.max_clients = (int)config_env_long("MAX_CLIENTS", DEFAULT_MAX_CLIENTS);
+    server_config.max_games = (int)config_env_long("MAX_GAMES", server_config.max_clients / DEFAULT_GAMES_PER_CLIENT_DIV);
+    server_config.lobby_tick_ms = (int)config_env_long("LOBBY_TICK_MS", DEFAULT_LOBBY_TICK_MS);
+    server_config.udp_threads = (int)config_env_long("UDP_THREADS", DEFAULT_UDP_THREADS);
+    server_config.bot_fill_delay = (int)config_env_long("BOT_FILL_DELAY", DEFAULT_BOT_FILL_DELAY);
+    server_config.waiting_timeout = (int)config_env_long("WAITING_TIMEOUT", DEFAULT_WAITING_TIMEOUT);
+    server_config.bot_level = DEFAULT_BOT_LEVEL;
+    if (getenv("BOT_LEVEL") && *getenv("BOT_LEVEL")) config_set_bot_level("BOT_LEVEL", getenv("BOT_LEVEL"));
+    config_parse_args(argc, argv, &games_set);
+
+    if (server_config.port > 65535) {
+        printf("Porta %d non valida, uso %d\n", server_config.port, DEFAULT_PORT);
+        server_config.port = DEFAULT_PORT;
+    }
+    if (!games_set) {
+        server_config.max_games = server_config.max_clients / DEFAULT_GAMES_PER_CLIENT_DIV;
+    }
+    if (server_config.max_games < 1) server_config.max_games = 1;
+    if (server_config.lobby_tick_ms > LOBBY_TICK_MS_MAX) {
+        printf("Finestra lista partite %d ms troppo ampia, uso %d\n", server_config.lobby_tick_ms, LOBBY_TICK_MS_MAX);
+        server_config.lobby_tick_ms = LOBBY_TICK_MS_MAX;
+    }
+
+    server_config.out_high_watermark = (size_t)config_env_long("OUT_HIGH_WATERMARK", DEFAULT_OUT_HIGH_WATERMARK);
+    server_config.out_low_watermark = (size_t)config_env_long("OUT_LOW_WATERMARK", DEFAULT_OUT_LOW_WATERMARK);
+    server_config.out_max_bytes = (size_t)config_env_long("OUT_MAX_BYTES", DEFAULT_OUT_MAX_BYTES);
+    server_config.slow_client_timeout = (int)config_env_long("SLOW_CLIENT_TIMEOUT", DEFAULT_SLOW_CLIENT_TIMEOUT);
+
+    if (server_config.out_low_watermark >= server_config.out_high_watermark ||
+        server_config.out_high_watermark > server_config.out_max_bytes) {
+        printf("Watermark della coda di invio incoerenti, uso i valori di default\n");
+        server_config.out_high_watermark = DEFAULT_OUT_HIGH_WATERMARK;
+        server_config.out_low_watermark = DEFAULT_OUT_LOW_WATERMARK;
+        server_config.out_max_bytes = DEFAULT_OUT_MAX_BYTES;
+    }
+}
+
+/**
+ * Stampa la configurazione attiva.
+ */
+void config_print(void) {
+    printf("Porta %d, fino a %d client e %d partite simultanee\n",
+           server_config.port, server_config.max_clients, server_config.max_games);
+    printf("Coda di invio: low %zu / high %zu / max %zu byte, client lenti disconnessi dopo %d s\n",
+           server_config.out_low_watermark, server_config.out_high_watermark,
+           server_config.out_max_bytes, server_config.slow_client_timeout);
+    printf("Aggiornamenti lista partite accorpati ogni %d ms\n", server_config.lobby_tick_ms);
+    printf("Thread UDP richiesti: %d (al massimo uno per CPU)\n", server_config.udp_threads);
+    if (server_config.bot_fill_delay < server_config.waiting_timeout) {
+        printf("Partite senza avversario: bot %s offerto dopo %d s, chiuse dopo %d s\n",
+               bot_level_name((BotLevel)server_config.bot_level), server_config.bot_fill_delay,
+               server_config.waiting_timeout);
+    } else {
+        printf("Partite senza avversario: chiuse dopo %d s (bot %s solo con PLAY_BOT)\n",
+               server_config.waiting_timeout, bot_level_name((BotLevel)server_config.bot_level));
+    }
+}
@@ -2,14 +2,52 @@
 #include "headers/game_manager.h"
 #include "headers/network.h"
 #include "headers/lobby.h"
+#include "headers/config.h"
+#include "headers/slab.h"
+#include "headers/udp_channel.h"
+#include "headers/bot.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 
-static Game games[MAX_GAMES];
-static mutex_t games_mutex;  // CAMBIATO: era CRITICAL_SECTION
-static int next_game_id = 1;
+static Slab games;           // Slot delle partite, crescono a blocchi fino a max_games
+static mutex_t games_mutex;  // Protegge la free-list e la crescita degli slot
+static int free_head = -1;   // Primo slot libero (riusato per primo)
+static int free_tail = -1;   // Ultimo slot liberato (FIFO: allontana il riuso di uno slot)
+
+// Liste di attesa: partite in GAME_STATE_WAITING in ordine di wait_since (WAIT_QUEUE_*)
+static mutex_t wait_mutex;                          // Protegge le liste (acquisito dopo game->mutex)
+static int wait_head[WAIT_QUEUES] = { -1, -1 };     // Partita in attesa da più tempo
+static int wait_tail[WAIT_QUEUES] = { -1, -1 };     // Ultima partita entrata nella lista
+static int wait_ready = 0;   // 1 dopo game_manager_init() (atomico, letto dal tick della lobby)
+
+/**
+ * Aggiornamento della lista partite (LIST_UPDATE:) conservato nel registro.
+ */
+typedef struct {
+    unsigned long seq;                      // Numero di sequenza (0 = voce mai scritta)
+    SharedMsg *msg;                         // Messaggio pronto per l'invio, condiviso dalle code dei client
+} ListDelta;
+
+/**
+ * Gruppo dell'indice della lista: slot delle partite elencate con lo stesso stato.
+ */
+typedef struct {
+    int *slots;                             // Slot delle partite (max_games voci)
+    int count;                              // Partite nel gruppo
+} ListGroup;
+
+// Lista partite: ogni modifica visibile produce un aggiornamento con numero di
+// sequenza e aggiorna l'indice per stato da cui sono servite le pagine
+static unsigned long list_version = 1;      // Sequenza dell'ultimo aggiornamento pubblicato
+static ListDelta list_deltas[LIST_DELTA_LOG];
+static ListGroup list_groups[LIST_FILTER_COUNT];
+static mutex_t list_mutex;                  // Protegge registro e indice (mai altri lock acquisiti dentro)
+
+static const char *list_filter_names[LIST_FILTER_COUNT] = { "WAITING", "PENDING", "PLAYING", "REMATCH" };
+
+static void game_list_publish(Game *game);
 
 /**
  * Inizializza un mutex per la sincronizzazione cross-platform.
@@ -70,35 +108,309 @@ int mutex_destroy(mutex_t *mutex) {
     #endif
 }
 
+/**
+ * Restituisce la partita nello slot indicato.
+ * 
+ * @param slot Indice dello slot
+ * @return Puntatore alla partita, NULL se lo slot non è ancora allocato
+ */
+static Game* game_at(int slot) {
+    return (Game*)slab_at(&games, (size_t)slot);
+}
+
+/**
+ * Assegna un campo giocatore della partita (player1, player2, pending_player,
+ * rematch_requester): prende un riferimento al nuovo client e lascia quello
+ * del precedente, così un client puntato da una partita non torna mai al pool.
+ * NOTA: deve essere chiamata con game->mutex acquisito.
+ * 
+ * @param field Campo da aggiornare
+ * @param client Nuovo valore (NULL per svuotare il campo)
+ */
+static void game_set_client(Client **field, Client *client) {
+    if (*field == client) return;
+    network_retain_client(client);
+    network_release_client(*field);
+    *field = client;
+}
+
+/**
+ * Lascia i riferimenti di tutti i giocatori di una partita.
+ * NOTA: deve essere chiamata con game->mutex acquisito.
+ * 
+ * @param game Partita da svuotare
+ */
+static void game_clear_clients(Game *game) {
+    game_set_client(&game->player1, NULL);
+    game_set_client(&game->player2, NULL);
+    game_set_client(&game->pending_player, NULL);
+    game_set_client(&game->rematch_requester, NULL);
+}
+
+/**
+ * Aggiunge una partita in fondo a una lista di attesa (wait_mutex acquisito).
+ */
+static void game_wait_link(Game *game, int queue) {
+    game->wait_queue = queue;
+    game->wait_prev = wait_tail[queue];
+    game->wait_next = -1;
+    if (wait_tail[queue] >= 0) game_at(wait_tail[queue])->wait_next = game->slot;
+    else wait_head[queue] = game->slot;
+    wait_tail[queue] = game->slot;
+}
+
+/**
+ * Toglie una partita dalla sua lista di attesa, se ne ha una (wait_mutex acquisito).
+ */
+static void game_wait_unlink(Game *game) {
+    int queue = game->wait_queue;
+    if (queue < 0) return;
+    if (game->wait_prev >= 0) game_at(game->wait_prev)->wait_next = game->wait_next;
+    else wait_head[queue] = game->wait_next;
+    if (game->wait_next >= 0) game_at(game->wait_next)->wait_prev = game->wait_prev;
+    else wait_tail[queue] = game->wait_prev;
+    game->wait_prev = game->wait_next = -1;
+    game->wait_queue = -1;
+}
+
+/**
+ * Accoda una partita alle liste di attesa: è appena entrata in
+ * GAME_STATE_WAITING, quindi l'ordine per wait_since resta rispettato.
+ * Con le offerte del bot disattivate passa direttamente alla lista delle scadenze.
+ * NOTA: deve essere chiamata con game->mutex acquisito.
+ * 
+ * @param game Partita in attesa di avversario
+ * 
+ * @note Ordine dei lock: game->mutex, poi wait_mutex
+ */
+static void game_wait_push(Game *game) {
+    int offer = server_config.bot_fill_delay < server_config.waiting_timeout;
+    
+    mutex_lock(&wait_mutex);
+    if (game->wait_queue < 0) {
+        game->wait_since = udp_channel_now_ms();
+        game_wait_link(game, offer ? WAIT_QUEUE_OFFER : WAIT_QUEUE_EXPIRE);
+    }
+    mutex_unlock(&wait_mutex);
+}
+
+/**
+ * Toglie una partita dalle liste di attesa (se presente): è uscita da
+ * GAME_STATE_WAITING o viene chiusa.
+ * NOTA: deve essere chiamata con game->mutex acquisito.
+ * 
+ * @param game Partita
+ */
+static void game_wait_remove(Game *game) {
+    mutex_lock(&wait_mutex);
+    game_wait_unlink(game);
+    mutex_unlock(&wait_mutex);
+}
+
+/**
+ * Restituisce l'ID della partita in testa a una lista di attesa se vi è
+ * entrata prima della scadenza indicata.
+ * 
+ * @param queue Lista (WAIT_QUEUE_OFFER o WAIT_QUEUE_EXPIRE)
+ * @param deadline Istante (ms monotoni) entro cui la testa deve essere entrata in attesa
+ * @return ID della partita, -1 se la lista è vuota o la testa non è ancora scaduta
+ */
+static int game_wait_due(int queue, long long deadline) {
+    int game_id = -1;
+    
+    mutex_lock(&wait_mutex);
+    if (wait_head[queue] >= 0) {
+        Game *head = game_at(wait_head[queue]);
+        if (head->wait_since <= deadline) game_id = head->game_id;
+    }
+    mutex_unlock(&wait_mutex);
+    return game_id;
+}
+
+/**
+ * Libera i gruppi dell'indice della lista partite.
+ */
+static void game_list_free_index(void) {
+    for (int i = 0; i < LIST_FILTER_COUNT; i++) {
+        free(list_groups[i].slots);
+        list_groups[i].slots = NULL;
+        list_groups[i].count = 0;
+    }
+}
+
+/**
+ * Invia lo stesso messaggio a entrambi i giocatori di una partita: il testo
+ * viene copiato una sola volta e le due code condividono il buffer.
+ * NOTA: deve essere chiamata con game->mutex acquisito.
+ * 
+ * @param game Partita destinataria
+ * @param message Messaggio da inviare
+ */
+static void game_send_to_players(Game *game, const char *message) {
+    SharedMsg *msg = network_msg_create(message);
+    if (!msg) return;
+    
+    if (game->player1) network_send_msg(game->player1, msg);
+    if (game->player2) network_send_msg(game->player2, msg);
+    network_msg_release(msg);
+}
+
+/**
+ * Invia un evento di partita (MOVE, GAME_OVER) a entrambi i giocatori sul
+ * loro canale UDP affidabile, così non attende dietro al traffico della
+ * lobby accodato su TCP. Per chi non ha un canale UDP aperto l'evento
+ * segue la coda TCP, con un unico buffer condiviso come in game_send_to_players().
+ * NOTA: deve essere chiamata con game->mutex acquisito.
+ * 
+ * @param game Partita destinataria
+ * @param message Evento da inviare
+ */
+static void game_send_event_to_players(Game *game, const char *message) {
+    Client *players[2] = { game->player1, game->player2 };
+    SharedMsg *msg = NULL;
+    
+    for (int i = 0; i < 2; i++) {
+        if (!players[i] || udp_channel_send(players[i], message)) continue;
+        if (!msg && !(msg = network_msg_create(message))) return;
+        network_send_msg(players[i], msg);
+    }
+    if (msg) network_msg_release(msg);
+}
+
+/**
+ * Invia GAME_START a un giocatore. Contro il bot la nota riporta il suo
+ * livello ("GAME_START:X:heuristic").
+ * NOTA: deve essere chiamata con game->mutex acquisito.
+ * 
+ * @param game Partita che inizia
+ * @param client Destinatario
+ * @param symbol Simbolo assegnato al destinatario
+ * @param opponent Avversario del destinatario
+ */
+static void game_send_start_to(Game *game, Client *client, PlayerSymbol symbol, Client *opponent) {
+    char msg[48];
+    int len = message_encode_game_start(msg, sizeof(msg), (char)symbol);
+    if (len <= 0) return;
+    if (opponent && opponent->is_bot) {
+        snprintf(msg + len, sizeof(msg) - (size_t)len, ":%s", bot_level_name((BotLevel)game->bot_level));
+    }
+    network_send_to_client(client, msg);
+}
+
+/**
+ * Avvia la partita comunicando a ciascun giocatore il proprio simbolo
+ * (player1 gioca sempre con X). Per le varianti diverse dal Tris classico
+ * GAME_VARIANT precede GAME_START, così il client prepara il tabellone giusto.
+ * NOTA: deve essere chiamata con game->mutex acquisito.
+ * 
+ * @param game Partita con entrambi i giocatori
+ */
+static void game_send_start(Game *game) {
+    char msg[32];
+    if (!board_is_classic(&game->board) &&
+        message_encode_game_variant(msg, sizeof(msg), game->board.rows, game->board.cols, game->board.k)) {
+        network_send_to_client(game->player1, msg);
+        network_send_to_client(game->player2, msg);
+    }
+    game_send_start_to(game, game->player1, PLAYER_X, game->player2);
+    game_send_start_to(game, game->player2, PLAYER_O, game->player1);
+}
+
+/**
+ * Alloca un nuovo blocco di slot e li accoda alla free-list.
+ * NOTA: deve essere chiamata con games_mutex acquisito.
+ * 
+ * @return 1 in caso di successo, 0 se si è raggiunto max_games o manca memoria
+ */
+static int game_grow_slots() {
+    size_t first, count;
+    if (!slab_grow(&games, &first, &count)) return 0;
+    
+    for (size_t i = first; i < first + count; i++) {
+        Game *game = game_at((int)i);
+        game->game_id = -1;
+        game->state = GAME_STATE_WAITING;
+        game->generation = 1;
+        game->slot = (int)i;
+        game->next_free = -1;
+        game->list_group = -1;
+        game->wait_queue = -1;
+        game->wait_prev = -1;
+        game->wait_next = -1;
+        mutex_init(&game->mutex);
+        
+        if (free_tail >= 0) game_at(free_tail)->next_free = (int)i;
+        else free_head = (int)i;
+        free_tail = (int)i;
+    }
+    
+    printf("Slot partite aumentati a %zu\n", first + count);
+    return 1;
+}
+
 /**
  * Inizializza il gestore delle partite, preparando tutte le strutture dati necessarie.
- * Inizializza l'array di partite, i mutex associati e imposta i valori di default.
+ * Gli slot sono allocati a blocchi di GAME_CHUNK_SLOTS su richiesta, fino a
+ * server_config.max_games; il primo blocco viene allocato subito.
  * 
  * @return 1 in caso di successo, 0 in caso di errore
  */
 int game_manager_init() {
-    if (mutex_init(&games_mutex) != 0) return 0;
-    
-    if (mutex_lock(&games_mutex) != 0) return 0;
-    
-    for (int i = 0; i < MAX_GAMES; i++) {
-        memset(&games[i], 0, sizeof(Game));
-        games[i].game_id = -1;
-        games[i].state = GAME_STATE_WAITING;
-        if (mutex_init(&games[i].mutex) != 0) {
-            // Aggiungi cleanup per i mutex già inizializzati
-            for (int j = 0; j < i; j++) {
-                mutex_destroy(&games[j].mutex);
-            }
-            mutex_unlock(&games_mutex);
-            mutex_destroy(&games_mutex);
-            return 0;
-        }
+    if (server_config.max_games > GAME_SLOT_MASK + 1) {
+        printf("Massimo %d partite simultanee con ID a %d bit di slot\n", GAME_SLOT_MASK + 1, GAME_SLOT_BITS);
+        server_config.max_games = GAME_SLOT_MASK + 1;
     }
     
-    if (mutex_unlock(&games_mutex) != 0) return 0;
+    if (!slab_init(&games, sizeof(Game), GAME_CHUNK_SLOTS, (size_t)server_config.max_games)) return 0;
+    if (mutex_init(&games_mutex) != 0) {
+        slab_destroy(&games);
+        return 0;
+    }
+    if (mutex_init(&list_mutex) != 0) {
+        mutex_destroy(&games_mutex);
+        slab_destroy(&games);
+        return 0;
+    }
+    if (mutex_init(&wait_mutex) != 0) {
+        mutex_destroy(&list_mutex);
+        mutex_destroy(&games_mutex);
+        slab_destroy(&games);
+        return 0;
+    }
+    list_version = 1;
+    memset(list_deltas, 0, sizeof(list_deltas));
+    int ok = 1;
+    for (int i = 0; i < LIST_FILTER_COUNT; i++) {
+        list_groups[i].count = 0;
+        list_groups[i].slots = (int*)malloc((size_t)server_config.max_games * sizeof(int));
+        if (!list_groups[i].slots) ok = 0;
+    }
+    
+    free_head = -1;
+    free_tail = -1;
+    for (int i = 0; i < WAIT_QUEUES; i++) {
+        wait_head[i] = -1;
+        wait_tail[i] = -1;
+    }
     
-    printf("Game Manager inizializzato\n");
+    if (ok) {
+        mutex_lock(&games_mutex);
+        ok = game_grow_slots();
+        mutex_unlock(&games_mutex);
+    }
+    if (!ok) {
+        game_list_free_index();
+        mutex_destroy(&wait_mutex);
+        mutex_destroy(&list_mutex);
+        mutex_destroy(&games_mutex);
+        slab_destroy(&games);
+        return 0;
+    }
+    
+    bot_init();
+    __atomic_store_n(&wait_ready, 1, __ATOMIC_RELEASE);
+    printf("Game Manager inizializzato (max %d partite, scansione tabellone %s)\n",
+           server_config.max_games, board_scan_impl());
     return 1;
 }
 
@@ -108,49 +420,114 @@ int game_manager_init() {
  */
 void game_manager_cleanup() {
     if (mutex_lock(&games_mutex) != 0) return;
+    __atomic_store_n(&wait_ready, 0, __ATOMIC_RELEASE);
     
-    for (int i = 0; i < MAX_GAMES; i++) {
-        mutex_destroy(&games[i].mutex);
+    int capacity = (int)slab_capacity(&games);
+    for (int i = 0; i < capacity; i++) {
+        Game *game = game_at(i);
+        game_clear_clients(game);
+        mutex_destroy(&game->mutex);
     }
     
     mutex_unlock(&games_mutex);
     mutex_destroy(&games_mutex);
+    for (int i = 0; i < LIST_DELTA_LOG; i++) {
+        network_msg_release(list_deltas[i].msg);
+        list_deltas[i].msg = NULL;
+    }
+    mutex_destroy(&list_mutex);
+    mutex_destroy(&wait_mutex);
+    game_list_free_index();
+    slab_destroy(&games);
     
     printf("Game Manager pulito\n");
 }
 
 /**
- * Cerca una partita nell'array delle partite utilizzando l'ID.
- * La ricerca è thread-safe grazie al mutex globale.
+ * Cerca una partita utilizzando l'ID.
+ * L'ID contiene l'indice dello slot, quindi la ricerca è O(1) e non usa
+ * lock globali; un ID di una partita già chiusa non corrisponde più alla
+ * generazione corrente dello slot e non viene trovato.
  * 
  * @param game_id ID della partita da cercare
  * @return Puntatore alla partita se trovata, NULL altrimenti
+ * 
+ * @note Senza game->mutex la partita può chiudersi subito dopo: chi deve
+ *       modificarla usa game_lock_by_id(), che ricontrolla l'ID sotto lock
  */
 Game* game_find_by_id(int game_id) {
-    mutex_lock(&games_mutex);  // CAMBIATO: era EnterCriticalSection
-    for (int i = 0; i < MAX_GAMES; i++) {
-        if (games[i].game_id == game_id) {
-            mutex_unlock(&games_mutex);  // CAMBIATO: era LeaveCriticalSection
-            return &games[i];
-        }
+    if (game_id <= 0) return NULL;
+    
+    Game *game = game_at(GAME_ID_SLOT(game_id));
+    return (game && game->game_id == game_id) ? game : NULL;
+}
+
+/**
+ * Cerca una partita per ID e ne acquisisce il mutex.
+ * 
+ * @param game_id ID della partita
+ * @return Partita con game->mutex acquisito, NULL se non esiste
+ *         (o è stata chiusa prima di acquisire il lock)
+ */
+static Game* game_lock_by_id(int game_id) {
+    Game *game = game_find_by_id(game_id);
+    if (!game) return NULL;
+    
+    mutex_lock(&game->mutex);
+    if (game->game_id != game_id) {
+        mutex_unlock(&game->mutex);
+        return NULL;
     }
-    mutex_unlock(&games_mutex);  // CAMBIATO: era LeaveCriticalSection
-    return NULL;
+    return game;
 }
 
 /**
- * Trova il primo slot libero nell'array delle partite.
- * NOTA: Questa funzione non è thread-safe, deve essere chiamata con il mutex acquisito.
+ * Libera lo slot di una partita chiusa.
+ * Lascia i riferimenti ai giocatori, incrementa la generazione (gli ID già
+ * distribuiti non sono più validi) e accoda lo slot alla free-list.
  * 
- * @return Puntatore al primo slot libero, NULL se non ci sono slot disponibili
+ * @param game Partita da liberare (con game->mutex acquisito)
+ * 
+ * @note Ordine dei lock: game->mutex, poi games_mutex
  */
-static Game* game_find_free_slot() {
-    for (int i = 0; i < MAX_GAMES; i++) {
-        if (games[i].game_id == -1) {
-            return &games[i];
-        }
+static void game_release_slot(Game *game) {
+    int slot = game->slot;
+    
+    game_clear_clients(game);
+    game_wait_remove(game);
+    game->game_id = -1;
+    game->generation = (game->generation >= GAME_GENERATION_MAX) ? 1 : game->generation + 1;
+    game_list_publish(game);
+    
+    mutex_lock(&games_mutex);
+    game->next_free = -1;
+    if (free_tail >= 0) game_at(free_tail)->next_free = slot;
+    else free_head = slot;
+    free_tail = slot;
+    mutex_unlock(&games_mutex);
+}
+
+/**
+ * Estrae il primo slot libero dalla free-list, allocando un nuovo blocco
+ * di slot se la free-list è vuota.
+ * 
+ * @return Puntatore allo slot libero, NULL se non ci sono slot disponibili
+ */
+static Game* game_alloc_slot() {
+    mutex_lock(&games_mutex);
+    if (free_head < 0) game_grow_slots();
+    
+    int slot = free_head;
+    Game *game = NULL;
+    if (slot >= 0) {
+        game = game_at(slot);
+        free_head = game->next_free;
+        if (free_head < 0) free_tail = -1;
+        game->next_free = -1;
     }
-    return NULL;
+    mutex_unlock(&games_mutex);
+    
+    return game;
 }
 
 /**
@@ -159,11 +536,7 @@ static Game* game_find_free_slot() {
  * @param game Puntatore alla partita di cui inizializzare la griglia
  */
 void game_init_board(Game *game) {
-    for (int i = 0; i < 3; i++) {
-        for (int j = 0; j < 3; j++) {
-            game->board[i][j] = PLAYER_NONE;
-        }
-    }
+    board_clear(&game->board);
 }
 
 /**
@@ -171,22 +544,21 @@ void game_init_board(Game *game) {
  * Il creatore diventa automaticamente il giocatore X e la partita entra in stato di attesa.
  * 
  * @param creator Client che crea la partita
- * @return ID della partita creata, -1 in caso di errore
+ * @param rows Righe del tabellone
+ * @param cols Colonne del tabellone
+ * @param k Simboli da allineare per vincere
+ * @return ID della partita creata, -1 in caso di errore o variante non valida
  */
-int game_create_new(Client *creator) {
-    if (!creator) return -1;
+int game_create_new(Client *creator, int rows, int cols, int k) {
+    if (!creator || !board_variant_valid(rows, cols, k)) return -1;
     
-    mutex_lock(&games_mutex);  // CAMBIATO: era EnterCriticalSection
-    Game *game = game_find_free_slot();
+    Game *game = game_alloc_slot();
     if (!game) {
-        mutex_unlock(&games_mutex);  // CAMBIATO: era LeaveCriticalSection
         return -1;
     }
     
-    game->game_id = next_game_id++;
-    game->player1 = creator;
-    game->player2 = NULL;
-    game->pending_player = NULL;
+    mutex_lock(&game->mutex);
+    game_set_client(&game->player1, creator);
     game->current_player = PLAYER_X;
     game->state = GAME_STATE_WAITING;
     game->winner = PLAYER_NONE;
@@ -194,15 +566,25 @@ int game_create_new(Client *creator) {
     game->rematch_requests = 0;
     game->rematch_declined = 0;
     game->creation_time = time(NULL);  // AGGIUNTO: era mancante
-    game_init_board(game);
+    board_init(&game->board, rows, cols, k);
+    
+    // Pubblica l'ID per ultimo: da qui la partita è visibile a game_find_by_id()
+    int game_id = GAME_MAKE_ID(game->generation, game->slot);
+    game->game_id = game_id;
     
-    creator->game_id = game->game_id;
+    creator->game_id = game_id;
     creator->symbol = 'X';
+    game_wait_push(game);
+    game_list_publish(game);
     
-    mutex_unlock(&games_mutex);  // CAMBIATO: era LeaveCriticalSection
+    mutex_unlock(&game->mutex);
     
-    printf("Partita %d creata da %s\n", game->game_id, creator->name);
-    return game->game_id;
+    if (board_is_classic(&game->board)) {
+        printf("Partita %d creata da %s\n", game_id, creator->name);
+    } else {
+        printf("Partita %d creata da %s (variante %dx%d, allineamento %d)\n", game_id, creator->name, rows, cols, k);
+    }
+    return game_id;
 }
 
 /**
@@ -218,61 +600,63 @@ int game_join(Client *client, int game_id) {
 
     // Controllo migliorato per client già in partita
     if (client->game_id > 0) {
-        char error_msg[50];
+        char error_msg[64];
         Game *current_game = game_find_by_id(client->game_id);
         
         if (current_game && current_game->game_id == game_id) {
-            snprintf(error_msg, sizeof(error_msg), "ERROR:Sei già in questa partita (ID: %d)", game_id);
+            message_encode_error(error_msg, sizeof(error_msg), "Sei già in questa partita (ID: %d)", game_id);
         } else {
-            snprintf(error_msg, sizeof(error_msg), "ERROR:Sei già in un'altra partita (ID: %d)", client->game_id);
+            message_encode_error(error_msg, sizeof(error_msg), "Sei già in un'altra partita (ID: %d)", client->game_id);
         }
         
         network_send_to_client(client, error_msg);
         return 0;
     }
 
-    Game *game = game_find_by_id(game_id);
+    Game *game = game_lock_by_id(game_id);
     if (!game) {
-        network_send_to_client(client, "ERROR:Partita non trovata");
+        network_send_message(client, SMSG_ERROR, "Partita non trovata");
         return 0;
     }
 
-    mutex_lock(&game->mutex);
-
     // Controllo migliorato per join alla propria partita
     if (game->player1 == client) {
-        network_send_to_client(client, "ERROR:Non puoi unirti alla tua partita");
+        network_send_message(client, SMSG_ERROR, "Non puoi unirti alla tua partita");
         mutex_unlock(&game->mutex);
         return 0;
     }
 
     if (game->state != GAME_STATE_WAITING || !game->player1 || game->player2) {
-        network_send_to_client(client, "ERROR:Partita non disponibile");
+        network_send_message(client, SMSG_ERROR, "Partita non disponibile");
         mutex_unlock(&game->mutex);
         return 0;
     }
 
     // Sistema di approvazione - il join non è più automatico
     if (game->pending_player) {
-        network_send_to_client(client, "ERROR:C'è già un giocatore in attesa di approvazione");
+        network_send_message(client, SMSG_ERROR, "C'è già un giocatore in attesa di approvazione");
         mutex_unlock(&game->mutex);
         return 0;
     }
 
     // Metti il giocatore in attesa di approvazione
-    game->pending_player = client;
+    game_set_client(&game->pending_player, client);
     game->state = GAME_STATE_PENDING_APPROVAL;
+    game_wait_remove(game);
     client->game_id = game_id;  // Temporaneo, sarà confermato se approvato
 
-    mutex_unlock(&game->mutex);
-
     // Notifica al creatore della richiesta di join
     char join_request[128];
-    snprintf(join_request, sizeof(join_request), "JOIN_REQUEST:%s:%d", client->name, game_id);
-    network_send_to_client(game->player1, join_request);
+    if (message_encode_join_request(join_request, sizeof(join_request), client->name, game_id)) {
+        network_send_to_client(game->player1, join_request);
+    }
     
     // Notifica al richiedente che è in attesa
-    network_send_to_client(client, "JOIN_PENDING:In attesa di approvazione dal creatore");
+    network_send_message(client, SMSG_JOIN_PENDING, "In attesa di approvazione dal creatore");
+    game_list_publish(game);
+
+    mutex_unlock(&game->mutex);
+    lobby_broadcast_game_list();
 
     printf("Client %s richiede di unirsi alla partita %d, in attesa di approvazione\n", client->name, game_id);
     return 1;
@@ -289,16 +673,15 @@ int game_join(Client *client, int game_id) {
 int game_approve_join(Client *creator, int approve) {
     if (!creator || creator->game_id <= 0) return 0;
     
-    Game *game = game_find_by_id(creator->game_id);
+    Game *game = game_lock_by_id(creator->game_id);
     if (!game || game->player1 != creator) {
-        network_send_to_client(creator, "ERROR:Non sei il creatore di questa partita");
+        if (game) mutex_unlock(&game->mutex);
+        network_send_message(creator, SMSG_ERROR, "Non sei il creatore di questa partita");
         return 0;
     }
     
-    mutex_lock(&game->mutex);
-    
     if (game->state != GAME_STATE_PENDING_APPROVAL || !game->pending_player) {
-        network_send_to_client(creator, "ERROR:Nessuna richiesta di join in attesa");
+        network_send_message(creator, SMSG_ERROR, "Nessuna richiesta di join in attesa");
         mutex_unlock(&game->mutex);
         return 0;
     }
@@ -306,54 +689,113 @@ int game_approve_join(Client *creator, int approve) {
     Client *pending = game->pending_player;
     
     if (approve) {
-        // Approva il join
-        game->player2 = pending;
-        game->pending_player = NULL;
+        // Approva il join (il riferimento passa da pending_player a player2)
+        game_set_client(&game->player2, pending);
+        game_set_client(&game->pending_player, NULL);
         game->state = GAME_STATE_PLAYING;
         pending->symbol = 'O';
         
         printf("Join approvato: %s si unisce alla partita %d\n", pending->name, game->game_id);
         
-        // Notifica approvazione
-        network_send_to_client(pending, "JOIN_APPROVED:O");
-        network_send_to_client(creator, "JOIN_APPROVED_BY_YOU");
-        
-        // Breve pausa per garantire l'ordine dei messaggi
-#ifdef _WIN32
-        Sleep(50);
-#else
-        usleep(50000);
-#endif
+        // Notifica approvazione (il framing dei messaggi ne garantisce la separazione)
+        char msg[32];
+        if (message_encode_join_approved(msg, sizeof(msg), PLAYER_O)) network_send_to_client(pending, msg);
+        network_send_message(creator, SMSG_JOIN_APPROVED_BY_YOU, NULL);
         
         // Avvia la partita
-        network_send_to_client(game->player1, "GAME_START:X");
-        network_send_to_client(game->player2, "GAME_START:O");
-        
-        // Aggiorna la lista giochi (rimuove la partita dalle disponibili)
-        char list_update[64];
-        snprintf(list_update, sizeof(list_update), "LIST_UPDATE:%d:REMOVE", game->game_id);
-        lobby_broadcast_message(list_update, NULL);
-        
+        game_send_start(game);
     } else {
-        // Rifiuta il join
-        game->pending_player = NULL;
+        // Rifiuta il join (la partita torna in attesa dall'inizio)
         game->state = GAME_STATE_WAITING;
+        game_wait_push(game);
         pending->game_id = -1;
         
         printf("Join rifiutato: %s non può unirsi alla partita %d\n", pending->name, game->game_id);
         
         // Notifica rifiuto
-        network_send_to_client(pending, "JOIN_REJECTED:Richiesta rifiutata dal creatore");
-        network_send_to_client(creator, "JOIN_REJECTED_BY_YOU");
-        
-        // Aggiorna la lista giochi (la partita rimane disponibile)
-        lobby_broadcast_game_list();
+        network_send_message(pending, SMSG_JOIN_REJECTED, "Richiesta rifiutata dal creatore");
+        network_send_message(creator, SMSG_JOIN_REJECTED_BY_YOU, NULL);
+        game_set_client(&game->pending_player, NULL);
     }
+    game_list_publish(game);
     
     mutex_unlock(&game->mutex);
+    
+    // Aggiorna la lista giochi (il broadcast avviene fuori da game->mutex)
+    lobby_broadcast_game_list();
+    return 1;
+}
+
+
+/**
+ * Fa occupare al bot del server il posto di player2 e avvia la partita.
+ * Il bot è un client virtuale (vedi network_alloc_virtual_client()) con il
+ * simbolo O e il livello di gioco scelto dal creatore.
+ * NOTA: deve essere chiamata con game->mutex acquisito, partita in
+ * GAME_STATE_WAITING senza avversario né richieste di join.
+ * 
+ * @param game Partita in attesa
+ * @param level Livello di gioco del bot
+ * @return 1 se la partita è iniziata, 0 se il bot non è disponibile
+ */
+static int game_seat_bot(Game *game, BotLevel level) {
+    Client *bot = network_alloc_virtual_client(BOT_NAME);
+    if (!bot) return 0;
+    
+    // Il riferimento di chi ha creato il bot passa alla partita
+    game_set_client(&game->player2, bot);
+    network_release_client(bot);
+    bot->game_id = game->game_id;
+    bot->symbol = 'O';
+    game->bot_level = (int)level;
+    game->state = GAME_STATE_PLAYING;
+    game_wait_remove(game);
+    
+    printf("Partita %d: %s gioca contro il bot (livello %s)\n", game->game_id,
+           game->player1 ? game->player1->name : "?", bot_level_name((BotLevel)game->bot_level));
+    game_send_start(game);
+    game_list_publish(game);
     return 1;
 }
 
+/**
+ * Fa iniziare al creatore la partita contro il bot del server, senza
+ * attendere un avversario umano (vedi game_seat_bot()). È anche la
+ * risposta a BOT_OFFER (vedi game_check_timeouts()).
+ * 
+ * @param creator Client creatore della partita in attesa
+ * @param level Livello di gioco del bot (già validato, vedi bot_parse_level())
+ * @return 1 in caso di successo, 0 in caso di errore (messaggio già inviato)
+ */
+int game_add_bot(Client *creator, BotLevel level) {
+    if (!creator || creator->game_id <= 0) {
+        network_send_message(creator, SMSG_ERROR, "Non sei in una partita");
+        return 0;
+    }
+    
+    Game *game = game_lock_by_id(creator->game_id);
+    if (!game || game->player1 != creator) {
+        if (game) mutex_unlock(&game->mutex);
+        network_send_message(creator, SMSG_ERROR, "Non sei il creatore di questa partita");
+        return 0;
+    }
+    
+    if (game->state != GAME_STATE_WAITING || game->player2 || game->pending_player) {
+        network_send_message(creator, SMSG_ERROR, "Partita non disponibile");
+        mutex_unlock(&game->mutex);
+        return 0;
+    }
+    
+    if (!game_seat_bot(game, level)) {
+        network_send_message(creator, SMSG_ERROR, "Bot non disponibile");
+        mutex_unlock(&game->mutex);
+        return 0;
+    }
+    
+    mutex_unlock(&game->mutex);
+    lobby_broadcast_game_list();
+    return 1;
+}
 
 /**
  * Gestisce l'uscita di un client da una partita.
@@ -363,34 +805,37 @@ int game_approve_join(Client *creator, int approve) {
  */
 void game_leave(Client *client) {
     if (!client || client->game_id <= 0) return;
-    Game *game = game_find_by_id(client->game_id);
+    Game *game = game_lock_by_id(client->game_id);
     if (!game) return;
     
-    mutex_lock(&game->mutex);
-    
     Client *opponent = NULL;
     
     // Gestione diversa in base al ruolo del client
+    // Il chiamante tiene un riferimento a client: resta valido dopo game_set_client()
     if (game->player1 == client) {
         opponent = game->player2;
-        game->player1 = NULL;
+        game_set_client(&game->player1, NULL);
     } else if (game->player2 == client) {
         opponent = game->player1;
-        game->player2 = NULL;
+        game_set_client(&game->player2, NULL);
     } else if (game->pending_player == client) {
         // Il giocatore in attesa di approvazione lascia
-        game->pending_player = NULL;
+        game_set_client(&game->pending_player, NULL);
         game->state = GAME_STATE_WAITING;
+        game_wait_push(game);
         client->game_id = -1;
         
         // Notifica al creatore
         if (game->player1) {
             char msg[100];
-            snprintf(msg, sizeof(msg), "JOIN_CANCELLED:%s ha annullato la richiesta", client->name);
-            network_send_to_client(game->player1, msg);
+            if (message_encode_join_cancelled(msg, sizeof(msg), "%s ha annullato la richiesta", client->name)) {
+                network_send_to_client(game->player1, msg);
+            }
         }
+        game_list_publish(game);
         
         mutex_unlock(&game->mutex);
+        lobby_broadcast_game_list();
         printf("Client %s ha annullato la richiesta di join per partita %d\n", client->name, client->game_id);
         return;
     }
@@ -400,10 +845,10 @@ void game_leave(Client *client) {
         
         // Gestione speciale per disconnessione durante rematch
         if (game->state == GAME_STATE_REMATCH_REQUESTED && game->rematch_requests > 0) {
-            snprintf(msg, sizeof(msg), "REMATCH_CANCELLED:%s si è disconnesso", client->name);
+            message_encode_rematch_cancelled(msg, sizeof(msg), "%s si è disconnesso", client->name);
             printf("Client %s si è disconnesso durante richiesta rematch, notificando avversario\n", client->name);
         } else {
-            snprintf(msg, sizeof(msg), "OPPONENT_LEFT:%s ha abbandonato", client->name);
+            message_encode_opponent_left(msg, sizeof(msg), "%s ha abbandonato", client->name);
         }
         
         network_send_to_client(opponent, msg);
@@ -412,12 +857,12 @@ void game_leave(Client *client) {
     
     // Pulisci anche eventuali pending players
     if (game->pending_player) {
-        network_send_to_client(game->pending_player, "GAME_CANCELLED:La partita è stata cancellata");
+        network_send_message(game->pending_player, SMSG_GAME_CANCELLED, "La partita è stata cancellata");
         game->pending_player->game_id = -1;
-        game->pending_player = NULL;
+        game_set_client(&game->pending_player, NULL);
     }
     
-    game->game_id = -1;
+    game_release_slot(game);
     game->state = GAME_STATE_WAITING;
     game->rematch_requests = 0;
     printf("Partita %d cancellata\n", client->game_id);
@@ -431,45 +876,31 @@ void game_leave(Client *client) {
 
 /**
  * Controlla se c'è un vincitore nella partita.
- * Verifica righe, colonne e diagonali per determinare se qualcuno ha vinto.
+ * Il vincitore è calcolato da board_place() a ogni mossa (vedi board.h).
  * 
  * @param game Partita da controllare
  * @return Simbolo del vincitore (PLAYER_X o PLAYER_O), PLAYER_NONE se nessun vincitore
  */
 int game_check_winner(Game *game) {
-    // Controllo righe
-    for (int i = 0; i < 3; i++) {
-        if (game->board[i][0] != PLAYER_NONE &&
-            game->board[i][0] == game->board[i][1] && 
-            game->board[i][1] == game->board[i][2]) {
-            return game->board[i][0];
-        }
-    }
-    
-    // Controllo colonne
-    for (int j = 0; j < 3; j++) {
-        if (game->board[0][j] != PLAYER_NONE &&
-            game->board[0][j] == game->board[1][j] && 
-            game->board[1][j] == game->board[2][j]) {
-            return game->board[0][j];
-        }
-    }
-    
-    // Controllo diagonale principale
-    if (game->board[0][0] != PLAYER_NONE &&
-        game->board[0][0] == game->board[1][1] && 
-        game->board[1][1] == game->board[2][2]) {
-        return game->board[0][0];
-    }
-    
-    // Controllo diagonale secondaria
-    if (game->board[0][2] != PLAYER_NONE &&
-        game->board[0][2] == game->board[1][1] && 
-        game->board[1][1] == game->board[2][0]) {
-        return game->board[0][2];
-    }
-    
-    return PLAYER_NONE;
+    return board_winner(&game->board);
+}
+
+/**
+ * Conta le minacce di un giocatore: finestre di k celle in riga, colonna o
+ * diagonale con k-1 suoi simboli e una cella vuota, cioè mosse vincenti.
+ * Esamina tutto il tabellone con board_scan() (SIMD se la CPU lo supporta).
+ * NOTA: deve essere chiamata con game->mutex acquisito.
+ * 
+ * @param game Partita da controllare
+ * @param symbol Giocatore (PLAYER_X o PLAYER_O)
+ * @return Numero di minacce, 0 per un simbolo non valido
+ */
+int game_count_threats(Game *game, PlayerSymbol symbol) {
+    BoardScan scan;
+    board_scan(&game->board, &scan);
+    if (symbol == PLAYER_X) return scan.threats_x;
+    if (symbol == PLAYER_O) return scan.threats_o;
+    return 0;
 }
 
 /**
@@ -479,14 +910,7 @@ int game_check_winner(Game *game) {
  * @return 1 se la griglia è piena, 0 altrimenti
  */
 int game_is_board_full(Game *game) {
-    for (int i = 0; i < 3; i++) {
-        for (int j = 0; j < 3; j++) {
-            if (game->board[i][j] == PLAYER_NONE) {
-                return 0;
-            }
-        }
-    }
-    return 1;
+    return board_is_full(&game->board);
 }
 
 /**
@@ -494,78 +918,119 @@ int game_is_board_full(Game *game) {
  * Controlla che le coordinate siano dentro i limiti e che la cella sia libera.
  * 
  * @param game Partita di riferimento
- * @param row Riga della mossa (0-2)
- * @param col Colonna della mossa (0-2)
+ * @param row Riga della mossa (da 0)
+ * @param col Colonna della mossa (da 0)
  * @return 1 se la mossa è valida, 0 altrimenti
  */
 int game_is_valid_move(Game *game, int row, int col) {
-    if (row < 0 || row > 2 || col < 0 || col > 2) {
-        return 0;
-    }
-    return game->board[row][col] == PLAYER_NONE;
+    return board_is_free(&game->board, row, col);
 }
 
 /**
- * Esegue una mossa in una partita se valida.
- * Controlla il turno, la validità della mossa, aggiorna la griglia e verifica vittoria/pareggio.
+ * Esegue una mossa se valida: controlla il turno, aggiorna il tabellone,
+ * verifica vittoria/pareggio e comunica l'esito ai giocatori.
+ * NOTA: deve essere chiamata con game->mutex acquisito.
  * 
- * @param game_id ID della partita
- * @param client Client che effettua la mossa
- * @param row Riga della mossa (0-2)
- * @param col Colonna della mossa (0-2)
- * @return 1 se la mossa è stata eseguita con successo, 0 altrimenti
+ * @param game Partita
+ * @param client Giocatore che effettua la mossa (umano o bot)
+ * @param row Riga della mossa (da 0)
+ * @param col Colonna della mossa (da 0)
+ * @param after_start 1 per inviare l'esito sulla coda TCP, dietro a GAME_START
+ *        (mossa d'apertura del bot); 0 per il canale degli eventi
+ * @return 1 se la mossa è stata eseguita, 0 altrimenti (errore già inviato al client)
  */
-int game_make_move(int game_id, Client *client, int row, int col) {
-    Game *game = game_find_by_id(game_id);
-    if (!game || !client) return 0;
-    
-    mutex_lock(&game->mutex);  // CAMBIATO: era EnterCriticalSection
-    
+static int game_apply_move(Game *game, Client *client, int row, int col, int after_start) {
+    void (*send_event)(Game*, const char*) = after_start ? game_send_to_players : game_send_event_to_players;
+
     PlayerSymbol expected_player = (game->current_player == PLAYER_X) ? PLAYER_X : PLAYER_O;
     if ((char)client->symbol != (char)expected_player) {
-        network_send_to_client(client, "ERROR:Non e' il tuo turno");
-        mutex_unlock(&game->mutex);  // CAMBIATO: era LeaveCriticalSection
+        network_send_message(client, SMSG_ERROR, "Non e' il tuo turno");
         return 0;
     }
     
-    if (!game_is_valid_move(game, row, col)) {
-        network_send_to_client(client, "ERROR:Mossa non valida");
-        mutex_unlock(&game->mutex);  // CAMBIATO: era LeaveCriticalSection
+    if (!board_place(&game->board, row, col, client->symbol)) {
+        network_send_message(client, SMSG_ERROR, "Mossa non valida");
         return 0;
     }
     
-    game->board[row][col] = (char)client->symbol;
-    
     PlayerSymbol winner = (PlayerSymbol)game_check_winner(game);
     if (winner != PLAYER_NONE) {
         game->state = GAME_STATE_OVER;
         game->winner = winner;
-        char msg[100];
-        sprintf(msg, "GAME_OVER:WINNER:%c", winner);
-        network_send_to_client(game->player1, msg);
-        network_send_to_client(game->player2, msg);
-        printf("Partita %d terminata - Vincitore: %c\n", game_id, winner);
+        char msg[32];
+        if (message_encode_game_over(msg, sizeof(msg), (char)winner)) send_event(game, msg);
+        printf("Partita %d terminata - Vincitore: %c\n", game->game_id, winner);
+        game_list_publish(game);
         
         // NON resettare game_id subito - servirà per il rematch
     }
     else if (game_is_board_full(game)) {
         game->state = GAME_STATE_OVER;
         game->is_draw = 1;
-        network_send_to_client(game->player1, "GAME_OVER:DRAW");
-        network_send_to_client(game->player2, "GAME_OVER:DRAW");
-        printf("Partita %d terminata - Pareggio\n", game_id);
+        char msg[32];
+        if (message_encode_game_over(msg, sizeof(msg), MESSAGE_DRAW)) send_event(game, msg);
+        printf("Partita %d terminata - Pareggio\n", game->game_id);
+        game_list_publish(game);
         
         // NON resettare game_id subito - servirà per il rematch
     }
     else {
         game->current_player = (game->current_player == PLAYER_X) ? PLAYER_O : PLAYER_X;
-        char move_msg[100];
-        sprintf(move_msg, "MOVE:%d,%d:%c", row, col, client->symbol);
-        network_send_to_client(game->player1, move_msg);
-        network_send_to_client(game->player2, move_msg);
+        char move_msg[32];
+        if (message_encode_move(move_msg, sizeof(move_msg), row, col, client->symbol)) {
+            send_event(game, move_msg);
+        }
     }
+    return 1;
+}
+
+/**
+ * Se la partita è in corso e tocca al bot, esegue la sua mossa (una
+ * lettura della tabella di bot.c) con lo stesso percorso delle mosse dei
+ * giocatori. Chiamata dopo ogni mossa dell'avversario e all'avvio di una
+ * partita in cui il bot ha X: la mossa d'apertura segue GAME_START sulla
+ * coda TCP, perché sul canale UDP potrebbe arrivare prima di GAME_START.
+ * NOTA: deve essere chiamata con game->mutex acquisito.
+ * 
+ * @param game Partita
+ */
+static void game_play_bot_turn(Game *game) {
+    Client *player = (game->current_player == PLAYER_X) ? game->player1 : game->player2;
+    int row, col;
     
+    if (game->state != GAME_STATE_PLAYING || !player || !player->is_bot) return;
+    if (bot_choose_move(&game->board, player->symbol, (BotLevel)game->bot_level, &row, &col)) {
+        game_apply_move(game, player, row, col, game->board.moves == 0);
+    }
+}
+
+/**
+ * Esegue una mossa in una partita se valida.
+ * Controlla il turno, la validità della mossa, aggiorna la griglia e verifica vittoria/pareggio.
+ * Nelle partite contro il bot la risposta del bot segue subito, sotto lo stesso lock.
+ * 
+ * @param game_id ID della partita
+ * @param client Client che effettua la mossa
+ * @param row Riga della mossa (da 0)
+ * @param col Colonna della mossa (da 0)
+ * @return 1 se la mossa è stata eseguita con successo, 0 altrimenti
+ */
+int game_make_move(int game_id, Client *client, int row, int col) {
+    if (!client) return 0;
+    Game *game = game_lock_by_id(game_id);
+    if (!game) return 0;
+    
+    if (!game_apply_move(game, client, row, col, 0)) {
+        mutex_unlock(&game->mutex);  // CAMBIATO: era LeaveCriticalSection
+        return 0;
+    }
+    game_play_bot_turn(game);
+    
+    int finished = (game->state == GAME_STATE_OVER);
     mutex_unlock(&game->mutex);  // CAMBIATO: era LeaveCriticalSection
+    
+    // La partita terminata esce dalla lista giochi
+    if (finished) lobby_broadcast_game_list();
     return 1;
 }
 
@@ -576,99 +1041,343 @@ int game_make_move(int game_id, Client *client, int row, int col) {
  * @param game_id ID della partita da resettare
  */
 void game_reset(int game_id) {
-    Game *game = game_find_by_id(game_id);
+    Game *game = game_lock_by_id(game_id);
     if (!game) return;
     
-    mutex_lock(&game->mutex);  // CAMBIATO: era EnterCriticalSection
     game_init_board(game);
     game->current_player = PLAYER_X;
     game->state = GAME_STATE_PLAYING;
     game->winner = PLAYER_NONE;
     game->is_draw = 0;
     
-    network_send_to_client(game->player1, "GAME_RESET");
-    network_send_to_client(game->player2, "GAME_RESET");
+    char msg[32];
+    if (message_encode_game_reset(msg, sizeof(msg))) game_send_to_players(game, msg);
+    game_list_publish(game);
     
     mutex_unlock(&game->mutex);  // CAMBIATO: era LeaveCriticalSection
+    lobby_broadcast_game_list();
     printf("Partita %d resettata\n", game_id);
 }
 
 /**
- * Genera una lista delle partite disponibili formattata per l'invio ai client.
- * Include partite in attesa, in corso e con richieste pendenti.
+ * Determina il gruppo della lista in cui compare una partita.
+ * NOTA: deve essere chiamata con game->mutex acquisito.
+ * 
+ * @param game Partita da classificare
+ * @return Gruppo (ListFilter), -1 se la partita non compare nella lista
+ */
+static int game_list_group(Game *game) {
+    if (game->game_id <= 0 || !game->player1) return -1;
+    
+    switch (game->state) {
+        case GAME_STATE_WAITING:
+            return game->player2 ? -1 : LIST_FILTER_WAITING;
+        case GAME_STATE_PENDING_APPROVAL:
+            return game->pending_player ? LIST_FILTER_PENDING : -1;
+        case GAME_STATE_PLAYING:
+            return game->player2 ? LIST_FILTER_PLAYING : -1;
+        case GAME_STATE_REMATCH_REQUESTED:
+            return game->player2 ? LIST_FILTER_REMATCH : -1;
+        default:
+            return -1;  // Le partite in altri stati non compaiono nella lista
+    }
+}
+
+/**
+ * Scrive la voce della lista di una partita: "<id> <stato> <giocatori>".
+ * Lo stato determina quanti nomi seguono (i nomi non contengono spazi):
+ * WAITING <creatore>, PENDING <creatore> <richiedente>,
+ * PLAYING <giocatore1> <giocatore2>, REMATCH <giocatore1> <giocatore2>.
+ * Le varianti diverse dal Tris classico aggiungono allo stato
+ * "/<righe>x<colonne>x<k>" (ad esempio "WAITING/15x15x5").
+ * NOTA: deve essere chiamata con game->mutex acquisito.
+ * 
+ * @param game Partita da descrivere
+ * @param group Gruppo della partita (vedi game_list_group())
+ * @param buffer Buffer di destinazione
+ * @param size Dimensione del buffer
+ * @return Lunghezza della voce, 0 se la voce non entra nel buffer
+ */
+static int game_list_format_entry(Game *game, int group, char *buffer, size_t size) {
+    char variant[16] = "";
+    int written;
+    if (!board_is_classic(&game->board)) {
+        snprintf(variant, sizeof(variant), "/%dx%dx%d", game->board.rows, game->board.cols, game->board.k);
+    }
+    if (group == LIST_FILTER_WAITING) {
+        written = snprintf(buffer, size, "%d %s%s %s",
+                           game->game_id, list_filter_names[group], variant, game->player1->name);
+    } else {
+        Client *second = group == LIST_FILTER_PENDING ? game->pending_player : game->player2;
+        written = snprintf(buffer, size, "%d %s%s %s %s",
+                           game->game_id, list_filter_names[group], variant, game->player1->name, second->name);
+    }
+    return (written > 0 && (size_t)written < size) ? written : 0;
+}
+
+/**
+ * Sposta una partita nel gruppo indicato dell'indice della lista.
+ * Ogni gruppo è un array compatto di slot: inserimento e rimozione sono O(1)
+ * (la rimozione sposta l'ultima partita del gruppo nella posizione liberata).
+ * NOTA: deve essere chiamata con list_mutex acquisito.
  * 
- * @param response Buffer dove scrivere la lista formattata
- * @param max_len Dimensione massima del buffer
+ * @param game Partita da spostare
+ * @param group Nuovo gruppo (-1 per togliere la partita dall'indice)
  */
-void game_list_available(char *response, size_t max_len) {
-    strcpy(response, "GAMES:");
+static void game_list_index(Game *game, int group) {
+    if (game->list_group == group) return;
+    
+    if (game->list_group >= 0) {
+        ListGroup *old = &list_groups[game->list_group];
+        int last = old->slots[--old->count];
+        old->slots[game->list_pos] = last;
+        game_at(last)->list_pos = game->list_pos;
+    }
+    if (group >= 0) {
+        ListGroup *dst = &list_groups[group];
+        game->list_pos = dst->count;
+        dst->slots[dst->count++] = game->slot;
+    }
+    game->list_group = group;
+}
+
+/**
+ * Pubblica la modifica di una partita come aggiornamento della lista:
+ * ADD se la partita entra nella lista, UPDATE se cambia, REMOVE se ne esce.
+ * L'aggiornamento riceve il numero di sequenza successivo e viene conservato
+ * nel registro, da cui lobby_broadcast_game_list() lo invia ai client;
+ * nella stessa sezione critica viene aggiornato l'indice delle pagine.
+ * NOTA: va chiamata dopo la modifica, con game->mutex ancora acquisito,
+ * così chi legge la nuova sequenza vede anche la partita aggiornata.
+ * 
+ * @param game Partita modificata
+ */
+static void game_list_publish(Game *game) {
+    char entry[LIST_ENTRY_SIZE];
+    int group = game_list_group(game);
+    if (group >= 0 && !game_list_format_entry(game, group, entry, sizeof(entry))) group = -1;
+    if (group < 0 && !game->listed_id) return;  // Non era e non è nella lista
+    
+    char text[LIST_DELTA_SIZE];
+    mutex_lock(&list_mutex);
+    unsigned long seq = list_version + 1;
+    ListDelta *delta = &list_deltas[seq % LIST_DELTA_LOG];
+    if (group >= 0) {
+        message_encode_list_update(text, sizeof(text), seq, "%s:%s", game->listed_id ? "UPDATE" : "ADD", entry);
+        memcpy(game->list_entry, entry, sizeof(entry));
+    } else {
+        message_encode_list_update(text, sizeof(text), seq, "REMOVE:%d", game->listed_id);
+    }
+    // Il messaggio sostituito resta valido per le code che lo referenziano ancora
+    network_msg_release(delta->msg);
+    delta->msg = network_msg_create(text);
+    delta->seq = seq;
+    game_list_index(game, group);
+    __atomic_store_n(&list_version, seq, __ATOMIC_RELEASE);
+    mutex_unlock(&list_mutex);
+    
+    game->listed_id = group >= 0 ? game->game_id : 0;
+}
+
+/**
+ * Ripubblica la voce della lista di una partita (es. dopo il cambio di nome
+ * di un giocatore).
+ * 
+ * @param game_id ID della partita
+ */
+void game_list_refresh(int game_id) {
+    Game *game = game_lock_by_id(game_id);
+    if (!game) return;
     
-    mutex_lock(&games_mutex);
-    int count = 0;
+    game_list_publish(game);
+    mutex_unlock(&game->mutex);
+}
+
+/**
+ * Restituisce la sequenza dell'ultimo aggiornamento della lista partite.
+ * 
+ * @return Sequenza (cresce a ogni modifica visibile nella lista)
+ */
+unsigned long game_list_version(void) {
+    return __atomic_load_n(&list_version, __ATOMIC_ACQUIRE);
+}
+
+/**
+ * Restituisce l'aggiornamento della lista con la sequenza indicata.
+ * Il registro conserva gli ultimi LIST_DELTA_LOG aggiornamenti: quelli
+ * più vecchi non sono più disponibili e i client che li hanno persi
+ * rileveranno il salto di sequenza, richiedendo di nuovo la pagina.
+ * 
+ * @param seq Sequenza dell'aggiornamento
+ * @return Messaggio con un riferimento per il chiamante (da rilasciare con
+ *         network_msg_release()), NULL se non è più nel registro
+ */
+SharedMsg* game_list_delta(unsigned long seq) {
+    SharedMsg *msg = NULL;
+    
+    mutex_lock(&list_mutex);
+    ListDelta *delta = &list_deltas[seq % LIST_DELTA_LOG];
+    if (delta->seq == seq && delta->msg) {
+        msg = delta->msg;
+        network_msg_retain(msg);
+    }
+    mutex_unlock(&list_mutex);
+    return msg;
+}
+
+/**
+ * Converte il nome di un filtro della lista (WAITING, PENDING, PLAYING,
+ * REMATCH o ALL).
+ * 
+ * @param name Nome del filtro
+ * @param filter Filtro corrispondente
+ * @return 1 se il nome è valido, 0 altrimenti
+ */
+int game_list_parse_filter(const char *name, ListFilter *filter) {
+    if (strcmp(name, "ALL") == 0) {
+        *filter = LIST_FILTER_ALL;
+        return 1;
+    }
+    for (int i = 0; i < LIST_FILTER_COUNT; i++) {
+        if (strcmp(name, list_filter_names[i]) == 0) {
+            *filter = (ListFilter)i;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Genera una pagina della lista partite per l'invio a un client:
+ * "GAMES:<sequenza>:<offset>:<totale>:" seguito dalle voci separate da spazi
+ * (formato in game_list_format_entry()). Il totale conta le partite che
+ * soddisfano il filtro; LIST_FILTER_ALL concatena i gruppi nell'ordine di ListFilter.
+ * 
+ * La pagina è copiata dall'indice per stato con il solo list_mutex: il costo
+ * dipende dalla dimensione della pagina e non dal numero di partite, e voci
+ * e sequenza sono coerenti tra loro. Se le voci richieste non entrano nel
+ * messaggio la pagina si ferma prima: il client chiede le successive con
+ * offset pari a quello ricevuto più il numero di voci lette.
+ * 
+ * @param filter Gruppi da includere
+ * @param offset Voci da saltare
+ * @param limit Voci al massimo (ridotto a LIST_PAGE_MAX)
+ * @param response Buffer dove scrivere la pagina
+ * @param max_len Dimensione massima del buffer (MAX_MSG_SIZE)
+ * @return Sequenza della lista a cui si riferisce la pagina
+ * 
+ * @note Le pagine successive possono riferirsi a sequenze diverse: chi le
+ *       scorre mentre le partite cambiano può vedere una voce due volte o saltarla
+ */
+unsigned long game_list_page(ListFilter filter, int offset, int limit, char *response, size_t max_len) {
+    int first = filter == LIST_FILTER_ALL ? 0 : (int)filter;
+    int end = filter == LIST_FILTER_ALL ? LIST_FILTER_COUNT : (int)filter + 1;
+    if (limit > LIST_PAGE_MAX) limit = LIST_PAGE_MAX;
+    
+    mutex_lock(&list_mutex);
+    unsigned long seq = list_version;
+    int total = 0;
+    for (int g = first; g < end; g++) {
+        total += list_groups[g].count;
+    }
     
-    for (int i = 0; i < MAX_GAMES; i++) {
-        if (games[i].game_id > 0) {
-            char game_info[150];
-            
-            if (games[i].state == GAME_STATE_WAITING && games[i].player1 && !games[i].player2) {
-                // Partita disponibile per join
-                snprintf(game_info, sizeof(game_info), "[%d]%s(In attesa) ", 
-                        games[i].game_id, games[i].player1->name);
-                count++;
-            } else if (games[i].state == GAME_STATE_PENDING_APPROVAL && games[i].pending_player) {
-                // Partita con richiesta in attesa
-                snprintf(game_info, sizeof(game_info), "[%d]%s(Richiesta di %s in attesa) ", 
-                        games[i].game_id, games[i].player1->name, games[i].pending_player->name);
-            } else if (games[i].state == GAME_STATE_PLAYING) {
-                // Partita in corso
-                snprintf(game_info, sizeof(game_info), "[%d]%s vs %s(In corso) ", 
-                        games[i].game_id, 
-                        games[i].player1 ? games[i].player1->name : "N/A",
-                        games[i].player2 ? games[i].player2->name : "N/A");
-            } else if (games[i].state == GAME_STATE_REMATCH_REQUESTED) {
-                // Partita con richiesta rematch
-                snprintf(game_info, sizeof(game_info), "[%d]%s vs %s(Rematch richiesto) ", 
-                        games[i].game_id,
-                        games[i].player1 ? games[i].player1->name : "N/A",
-                        games[i].player2 ? games[i].player2->name : "N/A");
-            } else {
-                continue; // Salta partite in altri stati
-            }
-            
-            if (strlen(response) + strlen(game_info) < max_len - 1) {
-                strcat(response, game_info);
+    size_t len = (size_t)message_encode_games(response, max_len, seq, "%d:%d:", offset, total);
+    int added = 0;
+    int skip = offset;
+    for (int g = first; g < end && added < limit; g++) {
+        ListGroup *group = &list_groups[g];
+        if (skip >= group->count) {
+            skip -= group->count;
+            continue;
+        }
+        
+        for (int i = skip; i < group->count && added < limit; i++) {
+            const char *entry = game_at(group->slots[i])->list_entry;
+            size_t entry_len = strlen(entry);
+            if (len + 1 + entry_len >= max_len) {
+                limit = added;  // Pagina piena: le voci restanti vanno alla richiesta successiva
+                break;
             }
+            if (added > 0) response[len++] = ' ';
+            memcpy(response + len, entry, entry_len);
+            len += entry_len;
+            added++;
         }
+        skip = 0;
     }
-    mutex_unlock(&games_mutex);
+    response[len] = '\0';
+    mutex_unlock(&list_mutex);
     
-    if (count == 0 && strlen(response) == 6) {
-        strcat(response, "Nessuna partita disponibile per il join");
-    }
+    return seq;
 }
 
 /**
- * Controlla e rimuove le partite che sono in attesa da troppo tempo.
- * Cancella automaticamente le partite in stato WAITING dopo 5 minuti di inattività.
+ * Gestisce le partite in attesa da troppo tempo. Chiamata a ogni tick della lobby.
+ * Dopo server_config.bot_fill_delay secondi il creatore riceve BOT_OFFER e può
+ * accettare con PLAY_BOT (vedi game_add_bot()); dopo server_config.waiting_timeout
+ * secondi in attesa la partita viene cancellata.
+ * 
+ * Ogni lista di attesa è ordinata per ingresso in GAME_STATE_WAITING e il
+ * suo ritardo è uguale per tutte le partite: basta esaminare la testa
+ * finché non è ancora scaduta. Una partita che riceve l'offerta passa in
+ * fondo alla lista delle scadenze, che resta così ordinata. Il costo è O(1)
+ * per tick più O(1) per partita gestita, indipendentemente dal numero di
+ * partite aperte.
+ * 
+ * @note Se bot_fill_delay >= waiting_timeout le offerte sono disattivate e
+ *       resta solo la scadenza
  */
-void game_check_timeouts() {
-    mutex_lock(&games_mutex);  // CAMBIATO: era EnterCriticalSection
-    time_t now = time(NULL);
-    
-    for (int i = 0; i < MAX_GAMES; i++) {
-        if (games[i].game_id != -1 && 
-            games[i].state == GAME_STATE_WAITING &&
-            difftime(now, games[i].creation_time) > 300) { 
+void game_check_timeouts(void) {
+    if (!__atomic_load_n(&wait_ready, __ATOMIC_ACQUIRE)) return;
+    
+    long long now = udp_channel_now_ms();
+    long long offer_deadline = now - (long long)server_config.bot_fill_delay * 1000;
+    long long expire_deadline = now - (long long)server_config.waiting_timeout * 1000;
+    int expired = 0;
+    int game_id;
+    
+    // Offerte: la partita resta in attesa, il creatore sceglie se giocare contro il bot
+    while ((game_id = game_wait_due(WAIT_QUEUE_OFFER, offer_deadline)) != -1) {
+        Game *game = game_lock_by_id(game_id);
+        if (!game) continue;    // Chiusa nel frattempo: ha già lasciato la lista
+        
+        // Ricontrolla sotto il lock: la partita può essere cambiata dopo la lettura
+        if (game->wait_queue == WAIT_QUEUE_OFFER && game->wait_since <= offer_deadline) {
+            mutex_lock(&wait_mutex);
+            game_wait_unlink(game);
+            game_wait_link(game, WAIT_QUEUE_EXPIRE);
+            mutex_unlock(&wait_mutex);
             
-            printf("Partita %d cancellata per timeout\n", games[i].game_id);
-            if (games[i].player1) {
-                network_send_to_client(games[i].player1, "ERROR:Timeout - Nessun avversario");
-                games[i].player1->game_id = -1;
+            if (game->player1) {
+                char note[128];
+                snprintf(note, sizeof(note), "Nessun avversario: PLAY_BOT[:random|heuristic|perfect] per giocare contro il bot (livello %s)",
+                         bot_level_name((BotLevel)server_config.bot_level));
+                network_send_message(game->player1, SMSG_BOT_OFFER, note);
+                printf("Partita %d: bot offerto a %s\n", game->game_id, game->player1->name);
             }
-            games[i].game_id = -1;
         }
+        mutex_unlock(&game->mutex);
     }
-    mutex_unlock(&games_mutex);  // CAMBIATO: era LeaveCriticalSection
+    
+    // Scadenze: la partita viene cancellata
+    while ((game_id = game_wait_due(WAIT_QUEUE_EXPIRE, expire_deadline)) != -1) {
+        Game *game = game_lock_by_id(game_id);
+        if (!game) continue;
+        
+        if (game->wait_queue == WAIT_QUEUE_EXPIRE && game->wait_since <= expire_deadline) {
+            printf("Partita %d cancellata per timeout\n", game->game_id);
+            if (game->player1) {
+                network_send_message(game->player1, SMSG_ERROR, "Timeout - Nessun avversario");
+                game->player1->game_id = -1;
+            }
+            game_release_slot(game);
+            game->state = GAME_STATE_WAITING;
+            expired = 1;
+        }
+        mutex_unlock(&game->mutex);
+    }
+    
+    if (expired) lobby_broadcast_game_list();
 }
 
 /**
@@ -681,22 +1390,21 @@ void game_check_timeouts() {
  */
 int game_request_rematch(Client *client) {
     if (!client || client->game_id <= 0) {
-        network_send_to_client(client, "ERROR:Non sei in una partita");
+        network_send_message(client, SMSG_ERROR, "Non sei in una partita");
         return 0;
     }
     
-    Game *game = game_find_by_id(client->game_id);
+    Game *game = game_lock_by_id(client->game_id);
     if (!game || (game->state != GAME_STATE_OVER && game->state != GAME_STATE_REMATCH_REQUESTED)) {
-        network_send_to_client(client, "ERROR:La partita non è terminata o non disponibile per rematch");
+        if (game) mutex_unlock(&game->mutex);
+        network_send_message(client, SMSG_ERROR, "La partita non è terminata o non disponibile per rematch");
         return 0;
     }
     
-    mutex_lock(&game->mutex);
-    
     // Controlla se qualcuno ha già rifiutato il rematch
     if (game->rematch_declined != 0) {
         mutex_unlock(&game->mutex);
-        network_send_to_client(client, "ERROR:Il rematch è stato rifiutato, non è possibile richiederne un altro");
+        network_send_message(client, SMSG_ERROR, "Il rematch è stato rifiutato, non è possibile richiederne un altro");
         printf("Richiesta rematch rifiutata per partita %d - qualcuno ha già declinato\n", game->game_id);
         return 0;
     }
@@ -713,24 +1421,25 @@ int game_request_rematch(Client *client) {
         opponent = game->player1;
     } else {
         mutex_unlock(&game->mutex);
-        network_send_to_client(client, "ERROR:Non fai parte di questa partita");
+        network_send_message(client, SMSG_ERROR, "Non fai parte di questa partita");
         return 0;
     }
     
     // Controlla se ha già richiesto rematch
     if (game->rematch_requests & player_bit) {
         mutex_unlock(&game->mutex);
-        network_send_to_client(client, "ERROR:Hai già richiesto un rematch");
+        network_send_message(client, SMSG_ERROR, "Hai già richiesto un rematch");
         return 0;
     }
     
-    // Segna la richiesta
+    // Segna la richiesta (il bot accetta sempre la rivincita)
     game->rematch_requests |= player_bit;
+    if (opponent && opponent->is_bot) game->rematch_requests |= 3 - player_bit;
     game->state = GAME_STATE_REMATCH_REQUESTED;
     
     // Traccia chi ha richiesto per primo il rematch (avrà sempre X)
     if (game->rematch_requester == NULL) {
-        game->rematch_requester = client;
+        game_set_client(&game->rematch_requester, client);
         printf("Client %s è il primo a richiedere rematch (avrà X)\n", client->name);
     }
     
@@ -754,29 +1463,40 @@ int game_request_rematch(Client *client) {
         Client* temp = game->player1;
         game->player1 = game->player2;  // Ex player2 diventa player1 (X)
         game->player2 = temp;           // Ex player1 diventa player2 (O)
+        game->player1->symbol = 'X';
+        game->player2->symbol = 'O';
         
         printf("[DEBUG REMATCH] Dopo l'alternanza - player1=%s(X), player2=%s(O)\n", 
                game->player1->name, game->player2->name);
         
-        network_send_to_client(game->player1, "REMATCH_ACCEPTED:Nuova partita iniziata!GAME_START:X");
-        network_send_to_client(game->player2, "REMATCH_ACCEPTED:Nuova partita iniziata!GAME_START:O");
+        char msg[64];
+        if (message_encode_rematch_accepted(msg, sizeof(msg), "Nuova partita iniziata!")) {
+            game_send_to_players(game, msg);
+        }
+        game_send_start(game);
         
         printf("Rematch accettato per partita %d - %s(X) vs %s(O)\n", 
                game->game_id, game->player1->name, game->player2->name);
         
         // Reset del richiedente per il prossimo possibile rematch
-        game->rematch_requester = NULL;
+        game_set_client(&game->rematch_requester, NULL);
+        
+        // Se ora il bot ha X, apre lui la partita
+        game_play_bot_turn(game);
     } else {
         // Solo uno ha richiesto, notifica l'altro
         char msg[128];
-        snprintf(msg, sizeof(msg), "REMATCH_REQUEST:%s vuole giocare di nuovo", client->name);
-        network_send_to_client(opponent, msg);
-        network_send_to_client(client, "REMATCH_SENT:Richiesta inviata, in attesa dell'avversario");
+        if (message_encode_rematch_request(msg, sizeof(msg), "%s vuole giocare di nuovo", client->name)) {
+            network_send_to_client(opponent, msg);
+        }
+        network_send_message(client, SMSG_REMATCH_SENT, "Richiesta inviata, in attesa dell'avversario");
         
         printf("Client %s ha richiesto rematch per partita %d\n", client->name, game->game_id);
     }
+    game_list_publish(game);
     
     mutex_unlock(&game->mutex);
+    lobby_broadcast_game_list();
     return 1;
 }
 
@@ -789,18 +1509,16 @@ int game_request_rematch(Client *client) {
  */
 int game_cancel_rematch(Client *client) {
     if (!client || client->game_id <= 0) {
-        network_send_to_client(client, "ERROR:Non sei in una partita");
+        network_send_message(client, SMSG_ERROR, "Non sei in una partita");
         return 0;
     }
     
-    Game *game = game_find_by_id(client->game_id);
+    Game *game = game_lock_by_id(client->game_id);
     if (!game) {
-        network_send_to_client(client, "ERROR:Partita non trovata");
+        network_send_message(client, SMSG_ERROR, "Partita non trovata");
         return 0;
     }
     
-    mutex_lock(&game->mutex);
-    
     // Ottiene l'avversario
     Client *opponent = NULL;
     if (game->player1 == client) {
@@ -809,15 +1527,16 @@ int game_cancel_rematch(Client *client) {
         opponent = game->player1;
     } else {
         mutex_unlock(&game->mutex);
-        network_send_to_client(client, "ERROR:Non fai parte di questa partita");
+        network_send_message(client, SMSG_ERROR, "Non fai parte di questa partita");
         return 0;
     }
     
     // Avvisa l'avversario che la rivincita è stata annullata
     if (opponent) {
         char msg[128];
-        snprintf(msg, sizeof(msg), "REMATCH_CANCELLED:%s ha deciso di fare una nuova partita", client->name);
-        network_send_to_client(opponent, msg);
+        if (message_encode_rematch_cancelled(msg, sizeof(msg), "%s ha deciso di fare una nuova partita", client->name)) {
+            network_send_to_client(opponent, msg);
+        }
     }
     
     // Reset della partita - pulizia completa
@@ -826,8 +1545,10 @@ int game_cancel_rematch(Client *client) {
     
     // Notifica che il rematch è stato cancellato
     printf("Client %s ha cancellato la rivincita per partita %d\n", client->name, game->game_id);
+    game_list_publish(game);
     
     mutex_unlock(&game->mutex);
+    lobby_broadcast_game_list();
     return 1;
 }
 
@@ -840,18 +1561,16 @@ int game_cancel_rematch(Client *client) {
  */
 int game_decline_rematch(Client *client) {
     if (!client || client->game_id <= 0) {
-        network_send_to_client(client, "ERROR:Non sei in una partita");
+        network_send_message(client, SMSG_ERROR, "Non sei in una partita");
         return 0;
     }
     
-    Game *game = game_find_by_id(client->game_id);
+    Game *game = game_lock_by_id(client->game_id);
     if (!game) {
-        network_send_to_client(client, "ERROR:Partita non trovata");
+        network_send_message(client, SMSG_ERROR, "Partita non trovata");
         return 0;
     }
     
-    mutex_lock(&game->mutex);
-    
     // Ottiene l'avversario
     Client *opponent = NULL;
     int player_bit = 0;
@@ -863,7 +1582,7 @@ int game_decline_rematch(Client *client) {
         player_bit = 2;
     } else {
         mutex_unlock(&game->mutex);
-        network_send_to_client(client, "ERROR:Non fai parte di questa partita");
+        network_send_message(client, SMSG_ERROR, "Non fai parte di questa partita");
         return 0;
     }
     
@@ -874,20 +1593,22 @@ int game_decline_rematch(Client *client) {
     game->state = GAME_STATE_OVER;
     
     // Reset del richiedente dato che il rematch è stato rifiutato
-    game->rematch_requester = NULL;
+    game_set_client(&game->rematch_requester, NULL);
     
     // Avvisa l'avversario che il rematch è stato rifiutato
     if (opponent) {
-        network_send_to_client(opponent, "REMATCH_DECLINED:L'avversario ha rifiutato l'altra partita");
+        network_send_message(opponent, SMSG_REMATCH_DECLINED, "L'avversario ha rifiutato l'altra partita");
     }
     
     // Conferma al giocatore che ha rifiutato che la sua azione è stata registrata
-    network_send_to_client(client, "REMATCH_DECLINE_CONFIRMED:Hai rifiutato il rematch. La partita è terminata.");
+    network_send_message(client, SMSG_REMATCH_DECLINE_CONFIRMED, "Hai rifiutato il rematch. La partita è terminata.");
     
     // Notifica che il rematch è stato rifiutato
     printf("Client %s ha rifiutato la rivincita per partita %d - cancellate tutte le richieste\n", client->name, game->game_id);
+    game_list_publish(game);
     
     mutex_unlock(&game->mutex);
+    lobby_broadcast_game_list();
     return 1;
 }
 
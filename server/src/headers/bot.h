@@ -0,0 +1,60 @@
+#ifndef BOT_H
+#define BOT_H
+
+/*
+ * HEADER BOT - AVVERSARIO AUTOMATICO DEL SERVER
+ *
+ * Questo header definisce il giocatore automatico con cui un creatore può
+ * iniziare la partita senza attendere un avversario umano (PLAY_BOT), o
+ * che il server gli offre (BOT_OFFER) dopo un'attesa troppo lunga (vedi
+ * game_check_timeouts()). Tre livelli di gioco:
+ *
+ * - BOT_RANDOM: una cella libera a caso;
+ * - BOT_HEURISTIC: vince se può, altrimenti blocca la vittoria
+ *   dell'avversario, altrimenti sceglie la cella che gli lascia più minacce
+ *   (board_scan()) e ne toglie di più all'avversario, preferendo il centro;
+ * - BOT_PERFECT: gioco perfetto nel Tris classico, euristico nelle altre
+ *   varianti.
+ *
+ * Le mosse del livello perfetto vengono da una tabella minimax calcolata
+ * una sola volta all'avvio su tutte le posizioni raggiungibili del Tris
+ * classico: ogni posizione ha un indice in base 3 (una cifra per cella,
+ * 0 vuota, 1 X, 2 O), quindi 3^9 = 19683 voci da un byte con la cella
+ * migliore per chi deve muovere. A parità di esito il bot sceglie la vittoria più rapida e
+ * la sconfitta più lontana; contro di lui si può al massimo pareggiare.
+ * Una mossa costa una lettura della tabella, senza ricerca né memoria per
+ * partita: un server può ospitare migliaia di partite contro il bot.
+ *
+ * Nel server il bot è un Client senza socket (network_alloc_virtual_client())
+ * che occupa il posto di player2 e muove tramite lo stesso percorso delle
+ * mosse dei giocatori (vedi game_add_bot()).
+ */
+
+#include "board.h"
+
+// ========== CONFIGURAZIONI ==========
+
+#define BOT_NAME "Bot"                  // Nome del giocatore automatico nella lista partite
+#define BOT_POSITIONS 19683             // Posizioni del Tris classico (3^9)
+
+// ========== ENUMERAZIONI ==========
+
+/**
+ * Livelli di gioco del bot (PLAY_BOT:<livello>; predefinito BOT_LEVEL,
+ * --bot-level). Nel protocollo binario il valore è il byte di PLAY_BOT.
+ */
+typedef enum {
+    BOT_RANDOM,                     // Mosse a caso
+    BOT_HEURISTIC,                  // Vittoria, blocco, poi minacce (qualsiasi variante)
+    BOT_PERFECT,                    // Tabella minimax nel Tris classico, euristico altrove
+    BOT_LEVEL_COUNT
+} BotLevel;
+
+// ========== FUNZIONI DEL BOT ==========
+
+void bot_init(void);
+int bot_parse_level(const char *name, BotLevel *level);
+const char* bot_level_name(BotLevel level);
+int bot_choose_move(const Board *board, char symbol, BotLevel level, int *row, int *col);
+
+#endif
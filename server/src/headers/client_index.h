@@ -0,0 +1,68 @@
+#ifndef CLIENT_INDEX_H
+#define CLIENT_INDEX_H
+
+/*
+ * HEADER CLIENT_INDEX - INDICI HASH DEI CLIENT REGISTRATI
+ *
+ * Questo header definisce gli indici usati per trovare un client senza
+ * scansionare la lobby: uno per nome (REGISTER) e uno per token di
+ * sessione UDP (il token apre ogni datagramma ricevuto, così un cambio di
+ * indirizzo del client non ne interrompe la sessione).
+ *
+ * Entrambi sono tabelle hash ad indirizzamento aperto (linear probing con
+ * tombstone), ridimensionate automaticamente. Sono protette da un mutex
+ * proprio, distinto da lobby_mutex, così le ricerche del thread UDP non
+ * si contendono il lock con i broadcast della lobby.
+ *
+ * Gli indici sono mantenuti da lobby_add_client_reference() e
+ * lobby_remove_client_reference(). Le funzioni acquire_* restituiscono il
+ * client con un riferimento preso sotto il mutex degli indici.
+ */
+
+#include "network.h"
+
+// ========== CONFIGURAZIONI ==========
+
+#define CLIENT_INDEX_MIN_CAPACITY 16    // Dimensione minima di una tabella (potenza di 2)
+#define CLIENT_INDEX_MAX_LOAD 75        // Percentuale di occupazione (tombstone incluse) oltre cui ricostruire
+
+// ========== STRUTTURE DATI ==========
+
+/**
+ * Cella di una tabella hash. client == NULL indica cella mai usata,
+ * client == INDEX_TOMBSTONE una cella liberata (la ricerca prosegue).
+ */
+typedef struct {
+    Client *client;                 // Client indicizzato
+    unsigned int hash;              // Hash della chiave (evita di ricalcolarlo)
+} ClientIndexSlot;
+
+/**
+ * Tabella hash ad indirizzamento aperto. La chiave non è copiata: viene
+ * letta dal client (nome o token UDP); il nome cambia solo tramite le
+ * funzioni di questo modulo, il token mai mentre il client è indicizzato.
+ */
+typedef struct {
+    ClientIndexSlot *slots;         // Celle della tabella
+    size_t capacity;                // Numero di celle (potenza di 2)
+    size_t used;                    // Celle occupate da un client
+    size_t tombstones;              // Celle liberate non ancora riutilizzate
+    int by_token;                   // 0 = chiave nome, 1 = chiave token UDP
+} ClientIndex;
+
+// ========== FUNZIONI DI GESTIONE INDICI ==========
+
+int client_index_init(size_t expected_clients);
+void client_index_cleanup(void);
+
+int client_index_add(Client *client);
+void client_index_remove(Client *client);
+int client_index_rename(Client *client, const char *new_name);
+
+// ========== FUNZIONI DI RICERCA ==========
+
+Client* client_index_find_by_name(const char *name);
+Client* client_index_acquire_by_name(const char *name);
+Client* client_index_acquire_by_token(unsigned long long token);
+
+#endif
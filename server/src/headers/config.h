@@ -0,0 +1,70 @@
+#ifndef CONFIG_H
+#define CONFIG_H
+
+/*
+ * HEADER CONFIG - PARAMETRI DI ESERCIZIO DEL SERVER TRIS
+ *
+ * Questo header raccoglie i parametri regolabili senza ricompilare.
+ * I valori di default sono definiti qui e possono essere sovrascritti
+ * con variabili d'ambiente e, con priorità maggiore, con opzioni da riga
+ * di comando all'avvio del server (config_load()).
+ *
+ * Parametri attuali: porta e capacità del server (client e partite),
+ * limiti della coda di invio per client (watermark di backpressure),
+ * scadenza per i client lenti, finestra di aggregazione degli
+ * aggiornamenti della lista partite, numero di thread UDP, attesa prima
+ * di offrire un bot o chiudere una partita senza avversario e livello
+ * di gioco del bot.
+ */
+
+#include <stddef.h>
+
+// ========== VALORI DI DEFAULT ==========
+
+#define DEFAULT_PORT 8080                   // Porta TCP/UDP di ascolto
+#define DEFAULT_MAX_CLIENTS 100             // Connessioni simultanee massime
+#define DEFAULT_GAMES_PER_CLIENT_DIV 2      // Se MAX_GAMES manca: una partita ogni 2 client
+
+#define DEFAULT_OUT_HIGH_WATERMARK 32768    // Byte in coda oltre i quali il client è "in ritardo"
+#define DEFAULT_OUT_LOW_WATERMARK 8192      // Byte in coda sotto i quali il client torna in pari
+#define DEFAULT_OUT_MAX_BYTES 262144        // Limite assoluto della coda: oltre si disconnette
+#define DEFAULT_SLOW_CLIENT_TIMEOUT 10      // Secondi massimi in ritardo prima della disconnessione
+
+#define DEFAULT_LOBBY_TICK_MS 50            // Finestra (ms) in cui gli aggiornamenti della lista vengono accorpati
+#define LOBBY_TICK_MS_MAX 1000              // Finestra massima accettata
+
+#define DEFAULT_UDP_THREADS 1               // Thread UDP, ognuno con il proprio socket (al massimo uno per CPU)
+
+#define DEFAULT_BOT_FILL_DELAY 60           // Secondi di attesa prima di offrire il bot al creatore (BOT_OFFER)
+#define DEFAULT_WAITING_TIMEOUT 300         // Secondi di attesa prima di chiudere una partita senza avversario
+#define DEFAULT_BOT_LEVEL BOT_PERFECT       // Livello del bot (BotLevel di bot.h: random, heuristic, perfect)
+
+// ========== STRUTTURE DATI ==========
+
+/**
+ * Configurazione di esercizio del server.
+ * Letta una sola volta all'avvio, poi solo consultata (nessun lock).
+ */
+typedef struct {
+    int port;                       // Porta di ascolto TCP e UDP
+    int max_clients;                // Connessioni simultanee massime
+    int max_games;                  // Partite simultanee massime
+    size_t out_high_watermark;      // Soglia di ingresso nello stato di ritardo
+    size_t out_low_watermark;       // Soglia di uscita dallo stato di ritardo
+    size_t out_max_bytes;           // Dimensione massima della coda di invio
+    int slow_client_timeout;        // Secondi concessi a un client in ritardo
+    int lobby_tick_ms;              // Finestra di aggregazione degli aggiornamenti lista (ms)
+    int udp_threads;                // Thread e socket UDP richiesti (SO_REUSEPORT se più di uno)
+    int bot_fill_delay;             // Secondi in WAITING prima di BOT_OFFER (>= waiting_timeout: mai)
+    int waiting_timeout;            // Secondi in WAITING prima della chiusura della partita
+    int bot_level;                  // Livello del bot (BotLevel, vedi bot.h)
+} ServerConfig;
+
+extern ServerConfig server_config;
+
+// ========== FUNZIONI DI CONFIGURAZIONE ==========
+
+void config_load(int argc, char *argv[]);
+void config_print(void);
+
+#endif
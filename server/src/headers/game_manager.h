@@ -10,18 +10,53 @@
  * Include la gestione completa del ciclo di vita delle partite:
  * creazione, join, approvazione, gameplay, rematch e cleanup.
  *
- * Supporta fino a MAX_GAMES partite simultanee con gestione thread-safe
- * tramite mutex per operazioni concorrenti.
+ * Il numero massimo di partite simultanee è server_config.max_games; gli
+ * slot sono allocati a blocchi man mano che servono, senza mai spostare
+ * le partite esistenti. Gestione thread-safe tramite mutex.
+ *
+ * Le partite in GAME_STATE_WAITING sono anche in una di due liste di
+ * attesa, ordinate per istante di ingresso nello stato: prima quella delle
+ * partite a cui offrire il bot (BOT_OFFER), poi quella delle partite che
+ * scadono. I ritardi sono uguali per tutte, quindi ogni lista scade nel suo
+ * ordine e game_check_timeouts() (chiamata a ogni tick della lobby) esamina
+ * solo le teste invece di tutta la tabella. Il creatore accetta l'offerta
+ * con PLAY_BOT; se la ignora, la partita viene chiusa alla scadenza.
  *
  * Compatibile con Windows e sistemi Unix/Linux.
  */
 
 #include "network.h"
+#include "board.h"
+#include "protocol.h"
+#include "bot.h"
 #include <time.h>
 
 // ========== CONFIGURAZIONI ==========
 
-#define MAX_GAMES 50                    // Numero massimo di partite simultanee
+#define GAME_CHUNK_SLOTS 64             // Slot partita allocati per ogni blocco
+
+// Lista partite: "LIST_GAMES[:<filtro>[:<offset>[:<limite>]]]" restituisce una pagina
+// "GAMES:<seq>:<offset>:<totale>:<voci>", poi il server invia gli aggiornamenti
+// "LIST_UPDATE:<seq>:ADD|UPDATE:<voce>" e "LIST_UPDATE:<seq>:REMOVE:<id>".
+// Un client che vede un salto di sequenza richiede di nuovo la pagina.
+#define LIST_ENTRY_SIZE 128             // Voce di una partita: "<id> <stato>[/<righe>x<colonne>x<k>] <nome> [<nome>]"
+#define LIST_DELTA_SIZE 192             // Messaggio LIST_UPDATE completo
+#define LIST_DELTA_LOG 1024             // Aggiornamenti conservati per l'invio ai client
+#define LIST_PAGE_DEFAULT 8             // Voci per pagina se il client non indica il limite
+#define LIST_PAGE_MAX 32                // Voci per pagina al massimo (la pagina sta comunque in MAX_MSG_SIZE)
+
+#define WAIT_QUEUE_OFFER 0              // Partite in attesa dell'offerta del bot (BOT_OFFER)
+#define WAIT_QUEUE_EXPIRE 1             // Partite in attesa della scadenza (offerta inviata o disattivata)
+#define WAIT_QUEUES 2
+
+// Gli ID partita codificano slot e generazione: id = (generazione << GAME_SLOT_BITS) | slot.
+// La ricerca per ID è quindi un accesso diretto alla tabella degli slot; la generazione,
+// incrementata a ogni liberazione dello slot, rende invalidi gli ID vecchi.
+#define GAME_SLOT_BITS 16                               // Bit riservati all'indice dello slot
+#define GAME_SLOT_MASK ((1 << GAME_SLOT_BITS) - 1)
+#define GAME_GENERATION_MAX ((1 << (31 - GAME_SLOT_BITS)) - 1)  // Oltre si riparte da 1 (ID sempre > 0)
+#define GAME_MAKE_ID(generation, slot) ((int)(((generation) << GAME_SLOT_BITS) | (slot)))
+#define GAME_ID_SLOT(game_id) ((game_id) & GAME_SLOT_MASK)
 
 // ========== ENUMERAZIONI ==========
 
@@ -59,7 +94,7 @@ typedef struct {
     Client* player1;                // Primo giocatore (creatore, simbolo X)
     Client* player2;                // Secondo giocatore (partecipante, simbolo O)
     Client* pending_player;         // Giocatore in attesa di approvazione
-    char board[3][3];              // Tabellone di gioco 3x3
+    Board board;                   // Tabellone m,n,k della partita (bitboard, vedi board.h)
     PlayerSymbol current_player;    // Giocatore che deve fare la mossa corrente
     GameState state;               // Stato attuale della partita
     PlayerSymbol winner;           // Vincitore della partita (se presente)
@@ -68,7 +103,19 @@ typedef struct {
     int rematch_declined;          // Bit field: 1=player1 ha rifiutato, 2=player2 ha rifiutato
     Client* rematch_requester;     // Chi ha richiesto per primo il rematch (avrà simbolo X)
     time_t creation_time;          // Timestamp di creazione della partita
+    int bot_level;                 // Livello del bot avversario (BotLevel, vedi bot.h)
+    long long wait_since;          // Ingresso in GAME_STATE_WAITING, ms monotoni (udp_channel_now_ms())
+    int wait_queue;                // Lista di attesa (WAIT_QUEUE_OFFER o WAIT_QUEUE_EXPIRE), -1 se fuori
+    int wait_prev;                 // Slot precedente nella lista di attesa (-1 se primo)
+    int wait_next;                 // Slot successivo nella lista di attesa (-1 se ultimo)
     mutex_t mutex;                 // Mutex per accesso thread-safe
+    int generation;                // Generazione corrente dello slot (parte alta dell'ID)
+    int slot;                      // Indice dello slot (parte bassa dell'ID)
+    int next_free;                 // Slot successivo nella free-list (-1 se ultimo)
+    int listed_id;                 // ID con cui la partita compare nella lista dei client (0 se assente)
+    int list_group;                // Gruppo nell'indice della lista (ListFilter, -1 se assente; list_mutex)
+    int list_pos;                  // Posizione nel gruppo dell'indice (list_mutex)
+    char list_entry[LIST_ENTRY_SIZE]; // Ultima voce pubblicata nella lista (list_mutex)
 } Game;
 
 // ========== FUNZIONI DI GESTIONE MUTEX ==========
@@ -85,9 +132,11 @@ void game_manager_cleanup();
 
 // ========== FUNZIONI DI GESTIONE PARTITE ==========
 
-int game_create_new(Client *creator);
+int game_create_new(Client *creator, int rows, int cols, int k);
 int game_join(Client *client, int game_id);
 int game_approve_join(Client *creator, int approve);
+int game_add_bot(Client *creator, BotLevel level);
+void game_check_timeouts(void);
 int game_request_rematch(Client *client);
 int game_cancel_rematch(Client *client); // Aggiunta nuova funzione
 int game_decline_rematch(Client *client); // Rifiuta il rematch
@@ -102,13 +151,18 @@ void game_reset(int game_id);
 // ========== FUNZIONI DI RICERCA E UTILITY ==========
 
 Game* game_find_by_id(int game_id);
-void game_list_available(char *response, size_t max_len);
+int game_list_parse_filter(const char *name, ListFilter *filter);
+unsigned long game_list_page(ListFilter filter, int offset, int limit, char *response, size_t max_len);
+unsigned long game_list_version(void);
+SharedMsg* game_list_delta(unsigned long seq);
+void game_list_refresh(int game_id);
 void game_broadcast_to_all_clients(const char *message);
 
 // ========== FUNZIONI DI LOGICA DI GIOCO ==========
 
 void game_init_board(Game *game);
 int game_check_winner(Game *game);
+int game_count_threats(Game *game, PlayerSymbol symbol);
 int game_is_valid_move(Game *game, int row, int col);
 int game_is_board_full(Game *game);
 
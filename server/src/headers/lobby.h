@@ -11,18 +11,36 @@
  * Gestisce registrazione, disconnessioni, routing dei messaggi e
  * integrazione con il sistema di gestione partite.
  *
- * Supporta fino a MAX_CLIENTS connessioni simultanee con gestione
- * thread-safe per operazioni concorrenti.
+ * Supporta fino a server_config.max_clients client registrati; gli slot
+ * sono allocati a blocchi man mano che servono. Gestione thread-safe per
+ * operazioni concorrenti.
  *
  * Compatibile con Windows e sistemi Unix/Linux.
  */
 
 #include "network.h"
 #include "game_manager.h"
+#include "protocol.h"
 
 // ========== CONFIGURAZIONI ==========
 
-#define MAX_CLIENTS 100             // Numero massimo di client simultanei
+#define LOBBY_CHUNK_SLOTS 256       // Slot client allocati per ogni blocco
+
+// Gli aggiornamenti della lista partite non vengono inviati a ogni modifica:
+// lobby_broadcast_game_list() li accumula e un thread li invia insieme una
+// volta per finestra di server_config.lobby_tick_ms.
+
+// ========== STRUTTURE DATI ==========
+
+/**
+ * Slot della lobby: contiene un client registrato oppure è nella pila
+ * degli slot liberi. L'indice dello slot è salvato in client->lobby_slot,
+ * così la rimozione non richiede scansioni.
+ */
+typedef struct {
+    Client *client;                 // Client nello slot (NULL se libero)
+    int next_free;                  // Slot libero successivo (-1 se ultimo)
+} LobbySlot;
 
 // ========== FUNZIONI DI INIZIALIZZAZIONE ==========
 
@@ -39,19 +57,14 @@ Client* lobby_find_client_by_name(const char *name);
 
 // ========== FUNZIONI DI COMUNICAZIONE ==========
 
-void lobby_handle_client_message(Client *client, const char *message);
+void lobby_handle_command(Client *client, const Command *cmd);
 void lobby_broadcast_message(const char *message, Client *exclude);
 void lobby_broadcast_game_list();
+void lobby_get_broadcast_stats(unsigned long *requests, unsigned long *coalesced);
 
 // ========== FUNZIONI DI GESTIONE COMANDI ==========
 
-void lobby_handle_register(Client *client, const char *name);
-void lobby_handle_create_game(Client *client);
-void lobby_handle_join_game(Client *client, const char *message);
-void lobby_handle_approve_join(Client *client, const char *message);
-void lobby_handle_list_games(Client *client);
-void lobby_handle_move(Client *client, const char *message);
-void lobby_handle_rematch(Client *client);
+void lobby_handle_approve_join(Client *client, int approve);
 void lobby_remove_client_reference(Client *client);
 
 // ========== FUNZIONI DI ACCESSO THREAD-SAFE ==========
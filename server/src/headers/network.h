@@ -7,17 +7,28 @@
  * Questo header definisce tutte le strutture dati e funzioni necessarie
  * per la gestione della comunicazione di rete del server Tris multiplayer.
  * 
- * Gestisce connessioni TCP e UDP, threading per client multipli,
- * e comunicazione bidirezionale con i client connessi.
+ * Gestisce connessioni TCP e UDP, dispatch dei messaggi dei client
+ * (servito dal reactor epoll su Linux) e comunicazione bidirezionale
+ * con i client connessi.
  *
- * Supporta fino a MAX_CLIENTS connessioni simultanee con gestione
- * thread-safe e cross-platform (Windows/Linux).
+ * Supporta fino a server_config.max_clients connessioni simultanee
+ * (vedi config.h) con gestione thread-safe e cross-platform (Windows/Linux).
+ * Le strutture Client e i buffer dei messaggi in uscita provengono da
+ * pool con cache per thread (pool.h) e vengono riutilizzati; un messaggio
+ * inviato a più client è un unico buffer condiviso dalle loro code.
+ *
+ * La vita di un Client è governata da un contatore di riferimenti: la
+ * connessione, lo slot della lobby, ogni campo di una partita che lo
+ * punta e ogni invio in corso da un altro thread tengono un riferimento.
+ * La struttura torna al pool solo con l'ultimo network_release_client(),
+ * quindi chi ha preso un riferimento può usarla anche fuori dai lock.
  *
  * Include astrazioni per socket, thread e mutex per portabilità.
  */
 
 #include <unistd.h>
 #include <sys/time.h>
+#include <time.h>
 
 // ========== CONFIGURAZIONE CROSS-PLATFORM ==========
 
@@ -59,40 +70,159 @@
     #define closesocket close
 #endif
 
+#include "messages.h"
+
 // ========== CONFIGURAZIONI SERVER ==========
 
-#define SERVER_PORT 8080            // Porta di ascolto del server
 #define MAX_MSG_SIZE 1024           // Dimensione massima messaggi
 #define MAX_NAME_LEN 50             // Lunghezza massima nome giocatore
-#define MAX_CLIENTS 100             // Numero massimo client simultanei
+#define CLIENT_CHUNK_SIZE 64        // Strutture Client allocate per ogni blocco del pool
+#define MSG_POOL_CHUNK_SIZE 256     // Buffer dei messaggi (ed elementi delle code) allocati per ogni blocco del pool
+#define UDP_MAX_SOCKETS 16          // Socket (e thread) UDP massimi con SO_REUSEPORT
+#define UDP_BATCH_SIZE 64           // Datagrammi letti e risposte inviate per chiamata (recvmmsg/sendmmsg)
+#define OUT_MSG_SMALL_SIZE 128      // Messaggi fino a questa lunghezza usano il pool dei buffer brevi
+#define NETWORK_RESERVED_FDS 64     // Descrittori riservati oltre ai client (socket di ascolto, epoll, log)
+#define REGISTRATION_TIMEOUT 30     // Secondi concessi per inviare REGISTER
+#define CLIENT_IDLE_TIMEOUT 600     // Secondi di inattività prima della disconnessione
+#define RECV_RING_SIZE 4096         // Buffer circolare di ricezione (potenza di 2, >= 2*MAX_MSG_SIZE)
+#define MSG_DELIMITER '\n'          // Terminatore di ogni messaggio TCP
+#define OUT_IOV_MAX 64              // Messaggi accorpati al massimo in una singola writev
+#define UDP_CHANNEL_WINDOW 16       // Eventi UDP in attesa di conferma per client (oltre si passa a TCP)
+#define UDP_CHANNEL_MSG_SIZE 128    // Dimensione massima di un evento UDP ("SEQ:<n>:<messaggio>")
 
 // ========== STRUTTURE DATI ==========
 
+/**
+ * Buffer circolare di ricezione per il framing dei messaggi TCP.
+ * I contatori sono monotoni e vengono ridotti con RECV_RING_SIZE - 1,
+ * quindi head == tail indica buffer vuoto senza sprecare celle.
+ */
+typedef struct {
+    char data[RECV_RING_SIZE];      // Byte ricevuti non ancora consumati
+    size_t head;                    // Primo byte non consumato
+    size_t tail;                    // Fine dei byte ricevuti
+    size_t scan;                    // Posizione fino a cui il terminatore è già stato cercato
+} RecvRing;
+
+/**
+ * Messaggio in uscita immutabile, già terminato da MSG_DELIMITER.
+ * Un messaggio destinato a più client (broadcast, mosse, aggiornamenti
+ * della lista) viene formattato una sola volta e accodato per riferimento
+ * a ogni destinatario; torna al pool quando l'ultima coda lo ha scritto o
+ * scartato (vedi network_msg_release()).
+ */
+typedef struct SharedMsg {
+    int refcount;                   // Riferimenti attivi: code di invio e chiamanti
+    int large;                      // Buffer del pool dei messaggi lunghi (MAX_MSG_SIZE)
+    struct SharedMsg *binary;       // Frame binario equivalente, creato al primo client binario
+    size_t len;                     // Lunghezza dei dati (terminatore incluso)
+    char data[];                    // Byte da inviare
+} SharedMsg;
+
+/**
+ * Elemento della coda di invio di un client: riferimento a un messaggio.
+ * Solo gli aggiornamenti della lobby (GAMES:, LIST_UPDATE:) sono scartabili:
+ * i messaggi di partita non vengono mai persi.
+ */
+typedef struct OutMsg {
+    struct OutMsg *next;            // Messaggio successivo nella coda
+    SharedMsg *msg;                 // Dati da inviare (riferimento preso all'accodamento)
+    int droppable;                  // Aggiornamento lobby scartabile se il client è in ritardo
+} OutMsg;
+
+/**
+ * Evento di partita inviato su UDP e non ancora confermato dal client.
+ */
+typedef struct {
+    unsigned long seq;              // Numero di sequenza
+    long long sent_ms;              // Ultimo invio (millisecondi monotoni)
+    int retries;                    // Ritrasmissioni già eseguite
+    size_t len;                     // Lunghezza del datagramma
+    size_t text;                    // Inizio del messaggio incapsulato (per il ripiego su TCP)
+    char data[UDP_CHANNEL_MSG_SIZE]; // Datagramma "SEQ:<n>:<messaggio>"
+} UdpPending;
+
+/**
+ * Canale UDP affidabile di un client (vedi udp_channel.h): numeri di
+ * sequenza, eventi in attesa di conferma e stato della ritrasmissione.
+ */
+typedef struct {
+    mutex_t mutex;                  // Protegge il canale
+    int active;                     // Canale aperto con UDP_REGISTER e non degradato a TCP
+    socket_t sock;                  // Socket UDP da cui partono gli eventi
+    struct sockaddr_in addr;        // Indirizzo UDP del client
+    unsigned long send_seq;         // Ultima sequenza inviata
+    unsigned long recv_seq;         // Ultima sequenza ricevuta in ordine dal client
+    int head;                       // Primo evento in attesa in pending
+    int count;                      // Eventi in attesa di conferma
+    UdpPending pending[UDP_CHANNEL_WINDOW];
+    int scheduled;                  // Client nella lista di ritrasmissione
+    struct Client *retransmit_next; // Lista di ritrasmissione
+} UdpChannel;
+
 /**
  * Struttura che rappresenta un client connesso al server.
  * Contiene tutte le informazioni necessarie per la comunicazione e lo stato.
  */
-typedef struct {
+typedef struct Client {
     socket_t client_fd;             // File descriptor della connessione TCP
     char name[MAX_NAME_LEN];        // Nome del giocatore
     int game_id;                    // ID della partita corrente (-1 se non in gioco)
     char symbol;                    // Simbolo del giocatore (X o O)
-    struct sockaddr_in udp_addr;    // Indirizzo UDP per comunicazione veloce
+    unsigned long long udp_token;   // Token di sessione UDP (UDP_SESSION), 0 se non assegnato
+    UdpChannel udp_channel;         // Canale UDP affidabile per gli eventi di partita
     int is_active;                  // Flag per stato attivazione client
-    thread_t thread;                // Thread dedicato per gestione client
+    int is_registered;              // Flag registrazione completata (REGISTER accettato)
+    int binary;                     // Protocollo binario negoziato (REGISTER:<nome>:BIN), scritto sotto out_mutex
+    int is_bot;                     // Giocatore automatico senza socket (vedi bot.h)
+    time_t connect_time;            // Timestamp di connessione (timeout registrazione)
+    time_t last_activity;           // Timestamp ultimo messaggio ricevuto
+    RecvRing recv_ring;             // Byte ricevuti in attesa di formare messaggi completi
+    mutex_t out_mutex;              // Protegge la coda di invio
+    OutMsg *out_head;               // Coda di invio: primo messaggio da scrivere
+    OutMsg *out_tail;               // Coda di invio: ultimo messaggio accodato
+    size_t out_offset;              // Byte di out_head già scritti (invio parziale)
+    size_t out_bytes;               // Byte totali in attesa nella coda
+    int flush_scheduled;            // Client già nella lista di flush del reactor
+    struct Client *flush_next;      // Lista dei client con dati da inviare
+    int lagging;                    // Coda oltre l'high watermark, non ancora sotto il low
+    time_t lagging_since;           // Inizio del ritardo (per la disconnessione forzata)
+    struct Client *lag_prev;        // Lista del reactor dei client in ritardo
+    struct Client *lag_next;
+    int lag_closed;                 // Connessione in chiusura: non rientra nella lista (list_mutex)
+    thread_t thread;                // Thread dedicato (solo Windows, thread-per-client)
+    struct Reactor *reactor;        // Reactor epoll che possiede la connessione (Linux)
+    struct Client *idle_prev;       // Lista del reactor ordinata per ultima attività
+    struct Client *idle_next;
+    struct Client *reg_prev;        // Lista del reactor dei client non ancora registrati
+    struct Client *reg_next;
+    int lobby_slot;                 // Slot occupato nella lobby (-1 se non registrato)
+    int refcount;                   // Riferimenti attivi (vedi network_retain_client())
 } Client;
 
+/**
+ * Contatori della politica di backpressure sul percorso di invio.
+ */
+typedef struct {
+    unsigned long dropped_messages;     // Aggiornamenti lobby scartati per client in ritardo
+    unsigned long evicted_clients;      // Client disconnessi perché troppo lenti
+    unsigned long lagging_events;       // Ingressi nello stato di ritardo
+} NetworkStats;
+
 /**
  * Struttura principale del server di rete.
  * Contiene le socket di ascolto e lo stato del server.
  */
 typedef struct {
     socket_t tcp_socket;            // Socket TCP per connessioni affidabili
-    socket_t udp_socket;            // Socket UDP per comunicazioni veloci
+    socket_t udp_sockets[UDP_MAX_SOCKETS]; // Socket UDP per comunicazioni veloci, uno per thread UDP
+    int udp_socket_count;           // Socket UDP aperti (più di uno solo con SO_REUSEPORT)
     struct sockaddr_in server_addr; // Indirizzo del server
     int is_running;                 // Flag per stato di esecuzione server
 } ServerNetwork;
 
+struct PoolStats;                   // Contatori dei pool di memoria (pool.h)
+
 // ========== FUNZIONI DI GESTIONE SERVER ==========
 
 int network_init(ServerNetwork *server);
@@ -101,13 +231,41 @@ void network_shutdown(ServerNetwork *server);
 
 // ========== FUNZIONI DI GESTIONE CLIENT ==========
 
+Client* network_alloc_client(socket_t client_fd);
+Client* network_alloc_virtual_client(const char *name);
 Client* network_accept_client(ServerNetwork *server);
 int network_send_to_client(Client *client, const char *message);
-int network_receive_from_client(Client *client, char *buffer, size_t buf_size);
+int network_send_message(Client *client, ServerMsgId id, const char *text);
+int network_send_lobby_update(Client *client, const char *message);
+int network_send_msg(Client *client, SharedMsg *msg);
+int network_send_lobby_update_msg(Client *client, SharedMsg *msg);
+int network_flush_client(Client *client);
+void network_handle_writable(Client *client);
+void network_evict_client(Client *client, const char *reason);
+void network_get_stats(NetworkStats *stats);
+int network_receive_from_client(Client *client);
+int network_next_message(Client *client, char *buffer, size_t buf_size);
+int network_handle_client_input(Client *client);
+void network_process_client_message(Client *client, const char *message);
+void network_process_client_frame(Client *client, const unsigned char *frame, size_t len);
+void network_cleanup_client(Client *client);
+void network_retain_client(Client *client);
+void network_release_client(Client *client);
+void network_clients_cleanup(void);
+void network_get_pool_stats(struct PoolStats *clients, struct PoolStats *nodes,
+                            struct PoolStats *small_msgs, struct PoolStats *large_msgs);
+
+// ========== FUNZIONI DI GESTIONE MESSAGGI CONDIVISI ==========
+
+SharedMsg* network_msg_create(const char *message);
+void network_msg_retain(SharedMsg *msg);
+void network_msg_release(SharedMsg *msg);
 
 // ========== FUNZIONI DI THREADING ==========
 
+#ifdef _WIN32
 thread_return_t THREAD_CALL network_handle_client_thread(thread_param_t arg);
+#endif
 thread_return_t THREAD_CALL network_handle_udp_thread(thread_param_t arg);
 
 // ========== FUNZIONI DI UTILITÀ CROSS-PLATFORM ==========
@@ -0,0 +1,72 @@
+#ifndef POOL_H
+#define POOL_H
+
+/*
+ * HEADER POOL - POOL DI OGGETTI A DIMENSIONE FISSA
+ *
+ * Questo header definisce i pool usati al posto di malloc/free sui
+ * percorsi caldi: strutture Client (accept) e buffer dei messaggi in
+ * uscita (ogni invio).
+ *
+ * Ogni thread ha una piccola cache privata per pool: allocazioni e
+ * rilasci che trovano spazio nella cache non prendono lock. Solo quando
+ * la cache è vuota (o piena) il thread scambia un lotto di oggetti con
+ * la lista globale del pool, protetta da mutex; se anche la lista globale
+ * è vuota il pool alloca un nuovo blocco di oggetti.
+ *
+ * La memoria non torna al sistema prima di pool_destroy(): un picco di
+ * connessioni lascia oggetti pronti per il picco successivo.
+ */
+
+#include "network.h"
+
+// ========== CONFIGURAZIONI ==========
+
+#define POOL_MAX_POOLS 8                // Pool registrabili (una cache per pool in ogni thread)
+#define POOL_CACHE_SIZE 32              // Oggetti al massimo nella cache di un thread
+#define POOL_CACHE_BATCH 16             // Oggetti scambiati con la lista globale per volta
+#define POOL_ALIGN 16                   // Allineamento degli oggetti
+
+// ========== STRUTTURE DATI ==========
+
+/**
+ * Contatori di un pool (letti senza lock, valori indicativi).
+ */
+typedef struct PoolStats {
+    unsigned long hits;             // Allocazioni servite dalla cache del thread
+    unsigned long misses;           // Allocazioni che hanno richiesto la lista globale
+    unsigned long in_use;           // Oggetti attualmente allocati
+    unsigned long high_water;       // Massimo di oggetti allocati contemporaneamente
+    unsigned long capacity;         // Oggetti creati dal pool (in uso, in cache o liberi)
+} PoolStats;
+
+/**
+ * Pool di oggetti di dimensione fissa con cache per thread.
+ */
+typedef struct {
+    const char *name;               // Nome del pool (per i log)
+    int id;                         // Indice della cache nei thread
+    size_t obj_size;                // Dimensione di un oggetto (arrotondata a POOL_ALIGN)
+    size_t chunk_objs;              // Oggetti allocati per ogni nuovo blocco
+    mutex_t mutex;                  // Protegge free_list e chunks
+    void *free_list;                // Oggetti liberi non in cache (lista intrusiva)
+    void *chunks;                   // Blocchi allocati (liberati da pool_destroy)
+    PoolStats stats;                // Contatori (aggiornati con operazioni atomiche)
+} ObjectPool;
+
+// ========== FUNZIONI DI GESTIONE ==========
+
+int pool_init(ObjectPool *pool, const char *name, size_t obj_size, size_t chunk_objs);
+void pool_destroy(ObjectPool *pool);
+void pool_thread_flush(void);
+
+// ========== FUNZIONI DI ALLOCAZIONE ==========
+
+void* pool_alloc(ObjectPool *pool);
+void pool_free(ObjectPool *pool, void *obj);
+
+// ========== FUNZIONI DI STATISTICA ==========
+
+void pool_get_stats(ObjectPool *pool, PoolStats *stats);
+
+#endif
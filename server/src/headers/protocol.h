@@ -0,0 +1,100 @@
+#ifndef PROTOCOL_H
+#define PROTOCOL_H
+
+/*
+ * HEADER PROTOCOL - ANALISI E SMISTAMENTO DEI COMANDI
+ *
+ * Questo header definisce l'analisi dei comandi testuali inviati dai
+ * client ("VERBO[:argomenti]"), comune al canale TCP e a quello UDP.
+ *
+ * I comandi e i messaggi del server sono definiti in common/messages.h,
+ * condiviso con il client. Il verbo viene letto in una sola passata e
+ * tradotto in un codice (CommandId) con confronti generati dalla tabella
+ * CLIENT_COMMANDS, che confrontano il testo solo dei verbi della stessa
+ * lunghezza: l'ordine dei comandi non conta (REMATCH e REMATCH_DECLINE
+ * sono verbi distinti) e un nuovo comando non richiede altre modifiche. Gli argomenti restano
+ * nel messaggio originale e si leggono con protocol_next_int() e
+ * protocol_next_field(), senza sscanf né allocazioni.
+ *
+ * Ogni canale smista i comandi con protocol_dispatch() su una propria
+ * tabella di gestori indicizzata per CommandId.
+ *
+ * Protocollo binario (solo TCP, facoltativo): un client che si registra con
+ * "REGISTER:<nome>:BIN" riceve "OK:BIN" come ultima riga di testo, poi in
+ * entrambe le direzioni viaggiano frame "<lunghezza varint><opcode><dati>",
+ * dove la lunghezza conta opcode e dati. I comandi usano come opcode il
+ * CommandId; i messaggi del server il ServerMsgId. Gli interi sono varint
+ * (7 bit per byte, il bit alto indica che seguono altri byte) e una cella
+ * del tabellone è un solo byte (riga << 4 | colonna). Gli argomenti numerici
+ * di un frame ricevuto finiscono direttamente in Command.values, senza
+ * passare dal testo; protocol_int_args() li legge da lì o dagli argomenti
+ * testuali. Il server produce la codifica binaria dal messaggio di testo al
+ * momento dell'invio, quindi il protocollo testuale resta quello di riferimento.
+ */
+
+#include <stddef.h>
+#include "messages.h"
+
+// ========== PROTOCOLLO BINARIO ==========
+
+#define PROTOCOL_BINARY_OPTION "BIN"        // Opzione di REGISTER che attiva il protocollo binario
+#define PROTOCOL_FRAME_HEADER_MAX 2         // Byte massimi della lunghezza (varint < 16384)
+#define PROTOCOL_CELL(row, col) ((unsigned char)(((row) << 4) | ((col) & 0x0F)))
+#define PROTOCOL_CELL_ROW(cell) ((cell) >> 4)
+#define PROTOCOL_CELL_COL(cell) ((cell) & 0x0F)
+#define PROTOCOL_LIST_FILTERS (LIST_FILTER_ALL + 1)  // Valori del byte di filtro di LIST_GAMES (ListFilter)
+#define PROTOCOL_MAX_VALUES 3               // Argomenti numerici di un comando (CREATE_GAME, LIST_GAMES)
+
+// ========== STRUTTURE DATI ==========
+
+/**
+ * Filtri della lista partite. Ogni partita elencata appartiene a uno solo
+ * dei gruppi (lo stato riportato nella sua voce); l'ordine dei gruppi è
+ * l'ordine in cui LIST_FILTER_ALL li concatena. Nel protocollo binario
+ * il filtro di LIST_GAMES è un byte con questo valore.
+ */
+typedef enum {
+    LIST_FILTER_WAITING,            // In attesa di avversario (le sole a cui ci si può unire)
+    LIST_FILTER_PENDING,            // Richiesta di join in attesa di approvazione
+    LIST_FILTER_PLAYING,            // Partita in corso
+    LIST_FILTER_REMATCH,            // Rivincita richiesta
+    LIST_FILTER_COUNT,
+    LIST_FILTER_ALL = LIST_FILTER_COUNT  // Tutti i gruppi
+} ListFilter;
+
+/**
+ * Comando analizzato. Gli argomenti puntano dentro il messaggio ricevuto,
+ * che deve restare valido finché il comando è in uso.
+ */
+typedef struct {
+    CommandId id;                   // Codice del verbo
+    const char *args;               // Argomenti dopo ':' (stringa vuota se assenti o già in values)
+    int value_count;                // Argomenti numerici già decodificati (frame binario), 0 per il testo
+    int values[PROTOCOL_MAX_VALUES]; // Argomenti numerici nell'ordine della forma testuale
+} Command;
+
+/**
+ * Gestore di un comando. ctx è il contesto del canale (es. il Client su
+ * TCP, mittente e socket su UDP).
+ */
+typedef void (*CommandHandler)(void *ctx, const Command *cmd);
+
+// ========== FUNZIONI DI ANALISI ==========
+
+int protocol_parse(const char *message, Command *cmd);
+int protocol_next_int(const char **cursor, char separator, int *value);
+size_t protocol_next_field(const char **cursor, char separator, const char **field);
+int protocol_int_args(const Command *cmd, char separator, int *values, int count);
+
+// ========== FUNZIONI DEL PROTOCOLLO BINARIO ==========
+
+size_t protocol_put_varint(unsigned char *out, unsigned long value);
+int protocol_get_varint(const unsigned char **cursor, const unsigned char *end, unsigned long *value);
+int protocol_decode_binary(const unsigned char *frame, size_t len, Command *cmd, char *args, size_t args_size);
+size_t protocol_encode_binary(const char *text, size_t len, unsigned char *out, size_t max);
+
+// ========== FUNZIONI DI SMISTAMENTO ==========
+
+int protocol_dispatch(const CommandHandler handlers[CMD_COUNT], void *ctx, const Command *cmd);
+
+#endif
@@ -0,0 +1,77 @@
+#ifndef REACTOR_H
+#define REACTOR_H
+
+/*
+ * HEADER REACTOR - EVENT LOOP EPOLL DEL SERVER TRIS
+ *
+ * Questo header definisce il reactor che sostituisce il modello
+ * thread-per-client su Linux. Un numero fisso di thread, ciascuno con
+ * la propria istanza epoll in modalità edge-triggered, serve tutte le
+ * connessioni TCP: il main thread accetta i socket e li assegna ai
+ * reactor in round-robin.
+ *
+ * Ogni connessione appartiene a un solo reactor per tutta la sua vita,
+ * quindi le letture di un client non sono mai concorrenti. I timeout
+ * di registrazione e di inattività sono gestiti con liste intrusive
+ * ordinate nel tempo, senza scansionare tutte le connessioni.
+ *
+ * Anche gli invii passano dal reactor: network_send_to_client() accoda
+ * il messaggio e segnala il client al reactor proprietario, che a fine
+ * ciclo di eventi scrive con una sola writev tutto ciò che è in coda.
+ * I client la cui coda resta oltre l'high watermark per più di
+ * slow_client_timeout secondi vengono disconnessi dal controllo periodico.
+ *
+ * Disponibile solo su Linux; su Windows resta il thread-per-client.
+ */
+
+#include "network.h"
+
+#ifndef _WIN32
+
+// ========== CONFIGURAZIONI ==========
+
+#define REACTOR_MAX_THREADS 16          // Numero massimo di thread reactor
+#define REACTOR_MAX_EVENTS 256          // Eventi epoll processati per iterazione
+#define REACTOR_TICK_MS 1000            // Intervallo di controllo dei timeout
+
+// ========== STRUTTURE DATI ==========
+
+/**
+ * Stato di un singolo thread reactor.
+ * Le liste dei client sono protette da list_mutex perché le aggiunte
+ * arrivano dal main thread (accept) mentre il resto avviene nel reactor.
+ */
+typedef struct Reactor {
+    int index;                      // Indice del reactor (per logging)
+    int epoll_fd;                   // Istanza epoll del reactor
+    thread_t thread;                // Thread che esegue il loop di eventi
+    mutex_t list_mutex;             // Protegge le liste e il contatore
+    Client *idle_head;              // Connessione meno recentemente attiva
+    Client *idle_tail;              // Connessione più recentemente attiva
+    Client *reg_head;               // Connessione non registrata più vecchia
+    Client *reg_tail;
+    Client *lag_head;               // Client in ritardo da più tempo (coda oltre l'high watermark)
+    Client *lag_tail;
+    int conn_count;                 // Connessioni servite dal reactor
+    int wake_fd;                    // eventfd per svegliare il reactor da altri thread
+    mutex_t flush_mutex;            // Protegge la lista dei client da svuotare
+    Client *flush_head;             // Client con messaggi accodati da inviare
+} Reactor;
+
+// ========== FUNZIONI DI GESTIONE REACTOR ==========
+
+int reactor_init(int num_threads);
+int reactor_start(void);
+int reactor_add_client(Client *client);
+void reactor_shutdown(void);
+void reactor_cleanup(void);
+
+// ========== FUNZIONI DI INVIO ==========
+
+int reactor_request_flush(Client *client);
+void reactor_forget_client(Client *client);
+void reactor_sync_lagging(Client *client);
+
+#endif
+
+#endif
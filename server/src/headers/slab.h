@@ -0,0 +1,49 @@
+#ifndef SLAB_H
+#define SLAB_H
+
+/*
+ * HEADER SLAB - TABELLE A BLOCCHI CRESCIBILI
+ *
+ * Questo header definisce la tabella a blocchi (slab) usata per le
+ * strutture dimensionate a runtime: client, slot della lobby e partite.
+ *
+ * Gli elementi sono allocati a blocchi di dimensione fissa (potenza di 2)
+ * e indirizzati tramite una directory di puntatori ai blocchi, allocata
+ * una sola volta per la capacità massima. Aggiungere un blocco non sposta
+ * né la directory né i blocchi esistenti: i puntatori agli elementi
+ * restano validi per tutta la vita della tabella e la lettura di un
+ * elemento già pubblicato non richiede lock.
+ *
+ * La crescita va serializzata dal chiamante (ogni tabella ha già un mutex
+ * che protegge la propria free-list).
+ */
+
+#include <stddef.h>
+
+// ========== STRUTTURE DATI ==========
+
+/**
+ * Tabella di elementi di dimensione fissa, allocata a blocchi.
+ * Gli elementi dei nuovi blocchi sono azzerati.
+ */
+typedef struct {
+    unsigned char **chunks;         // Directory dei blocchi (max_chunks voci)
+    size_t elem_size;               // Dimensione di un elemento in byte
+    size_t chunk_shift;             // log2 degli elementi per blocco
+    size_t max_chunks;              // Blocchi allocabili al massimo
+    size_t max_elems;               // Capacità massima richiesta
+    size_t capacity;                // Elementi utilizzabili (<= max_elems, letto con acquire)
+} Slab;
+
+// ========== FUNZIONI DI GESTIONE ==========
+
+int slab_init(Slab *slab, size_t elem_size, size_t chunk_elems, size_t max_elems);
+void slab_destroy(Slab *slab);
+int slab_grow(Slab *slab, size_t *first_index, size_t *count);
+
+// ========== FUNZIONI DI ACCESSO ==========
+
+size_t slab_capacity(const Slab *slab);
+void* slab_at(const Slab *slab, size_t index);
+
+#endif
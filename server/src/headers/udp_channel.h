@@ -0,0 +1,62 @@
+#ifndef UDP_CHANNEL_H
+#define UDP_CHANNEL_H
+
+/*
+ * HEADER UDP_CHANNEL - CANALE UDP AFFIDABILE PER GLI EVENTI DI PARTITA
+ *
+ * Questo header definisce il canale UDP con cui mosse ed esiti di una
+ * partita (MOVE, GAME_OVER) raggiungono i giocatori senza attendere dietro
+ * al traffico della lobby accodato sulla connessione TCP.
+ *
+ * Sessione: alla prima registrazione il server invia "UDP_SESSION:<token>"
+ * sulla connessione TCP e il client apre ogni datagramma con "<token>:".
+ * Il token identifica il client tramite client_index_acquire_by_token();
+ * "<token>:UDP_REGISTER" apre il canale verso l'indirizzo del mittente e
+ * ogni datagramma successivo da un indirizzo diverso lo sposta
+ * (udp_channel_rebind()), senza perdere sequenze ed eventi in attesa.
+ *
+ * La risposta UDP_REGISTERED:<base> indica da dove proseguono le sequenze,
+ * che restano crescenti anche quando il client ripete UDP_REGISTER.
+ *
+ * Ogni evento viaggia come "SEQ:<n>:<messaggio>" con n crescente e resta
+ * in attesa finché il client non risponde "ACK:<n>" (conferma cumulativa).
+ * Gli eventi non confermati entro UDP_CHANNEL_RTO_MS vengono ritrasmessi
+ * da un thread dedicato, raddoppiando l'attesa a ogni tentativo; dopo
+ * UDP_CHANNEL_MAX_RETRIES ritrasmissioni (circa 12 secondi), o con la
+ * finestra di UDP_CHANNEL_WINDOW eventi piena, il canale degrada a TCP:
+ * gli eventi in attesa partono in ordine sulla connessione TCP e così i
+ * successivi, finché il client non ripete UDP_REGISTER.
+ *
+ * Nella direzione opposta il client invia "SEQ:<n>:MOVE:<riga>,<colonna>",
+ * un comando alla volta; il server esegue solo sequenze più recenti
+ * dell'ultima eseguita (duplicati e ritardatari vengono scartati) e
+ * conferma sempre con "ACK:<ultima eseguita>".
+ */
+
+#include "network.h"
+
+// ========== CONFIGURAZIONI ==========
+
+#define UDP_CHANNEL_RTO_MS 200          // Attesa della conferma prima della prima ritrasmissione
+#define UDP_CHANNEL_MAX_RETRIES 5       // Ritrasmissioni prima di passare a TCP
+#define UDP_CHANNEL_TICK_MS 50          // Periodo del thread di ritrasmissione
+
+// ========== FUNZIONI DI GESTIONE ==========
+
+int udp_channel_init(void);
+void udp_channel_shutdown(void);
+unsigned long long udp_channel_new_token(void);
+long long udp_channel_now_ms(void);
+
+// ========== FUNZIONI DEL CANALE ==========
+
+void udp_channel_reset(Client *client);
+void udp_channel_destroy(Client *client);
+unsigned long udp_channel_open(Client *client, socket_t sock, const struct sockaddr_in *addr);
+int udp_channel_rebind(Client *client, socket_t sock, const struct sockaddr_in *addr);
+void udp_channel_close(Client *client);
+int udp_channel_send(Client *client, const char *message);
+void udp_channel_ack(Client *client, unsigned long seq);
+int udp_channel_accept(Client *client, unsigned long seq, unsigned long *ack);
+
+#endif
@@ -1,69 +1,230 @@
+#define _GNU_SOURCE
 #include "headers/lobby.h"
 #include "headers/network.h"
 #include "headers/game_manager.h"
+#include "headers/client_index.h"
+#include "headers/config.h"
+#include "headers/slab.h"
+#include "headers/pool.h"
+#include "headers/protocol.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
-static Client *clients[MAX_CLIENTS];
+static Slab lobby_slots;         // LobbySlot, crescono a blocchi fino a max_clients
+static int free_slot_head = -1;  // Pila degli slot liberi
+static int lobby_count = 0;      // Client presenti nella lobby
 static mutex_t lobby_mutex;
+static unsigned long broadcast_list_version;    // Sequenza dell'ultimo aggiornamento lista inviato
+static mutex_t list_broadcast_mutex;            // Mantiene l'ordine di sequenza degli aggiornamenti inviati
+
+// Aggregazione degli invii della lista: le richieste arrivate in una finestra
+// di server_config.lobby_tick_ms producono un solo invio dal thread del tick
+static thread_t list_tick_thread;
+static int list_tick_running;                   // 1 mentre il thread del tick è attivo (atomico)
+static int list_broadcast_pending;              // 1 se c'è un invio in attesa del prossimo tick (atomico)
+static unsigned long list_broadcast_requests;   // Richieste di invio con aggiornamenti nuovi (atomico)
+static unsigned long list_broadcast_passes;     // Invii effettivi ai client (atomico)
+
+static void lobby_flush_game_list(void);
+
+/**
+ * Restituisce lo slot della lobby di indice dato.
+ * 
+ * @param index Indice dello slot
+ * @return Puntatore allo slot, NULL se non ancora allocato
+ */
+static LobbySlot* lobby_slot_at(int index) {
+    return (LobbySlot*)slab_at(&lobby_slots, (size_t)index);
+}
+
+/**
+ * Restituisce il numero di slot attualmente allocati.
+ */
+static int lobby_capacity() {
+    return (int)slab_capacity(&lobby_slots);
+}
+
+/**
+ * Alloca un nuovo blocco di slot e lo aggiunge alla pila dei liberi.
+ * NOTA: Questa funzione non è thread-safe, deve essere chiamata con il mutex acquisito.
+ * 
+ * @return 1 in caso di successo, 0 se si è raggiunto max_clients o manca memoria
+ */
+static int lobby_grow_slots() {
+    size_t first, count;
+    if (!slab_grow(&lobby_slots, &first, &count)) return 0;
+    
+    // Impila al contrario: gli slot di indice più basso vengono usati per primi
+    for (size_t i = first + count; i > first; i--) {
+        LobbySlot *slot = lobby_slot_at((int)(i - 1));
+        slot->client = NULL;
+        slot->next_free = free_slot_head;
+        free_slot_head = (int)(i - 1);
+    }
+    return 1;
+}
+
+/**
+ * Attende un tick della lista partite (server_config.lobby_tick_ms).
+ */
+static void lobby_list_tick_sleep(void) {
+#ifdef _WIN32
+    Sleep((DWORD)server_config.lobby_tick_ms);
+#else
+    struct timespec ts;
+    ts.tv_sec = server_config.lobby_tick_ms / 1000;
+    ts.tv_nsec = (long)(server_config.lobby_tick_ms % 1000) * 1000000L;
+    while (nanosleep(&ts, &ts) == -1 && errno == EINTR) {}
+#endif
+}
+
+/**
+ * Thread del tick della lista partite: a ogni tick gestisce le partite in
+ * attesa da troppo tempo (game_check_timeouts()) e, se qualcuno ha chiesto
+ * un invio, manda ai client tutti gli aggiornamenti accumulati nella finestra.
+ * 
+ * @param arg Non usato
+ * @return 0 alla terminazione
+ */
+static thread_return_t THREAD_CALL lobby_list_tick_thread(thread_param_t arg) {
+    (void)arg;
+    while (__atomic_load_n(&list_tick_running, __ATOMIC_ACQUIRE)) {
+        lobby_list_tick_sleep();
+        game_check_timeouts();
+        if (__atomic_exchange_n(&list_broadcast_pending, 0, __ATOMIC_ACQ_REL)) {
+            lobby_flush_game_list();
+        }
+    }
+    pool_thread_flush();
+    return 0;
+}
+
+/**
+ * Ferma il thread del tick e invia gli aggiornamenti ancora in attesa.
+ * Le richieste successive vengono servite subito dal thread chiamante.
+ */
+static void lobby_stop_list_tick(void) {
+    if (!__atomic_exchange_n(&list_tick_running, 0, __ATOMIC_ACQ_REL)) return;
+#ifdef _WIN32
+    WaitForSingleObject(list_tick_thread, INFINITE);
+    CloseHandle(list_tick_thread);
+#else
+    pthread_join(list_tick_thread, NULL);
+#endif
+    if (__atomic_exchange_n(&list_broadcast_pending, 0, __ATOMIC_ACQ_REL)) {
+        lobby_flush_game_list();
+    }
+}
 
 /**
  * Inizializza la lobby del server e le strutture dati necessarie.
- * Prepara l'array dei client e inizializza il mutex per la sincronizzazione thread-safe.
+ * Prepara il primo blocco di slot dei client, gli indici hash (nome, indirizzo UDP)
+ * e il mutex per la sincronizzazione thread-safe. Gli slot crescono a blocchi
+ * di LOBBY_CHUNK_SLOTS fino a server_config.max_clients.
  * 
  * @return 1 in caso di successo, 0 in caso di errore
  */
 int lobby_init() {
-    if (mutex_init(&lobby_mutex) != 0) return 0;
+    if (!slab_init(&lobby_slots, sizeof(LobbySlot), LOBBY_CHUNK_SLOTS, (size_t)server_config.max_clients)) return 0;
+    if (mutex_init(&lobby_mutex) != 0) {
+        slab_destroy(&lobby_slots);
+        return 0;
+    }
+    if (!client_index_init((size_t)server_config.max_clients)) {
+        mutex_destroy(&lobby_mutex);
+        slab_destroy(&lobby_slots);
+        return 0;
+    }
+    if (mutex_init(&list_broadcast_mutex) != 0) {
+        client_index_cleanup();
+        mutex_destroy(&lobby_mutex);
+        slab_destroy(&lobby_slots);
+        return 0;
+    }
+    broadcast_list_version = 0;
+    list_broadcast_pending = 0;
+    list_broadcast_requests = 0;
+    list_broadcast_passes = 0;
     
     if (mutex_lock(&lobby_mutex) != 0) return 0;
-    for (int i = 0; i < MAX_CLIENTS; i++) {
-        clients[i] = NULL;
-    }
+    free_slot_head = -1;
+    lobby_count = 0;
+    lobby_grow_slots();
     mutex_unlock(&lobby_mutex);
     
-    printf("Lobby inizializzata\n");
+    // Senza thread del tick gli aggiornamenti vengono inviati subito
+    __atomic_store_n(&list_tick_running, 1, __ATOMIC_RELEASE);
+    if (create_thread(&list_tick_thread, lobby_list_tick_thread, NULL, "tick lista partite") != 0) {
+        __atomic_store_n(&list_tick_running, 0, __ATOMIC_RELEASE);
+    }
+    
+    printf("Lobby inizializzata (max %d client)\n", server_config.max_clients);
     return 1;
 }
 
 /**
  * Pulisce e chiude tutte le risorse della lobby prima dello shutdown del server.
  * Disconnette tutti i client attivi, invia notifiche di spegnimento e libera le risorse.
- * Include una pausa per permettere ai thread di terminare correttamente.
+ * 
+ * @note Su Linux va chiamata dopo reactor_shutdown(): la memoria dei client
+ *       viene liberata da reactor_cleanup()
+ * @note game_leave() viene chiamata fuori dal lock perché aggiorna la lobby
+ * @note Il thread del tick viene fermato per primo, inviando gli aggiornamenti in attesa
  */
 void lobby_cleanup() {
+    int leaving_count = 0;
+    
+    // Da qui in poi gli aggiornamenti della lista partono subito
+    lobby_stop_list_tick();
+    
     mutex_lock(&lobby_mutex);
     printf("Disconnettendo tutti i client prima dello shutdown...\n");
     
-    for (int i = 0; i < MAX_CLIENTS; i++) {
-        if (clients[i] && clients[i]->is_active) {
+    Client **leaving = (Client**)malloc((size_t)(lobby_count > 0 ? lobby_count : 1) * sizeof(Client*));
+    int capacity = lobby_capacity();
+    for (int i = 0; i < capacity; i++) {
+        Client *client = lobby_slot_at(i)->client;
+        if (client && client->is_active) {
             // Invia un messaggio di disconnessione al client
-            network_send_to_client(clients[i], "SERVER_SHUTDOWN:Server in spegnimento");
+            network_send_message(client, SMSG_SERVER_SHUTDOWN, "Server in spegnimento");
             
             // Chiudi la connessione
-            clients[i]->is_active = 0;
-            closesocket(clients[i]->client_fd);
+            client->is_active = 0;
+            closesocket(client->client_fd);
+            client->client_fd = INVALID_SOCKET_VALUE;
             
-            printf("Client %s disconnesso per shutdown\n", clients[i]->name);
+            printf("Client %s disconnesso per shutdown\n", client->name);
         }
         
-        if (clients[i]) {
-            game_leave(clients[i]);
-            // Non fare free qui - verrà fatto dal thread del client
-            clients[i] = NULL;
+        if (client) {
+            // Il riferimento dello slot passa a leaving; la connessione resta
+            // al reactor (o al thread del client) che la libererà
+            client_index_remove(client);
+            client->lobby_slot = -1;
+            lobby_slot_at(i)->client = NULL;
+            if (leaving) leaving[leaving_count++] = client;
+            else network_release_client(client);
         }
     }
+    lobby_count = 0;
     mutex_unlock(&lobby_mutex);
     
-    // Aspetta un po' per permettere ai thread di terminare
+    for (int i = 0; i < leaving_count; i++) {
+        game_leave(leaving[i]);
+        network_release_client(leaving[i]);
+    }
+    free(leaving);
+    
 #ifdef _WIN32
+    // Aspetta un po' per permettere ai thread dei client di terminare
     Sleep(1000);
-#else
-    sleep(1);
 #endif
     
+    mutex_destroy(&list_broadcast_mutex);
     mutex_destroy(&lobby_mutex);
+    client_index_cleanup();
+    slab_destroy(&lobby_slots);
     
     printf("Lobby pulita\n");
 }
@@ -76,62 +237,75 @@ void lobby_cleanup() {
  */
 int lobby_is_full() {
     mutex_lock(&lobby_mutex);
-    int count = 0;
-    for (int i = 0; i < MAX_CLIENTS; i++) {
-        if (clients[i] != NULL) {
-            count++;
-        }
-    }
+    int count = lobby_count;
     mutex_unlock(&lobby_mutex);
-    return count >= MAX_CLIENTS;
+    return count >= server_config.max_clients;
 }
 
 /**
- * Trova il primo slot libero nell'array dei client.
+ * Occupa uno slot libero per il client, allocando un nuovo blocco se necessario.
+ * Lo slot tiene un riferimento al client finché non viene liberato.
  * NOTA: Questa funzione non è thread-safe, deve essere chiamata con il mutex acquisito.
  * 
- * @return Indice del primo slot libero, -1 se non ci sono slot disponibili
+ * @param client Client da inserire nello slot
+ * @return Indice dello slot occupato, -1 se non ci sono slot disponibili
  */
-static int lobby_find_free_slot() {
-    for (int i = 0; i < MAX_CLIENTS; i++) {
-        if (clients[i] == NULL) {
-            return i;
-        }
-    }
-    return -1;
+static int lobby_take_slot(Client *client) {
+    if (free_slot_head < 0 && !lobby_grow_slots()) return -1;
+    
+    int index = free_slot_head;
+    LobbySlot *slot = lobby_slot_at(index);
+    free_slot_head = slot->next_free;
+    slot->client = client;
+    slot->next_free = -1;
+    client->lobby_slot = index;
+    lobby_count++;
+    network_retain_client(client);
+    return index;
+}
+
+/**
+ * Libera lo slot occupato dal client, se il client è nella lobby, e ne
+ * lascia il riferimento.
+ * NOTA: Questa funzione non è thread-safe, deve essere chiamata con il mutex acquisito.
+ * 
+ * @param client Client da rimuovere (il chiamante deve tenerne un altro riferimento)
+ * @return Indice dello slot liberato, -1 se il client non era nella lobby
+ */
+static int lobby_release_slot(Client *client) {
+    int index = client->lobby_slot;
+    LobbySlot *slot = lobby_slot_at(index);
+    if (index < 0 || !slot || slot->client != client) return -1;
+    
+    slot->client = NULL;
+    slot->next_free = free_slot_head;
+    free_slot_head = index;
+    client->lobby_slot = -1;
+    lobby_count--;
+    network_release_client(client);
+    return index;
 }
 
 /**
  * Aggiunge un nuovo client alla lobby con le informazioni fornite.
- * Alloca memoria per il client, inizializza i suoi dati e lo inserisce nel primo slot libero.
+ * Alloca il client dalla tabella dei client, inizializza i suoi dati e lo inserisce in uno slot libero.
  * 
  * @param client_fd Socket file descriptor del client
  * @param name Nome del giocatore (massimo MAX_NAME_LEN-1 caratteri)
  * @return Puntatore al client creato in caso di successo, NULL in caso di errore
+ *         (lobby piena o nome già in uso)
  */
 Client* lobby_add_client(socket_t client_fd, const char *name) {
-    mutex_lock(&lobby_mutex);
-    int slot = lobby_find_free_slot();
-    if (slot == -1) {
-        mutex_unlock(&lobby_mutex);
-        return NULL;
-    }
-    
-    Client *client = (Client*)malloc(sizeof(Client));
-    if (!client) {
-        mutex_unlock(&lobby_mutex);
-        return NULL;
-    }
+    Client *client = network_alloc_client(client_fd);
+    if (!client) return NULL;
     
-    memset(client, 0, sizeof(Client));
-    client->client_fd = client_fd;
     strncpy(client->name, name, MAX_NAME_LEN - 1);
     client->name[MAX_NAME_LEN - 1] = '\0';
-    client->is_active = 1;
-    client->game_id = -1;
     
-    clients[slot] = client;
-    mutex_unlock(&lobby_mutex);
+    if (!lobby_add_client_reference(client)) {
+        network_release_client(client);
+        return NULL;
+    }
     
     printf("Client %s aggiunto alla lobby\n", name);
     return client;
@@ -148,12 +322,10 @@ void lobby_remove_client_reference(Client *client) {
     
     mutex_lock(&lobby_mutex);
     
-    for (int i = 0; i < MAX_CLIENTS; i++) {
-        if (clients[i] == client) {
-            clients[i] = NULL;
-            printf("Client %s rimosso dalla lobby slot %d\n", client->name, i);
-            break;
-        }
+    int slot = lobby_release_slot(client);
+    if (slot >= 0) {
+        client_index_remove(client);
+        printf("Client %s rimosso dalla lobby slot %d\n", client->name, slot);
     }
     
     mutex_unlock(&lobby_mutex);
@@ -171,14 +343,12 @@ void lobby_remove_client_reference(Client *client) {
 void lobby_remove_client(Client *client) {
     if (!client) return;
     
-    mutex_lock(&lobby_mutex);
+    // game_leave() prende game->mutex: va chiamata fuori da lobby_mutex
     game_leave(client);
     
-    for (int i = 0; i < MAX_CLIENTS; i++) {
-        if (clients[i] == client) {
-            clients[i] = NULL;
-            break;
-        }
+    mutex_lock(&lobby_mutex);
+    if (lobby_release_slot(client) >= 0) {
+        client_index_remove(client);
     }
     mutex_unlock(&lobby_mutex);
     
@@ -194,11 +364,12 @@ void lobby_remove_client(Client *client) {
  */
 Client* lobby_find_client_by_fd(socket_t fd) {
     mutex_lock(&lobby_mutex);
-    for (int i = 0; i < MAX_CLIENTS; i++) {
-        if (clients[i] && clients[i]->client_fd == fd) {
-            Client *found = clients[i];
+    int capacity = lobby_capacity();
+    for (int i = 0; i < capacity; i++) {
+        Client *client = lobby_slot_at(i)->client;
+        if (client && client->client_fd == fd) {
             mutex_unlock(&lobby_mutex);
-            return found;
+            return client;
         }
     }
     mutex_unlock(&lobby_mutex);
@@ -207,175 +378,405 @@ Client* lobby_find_client_by_fd(socket_t fd) {
 
 /**
  * Cerca un client nella lobby utilizzando il nome del giocatore.
- * Operazione thread-safe per trovare un client tramite il suo nome utente.
+ * Ricerca in O(1) sull'indice per nome, senza acquisire lobby_mutex.
  * 
  * @param name Nome del giocatore da cercare
  * @return Puntatore al client se trovato, NULL altrimenti o se name è NULL
  */
 Client* lobby_find_client_by_name(const char *name) {
-    if (!name) return NULL;
+    return client_index_find_by_name(name);
+}
+
+/**
+ * Copia i client attivi della lobby prendendo un riferimento per ciascuno.
+ * lobby_mutex è tenuto solo per la copia: gli invii avvengono fuori dal lock,
+ * senza bloccare registrazioni e uscite durante i broadcast.
+ * 
+ * @param exclude Client da non copiare, NULL per copiarli tutti
+ * @param count Numero di client copiati
+ * @return Array da restituire con lobby_release_snapshot(), NULL se vuoto o manca memoria
+ */
+static Client** lobby_snapshot(Client *exclude, int *count) {
+    Client **clients = NULL;
+    *count = 0;
     
     mutex_lock(&lobby_mutex);
-    for (int i = 0; i < MAX_CLIENTS; i++) {
-        if (clients[i] && strcmp(clients[i]->name, name) == 0) {
-            Client *found = clients[i];
-            mutex_unlock(&lobby_mutex);
-            return found;
+    if (lobby_count > 0) {
+        clients = (Client**)malloc((size_t)lobby_count * sizeof(Client*));
+    }
+    if (clients) {
+        int capacity = lobby_capacity();
+        for (int i = 0; i < capacity && *count < lobby_count; i++) {
+            Client *client = lobby_slot_at(i)->client;
+            if (client && client != exclude && client->is_active) {
+                network_retain_client(client);
+                clients[(*count)++] = client;
+            }
         }
     }
     mutex_unlock(&lobby_mutex);
-    return NULL;
+    return clients;
+}
+
+/**
+ * Lascia i riferimenti presi da lobby_snapshot() e libera l'array.
+ * 
+ * @param clients Array restituito da lobby_snapshot()
+ * @param count Numero di client nell'array
+ */
+static void lobby_release_snapshot(Client **clients, int count) {
+    for (int i = 0; i < count; i++) {
+        network_release_client(clients[i]);
+    }
+    free(clients);
 }
 
 /**
  * Invia un messaggio broadcast a tutti i client connessi alla lobby.
  * Permette di escludere un client specifico dall'invio (utile per non inviare messaggi al mittente).
+ * Il messaggio è copiato una sola volta: le code di tutti i destinatari
+ * condividono lo stesso buffer.
  * 
  * @param message Messaggio da inviare a tutti i client
  * @param exclude Client da escludere dall'invio, NULL per inviare a tutti
  */
 void lobby_broadcast_message(const char *message, Client *exclude) {
-    if (!message) return;
+    SharedMsg *msg = network_msg_create(message);
+    if (!msg) return;
     
-    mutex_lock(&lobby_mutex);
-    for (int i = 0; i < MAX_CLIENTS; i++) {
-        if (clients[i] && clients[i] != exclude && clients[i]->is_active) {
-            network_send_to_client(clients[i], message);
-        }
+    int count;
+    Client **clients = lobby_snapshot(exclude, &count);
+    for (int i = 0; i < count; i++) {
+        network_send_msg(clients[i], msg);
     }
-    mutex_unlock(&lobby_mutex);
+    lobby_release_snapshot(clients, count);
+    network_msg_release(msg);
 }
 
 /**
- * Invia la lista aggiornata delle partite disponibili a tutti i client liberi.
- * Viene inviata solo ai client che non sono attualmente impegnati in una partita.
- * Operazione ottimizzata per evitare spam ai giocatori in partita.
+ * Invia ai client liberi gli aggiornamenti della lista partite (LIST_UPDATE:)
+ * pubblicati dopo l'ultimo invio, in ordine di sequenza.
+ * Viene inviata solo ai client che non sono attualmente impegnati in una partita:
+ * chi rientra nella lobby vedrà un salto di sequenza e richiederà la lista completa.
+ * Gli aggiornamenti sono scartabili per i client in ritardo sulla coda di invio,
+ * che si risincronizzano allo stesso modo.
+ * 
+ * Il costo per client è proporzionale alle partite modificate, non al numero
+ * di partite; senza nuovi aggiornamenti (es. uscita di un client che non era
+ * in partita) non viene inviato nulla.
+ * 
+ * @note Chiamata dal thread del tick (o direttamente da lobby_broadcast_game_list()
+ *       se il tick non è attivo); non va chiamata con il mutex di una partita acquisito
  */
-void lobby_broadcast_game_list() {
-    char game_list[MAX_MSG_SIZE];
-    game_list_available(game_list, sizeof(game_list));
+static void lobby_flush_game_list(void) {
+    unsigned long latest = game_list_version();
+    if (latest <= __atomic_load_n(&broadcast_list_version, __ATOMIC_RELAXED)) return;
     
-    // Broadcast solo ai client che non sono in partita
-    mutex_lock(&lobby_mutex);
-    for (int i = 0; i < MAX_CLIENTS; i++) {
-        if (clients[i] && clients[i]->is_active && clients[i]->game_id <= 0) {
-            network_send_to_client(clients[i], game_list);
-        }
+    // Un solo thread alla volta invia: ogni client riceve le sequenze in ordine
+    mutex_lock(&list_broadcast_mutex);
+    latest = game_list_version();
+    unsigned long seq = broadcast_list_version + 1;
+    if (latest >= LIST_DELTA_LOG && seq <= latest - LIST_DELTA_LOG) {
+        seq = latest - LIST_DELTA_LOG + 1;  // I più vecchi non sono più nel registro
     }
-    mutex_unlock(&lobby_mutex);
     
-    printf("Lista giochi aggiornata e inviata a tutti i client liberi\n");
+    if (seq <= latest) {
+        int count;
+        __atomic_add_fetch(&list_broadcast_passes, 1, __ATOMIC_RELAXED);
+        Client **clients = lobby_snapshot(NULL, &count);
+        for (; seq <= latest; seq++) {
+            // Lo stesso buffer del registro finisce nelle code di tutti i client
+            SharedMsg *delta = game_list_delta(seq);
+            if (!delta) continue;
+            
+            for (int i = 0; i < count; i++) {
+                if (clients[i]->game_id <= 0) {
+                    network_send_lobby_update_msg(clients[i], delta);
+                }
+            }
+            network_msg_release(delta);
+        }
+        lobby_release_snapshot(clients, count);
+        __atomic_store_n(&broadcast_list_version, latest, __ATOMIC_RELAXED);
+    }
+    mutex_unlock(&list_broadcast_mutex);
 }
 
-// Sostituisci la funzione lobby_handle_client_message in lobby.c
-
-// Fix per lobby_handle_client_message - Sostituire completamente
-
 /**
- * Gestisce ed elabora tutti i messaggi ricevuti dai client.
- * Router centrale per tutti i comandi del protocollo di comunicazione client-server.
- * Analizza il messaggio e chiama la funzione appropriata per gestire ogni comando.
+ * Richiede l'invio ai client liberi degli aggiornamenti della lista partite.
+ * Le richieste vengono aggregate: il thread del tick invia una sola volta,
+ * entro server_config.lobby_tick_ms, tutti gli aggiornamenti pubblicati nel
+ * frattempo (vedi lobby_flush_game_list()). Se il thread del tick non è
+ * attivo (avvio fallito o spegnimento in corso) l'invio è immediato.
  * 
- * @param client Client che ha inviato il messaggio
- * @param message Contenuto del messaggio ricevuto
+ * @note Non va chiamata con il mutex di una partita acquisito
+ */
+void lobby_broadcast_game_list() {
+    if (game_list_version() <= __atomic_load_n(&broadcast_list_version, __ATOMIC_RELAXED)) return;
+    __atomic_add_fetch(&list_broadcast_requests, 1, __ATOMIC_RELAXED);
+    
+    if (__atomic_load_n(&list_tick_running, __ATOMIC_ACQUIRE)) {
+        __atomic_store_n(&list_broadcast_pending, 1, __ATOMIC_RELEASE);
+        return;
+    }
+    lobby_flush_game_list();
+}
+
+/**
+ * Restituisce i contatori dell'aggregazione degli invii della lista partite.
  * 
- * @note Supporta i comandi: CREATE_GAME, LIST_GAMES, JOIN, MOVE, LEAVE, REMATCH, APPROVE, CANCEL, PING
- * @note Include logging dettagliato per debugging e tracciamento delle operazioni
+ * @param requests Richieste di invio con aggiornamenti nuovi
+ * @param coalesced Richieste assorbite da un invio già previsto (richieste - invii)
  */
-void lobby_handle_client_message(Client *client, const char *message) {
-    if (!client || !message) return;
+void lobby_get_broadcast_stats(unsigned long *requests, unsigned long *coalesced) {
+    unsigned long passes = __atomic_load_n(&list_broadcast_passes, __ATOMIC_RELAXED);
+    *requests = __atomic_load_n(&list_broadcast_requests, __ATOMIC_RELAXED);
+    *coalesced = *requests > passes ? *requests - passes : 0;
+}
+
+/**
+ * CREATE_GAME[:<righe>,<colonne>,<k>]: crea una nuova partita con il client
+ * come creatore. Senza argomenti la partita è un Tris classico (3,3,3).
+ */
+static void lobby_cmd_create_game(void *ctx, const Command *cmd) {
+    Client *client = (Client*)ctx;
+    int variant[3] = { BOARD_SIDE, BOARD_SIDE, BOARD_SIDE };
     
-    printf("Elaborando messaggio: %s da %s\n", message, client->name);
+    if ((cmd->value_count > 0 || *cmd->args) &&
+        (!protocol_int_args(cmd, ',', variant, 3) || !board_variant_valid(variant[0], variant[1], variant[2]))) {
+        network_send_message(client, SMSG_ERROR, "Variante non valida");
+        return;
+    }
     
-    if (strncmp(message, "CREATE_GAME", 11) == 0) {
-        // Controlla se già in partita ATTIVA prima di creare
-        if (client->game_id > 0) {
-            Game *current_game = game_find_by_id(client->game_id);
-            if (current_game && current_game->state != GAME_STATE_OVER) {
-                network_send_to_client(client, "ERROR:Sei già in una partita");
-                return;
-            }
-            // Se la partita è terminata, resetta il game_id del client
-            if (current_game && current_game->state == GAME_STATE_OVER) {
-                client->game_id = -1;
-            }
+    // Controlla se già in partita ATTIVA prima di creare
+    if (client->game_id > 0) {
+        Game *current_game = game_find_by_id(client->game_id);
+        if (current_game && current_game->state != GAME_STATE_OVER) {
+            network_send_message(client, SMSG_ERROR, "Sei già in una partita");
+            return;
         }
-        
-        int game_id = game_create_new(client);
-        if (game_id > 0) {
-            char response[64];
-            sprintf(response, "GAME_CREATED:%d", game_id);
+        // Se la partita è terminata, resetta il game_id del client
+        if (current_game && current_game->state == GAME_STATE_OVER) {
+            client->game_id = -1;
+        }
+    }
+    
+    int game_id = game_create_new(client, variant[0], variant[1], variant[2]);
+    if (game_id > 0) {
+        char response[64];
+        if (message_encode_game_created(response, sizeof(response), game_id)) {
             network_send_to_client(client, response);
-            network_send_to_client(client, "WAITING_OPPONENT");
-            printf("Client %s ha creato partita %d\n", client->name, game_id);
-            
-            // Broadcast della nuova partita disponibile
-            lobby_broadcast_game_list();
-        } else {
-            network_send_to_client(client, "ERROR:Impossibile creare partita");
         }
-    } 
-    else if (strncmp(message, "LIST_GAMES", 10) == 0) {
-        char response[MAX_MSG_SIZE];
-        game_list_available(response, sizeof(response));
-        network_send_to_client(client, response);
-    } 
-    else if (strncmp(message, "JOIN:", 5) == 0) {
-        int game_id = atoi(message + 5);
-        printf("Client %s tenta di unirsi alla partita %d\n", client->name, game_id);
+        network_send_message(client, SMSG_WAITING_OPPONENT, NULL);
+        printf("Client %s ha creato partita %d\n", client->name, game_id);
         
-        // FIX: La logica è già gestita in game_join
-        if (!game_join(client, game_id)) {
-            // game_join già invia il messaggio di errore appropriato
-            printf("Join fallito per %s -> partita %d\n", client->name, game_id);
+        // Broadcast della nuova partita disponibile
+        lobby_broadcast_game_list();
+    } else {
+        network_send_message(client, SMSG_ERROR, "Impossibile creare partita");
+    }
+}
+
+/**
+ * LIST_GAMES[:<filtro>[:<offset>[:<limite>]]]: invia una pagina della lista partite.
+ */
+static void lobby_cmd_list_games(void *ctx, const Command *cmd) {
+    Client *client = (Client*)ctx;
+    const char *cursor = cmd->args;
+    const char *field;
+    char filter_name[16] = "ALL";
+    int offset = 0;
+    int limit = LIST_PAGE_DEFAULT;
+    int valid = 1;
+    ListFilter filter = LIST_FILTER_ALL;
+    
+    if (cmd->value_count == 3) {
+        // Frame binario: filtro, offset e limite già decodificati
+        filter = (ListFilter)cmd->values[0];
+        offset = cmd->values[1];
+        limit = cmd->values[2];
+    } else {
+        size_t len = protocol_next_field(&cursor, ':', &field);
+        if (len >= sizeof(filter_name)) {
+            valid = 0;
+        } else if (len > 0) {
+            memcpy(filter_name, field, len);
+            filter_name[len] = '\0';
         }
-    } 
-    else if (strncmp(message, "MOVE:", 5) == 0) {
-        int row, col;
-        if (sscanf(message + 5, "%d,%d", &row, &col) == 2) {
-            if (!game_make_move(client->game_id, client, row, col)) {
-                network_send_to_client(client, "ERROR:Mossa non valida");
-            }
-        } else {
-            network_send_to_client(client, "ERROR:Formato mossa non valido");
+        if (valid && *cursor) valid = protocol_next_int(&cursor, ':', &offset);
+        if (valid && *cursor) valid = protocol_next_int(&cursor, ':', &limit);
+        valid = valid && !*cursor && game_list_parse_filter(filter_name, &filter);
+    }
+    
+    if (!valid || offset < 0 || limit <= 0) {
+        network_send_message(client, SMSG_ERROR, "Richiesta lista partite non valida");
+    } else {
+        char response[MAX_MSG_SIZE];
+        game_list_page(filter, offset, limit, response, sizeof(response));
+        network_send_to_client(client, response);
+    }
+}
+
+/**
+ * JOIN:<id>: chiede di unirsi a una partita.
+ */
+static void lobby_cmd_join(void *ctx, const Command *cmd) {
+    Client *client = (Client*)ctx;
+    int game_id;
+    
+    // Un ID non valido diventa 0: game_join() risponde con l'errore appropriato
+    if (!protocol_int_args(cmd, ',', &game_id, 1)) game_id = 0;
+    printf("Client %s tenta di unirsi alla partita %d\n", client->name, game_id);
+    
+    if (!game_join(client, game_id)) {
+        // game_join già invia il messaggio di errore appropriato
+        printf("Join fallito per %s -> partita %d\n", client->name, game_id);
+    }
+}
+
+/**
+ * MOVE:<riga>,<colonna>: esegue una mossa nella partita del client.
+ */
+static void lobby_cmd_move(void *ctx, const Command *cmd) {
+    Client *client = (Client*)ctx;
+    int cell[2];
+    
+    if (protocol_int_args(cmd, ',', cell, 2)) {
+        if (!game_make_move(client->game_id, client, cell[0], cell[1])) {
+            network_send_message(client, SMSG_ERROR, "Mossa non valida");
         }
-    } 
-    else if (strncmp(message, "LEAVE", 5) == 0) {
+    } else {
+        network_send_message(client, SMSG_ERROR, "Formato mossa non valido");
+    }
+}
+
+/**
+ * LEAVE: abbandona la partita corrente.
+ */
+static void lobby_cmd_leave(void *ctx, const Command *cmd) {
+    Client *client = (Client*)ctx;
+    (void)cmd;
+    game_leave(client);
+    network_send_message(client, SMSG_LEFT_GAME, NULL);
+}
+
+/**
+ * REMATCH: richiede la rivincita.
+ */
+static void lobby_cmd_rematch(void *ctx, const Command *cmd) {
+    Client *client = (Client*)ctx;
+    (void)cmd;
+    if (!game_request_rematch(client)) {
+        // game_request_rematch già invia il messaggio di errore appropriato
+        printf("Rematch fallito per %s\n", client->name);
+    }
+}
+
+/**
+ * REMATCH_DECLINE: rifiuta la rivincita.
+ */
+static void lobby_cmd_rematch_decline(void *ctx, const Command *cmd) {
+    Client *client = (Client*)ctx;
+    (void)cmd;
+    if (!game_decline_rematch(client)) {
+        printf("Nessun rematch per %s\n", client->name);
+    }
+}
+
+/**
+ * APPROVE:<1|0>: approva o rifiuta la richiesta di join in attesa.
+ */
+static void lobby_cmd_approve(void *ctx, const Command *cmd) {
+    int approve;
+    
+    // Un valore non numerico vale come rifiuto
+    if (!protocol_int_args(cmd, ',', &approve, 1)) approve = 0;
+    lobby_handle_approve_join((Client*)ctx, approve);
+}
+
+/**
+ * CANCEL: annulla la partita creata (o abbandona quella corrente).
+ */
+static void lobby_cmd_cancel(void *ctx, const Command *cmd) {
+    Client *client = (Client*)ctx;
+    (void)cmd;
+    if (client->game_id > 0) {
         game_leave(client);
-        network_send_to_client(client, "LEFT_GAME");
-    } 
-    else if (strncmp(message, "REMATCH_DECLINE", 15) == 0) {
-        if (!game_decline_rematch(client)) {
-            printf("Nessun rematch per %s\n", client->name);
-        }
+        network_send_message(client, SMSG_GAME_CANCELED, NULL);
+    } else {
+        network_send_message(client, SMSG_ERROR, "Non sei in una partita");
     }
-    else if (strncmp(message, "REMATCH", 7) == 0) {
-        if (!game_request_rematch(client)) {
-            // game_request_rematch già invia il messaggio di errore appropriato
-            printf("Rematch fallito per %s\n", client->name);
-        }
+}
+
+/**
+ * PLAY_BOT[:livello]: il bot del server diventa l'avversario della partita
+ * creata, al livello scelto (nome, o un byte BotLevel nel frame binario) o
+ * a quello della configurazione se manca.
+ */
+static void lobby_cmd_play_bot(void *ctx, const Command *cmd) {
+    Client *client = (Client*)ctx;
+    BotLevel level = (BotLevel)server_config.bot_level;
+    int valid = 1;
+    
+    if (cmd->value_count > 0) {
+        valid = cmd->values[0] >= 0 && cmd->values[0] < BOT_LEVEL_COUNT;
+        if (valid) level = (BotLevel)cmd->values[0];
+    } else if (*cmd->args) {
+        valid = bot_parse_level(cmd->args, &level);
     }
-    else if (strncmp(message, "APPROVE:", 8) == 0) {
-        int approve = atoi(message + 8); // 1 per approvare, 0 per rifiutare
-        if (!game_approve_join(client, approve)) {
-            printf("Approvazione fallita per %s\n", client->name);
-        }
-    } 
-    else if (strncmp(message, "CANCEL", 6) == 0) {
-        if (client->game_id > 0) {
-            game_leave(client);
-            network_send_to_client(client, "GAME_CANCELED");
-        } else {
-            network_send_to_client(client, "ERROR:Non sei in una partita");
-        }
-    } 
-    else if (strncmp(message, "PING", 4) == 0) {
-        // Handle PING with PONG response (usando strncmp per gestire eventuali caratteri extra)
-        network_send_to_client(client, "PONG");
+    if (!valid) {
+        network_send_message(client, SMSG_ERROR, "Livello del bot non valido (random, heuristic, perfect)");
+        return;
     }
-    else {
-        printf("Comando sconosciuto da %s: %s\n", client->name, message);
-        network_send_to_client(client, "ERROR:Comando sconosciuto");
+    
+    if (!game_add_bot(client, level)) {
+        // game_add_bot già invia il messaggio di errore appropriato
+        printf("Bot non aggiunto per %s\n", client->name);
+    }
+}
+
+/**
+ * PING: risponde PONG.
+ */
+static void lobby_cmd_ping(void *ctx, const Command *cmd) {
+    (void)cmd;
+    network_send_message((Client*)ctx, SMSG_PONG, NULL);
+}
+
+/**
+ * Gestori dei comandi della lobby (canale TCP, client registrati).
+ * REGISTER è gestito dal livello di rete prima di arrivare qui.
+ */
+static const CommandHandler lobby_commands[CMD_COUNT] = {
+    [CMD_PING] = lobby_cmd_ping,
+    [CMD_CREATE_GAME] = lobby_cmd_create_game,
+    [CMD_LIST_GAMES] = lobby_cmd_list_games,
+    [CMD_JOIN] = lobby_cmd_join,
+    [CMD_MOVE] = lobby_cmd_move,
+    [CMD_LEAVE] = lobby_cmd_leave,
+    [CMD_REMATCH] = lobby_cmd_rematch,
+    [CMD_REMATCH_DECLINE] = lobby_cmd_rematch_decline,
+    [CMD_APPROVE] = lobby_cmd_approve,
+    [CMD_CANCEL] = lobby_cmd_cancel,
+    [CMD_PLAY_BOT] = lobby_cmd_play_bot
+};
+
+/**
+ * Esegue un comando di un client registrato.
+ * Il comando, già analizzato da protocol_parse(), viene smistato con un
+ * accesso diretto alla tabella dei gestori (lobby_commands).
+ * 
+ * @param client Client che ha inviato il comando
+ * @param cmd Comando analizzato
+ * 
+ * @note Comandi sconosciuti o non ammessi sul canale TCP ricevono "ERROR:Comando sconosciuto"
+ */
+void lobby_handle_command(Client *client, const Command *cmd) {
+    if (!client || !cmd) return;
+    
+    if (!protocol_dispatch(lobby_commands, client, cmd)) {
+        printf("Comando sconosciuto da %s: %s\n", client->name, command_verb(cmd->id));
+        network_send_message(client, SMSG_ERROR, "Comando sconosciuto");
     }
 }
 
@@ -393,12 +794,12 @@ mutex_t* lobby_get_mutex() {
  * Accede a un client nell'array tramite indice.
  * Funzione di utilità per accesso diretto agli slot della lobby.
  * 
- * @param index Indice dello slot da verificare (0 a MAX_CLIENTS-1)
+ * @param index Indice dello slot da verificare (0 a max_clients-1)
  * @return Puntatore al client nello slot specificato, NULL se indice non valido o slot vuoto
  */
 Client* lobby_get_client_by_index(int index) {
-    if (index < 0 || index >= MAX_CLIENTS) return NULL;
-    return clients[index]; 
+    LobbySlot *slot = (index >= 0) ? lobby_slot_at(index) : NULL;
+    return slot ? slot->client : NULL;
 }
 
 /**
@@ -407,7 +808,9 @@ Client* lobby_get_client_by_index(int index) {
  * il riferimento alla lobby senza duplicare la creazione.
  * 
  * @param client Puntatore al client da aggiungere alla lobby
- * @return 1 in caso di successo, 0 se la lobby è piena o client è NULL
+ * @return 1 in caso di successo, 0 se la lobby è piena, il nome è già in uso
+ *         o client è NULL
+ * @note Il client viene anche indicizzato per nome (e indirizzo UDP)
  */
 int lobby_add_client_reference(Client *client) {
     if (!client) return 0;
@@ -415,13 +818,17 @@ int lobby_add_client_reference(Client *client) {
     mutex_t* mutex = lobby_get_mutex();
     mutex_lock(mutex);
     
-    for (int i = 0; i < MAX_CLIENTS; i++) {
-        if (clients[i] == NULL) {
-            clients[i] = client;
+    int i = lobby_take_slot(client);
+    if (i >= 0) {
+        if (!client_index_add(client)) {
+            lobby_release_slot(client);
             mutex_unlock(mutex);
-            printf("Client FD:%d aggiunto alla lobby nello slot %d\n", (int)client->client_fd, i);
-            return 1;
+            printf("ERRORE: Nome %s già in uso, client FD:%d non aggiunto\n", client->name, (int)client->client_fd);
+            return 0;
         }
+        mutex_unlock(mutex);
+        printf("Client FD:%d aggiunto alla lobby nello slot %d\n", (int)client->client_fd, i);
+        return 1;
     }
     
     mutex_unlock(mutex);
@@ -434,12 +841,11 @@ int lobby_add_client_reference(Client *client) {
  * Wrapper per la funzione game_approve_join con gestione degli errori.
  * 
  * @param client Client creatore che deve approvare il join
- * @param message Messaggio contenente la decisione (1 per approvare, 0 per rifiutare)
+ * @param approve 1 per approvare, 0 per rifiutare
  */
-void lobby_handle_approve_join(Client *client, const char *message) {
-    if (!client || !message) return;
+void lobby_handle_approve_join(Client *client, int approve) {
+    if (!client) return;
     
-    int approve = atoi(message);
     if (!game_approve_join(client, approve)) {
         printf("Approvazione fallita per %s\n", client->name);
     }
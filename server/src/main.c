@@ -20,10 +20,74 @@
 #include "headers/network.h"
 #include "headers/lobby.h"
 #include "headers/game_manager.h"
+#include "headers/reactor.h"
+#include "headers/config.h"
+#include "headers/pool.h"
+#include "headers/udp_channel.h"
 
 static ServerNetwork server;
 static int server_running = 1;
 
+#define STATS_LOG_INTERVAL 60   // Secondi tra due stampe dei contatori di backpressure e dei pool
+
+/**
+ * Stampa i contatori di backpressure del percorso di invio e dell'aggregazione
+ * degli invii della lista partite se sono cambiati dall'ultima stampa
+ * (o sempre, se richiesto).
+ * 
+ * @param force 1 per stampare anche senza variazioni (es. allo spegnimento)
+ */
+static void log_send_stats(int force) {
+    static NetworkStats last;
+    static unsigned long last_requests, last_coalesced;
+    NetworkStats now;
+    unsigned long requests, coalesced;
+    network_get_stats(&now);
+    lobby_get_broadcast_stats(&requests, &coalesced);
+    
+    if (force || memcmp(&now, &last, sizeof(now)) != 0) {
+        printf("[STATS] Aggiornamenti lobby scartati: %lu, client in ritardo: %lu, client disconnessi per lentezza: %lu\n",
+               now.dropped_messages, now.lagging_events, now.evicted_clients);
+        last = now;
+    }
+    if (force || requests != last_requests || coalesced != last_coalesced) {
+        printf("[STATS] Invii lista partite richiesti: %lu, accorpati: %lu\n", requests, coalesced);
+        last_requests = requests;
+        last_coalesced = coalesced;
+    }
+}
+
+/**
+ * Stampa i contatori di un pool di memoria.
+ * 
+ * @param name Nome del pool
+ * @param stats Contatori da stampare
+ */
+static void log_pool_stats(const char *name, const PoolStats *stats) {
+    printf("[POOL] %s: hit %lu, miss %lu, in uso %lu, massimo %lu, allocati %lu\n",
+           name, stats->hits, stats->misses, stats->in_use, stats->high_water, stats->capacity);
+}
+
+/**
+ * Stampa i contatori dei pool di client, code e buffer se sono cambiati
+ * dall'ultima stampa (o sempre, se richiesto).
+ * 
+ * @param force 1 per stampare anche senza variazioni (es. allo spegnimento)
+ */
+static void log_pool_stats_all(int force) {
+    static PoolStats last[4];
+    PoolStats now[4];
+    network_get_pool_stats(&now[0], &now[1], &now[2], &now[3]);
+    
+    if (force || memcmp(now, last, sizeof(now)) != 0) {
+        log_pool_stats("client", &now[0]);
+        log_pool_stats("elementi code", &now[1]);
+        log_pool_stats("messaggi brevi", &now[2]);
+        log_pool_stats("messaggi lunghi", &now[3]);
+        memcpy(last, now, sizeof(now));
+    }
+}
+
 // CAMBIATO: Gestione segnali cross-platform
 #ifdef _WIN32
 /**
@@ -102,19 +166,22 @@ void setup_signal_handlers() {
 /**
  * Funzione principale del server Tris multiplayer.
  * Inizializza tutti i componenti del server, avvia l'ascolto per connessioni client
- * e gestisce il loop principale di accettazione connessioni con threading.
+ * e gestisce il loop principale di accettazione connessioni.
  * 
+ * @param argc Numero di argomenti
+ * @param argv Opzioni --port, --max-clients, --max-games, --lobby-tick (vedi config_load())
  * @return 0 se l'esecuzione è completata con successo, 1 in caso di errore
  * 
- * @note Inizializza nell'ordine: rete, lobby, game manager, ascolto
+ * @note Inizializza nell'ordine: rete, lobby, game manager, reactor, ascolto
  * @note Usa select() con timeout per rendere l'accept non-bloccante e controllare server_running
- * @note Ogni client viene gestito in un thread separato (Windows: CreateThread, Unix: pthread)
+ * @note Su Linux ogni connessione viene affidata a un reactor epoll (numero fisso di thread),
+ *       su Windows viene gestita in un thread separato
  * @note Include controllo di lobby piena per rifiutare connessioni eccedenti
  * @note Gestisce graceful shutdown tramite signal handler cross-platform
  * @note Pulisce automaticamente tutte le risorse prima della terminazione
- * @note Supporta fino a MAX_CLIENTS connessioni simultanee
+ * @note Supporta fino a server_config.max_clients giocatori registrati
  */
-int main() {
+int main(int argc, char *argv[]) {
 #ifdef _WIN32
     printf("=== TRIS SERVER (Windows) ===\n");
 #else
@@ -122,6 +189,8 @@ int main() {
 #endif
     
     setup_signal_handlers();
+    config_load(argc, argv);
+    config_print();
     
     if (!network_init(&server)) {
         fprintf(stderr, "Errore inizializzazione rete\n");
@@ -141,8 +210,32 @@ int main() {
         return 1;
     }
     
+    if (!udp_channel_init()) {
+        fprintf(stderr, "Errore avvio canale UDP\n");
+        game_manager_cleanup();
+        lobby_cleanup();
+        network_shutdown(&server);
+        return 1;
+    }
+    
+#ifndef _WIN32
+    if (!reactor_init(0) || !reactor_start()) {
+        fprintf(stderr, "Errore avvio reactor\n");
+        udp_channel_shutdown();
+        game_manager_cleanup();
+        lobby_cleanup();
+        network_shutdown(&server);
+        return 1;
+    }
+#endif
+    
     if (!network_start_listening(&server)) {
         fprintf(stderr, "Errore avvio server\n");
+#ifndef _WIN32
+        reactor_shutdown();
+        reactor_cleanup();
+#endif
+        udp_channel_shutdown();
         game_manager_cleanup();
         lobby_cleanup();
         network_shutdown(&server);
@@ -152,7 +245,14 @@ int main() {
     printf("Server avviato con successo!\n");
     printf("Premere Ctrl+C per fermare il server\n\n");
     
+    time_t last_stats = time(NULL);
     while (server_running) {
+        if (difftime(time(NULL), last_stats) >= STATS_LOG_INTERVAL) {
+            log_send_stats(0);
+            log_pool_stats_all(0);
+            last_stats = time(NULL);
+        }
+        
         // Usa select per rendere accept non-bloccante
         fd_set read_fds;
         FD_ZERO(&read_fds);
@@ -167,48 +267,35 @@ int main() {
         if (!server_running) break;  // Check dopo ogni operazione bloccante
         
         if (select_result > 0 && FD_ISSET(server.tcp_socket, &read_fds)) {
-            Client *new_client = network_accept_client(&server);
-            if (!new_client) {
-                if (server_running) {
-                    printf("Errore accept client\n");
+            // Il socket di ascolto è non bloccante: accetta tutte le connessioni in coda
+            Client *new_client;
+            while (server_running && (new_client = network_accept_client(&server)) != NULL) {
+                // Aggiungi questo controllo
+                if (lobby_is_full()) {
+                    printf("Lobby piena, rifiuto connessione\n");
+                    closesocket(new_client->client_fd);
+                    network_release_client(new_client);
+                    continue;
                 }
-                continue;
-            }
-            
-            if (!server_running) {
-                closesocket(new_client->client_fd);
-                free(new_client);
-                break;
-            }
-            
-            // Aggiungi questo controllo
-            if (lobby_is_full()) {
-                printf("Lobby piena, rifiuto connessione\n");
-                closesocket(new_client->client_fd);
-                free(new_client);
-                continue;
-            }
-            
-            // Creazione thread con gestione errori migliorata
+                
 #ifdef _WIN32
-            new_client->thread = CreateThread(NULL, 0, network_handle_client_thread, 
-                                             new_client, 0, NULL);
-            if (new_client->thread == NULL) {
-                printf("Errore creazione thread client: %lu\n", GetLastError());
-                closesocket(new_client->client_fd);
-                free(new_client);
-                continue;
-            }
-            CloseHandle(new_client->thread);
+                new_client->thread = CreateThread(NULL, 0, network_handle_client_thread, 
+                                                 new_client, 0, NULL);
+                if (new_client->thread == NULL) {
+                    printf("Errore creazione thread client: %lu\n", GetLastError());
+                    closesocket(new_client->client_fd);
+                    network_release_client(new_client);
+                    continue;
+                }
+                CloseHandle(new_client->thread);
 #else
-            if (pthread_create(&new_client->thread, NULL, network_handle_client_thread, new_client) != 0) {
-                printf("Errore creazione thread client: %s\n", strerror(errno));
-                closesocket(new_client->client_fd);
-                free(new_client);
-                continue;
-            }
-            pthread_detach(new_client->thread);
+                if (!reactor_add_client(new_client)) {
+                    closesocket(new_client->client_fd);
+                    network_release_client(new_client);
+                    continue;
+                }
 #endif
+            }
         }
         else if (select_result == -1) {
             if (!server_running) break;
@@ -220,10 +307,21 @@ int main() {
     }
     
     printf("Iniziando spegnimento server...\n");
-    network_shutdown(&server);
+#ifndef _WIN32
+    // Ferma i reactor prima di toccare lobby e partite
+    reactor_shutdown();
+#endif
     printf("Pulizia in corso...\n");
-    game_manager_cleanup();
+    udp_channel_shutdown();
     lobby_cleanup();
+    game_manager_cleanup();
+#ifndef _WIN32
+    reactor_cleanup();
+#endif
+    log_send_stats(1);
+    log_pool_stats_all(1);
+    network_shutdown(&server);
+    network_clients_cleanup();
     printf("Server spento completamente\n");
     return 0;
-}
\ No newline at end of file
+}
@@ -1,11 +1,24 @@
+#define _GNU_SOURCE
 #include "headers/network.h"
 #include "headers/lobby.h"
 #include "headers/game_manager.h"
+#include "headers/reactor.h"
+#include "headers/config.h"
+#include "headers/client_index.h"
+#include "headers/pool.h"
+#include "headers/protocol.h"
+#include "headers/udp_channel.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
 
+#ifndef _WIN32
+    #include <fcntl.h>
+    #include <sys/uio.h>
+    #include <sys/resource.h>
+#endif
+
 #define LOG_ERROR(msg) printf("ERROR: %s\n", msg)
 
 /**
@@ -29,6 +42,13 @@ const char* get_socket_error() {
 }
 
 static ServerNetwork *global_server = NULL;
+static NetworkStats net_stats;              // Contatori di backpressure (protetti da stats_mutex)
+static mutex_t stats_mutex;
+static ObjectPool client_pool;              // Strutture Client
+static ObjectPool node_pool;                // Elementi delle code di invio (OutMsg)
+static ObjectPool small_msg_pool;           // Buffer dei messaggi in uscita brevi
+static ObjectPool large_msg_pool;           // Buffer dei messaggi in uscita fino a MAX_MSG_SIZE
+static int connected_clients = 0;           // Client allocati (limite server_config.max_clients)
 
 /**
  * Stampa le informazioni di configurazione del server sulla console.
@@ -40,7 +60,7 @@ static ServerNetwork *global_server = NULL;
  */
 void print_server_info() {
     printf("=== INFORMAZIONI SERVER ===\n");
-    printf("Porta: %d\n", SERVER_PORT);
+    printf("Porta: %d\n", server_config.port);
     
 #ifdef _WIN32
     char hostname[256];
@@ -64,135 +84,192 @@ void print_server_info() {
 }
 
 /**
- * Registra un client per la comunicazione UDP salvando il suo indirizzo.
- * Associa l'indirizzo UDP del client alla sua struttura dati per comunicazioni future.
+ * Stampa l'indirizzo a cui è associato il canale UDP di un client.
  * 
- * @param client Puntatore al client da registrare per UDP
- * @param udp_addr Indirizzo UDP del client da memorizzare
- * @return 1 in caso di successo, 0 se i parametri sono invalidi
+ * @param client Client del canale
+ * @param event Descrizione dell'evento ("registrato", "spostato")
+ * @param addr Indirizzo UDP del client
  */
-static int network_register_udp_client(Client *client, struct sockaddr_in *udp_addr) {
-    if (!client || !udp_addr) return 0;
-    
-    memcpy(&client->udp_addr, udp_addr, sizeof(struct sockaddr_in));
-    
-    printf("Client %s registrato per UDP da %s:%d\n", 
-           client->name, 
-           inet_ntoa(udp_addr->sin_addr), 
-           ntohs(udp_addr->sin_port));
-    return 1;
+static void network_log_udp_binding(const Client *client, const char *event, const struct sockaddr_in *addr) {
+    char ip[INET_ADDRSTRLEN];
+    inet_ntop(AF_INET, &addr->sin_addr, ip, sizeof(ip));
+    printf("Client %s %s per UDP su %s:%d\n", client->name, event, ip, ntohs(addr->sin_port));
 }
 
 /**
- * Cerca un client registrato tramite il suo indirizzo UDP.
- * Operazione thread-safe che confronta indirizzi IP e porte UDP.
+ * Risposte UDP in attesa di invio. Il thread UDP le accumula mentre
+ * elabora un blocco di datagrammi e le spedisce tutte con una sola
+ * sendmmsg() alla fine del blocco (su Windows partono subito con sendto()).
+ */
+typedef struct {
+    socket_t sock;                                  // Socket da cui partono le risposte
+    int count;                                      // Risposte in attesa
+#ifndef _WIN32
+    struct sockaddr_in addrs[UDP_BATCH_SIZE];       // Destinatari
+    size_t lens[UDP_BATCH_SIZE];                    // Lunghezze delle risposte
+    char data[UDP_BATCH_SIZE][MAX_MSG_SIZE];        // Testi delle risposte
+#endif
+} UdpReplies;
+
+/**
+ * Contesto dei gestori dei comandi UDP: risposte del blocco corrente,
+ * mittente del datagramma e client identificato dal suo token.
+ */
+typedef struct {
+    UdpReplies *replies;            // Risposte in attesa del thread UDP
+    struct sockaddr_in *addr;       // Mittente del datagramma
+    Client *client;                 // Client del token (con un riferimento), NULL se assente o sconosciuto
+} UdpRequest;
+
+/**
+ * Spedisce le risposte UDP in attesa con sendmmsg(), ripetendo la chiamata
+ * finché non sono partite tutte. Una risposta che il kernel rifiuta viene
+ * scartata (UDP non garantisce la consegna) e l'invio prosegue con le altre.
  * 
- * @param addr Indirizzo UDP da cercare tra i client registrati
- * @return Puntatore al client corrispondente, NULL se non trovato o addr è NULL
+ * @param replies Risposte in attesa, svuotate al termine
  */
-static Client* network_find_client_by_udp_addr(struct sockaddr_in *addr) {
-    if (!addr) return NULL;
+static void network_flush_udp_replies(UdpReplies *replies) {
+#ifndef _WIN32
+    struct mmsghdr msgs[UDP_BATCH_SIZE];
+    struct iovec iovs[UDP_BATCH_SIZE];
+    int sent = 0;
     
-    mutex_t* mutex = lobby_get_mutex();
-    mutex_lock(mutex);
+    memset(msgs, 0, sizeof(msgs[0]) * (size_t)replies->count);
+    for (int i = 0; i < replies->count; i++) {
+        iovs[i].iov_base = replies->data[i];
+        iovs[i].iov_len = replies->lens[i];
+        msgs[i].msg_hdr.msg_name = &replies->addrs[i];
+        msgs[i].msg_hdr.msg_namelen = sizeof(replies->addrs[i]);
+        msgs[i].msg_hdr.msg_iov = &iovs[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+    }
     
-    for (int i = 0; i < MAX_CLIENTS; i++) {
-        Client *client = lobby_get_client_by_index(i); 
-        if (client && 
-            client->udp_addr.sin_addr.s_addr == addr->sin_addr.s_addr &&
-            client->udp_addr.sin_port == addr->sin_port) {
-            mutex_unlock(mutex);
-            return client;
+    while (sent < replies->count) {
+        int n = sendmmsg(replies->sock, msgs + sent, (unsigned int)(replies->count - sent), 0);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            printf("Errore invio UDP: %s\n", strerror(errno));
+            sent++;
+            continue;
         }
+        sent += n;
     }
-    
-    mutex_unlock(mutex);
-    return NULL;
+#endif
+    replies->count = 0;
 }
 
 /**
  * Invia un messaggio UDP a un indirizzo client specifico.
- * Gestisce l'invio di risposte UDP con logging e gestione errori.
+ * Su Linux la risposta viene accodata e parte con network_flush_udp_replies()
+ * insieme alle altre del blocco di datagrammi in elaborazione.
  * 
- * @param server Struttura server contenente il socket UDP
- * @param client_addr Indirizzo di destinazione del messaggio
+ * @param request Richiesta UDP a cui si risponde (mittente e risposte in attesa)
  * @param message Messaggio da inviare
  * @return 1 in caso di successo, 0 in caso di errore
  */
-static int network_send_udp_response(ServerNetwork *server, struct sockaddr_in *client_addr, const char *message) {
-    if (!server || !client_addr || !message) return 0;
+static int network_send_udp_response(UdpRequest *request, const char *message) {
+    if (!request || !message) return 0;
     
-    int bytes_sent = sendto(server->udp_socket, message, (int)strlen(message), 0,
-                           (struct sockaddr*)client_addr, sizeof(*client_addr));
+    size_t len = strlen(message);
+#ifdef _WIN32
+    int bytes_sent = sendto(request->replies->sock, message, (int)len, 0,
+                           (struct sockaddr*)request->addr, sizeof(*request->addr));
     
     if (bytes_sent == SOCKET_ERROR_VALUE) {
-#ifdef _WIN32
         printf("Errore invio UDP: %d\n", WSAGetLastError());
-#else
-        printf("Errore invio UDP: %s\n", strerror(errno));
-#endif
         return 0;
     }
+#else
+    UdpReplies *replies = request->replies;
+    if (len >= MAX_MSG_SIZE) return 0;
+    if (replies->count == UDP_BATCH_SIZE) {
+        network_flush_udp_replies(replies);
+    }
     
-    printf("UDP inviato a %s:%d: %s\n", 
-           inet_ntoa(client_addr->sin_addr), 
-           ntohs(client_addr->sin_port), 
-           message);
+    memcpy(replies->data[replies->count], message, len);
+    replies->lens[replies->count] = len;
+    replies->addrs[replies->count] = *request->addr;
+    replies->count++;
+#endif
     return 1;
 }
 
 /**
- * Gestisce la registrazione UDP di un client tramite nome.
- * Trova il client per nome e lo registra per la comunicazione UDP.
+ * Invia una risposta UDP senza dati strutturati, scritta con message_write().
  * 
- * @param server Struttura server per l'invio della risposta
- * @param client_addr Indirizzo UDP del client da registrare
- * @param name Nome del client da cercare e registrare
+ * @param request Richiesta UDP a cui si risponde
+ * @param id Tipo del messaggio
+ * @param text Testo dopo il verbo, NULL per il solo verbo
+ * @return 1 in caso di successo, 0 in caso di errore
  */
-static void handle_udp_register(ServerNetwork *server, struct sockaddr_in *client_addr, const char *name) {
-    Client *client = lobby_find_client_by_name(name);
-    if (!client) {
-        network_send_udp_response(server, client_addr, "ERROR:Client non trovato");
-        return;
-    }
+static int network_send_udp_message(UdpRequest *request, ServerMsgId id, const char *text) {
+    char message[MAX_MSG_SIZE];
+    if (!message_write(id, message, sizeof(message), text)) return 0;
+    return network_send_udp_response(request, message);
+}
+
+/**
+ * Verifica che il datagramma sia stato aperto da un token di sessione
+ * valido, rispondendo con un errore in caso contrario.
+ * 
+ * @param request Richiesta UDP
+ * @return 1 se request->client è disponibile, 0 altrimenti
+ */
+static int network_udp_require_client(UdpRequest *request) {
+    if (request->client) return 1;
+    network_send_udp_message(request, SMSG_ERROR, "Token di sessione non valido");
+    return 0;
+}
+
+/**
+ * Gestisce la registrazione UDP di un client (<token>:UDP_REGISTER).
+ * Il client è già identificato dal token ricevuto con UDP_SESSION: apre
+ * il canale UDP affidabile verso l'indirizzo del mittente e risponde con
+ * la sequenza da cui proseguono entrambe le direzioni.
+ * 
+ * @param ctx Richiesta UDP (UdpRequest)
+ * @param cmd Comando (senza argomenti)
+ */
+static void handle_udp_register(void *ctx, const Command *cmd) {
+    UdpRequest *request = (UdpRequest*)ctx;
+    (void)cmd;
     
-    if (network_register_udp_client(client, client_addr)) {
-        network_send_udp_response(server, client_addr, "UDP_REGISTERED:OK");
-    } else {
-        network_send_udp_response(server, client_addr, "ERROR:Registrazione fallita");
+    if (!network_udp_require_client(request)) return;
+    
+    unsigned long base = udp_channel_open(request->client, request->replies->sock, request->addr);
+    network_log_udp_binding(request->client, "registrato", request->addr);
+    
+    char reply[32];
+    if (message_encode_udp_registered(reply, sizeof(reply), (int)base)) {
+        network_send_udp_response(request, reply);
     }
 }
 
 /**
- * Gestisce una mossa di gioco ricevuta tramite UDP.
+ * Gestisce una mossa di gioco ricevuta tramite UDP (MOVE:<riga>,<colonna>).
  * Valida il formato della mossa, trova il client e esegue la mossa nella partita.
  * 
- * @param server Struttura server per l'invio della risposta
- * @param client_addr Indirizzo del client che ha inviato la mossa
- * @param move_data Dati della mossa nel formato "riga,colonna"
+ * @param ctx Richiesta UDP (UdpRequest)
+ * @param cmd Comando; gli argomenti sono la mossa nel formato "riga,colonna"
  */
-static void handle_udp_move(ServerNetwork *server, struct sockaddr_in *client_addr, const char *move_data) {
-    int row, col;
-    if (sscanf(move_data, "%d,%d", &row, &col) != 2) {
-        network_send_udp_response(server, client_addr, "ERROR:Formato mossa non valido");
-        return;
-    }
+static void handle_udp_move(void *ctx, const Command *cmd) {
+    UdpRequest *request = (UdpRequest*)ctx;
+    Client *client = request->client;
+    int cell[2];
     
-    Client *client = network_find_client_by_udp_addr(client_addr);
-    if (!client) {
-        network_send_udp_response(server, client_addr, "ERROR:Client non registrato per UDP");
+    if (!protocol_int_args(cmd, ',', cell, 2)) {
+        network_send_udp_message(request, SMSG_ERROR, "Formato mossa non valido");
         return;
     }
     
-    if (client->game_id <= 0) {
-        network_send_udp_response(server, client_addr, "ERROR:Non sei in una partita");
-        return;
-    }
+    if (!network_udp_require_client(request)) return;
     
-    if (game_make_move(client->game_id, client, row, col)) {
-        network_send_udp_response(server, client_addr, "MOVE_ACCEPTED");
+    if (client->game_id <= 0) {
+        network_send_udp_message(request, SMSG_ERROR, "Non sei in una partita");
+    } else if (game_make_move(client->game_id, client, cell[0], cell[1])) {
+        network_send_udp_message(request, SMSG_MOVE_ACCEPTED, NULL);
     } else {
-        network_send_udp_response(server, client_addr, "ERROR:Mossa non valida");
+        network_send_udp_message(request, SMSG_ERROR, "Mossa non valida");
     }
 }
 
@@ -200,126 +277,302 @@ static void handle_udp_move(ServerNetwork *server, struct sockaddr_in *client_ad
  * Gestisce una richiesta di ping UDP inviando una risposta PONG.
  * Utilizzata per verificare la connettività UDP e mantenere la connessione attiva.
  * 
- * @param server Struttura server per l'invio della risposta
- * @param client_addr Indirizzo del client che ha inviato il ping
+ * @param ctx Richiesta UDP (UdpRequest)
+ * @param cmd Comando (senza argomenti)
  */
-static void handle_udp_ping(ServerNetwork *server, struct sockaddr_in *client_addr) {
-    network_send_udp_response(server, client_addr, "PONG");
+static void handle_udp_ping(void *ctx, const Command *cmd) {
+    UdpRequest *request = (UdpRequest*)ctx;
+    (void)cmd;
+    network_send_udp_message(request, SMSG_PONG, NULL);
 }
 
 /**
  * Gestisce una richiesta di stato di gioco tramite UDP.
  * Invia le informazioni correnti della partita del client richiedente.
  * 
- * @param server Struttura server per l'invio della risposta
- * @param client_addr Indirizzo del client che richiede lo stato
+ * @param ctx Richiesta UDP (UdpRequest)
+ * @param cmd Comando (senza argomenti)
  */
-static void handle_udp_game_state(ServerNetwork *server, struct sockaddr_in *client_addr) {
-    Client *client = network_find_client_by_udp_addr(client_addr);
-    if (!client) {
-        network_send_udp_response(server, client_addr, "ERROR:Client non registrato");
-        return;
-    }
+static void handle_udp_game_state(void *ctx, const Command *cmd) {
+    UdpRequest *request = (UdpRequest*)ctx;
+    (void)cmd;
     
-    if (client->game_id <= 0) {
-        network_send_udp_response(server, client_addr, "GAME_STATE:NO_GAME");
+    if (!network_udp_require_client(request)) return;
+    
+    int game_id = request->client->game_id;
+    
+    if (game_id <= 0) {
+        network_send_udp_message(request, SMSG_GAME_STATE, "NO_GAME");
         return;
     }
     
-    Game *game = game_find_by_id(client->game_id);
+    Game *game = game_find_by_id(game_id);
     if (!game) {
-        network_send_udp_response(server, client_addr, "ERROR:Partita non trovata");
+        network_send_udp_message(request, SMSG_ERROR, "Partita non trovata");
         return;
     }
     
     char state_msg[256];
-    sprintf(state_msg, "GAME_STATE:%d:%c:%d", 
-            game->game_id, 
-            (char)game->current_player, 
-            (int)game->state);
+    if (message_encode_game_state(state_msg, sizeof(state_msg), "%d:%c:%d",
+                                  game->game_id,
+                                  (char)game->current_player,
+                                  (int)game->state)) {
+        network_send_udp_response(request, state_msg);
+    }
+}
+
+/**
+ * Gestisce la disconnessione UDP: il client torna a ricevere solo via TCP.
+ * 
+ * @param ctx Richiesta UDP (UdpRequest)
+ * @param cmd Comando (senza argomenti)
+ */
+static void handle_udp_disconnect(void *ctx, const Command *cmd) {
+    UdpRequest *request = (UdpRequest*)ctx;
+    (void)cmd;
+    
+    Client *client = request->client;
+    if (client) {
+        udp_channel_close(client);
+        network_send_udp_message(request, SMSG_UDP_DISCONNECTED, NULL);
+        printf("Client %s disconnesso da UDP\n", client->name);
+    }
+}
+
+/**
+ * Gestisce un comando sequenziato del canale affidabile
+ * (SEQ:<sequenza>:<comando>). Il comando viene eseguito una sola volta,
+ * nell'ordine di invio, con le stesse regole del canale TCP; la risposta
+ * "ACK:<ultima sequenza eseguita>" parte sempre, anche per i duplicati.
+ * 
+ * @param ctx Richiesta UDP (UdpRequest)
+ * @param cmd Comando; gli argomenti sono la sequenza e il comando incapsulato
+ * 
+ * @note Sul canale affidabile è ammessa solo MOVE
+ */
+static void handle_udp_seq(void *ctx, const Command *cmd) {
+    UdpRequest *request = (UdpRequest*)ctx;
+    const char *cursor = cmd->args;
+    int seq;
+    
+    if (!protocol_next_int(&cursor, ':', &seq) || seq <= 0) {
+        network_send_udp_message(request, SMSG_ERROR, "Sequenza non valida");
+        return;
+    }
+    
+    if (!network_udp_require_client(request)) return;
+    Client *client = request->client;
+    
+    unsigned long ack;
+    int fresh = udp_channel_accept(client, (unsigned long)seq, &ack);
+    char reply[32];
+    if (message_encode_ack(reply, sizeof(reply), (int)ack)) {
+        network_send_udp_response(request, reply);
+    }
+    
+    if (fresh) {
+#ifndef _WIN32
+        // L'ACK precede gli eventi prodotti dal comando, inviati subito dal canale
+        network_flush_udp_replies(request->replies);
+#endif
+        Command inner;
+        protocol_parse(cursor, &inner);
+        if (inner.id == CMD_MOVE) {
+            lobby_handle_command(client, &inner);
+        } else {
+            network_send_message(client, SMSG_ERROR, "Comando non ammesso sul canale UDP");
+        }
+    }
+}
+
+/**
+ * Gestisce la conferma di un client (ACK:<sequenza>): gli eventi di partita
+ * fino a quella sequenza non vengono più ritrasmessi.
+ * 
+ * @param ctx Richiesta UDP (UdpRequest)
+ * @param cmd Comando; l'argomento è l'ultima sequenza ricevuta in ordine
+ */
+static void handle_udp_ack(void *ctx, const Command *cmd) {
+    UdpRequest *request = (UdpRequest*)ctx;
+    const char *cursor = cmd->args;
+    int seq;
+    
+    if (!protocol_next_int(&cursor, '\0', &seq) || seq < 0) return;
+    
+    if (request->client) {
+        udp_channel_ack(request->client, (unsigned long)seq);
+    }
+}
+
+/**
+ * Gestori dei comandi ammessi sul canale UDP.
+ */
+static const CommandHandler udp_commands[CMD_COUNT] = {
+    [CMD_UDP_REGISTER] = handle_udp_register,
+    [CMD_MOVE] = handle_udp_move,
+    [CMD_PING] = handle_udp_ping,
+    [CMD_GET_GAME_STATE] = handle_udp_game_state,
+    [CMD_UDP_DISCONNECT] = handle_udp_disconnect,
+    [CMD_SEQ] = handle_udp_seq,
+    [CMD_ACK] = handle_udp_ack
+};
+
+/**
+ * Socket UDP servito da ciascun thread UDP.
+ */
+typedef struct {
+    ServerNetwork *server;          // Server a cui appartiene il socket
+    int index;                      // Indice in server->udp_sockets
+} UdpWorker;
+
+static UdpWorker udp_workers[UDP_MAX_SOCKETS];
+
+/**
+ * Legge il token di sessione che apre un datagramma
+ * ("<UDP_TOKEN_DIGITS cifre esadecimali>:<comando>").
+ * 
+ * @param buffer Testo del datagramma; in uscita punta al comando
+ * @return Token letto, 0 se il datagramma non inizia con un token
+ */
+static unsigned long long network_parse_udp_token(const char **buffer) {
+    const char *p = *buffer;
+    unsigned long long token = 0;
+    
+    for (int i = 0; i < UDP_TOKEN_DIGITS; i++) {
+        char c = p[i];
+        int digit;
+        if (c >= '0' && c <= '9') digit = c - '0';
+        else if (c >= 'a' && c <= 'f') digit = c - 'a' + 10;
+        else return 0;
+        token = (token << 4) | (unsigned long long)digit;
+    }
+    if (p[UDP_TOKEN_DIGITS] != ':') return 0;
+    
+    *buffer = p + UDP_TOKEN_DIGITS + 1;
+    return token;
+}
+
+/**
+ * Analizza un datagramma e lo smista sulla tabella udp_commands.
+ * Il token iniziale identifica il client in O(1) sull'indice dei token,
+ * indipendentemente dall'indirizzo del mittente: se questo è cambiato
+ * (rebinding NAT, cambio di rete) il canale UDP lo segue.
+ * 
+ * @param replies Risposte in attesa del thread UDP
+ * @param buffer Testo del datagramma (null-terminato)
+ * @param addr Mittente del datagramma
+ * 
+ * @note I datagrammi senza token sono ammessi, ma solo PING non lo richiede
+ */
+static void network_process_udp_datagram(UdpReplies *replies, const char *buffer, struct sockaddr_in *addr) {
+    Command cmd;
+    UdpRequest request = { replies, addr, NULL };
+    
+    unsigned long long token = network_parse_udp_token(&buffer);
+    if (token) {
+        request.client = client_index_acquire_by_token(token);
+        if (request.client && udp_channel_rebind(request.client, replies->sock, addr)) {
+            network_log_udp_binding(request.client, "spostato", addr);
+        }
+    }
     
-    network_send_udp_response(server, client_addr, state_msg);
+    protocol_parse(buffer, &cmd);
+    if (!protocol_dispatch(udp_commands, &request, &cmd)) {
+        network_send_udp_message(&request, SMSG_ERROR, "Comando UDP sconosciuto");
+    }
+    network_release_client(request.client);
 }
 
 /**
- * Thread dedicato alla gestione delle comunicazioni UDP.
- * Riceve e processa tutti i messaggi UDP in un loop separato dal TCP.
- * Supporta comandi: UDP_REGISTER, MOVE, PING, GET_GAME_STATE, UDP_DISCONNECT.
+ * Thread dedicato alla gestione delle comunicazioni UDP su uno dei socket UDP.
+ * Riceve e processa i messaggi UDP in un loop separato dal TCP.
+ * Ogni datagramma inizia con il token di sessione del client (UDP_SESSION).
+ * Supporta comandi: UDP_REGISTER, MOVE, PING, GET_GAME_STATE, UDP_DISCONNECT,
+ * SEQ, ACK,
+ * smistati con protocol_dispatch() sulla tabella udp_commands.
+ * 
+ * Su Linux legge fino a UDP_BATCH_SIZE datagrammi per chiamata con
+ * recvmmsg() (attende solo il primo, poi prende quelli già arrivati) e
+ * spedisce le risposte del blocco con una sola sendmmsg().
  * 
- * @param arg Puntatore alla struttura ServerNetwork
+ * @param arg Socket da servire (UdpWorker)
  * @return Valore di ritorno del thread (0 su Windows, NULL su Unix)
  * 
  * @note Funziona finché server->is_running è true
- * @note Include timeout per evitare blocchi indefiniti
+ * @note La ricezione è bloccante senza timeout: network_shutdown() sveglia
+ *       il thread con shutdown() sul socket
  */
 #ifdef _WIN32
 thread_return_t THREAD_CALL network_handle_udp_thread(thread_param_t arg) {
 #else
 thread_return_t network_handle_udp_thread(thread_param_t arg) {
 #endif
-    ServerNetwork *server = (ServerNetwork*)arg;
+    UdpWorker *worker = (UdpWorker*)arg;
+    ServerNetwork *server = worker->server;
+    UdpReplies replies;
+    
+    replies.sock = server->udp_sockets[worker->index];
+    replies.count = 0;
+    printf("Thread UDP %d avviato\n", worker->index);
+    
+#ifdef _WIN32
     char buffer[MAX_MSG_SIZE];
     struct sockaddr_in client_addr;
-    socklen_t addr_len = sizeof(client_addr);
-    
-    printf("Thread UDP avviato\n");
     
     while (server->is_running) {
-        int bytes = recvfrom(server->udp_socket, buffer, sizeof(buffer) - 1, 0,
+        int addr_len = sizeof(client_addr);
+        int bytes = recvfrom(replies.sock, buffer, sizeof(buffer) - 1, 0,
                            (struct sockaddr*)&client_addr, &addr_len);
         
+        if (!server->is_running) break;
         if (bytes <= 0) {
-#ifdef _WIN32
-            int error = WSAGetLastError();
-            if (error == WSAETIMEDOUT) {
-                continue;
-            }
-#else
-            if (errno == EAGAIN || errno == EWOULDBLOCK) {
-                continue;
-            }
-#endif
-            if (server->is_running) {
-                printf("Errore ricezione UDP: %s\n", get_socket_error());
-            }
+            printf("Errore ricezione UDP: %s\n", get_socket_error());
             continue;
         }
 
         buffer[bytes] = '\0';
+        network_process_udp_datagram(&replies, buffer, &client_addr);
+    }
+#else
+    char buffers[UDP_BATCH_SIZE][MAX_MSG_SIZE];
+    struct mmsghdr msgs[UDP_BATCH_SIZE];
+    struct iovec iovs[UDP_BATCH_SIZE];
+    struct sockaddr_in addrs[UDP_BATCH_SIZE];
+    
+    memset(msgs, 0, sizeof(msgs));
+    for (int i = 0; i < UDP_BATCH_SIZE; i++) {
+        iovs[i].iov_base = buffers[i];
+        iovs[i].iov_len = MAX_MSG_SIZE - 1;
+        msgs[i].msg_hdr.msg_name = &addrs[i];
+        msgs[i].msg_hdr.msg_iov = &iovs[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+    
+    while (server->is_running) {
+        for (int i = 0; i < UDP_BATCH_SIZE; i++) {
+            msgs[i].msg_hdr.msg_namelen = sizeof(addrs[i]);
+        }
         
-        printf("UDP ricevuto: %s da %s:%d\n", 
-               buffer, 
-               inet_ntoa(client_addr.sin_addr), 
-               ntohs(client_addr.sin_port));
+        int count = recvmmsg(replies.sock, msgs, UDP_BATCH_SIZE, MSG_WAITFORONE, NULL);
         
-        if (strncmp(buffer, "UDP_REGISTER:", 13) == 0) {
-            const char *name = buffer + 13;
-            handle_udp_register(server, &client_addr, name);
-        }
-        else if (strncmp(buffer, "MOVE:", 5) == 0) {
-            const char *move_data = buffer + 5;
-            handle_udp_move(server, &client_addr, move_data);
-        }
-        else if (strncmp(buffer, "PING", 4) == 0) {
-            handle_udp_ping(server, &client_addr);
-        }
-        else if (strncmp(buffer, "GET_GAME_STATE", 14) == 0) {
-            handle_udp_game_state(server, &client_addr);
-        }
-        else if (strncmp(buffer, "UDP_DISCONNECT", 14) == 0) {
-            Client *client = network_find_client_by_udp_addr(&client_addr);
-            if (client) {
-                memset(&client->udp_addr, 0, sizeof(client->udp_addr));
-                network_send_udp_response(server, &client_addr, "UDP_DISCONNECTED");
-                printf("Client %s disconnesso da UDP\n", client->name);
+        if (!server->is_running) break;
+        if (count < 0) {
+            if (errno != EINTR) {
+                printf("Errore ricezione UDP: %s\n", get_socket_error());
             }
+            continue;
         }
-        else {
-            network_send_udp_response(server, &client_addr, "ERROR:Comando UDP sconosciuto");
+        
+        for (int i = 0; i < count; i++) {
+            if (msgs[i].msg_len == 0) continue;
+            buffers[i][msgs[i].msg_len] = '\0';
+            network_process_udp_datagram(&replies, buffers[i], &addrs[i]);
         }
+        network_flush_udp_replies(&replies);
     }
+#endif
     
-    printf("Thread UDP terminato\n");
+    printf("Thread UDP %d terminato\n", worker->index);
 #ifdef _WIN32
     return 0;
 #else
@@ -348,6 +601,33 @@ int network_init(ServerNetwork *server) {
 #endif
 
     memset(server, 0, sizeof(ServerNetwork));
+    memset(&net_stats, 0, sizeof(net_stats));
+    mutex_init(&stats_mutex);
+    
+    connected_clients = 0;
+    if (!pool_init(&client_pool, "client", sizeof(Client), CLIENT_CHUNK_SIZE) ||
+        !pool_init(&node_pool, "msg-node", sizeof(OutMsg), MSG_POOL_CHUNK_SIZE) ||
+        !pool_init(&small_msg_pool, "msg-small", sizeof(SharedMsg) + OUT_MSG_SMALL_SIZE, MSG_POOL_CHUNK_SIZE) ||
+        !pool_init(&large_msg_pool, "msg-large", sizeof(SharedMsg) + MAX_MSG_SIZE, MSG_POOL_CHUNK_SIZE)) {
+        printf("Errore inizializzazione pool di memoria\n");
+#ifdef _WIN32
+        WSACleanup();
+#endif
+        return 0;
+    }
+    
+#ifndef _WIN32
+    // Ogni client occupa un descrittore: alza il limite soft fin dove serve (e il limite hard consente)
+    struct rlimit fd_limit;
+    rlim_t wanted = (rlim_t)server_config.max_clients + NETWORK_RESERVED_FDS;
+    if (getrlimit(RLIMIT_NOFILE, &fd_limit) == 0 && fd_limit.rlim_cur < wanted) {
+        fd_limit.rlim_cur = (fd_limit.rlim_max < wanted) ? fd_limit.rlim_max : wanted;
+        if (setrlimit(RLIMIT_NOFILE, &fd_limit) != 0 || fd_limit.rlim_cur < wanted) {
+            printf("Attenzione: limite descrittori %lu, inferiore a %lu richiesti per %d client\n",
+                   (unsigned long)fd_limit.rlim_cur, (unsigned long)wanted, server_config.max_clients);
+        }
+    }
+#endif
     
     // Crea socket TCP
     server->tcp_socket = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
@@ -359,22 +639,47 @@ int network_init(ServerNetwork *server) {
         return 0;
     }
     
-    // Crea socket UDP
-    server->udp_socket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
-    if (server->udp_socket == INVALID_SOCKET_VALUE) {
-        printf("Errore creazione socket UDP: %s\n", get_socket_error());
-        closesocket(server->tcp_socket);
+    // Crea i socket UDP: uno per thread, sulla stessa porta con SO_REUSEPORT
 #ifdef _WIN32
-        WSACleanup();
+    server->udp_socket_count = 1;
+#else
+    // Più thread UDP che CPU non servono: il numero viene limitato alle CPU
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    server->udp_socket_count = server_config.udp_threads;
+    if (cpus > 0 && server->udp_socket_count > cpus) {
+        server->udp_socket_count = (int)cpus;
+    }
+    if (server->udp_socket_count > UDP_MAX_SOCKETS) {
+        server->udp_socket_count = UDP_MAX_SOCKETS;
+    }
+#ifndef SO_REUSEPORT
+    if (server->udp_socket_count > 1) {
+        printf("SO_REUSEPORT non disponibile, uso un solo socket UDP\n");
+        server->udp_socket_count = 1;
+    }
 #endif
-        return 0;
+#endif
+    for (int i = 0; i < server->udp_socket_count; i++) {
+        server->udp_sockets[i] = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+        if (server->udp_sockets[i] == INVALID_SOCKET_VALUE) {
+            printf("Errore creazione socket UDP: %s\n", get_socket_error());
+            while (i-- > 0) {
+                closesocket(server->udp_sockets[i]);
+            }
+            server->udp_socket_count = 0;
+            closesocket(server->tcp_socket);
+#ifdef _WIN32
+            WSACleanup();
+#endif
+            return 0;
+        }
     }
     
     // Configurazione indirizzo server
     memset(&server->server_addr, 0, sizeof(server->server_addr));
     server->server_addr.sin_family = AF_INET;
     server->server_addr.sin_addr.s_addr = INADDR_ANY; // Ascolta su tutte le interfacce di rete
-    server->server_addr.sin_port = htons(SERVER_PORT);
+    server->server_addr.sin_port = htons(server_config.port);
     
     // Configura opzioni socket
 #ifdef _WIN32
@@ -382,14 +687,10 @@ int network_init(ServerNetwork *server) {
     if (setsockopt(server->tcp_socket, SOL_SOCKET, SO_REUSEADDR, (char*)&opt, sizeof(opt)) == SOCKET_ERROR_VALUE) {
         printf("Errore setsockopt TCP SO_REUSEADDR: %s\n", get_socket_error());
     }
-    if (setsockopt(server->udp_socket, SOL_SOCKET, SO_REUSEADDR, (char*)&opt, sizeof(opt)) == SOCKET_ERROR_VALUE) {
+    if (setsockopt(server->udp_sockets[0], SOL_SOCKET, SO_REUSEADDR, (char*)&opt, sizeof(opt)) == SOCKET_ERROR_VALUE) {
         printf("Errore setsockopt UDP SO_REUSEADDR: %s\n", get_socket_error());
     }
     
-    // Timeout per UDP
-    DWORD timeout = 1000; 
-    setsockopt(server->udp_socket, SOL_SOCKET, SO_RCVTIMEO, (char*)&timeout, sizeof(timeout));
-    
     // Disabilita algoritmo di Nagle per TCP (migliori prestazioni per piccoli pacchetti)
     BOOL no_delay = TRUE;
     setsockopt(server->tcp_socket, IPPROTO_TCP, TCP_NODELAY, (char*)&no_delay, sizeof(no_delay));
@@ -398,16 +699,19 @@ int network_init(ServerNetwork *server) {
     if (setsockopt(server->tcp_socket, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt)) == -1) {
         printf("Errore setsockopt TCP SO_REUSEADDR: %s\n", strerror(errno));
     }
-    if (setsockopt(server->udp_socket, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt)) == -1) {
-        printf("Errore setsockopt UDP SO_REUSEADDR: %s\n", strerror(errno));
+    for (int i = 0; i < server->udp_socket_count; i++) {
+        if (setsockopt(server->udp_sockets[i], SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt)) == -1) {
+            printf("Errore setsockopt UDP SO_REUSEADDR: %s\n", strerror(errno));
+        }
+#ifdef SO_REUSEPORT
+        // Il kernel distribuisce i datagrammi tra i socket in base al mittente
+        if (server->udp_socket_count > 1 &&
+            setsockopt(server->udp_sockets[i], SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt)) == -1) {
+            printf("Errore setsockopt UDP SO_REUSEPORT: %s\n", strerror(errno));
+        }
+#endif
     }
     
-    // Timeout per UDP
-    struct timeval timeout;
-    timeout.tv_sec = 1;
-    timeout.tv_usec = 0;
-    setsockopt(server->udp_socket, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
-    
     // Disabilita algoritmo di Nagle per TCP
     int no_delay = 1;
     setsockopt(server->tcp_socket, IPPROTO_TCP, TCP_NODELAY, &no_delay, sizeof(no_delay));
@@ -432,22 +736,24 @@ int network_start_listening(ServerNetwork *server) {
     // Bind TCP
     if (bind(server->tcp_socket, (struct sockaddr*)&server->server_addr, 
              sizeof(server->server_addr)) == SOCKET_ERROR_VALUE) {
-        printf("Errore bind TCP sulla porta %d: %s\n", SERVER_PORT, get_socket_error());
+        printf("Errore bind TCP sulla porta %d: %s\n", server_config.port, get_socket_error());
         printf("Possibili cause:\n");
         printf("- Porta già in uso da un altro processo\n");
         printf("- Permessi insufficienti (provare con sudo su Linux)\n");
         printf("- Firewall che blocca la porta\n");
         return 0;
     }
-    printf("TCP bind riuscito sulla porta %d\n", SERVER_PORT);
+    printf("TCP bind riuscito sulla porta %d\n", server_config.port);
     
     // Bind UDP
-    if (bind(server->udp_socket, (struct sockaddr*)&server->server_addr, 
-             sizeof(server->server_addr)) == SOCKET_ERROR_VALUE) {
-        printf("Errore bind UDP sulla porta %d: %s\n", SERVER_PORT, get_socket_error());
-        return 0;
+    for (int i = 0; i < server->udp_socket_count; i++) {
+        if (bind(server->udp_sockets[i], (struct sockaddr*)&server->server_addr, 
+                 sizeof(server->server_addr)) == SOCKET_ERROR_VALUE) {
+            printf("Errore bind UDP sulla porta %d: %s\n", server_config.port, get_socket_error());
+            return 0;
+        }
     }
-    printf("UDP bind riuscito sulla porta %d\n", SERVER_PORT);
+    printf("UDP bind riuscito sulla porta %d (%d socket)\n", server_config.port, server->udp_socket_count);
     
     // Avvia listening TCP
     if (listen(server->tcp_socket, SOMAXCONN) == SOCKET_ERROR_VALUE) {
@@ -455,29 +761,39 @@ int network_start_listening(ServerNetwork *server) {
         return 0;
     }
     
+    // Il main thread accetta in blocco tutte le connessioni in coda
+    if (network_set_socket_nonblocking(server->tcp_socket) != 0) {
+        printf("Errore impostazione socket TCP non bloccante: %s\n", get_socket_error());
+        return 0;
+    }
+    
     server->is_running = 1;
     
     // Stampa informazioni del server
     print_server_info();
     printf("Server pronto per connessioni TCP e UDP\n");
-    printf("IMPORTANTE: Assicurati che il firewall permetta connessioni sulla porta %d\n\n", SERVER_PORT);
+    printf("IMPORTANTE: Assicurati che il firewall permetta connessioni sulla porta %d\n\n", server_config.port);
     
-    // Crea thread UDP
+    // Crea un thread UDP per socket
+    for (int i = 0; i < server->udp_socket_count; i++) {
+        udp_workers[i].server = server;
+        udp_workers[i].index = i;
 #ifdef _WIN32
-    HANDLE udp_thread = CreateThread(NULL, 0, network_handle_udp_thread, server, 0, NULL);
-    if (udp_thread == NULL) {
-        printf("Errore creazione thread UDP: %lu\n", GetLastError());
-        return 0;
-    }
-    CloseHandle(udp_thread);
+        HANDLE udp_thread = CreateThread(NULL, 0, network_handle_udp_thread, &udp_workers[i], 0, NULL);
+        if (udp_thread == NULL) {
+            printf("Errore creazione thread UDP: %lu\n", GetLastError());
+            return 0;
+        }
+        CloseHandle(udp_thread);
 #else
-    pthread_t udp_thread;
-    if (pthread_create(&udp_thread, NULL, network_handle_udp_thread, server) != 0) {
-        printf("Errore creazione thread UDP: %s\n", strerror(errno));
-        return 0;
-    }
-    pthread_detach(udp_thread);
+        pthread_t udp_thread;
+        if (pthread_create(&udp_thread, NULL, network_handle_udp_thread, &udp_workers[i]) != 0) {
+            printf("Errore creazione thread UDP: %s\n", strerror(errno));
+            return 0;
+        }
+        pthread_detach(udp_thread);
 #endif
+    }
     
     return 1;
 }
@@ -506,15 +822,20 @@ void network_shutdown(ServerNetwork *server) {
         printf("Socket TCP chiuso\n");
     }
 
-    if (server->udp_socket != INVALID_SOCKET_VALUE) {
+    // shutdown() sveglia i thread UDP bloccati in ricezione
+    for (int i = 0; i < server->udp_socket_count; i++) {
+        if (server->udp_sockets[i] == INVALID_SOCKET_VALUE) continue;
 #ifdef _WIN32
-        shutdown(server->udp_socket, SD_BOTH);
+        shutdown(server->udp_sockets[i], SD_BOTH);
 #else
-        shutdown(server->udp_socket, SHUT_RDWR);
+        shutdown(server->udp_sockets[i], SHUT_RDWR);
 #endif
-        closesocket(server->udp_socket);
-        server->udp_socket = INVALID_SOCKET_VALUE;
+        closesocket(server->udp_sockets[i]);
+        server->udp_sockets[i] = INVALID_SOCKET_VALUE;
+    }
+    if (server->udp_socket_count > 0) {
         printf("Socket UDP chiuso\n");
+        server->udp_socket_count = 0;
     }
 
 #ifdef _WIN32
@@ -524,6 +845,77 @@ void network_shutdown(ServerNetwork *server) {
     printf("Server spento completamente\n");
 }
 
+/**
+ * Prende una struttura Client dal pool dei client e la inizializza.
+ * Il pool alloca blocchi di CLIENT_CHUNK_SIZE strutture solo quando le
+ * cache dei thread e la lista globale sono vuote.
+ * 
+ * @param client_fd Socket della connessione del client
+ * @return Client inizializzato con un riferimento (quello della connessione),
+ *         NULL se il server è al completo o manca memoria
+ * 
+ * @note Il riferimento della connessione va lasciato con network_cleanup_client()
+ *       o, se il client non è mai stato pubblicato, con network_release_client()
+ */
+Client* network_alloc_client(socket_t client_fd) {
+    if (__atomic_add_fetch(&connected_clients, 1, __ATOMIC_RELAXED) > server_config.max_clients) {
+        __atomic_sub_fetch(&connected_clients, 1, __ATOMIC_RELAXED);
+        return NULL;
+    }
+    
+    Client *client = (Client*)pool_alloc(&client_pool);
+    if (!client) {
+        __atomic_sub_fetch(&connected_clients, 1, __ATOMIC_RELAXED);
+        return NULL;
+    }
+    
+    memset(client, 0, sizeof(Client));
+    mutex_init(&client->out_mutex);
+    udp_channel_reset(client);
+    client->client_fd = client_fd;
+    client->is_active = 1;
+    client->game_id = -1;
+    client->lobby_slot = -1;
+    client->refcount = 1;
+    client->connect_time = time(NULL);
+    client->last_activity = client->connect_time;
+    strcpy(client->name, "Unknown");
+    return client;
+}
+
+/**
+ * Prende dal pool un client virtuale, senza socket: un giocatore
+ * automatico che occupa un posto in una partita (vedi bot.h).
+ * Non conta nel limite server_config.max_clients e non entra nella lobby;
+ * i messaggi che gli vengono inviati sono scartati senza accodarli.
+ * 
+ * @param name Nome del giocatore (troncato a MAX_NAME_LEN - 1 caratteri)
+ * @return Client registrato con un riferimento (di chi lo crea),
+ *         NULL se manca memoria
+ * 
+ * @note Il riferimento va lasciato con network_release_client(), di
+ *       norma subito dopo averlo assegnato a una partita
+ */
+Client* network_alloc_virtual_client(const char *name) {
+    Client *client = (Client*)pool_alloc(&client_pool);
+    if (!client) return NULL;
+    
+    memset(client, 0, sizeof(Client));
+    mutex_init(&client->out_mutex);
+    udp_channel_reset(client);
+    client->client_fd = INVALID_SOCKET_VALUE;
+    client->is_bot = 1;
+    client->is_active = 1;
+    client->is_registered = 1;
+    client->game_id = -1;
+    client->lobby_slot = -1;
+    client->refcount = 1;
+    client->connect_time = time(NULL);
+    client->last_activity = client->connect_time;
+    snprintf(client->name, sizeof(client->name), "%s", name);
+    return client;
+}
+
 /**
  * Accetta una nuova connessione TCP e crea la struttura Client corrispondente.
  * Configura il socket client per prestazioni ottimali e logga le informazioni di connessione.
@@ -531,8 +923,10 @@ void network_shutdown(ServerNetwork *server) {
  * @param server Struttura server con il socket TCP in ascolto
  * @return Puntatore al nuovo Client creato, NULL in caso di errore
  * 
- * @note Alloca memoria per il Client che dovrà essere liberata dal chiamante
+ * @note Il Client va restituito dal chiamante con network_release_client()
  * @note Configura TCP_NODELAY per ridurre la latenza
+ * @note Su Linux il socket viene reso non bloccante per il reactor epoll
+ * @note Restituisce NULL senza log quando non ci sono connessioni in coda (EAGAIN)
  * @note Include logging dettagliato delle informazioni di connessione
  */
 Client* network_accept_client(ServerNetwork *server) {
@@ -547,7 +941,8 @@ Client* network_accept_client(ServerNetwork *server) {
             printf("Errore accept: %d\n", error);
         }
 #else
-        if (errno != EINTR && errno != ECONNABORTED && server->is_running) {
+        if (errno != EINTR && errno != ECONNABORTED && errno != EAGAIN &&
+            errno != EWOULDBLOCK && server->is_running) {
             printf("Errore accept: %s\n", strerror(errno));
         }
 #endif
@@ -562,19 +957,13 @@ Client* network_accept_client(ServerNetwork *server) {
     printf("========================\n");
     
     // Crea struttura client
-    Client *client = (Client*)malloc(sizeof(Client));
+    Client *client = network_alloc_client(client_fd);
     if (!client) {
-        printf("Errore allocazione memoria per client\n");
+        printf("Server pieno (%d connessioni), rifiuto FD:%d\n", server_config.max_clients, (int)client_fd);
         closesocket(client_fd);
         return NULL;
     }
     
-    memset(client, 0, sizeof(Client));
-    client->client_fd = client_fd;
-    client->is_active = 1;
-    client->game_id = -1;
-    strcpy(client->name, "Unknown");
-    
     // Configura socket client per migliori prestazioni
 #ifdef _WIN32
     BOOL no_delay = TRUE;
@@ -582,78 +971,637 @@ Client* network_accept_client(ServerNetwork *server) {
 #else
     int no_delay = 1;
     setsockopt(client_fd, IPPROTO_TCP, TCP_NODELAY, &no_delay, sizeof(no_delay));
+    
+    // Il reactor epoll edge-triggered richiede socket non bloccanti
+    if (network_set_socket_nonblocking(client_fd) != 0) {
+        printf("Errore impostazione socket non bloccante FD:%d\n", (int)client_fd);
+        closesocket(client_fd);
+        network_release_client(client);
+        return NULL;
+    }
 #endif
     
     return client;
 }
 
 /**
- * Invia un messaggio TCP a un client specifico.
- * Valida i parametri, controlla lo stato del client e gestisce gli errori di invio.
+ * Aggiorna i contatori di backpressure in modo thread-safe.
  * 
- * @param client Client di destinazione del messaggio
- * @param message Messaggio da inviare (deve essere < MAX_MSG_SIZE)
- * @return 1 in caso di successo, 0 in caso di errore
+ * @param dropped Messaggi scartati da aggiungere
+ * @param evicted Client disconnessi da aggiungere
+ * @param lagging Ingressi nello stato di ritardo da aggiungere
+ */
+static void network_stats_add(unsigned long dropped, unsigned long evicted, unsigned long lagging) {
+    mutex_lock(&stats_mutex);
+    net_stats.dropped_messages += dropped;
+    net_stats.evicted_clients += evicted;
+    net_stats.lagging_events += lagging;
+    mutex_unlock(&stats_mutex);
+}
+
+/**
+ * Copia i contatori di backpressure correnti.
  * 
- * @note Marca il client come inattivo se l'invio fallisce
- * @note Include logging di tutti i messaggi inviati
- * @note Valida la lunghezza del messaggio per evitare overflow
+ * @param stats Struttura da riempire
  */
-int network_send_to_client(Client *client, const char *message) {
-    if (!client || !message || strlen(message) == 0 || strlen(message) >= MAX_MSG_SIZE) {
-        LOG_ERROR("network_send_to_client: Parametri invalidi");
-        return 0;
-    }
-    
-    if (!client->is_active) {
-        printf("Tentativo di invio a client inattivo: %s\n", client->name);
-        return 0;
-    }
-    
-    int bytes_sent = send(client->client_fd, message, (int)strlen(message), 0);
-    if (bytes_sent == SOCKET_ERROR_VALUE) {
+void network_get_stats(NetworkStats *stats) {
+    mutex_lock(&stats_mutex);
+    *stats = net_stats;
+    mutex_unlock(&stats_mutex);
+}
+
+/**
+ * Chiude il socket di un client in entrambe le direzioni, senza liberarlo:
+ * il reactor proprietario riceve un evento e chiude la connessione.
+ * NOTA: deve essere chiamata con client->out_mutex acquisito, così il
+ * descrittore non può essere chiuso (e riusato da una nuova connessione)
+ * da network_cleanup_client() nel frattempo.
+ * 
+ * @param client Client da svegliare
+ */
+static void network_wake_client_locked(Client *client) {
+    if (client->client_fd == INVALID_SOCKET_VALUE) return;
 #ifdef _WIN32
-        int error = WSAGetLastError();
-        printf("Errore invio messaggio TCP a %s (FD:%d): %d\n", client->name, (int)client->client_fd, error);
+    shutdown(client->client_fd, SD_BOTH);
 #else
-        printf("Errore invio messaggio TCP a %s (FD:%d): %s\n", client->name, (int)client->client_fd, strerror(errno));
+    shutdown(client->client_fd, SHUT_RDWR);
 #endif
-        client->is_active = 0;
-        return 0;
-    }
-    
-    printf("TCP -> %s: %s\n", client->name, message);
-    return 1;
 }
 
 /**
- * Riceve un messaggio TCP da un client con timeout configurabile.
- * Gestisce timeout lunghi per evitare disconnessioni premature e logga gli errori.
+ * Disconnette forzatamente un client troppo lento.
+ * Il client viene marcato inattivo e il socket chiuso in entrambe le
+ * direzioni, così il reactor proprietario lo rimuove al prossimo evento.
  * 
- * @param client Client da cui ricevere il messaggio
- * @param buffer Buffer dove scrivere il messaggio ricevuto
- * @param buf_size Dimensione del buffer di ricezione
- * @return Numero di byte ricevuti, -1 in caso di errore o disconnessione
- * 
- * @note Imposta timeout di 10 minuti per evitare disconnessioni durante inattività
- * @note Null-termina automaticamente il buffer ricevuto
- * @note Marca il client come inattivo se la ricezione fallisce
+ * @param client Client da disconnettere
+ * @param reason Motivo (per il log)
  */
-int network_receive_from_client(Client *client, char *buffer, size_t buf_size) {
-    if (!client || !client->is_active || !buffer) {
-        return -1;
+void network_evict_client(Client *client, const char *reason) {
+    // Sotto out_mutex: il descrittore non può essere chiuso e riusato nel frattempo
+    mutex_lock(&client->out_mutex);
+    if (!client->is_active || client->client_fd == INVALID_SOCKET_VALUE) {
+        mutex_unlock(&client->out_mutex);
+        return;
     }
+    int fd = (int)client->client_fd;
+    client->is_active = 0;
+    network_wake_client_locked(client);
+    mutex_unlock(&client->out_mutex);
     
-    // Timeout più lungo per evitare disconnessioni premature
-#ifdef _WIN32
-    DWORD timeout_ms = 600000; // 10 minuti
-    setsockopt(client->client_fd, SOL_SOCKET, SO_RCVTIMEO, (char*)&timeout_ms, sizeof(timeout_ms));
+    printf("Disconnessione forzata di %s (FD:%d): %s\n", client->name, fd, reason);
+    network_stats_add(0, 1, 0);
+}
+
+/**
+ * Alloca un messaggio in uscita dal pool adatto alla sua lunghezza.
+ * 
+ * @param len Byte del messaggio (al massimo MAX_MSG_SIZE)
+ * @return Messaggio con un riferimento e dati da riempire, NULL se manca memoria
+ */
+static SharedMsg* network_msg_alloc(size_t len) {
+    ObjectPool *pool = (len <= OUT_MSG_SMALL_SIZE) ? &small_msg_pool : &large_msg_pool;
+    SharedMsg *msg = (SharedMsg*)pool_alloc(pool);
+    if (!msg) {
+        printf("Errore allocazione messaggio in uscita\n");
+        return NULL;
+    }
+    msg->refcount = 1;
+    msg->large = (pool == &large_msg_pool);
+    msg->binary = NULL;
+    msg->len = len;
+    return msg;
+}
+
+/**
+ * Crea un messaggio in uscita condivisibile tra più destinatari.
+ * Il testo viene copiato una sola volta, con MSG_DELIMITER in coda, in un
+ * buffer del pool adatto alla sua lunghezza.
+ * 
+ * @param message Messaggio da inviare (non vuoto, < MAX_MSG_SIZE)
+ * @return Messaggio con un riferimento per il chiamante, NULL se il testo
+ *         non è valido o manca memoria
+ * 
+ * @note Il chiamante accoda il messaggio con network_send_msg() (o
+ *       network_send_lobby_update_msg()) e poi lo rilascia con network_msg_release()
+ */
+SharedMsg* network_msg_create(const char *message) {
+    size_t len = message ? strlen(message) : 0;
+    if (len == 0 || len >= MAX_MSG_SIZE) {
+        LOG_ERROR("network_msg_create: Messaggio non valido");
+        return NULL;
+    }
+    
+    SharedMsg *msg = network_msg_alloc(len + 1);
+    if (!msg) return NULL;
+    memcpy(msg->data, message, len);
+    msg->data[len] = MSG_DELIMITER;
+    return msg;
+}
+
+/**
+ * Restituisce il frame binario equivalente a un messaggio di testo, creandolo
+ * al primo destinatario che usa il protocollo binario. Il frame resta legato
+ * al messaggio: gli altri client binari lo condividono senza ricodificarlo.
+ * 
+ * @param msg Messaggio di testo creato con network_msg_create()
+ * @return Frame binario (riferimento posseduto da msg), NULL in caso di errore
+ */
+static SharedMsg* network_msg_binary(SharedMsg *msg) {
+    SharedMsg *binary = __atomic_load_n(&msg->binary, __ATOMIC_ACQUIRE);
+    if (binary) return binary;
+    
+    unsigned char frame[MAX_MSG_SIZE];
+    size_t len = protocol_encode_binary(msg->data, msg->len - 1, frame, sizeof(frame));
+    if (len == 0) {
+        LOG_ERROR("network_msg_binary: Messaggio non codificabile");
+        return NULL;
+    }
+    binary = network_msg_alloc(len);
+    if (!binary) return NULL;
+    memcpy(binary->data, frame, len);
+    
+    // Due thread possono codificare lo stesso messaggio: vince il primo
+    SharedMsg *expected = NULL;
+    if (!__atomic_compare_exchange_n(&msg->binary, &expected, binary, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        network_msg_release(binary);
+        binary = expected;
+    }
+    return binary;
+}
+
+/**
+ * Prende un riferimento a un messaggio condiviso.
+ * 
+ * @param msg Messaggio da referenziare
+ */
+void network_msg_retain(SharedMsg *msg) {
+    __atomic_add_fetch(&msg->refcount, 1, __ATOMIC_RELAXED);
+}
+
+/**
+ * Lascia un riferimento a un messaggio condiviso; l'ultimo lo restituisce al pool.
+ * 
+ * @param msg Messaggio da rilasciare (NULL ignorato)
+ */
+void network_msg_release(SharedMsg *msg) {
+    if (!msg) return;
+    
+    if (__atomic_sub_fetch(&msg->refcount, 1, __ATOMIC_ACQ_REL) == 0) {
+        network_msg_release(msg->binary);
+        pool_free(msg->large ? &large_msg_pool : &small_msg_pool, msg);
+    }
+}
+
+/**
+ * Restituisce al pool un elemento della coda di invio, lasciando il suo
+ * riferimento al messaggio.
+ * 
+ * @param node Elemento da liberare
+ */
+static void network_free_out_msg(OutMsg *node) {
+    network_msg_release(node->msg);
+    pool_free(&node_pool, node);
+}
+
+/**
+ * Aggiunge un elemento in fondo alla coda di invio di un client.
+ * NOTA: deve essere chiamata con client->out_mutex acquisito.
+ * 
+ * @param client Client proprietario della coda
+ * @param msg Elemento con il messaggio già assegnato
+ */
+static void network_out_append_locked(Client *client, OutMsg *msg) {
+    if (client->out_tail) client->out_tail->next = msg;
+    else client->out_head = msg;
+    client->out_tail = msg;
+    client->out_bytes += msg->msg->len;
+}
+
+/**
+ * Accoda un riferimento a un messaggio nella coda di invio di un client
+ * applicando la politica di backpressure:
+ * - oltre l'high watermark il client è "in ritardo" e gli aggiornamenti
+ *   lobby già in coda (non ancora iniziati) vengono scartati;
+ * - finché è in ritardo i nuovi aggiornamenti lobby vengono scartati;
+ * - i messaggi di partita sono sempre accodati, fino a out_max_bytes,
+ *   oltre il quale il client viene disconnesso.
+ * 
+ * @param client Client di destinazione
+ * @param shared Messaggio da inviare (la coda prende un proprio riferimento)
+ * @param droppable 1 per gli aggiornamenti lobby scartabili, 0 altrimenti
+ * @return 1 se il messaggio è stato accodato (o scartato per politica), 0 in caso di errore
+ * 
+ * @note Ai client che usano il protocollo binario viene accodato il frame
+ *       equivalente (vedi network_msg_binary()); il formato è scelto sotto
+ *       out_mutex, come in network_switch_to_binary()
+ */
+static int network_queue_message(Client *client, SharedMsg *shared, int droppable) {
+    if (!client || !shared) {
+        LOG_ERROR("network_send_to_client: Parametri invalidi");
+        return 0;
+    }
+    
+    // Il bot non ha una connessione: legge lo stato direttamente dalla partita
+    if (client->is_bot) return 1;
+    
+    if (!client->is_active) {
+        printf("Tentativo di invio a client inattivo: %s\n", client->name);
+        return 0;
+    }
+    
+    // Il flag passa solo da 0 a 1: il frame si prepara fuori dal lock quando possibile
+    SharedMsg *frame = NULL;
+    if (__atomic_load_n(&client->binary, __ATOMIC_ACQUIRE)) {
+        frame = network_msg_binary(shared);
+        if (!frame) return 0;
+    }
+    
+    OutMsg *msg = (OutMsg*)pool_alloc(&node_pool);
+    if (!msg) {
+        printf("Errore allocazione messaggio per %s\n", client->name);
+        return 0;
+    }
+    msg->next = NULL;
+    msg->msg = NULL;
+    msg->droppable = droppable;
+    
+    unsigned long dropped = 0;
+    int became_lagging = 0;
+    size_t queued = 0;
+    
+    mutex_lock(&client->out_mutex);
+    if (client->client_fd == INVALID_SOCKET_VALUE) {
+        // Connessione già chiusa: il client è ancora referenziato ma non riceve più
+        mutex_unlock(&client->out_mutex);
+        network_free_out_msg(msg);
+        return 0;
+    }
+    if (client->binary) {
+        // Passato al binario dopo la lettura: la conferma "OK:BIN" è già in coda
+        if (!frame) frame = network_msg_binary(shared);
+        if (!frame) {
+            mutex_unlock(&client->out_mutex);
+            network_free_out_msg(msg);
+            return 0;
+        }
+        shared = frame;
+    }
+    network_msg_retain(shared);
+    msg->msg = shared;
+    if (droppable && client->lagging) {
+        mutex_unlock(&client->out_mutex);
+        network_free_out_msg(msg);
+        network_stats_add(1, 0, 0);
+        return 1;
+    }
+    if (client->out_bytes + shared->len > server_config.out_max_bytes) {
+        mutex_unlock(&client->out_mutex);
+        network_free_out_msg(msg);
+        network_evict_client(client, "coda di invio piena");
+        return 0;
+    }
+    network_out_append_locked(client, msg);
+    
+    if (!client->lagging && client->out_bytes >= server_config.out_high_watermark) {
+        client->lagging = 1;
+        client->lagging_since = time(NULL);
+        became_lagging = 1;
+        
+        // Scarta gli aggiornamenti lobby ancora da iniziare: sono comunque superati
+        OutMsg **link = client->out_offset > 0 ? &client->out_head->next : &client->out_head;
+        OutMsg *last = client->out_offset > 0 ? client->out_head : NULL;
+        while (*link) {
+            OutMsg *cur = *link;
+            if (cur->droppable) {
+                if (cur == msg) msg = NULL;
+                *link = cur->next;
+                client->out_bytes -= cur->msg->len;
+                network_free_out_msg(cur);
+                dropped++;
+            } else {
+                last = cur;
+                link = &cur->next;
+            }
+        }
+        client->out_tail = last;
+    }
+    queued = client->out_bytes;
+    mutex_unlock(&client->out_mutex);
+    
+    if (became_lagging) {
+        printf("Client %s in ritardo: %zu byte in coda, %lu aggiornamenti lobby scartati\n",
+               client->name, queued, dropped);
+        network_stats_add(dropped, 0, 1);
+#ifndef _WIN32
+        reactor_sync_lagging(client);
+#endif
+    }
+    
+    if (!msg) {
+        return 1;  // Scartato insieme agli altri aggiornamenti lobby
+    }
+    
+#ifndef _WIN32
+    if (reactor_request_flush(client)) {
+        return 1;
+    }
+#endif
+    return network_flush_client(client) >= 0;
+}
+
+/**
+ * Invia un messaggio TCP a un client specifico.
+ * Il messaggio viene accodato nella coda di invio del client; la scrittura
+ * sul socket avviene in network_flush_client(), che accorpa in una sola
+ * writev tutti i messaggi accodati dall'ultimo flush.
+ * 
+ * @param client Client di destinazione del messaggio
+ * @param message Messaggio da inviare (deve essere < MAX_MSG_SIZE)
+ * @return 1 in caso di successo, 0 in caso di errore
+ * 
+ * @note Non blocca mai: può essere chiamata con game->mutex o lobby_mutex acquisiti
+ * @note Su Linux il flush è affidato al reactor proprietario della connessione
+ *       (a fine ciclo di eventi); senza reactor attivo viene eseguito subito
+ * @note Il messaggio non viene mai scartato; se la coda supera out_max_bytes
+ *       il client viene disconnesso
+ * @note Aggiunge MSG_DELIMITER in coda: il client estrae i messaggi dal flusso TCP
+ */
+int network_send_to_client(Client *client, const char *message) {
+    SharedMsg *msg = network_msg_create(message);
+    if (!msg) return 0;
+    
+    int result = network_queue_message(client, msg, 0);
+    network_msg_release(msg);
+    return result;
+}
+
+/**
+ * Invia a un client un messaggio senza dati strutturati, scritto con
+ * message_write() a partire dal tipo (vedi common/messages.h).
+ * 
+ * @param client Client di destinazione
+ * @param id Tipo del messaggio
+ * @param text Testo dopo il verbo, NULL per il solo verbo
+ * @return 1 se accodato, 0 in caso di errore
+ */
+int network_send_message(Client *client, ServerMsgId id, const char *text) {
+    char message[MAX_MSG_SIZE];
+    if (!message_write(id, message, sizeof(message), text)) {
+        LOG_ERROR("network_send_message: Messaggio non valido");
+        return 0;
+    }
+    return network_send_to_client(client, message);
+}
+
+/**
+ * Passa un client al protocollo binario. La conferma "OK:BIN" viene accodata
+ * come ultimo messaggio di testo e client->binary impostato nella stessa
+ * sezione critica di out_mutex: ogni messaggio accodato da un altro thread
+ * finisce prima della conferma come riga di testo o dopo come frame.
+ * 
+ * @param client Client che ha chiesto "REGISTER:<nome>:BIN"
+ * @return 1 in caso di successo, 0 in caso di errore
+ */
+static int network_switch_to_binary(Client *client) {
+    char message[MAX_MSG_SIZE];
+    if (!message_write(SMSG_OK, message, sizeof(message), PROTOCOL_BINARY_OPTION)) {
+        LOG_ERROR("network_switch_to_binary: Messaggio non valido");
+        return 0;
+    }
+    SharedMsg *shared = network_msg_create(message);
+    if (!shared) return 0;
+    
+    OutMsg *msg = (OutMsg*)pool_alloc(&node_pool);
+    if (!msg) {
+        printf("Errore allocazione messaggio per %s\n", client->name);
+        network_msg_release(shared);
+        return 0;
+    }
+    msg->next = NULL;
+    msg->msg = shared;  // La coda eredita il riferimento
+    msg->droppable = 0;
+    
+    mutex_lock(&client->out_mutex);
+    if (client->client_fd == INVALID_SOCKET_VALUE) {
+        mutex_unlock(&client->out_mutex);
+        network_free_out_msg(msg);
+        return 0;
+    }
+    network_out_append_locked(client, msg);
+    __atomic_store_n(&client->binary, 1, __ATOMIC_RELEASE);
+    mutex_unlock(&client->out_mutex);
+    
+#ifndef _WIN32
+    if (reactor_request_flush(client)) {
+        return 1;
+    }
+#endif
+    return network_flush_client(client) >= 0;
+}
+
+/**
+ * Invia un aggiornamento della lista partite (GAMES:, LIST_UPDATE:).
+ * A differenza di network_send_to_client() il messaggio viene scartato
+ * se il client è in ritardo: il prossimo aggiornamento lo sostituisce.
+ * 
+ * @param client Client di destinazione
+ * @param message Aggiornamento da inviare
+ * @return 1 se accodato o scartato per politica, 0 in caso di errore
+ */
+int network_send_lobby_update(Client *client, const char *message) {
+    SharedMsg *msg = network_msg_create(message);
+    if (!msg) return 0;
+    
+    int result = network_queue_message(client, msg, 1);
+    network_msg_release(msg);
+    return result;
+}
+
+/**
+ * Invia a un client un messaggio già creato con network_msg_create().
+ * Come network_send_to_client(), ma senza copiare il testo: la coda del
+ * client referenzia lo stesso buffer degli altri destinatari.
+ * 
+ * @param client Client di destinazione
+ * @param msg Messaggio da inviare (il chiamante mantiene il proprio riferimento)
+ * @return 1 in caso di successo, 0 in caso di errore
+ */
+int network_send_msg(Client *client, SharedMsg *msg) {
+    return network_queue_message(client, msg, 0);
+}
+
+/**
+ * Invia a un client un aggiornamento della lista già creato con
+ * network_msg_create(); scartabile come network_send_lobby_update().
+ * 
+ * @param client Client di destinazione
+ * @param msg Aggiornamento da inviare (il chiamante mantiene il proprio riferimento)
+ * @return 1 se accodato o scartato per politica, 0 in caso di errore
+ */
+int network_send_lobby_update_msg(Client *client, SharedMsg *msg) {
+    return network_queue_message(client, msg, 1);
+}
+
+/**
+ * Gestisce la notifica di socket di nuovo scrivibile (EPOLLOUT).
+ * Riprende lo svuotamento della coda; se la coda è già vuota (gli
+ * aggiornamenti lobby sono stati scartati) il client torna in pari.
+ * 
+ * @param client Client il cui socket è di nuovo scrivibile
+ */
+void network_handle_writable(Client *client) {
+    int recovered = 0;
+    
+    mutex_lock(&client->out_mutex);
+    if (!client->out_head && client->lagging) {
+        client->lagging = 0;
+        recovered = 1;
+    }
+    mutex_unlock(&client->out_mutex);
+    
+    if (recovered) {
+        printf("Client %s di nuovo in pari con la coda di invio\n", client->name);
+#ifndef _WIN32
+        reactor_sync_lagging(client);
+#endif
+        return;
+    }
+    
+    network_flush_client(client);
+}
+
+/**
+ * Scrive sul socket i messaggi in attesa nella coda di invio di un client.
+ * Su Linux i messaggi vengono raccolti in un unico vettore e scritti con
+ * writev; le scritture parziali restano in coda fino al prossimo evento
+ * EPOLLOUT del reactor.
+ * 
+ * @param client Client di cui svuotare la coda
+ * @return 1 se la coda è vuota, 0 se restano dati (socket non scrivibile),
+ *         -1 in caso di errore (client marcato inattivo)
+ * 
+ * @note Sicura da chiamare da qualsiasi thread: la coda è protetta da out_mutex
+ */
+int network_flush_client(Client *client) {
+    int result = 1;
+    int recovered = 0;
+    
+    mutex_lock(&client->out_mutex);
+    while (client->out_head) {
+#ifdef _WIN32
+        OutMsg *msg = client->out_head;
+        int bytes_sent = send(client->client_fd, msg->msg->data + client->out_offset,
+                              (int)(msg->msg->len - client->out_offset), 0);
+        if (bytes_sent == SOCKET_ERROR_VALUE) {
+            printf("Errore invio messaggio TCP a %s (FD:%d): %d\n", client->name, (int)client->client_fd, WSAGetLastError());
+            result = -1;
+            break;
+        }
+        size_t written = (size_t)bytes_sent;
 #else
-    struct timeval timeout = { .tv_sec = 600, .tv_usec = 0 }; // 10 minuti
-    setsockopt(client->client_fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        struct iovec iov[OUT_IOV_MAX];
+        int count = 0;
+        size_t offset = client->out_offset;
+        for (OutMsg *msg = client->out_head; msg && count < OUT_IOV_MAX; msg = msg->next) {
+            iov[count].iov_base = msg->msg->data + offset;
+            iov[count].iov_len = msg->msg->len - offset;
+            offset = 0;
+            count++;
+        }
+        
+        ssize_t bytes_sent = writev(client->client_fd, iov, count);
+        if (bytes_sent < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                // Socket pieno: il reactor riprenderà all'evento EPOLLOUT
+                result = 0;
+                break;
+            }
+            printf("Errore invio messaggio TCP a %s (FD:%d): %s\n", client->name, (int)client->client_fd, strerror(errno));
+            result = -1;
+            break;
+        }
+        size_t written = (size_t)bytes_sent;
 #endif
+        
+        // Rimuove dalla coda i messaggi scritti completamente
+        client->out_bytes -= written;
+        while (written > 0) {
+            OutMsg *msg = client->out_head;
+            size_t remaining = msg->msg->len - client->out_offset;
+            if (written < remaining) {
+                client->out_offset += written;
+                break;
+            }
+            written -= remaining;
+            client->out_offset = 0;
+            client->out_head = msg->next;
+            if (!client->out_head) client->out_tail = NULL;
+            network_free_out_msg(msg);
+        }
+        
+        // Il client torna in pari solo dopo una scrittura riuscita: dopo lo
+        // scarto degli aggiornamenti lobby la coda può essere corta anche
+        // con il peer ancora fermo
+        if (client->lagging && client->out_bytes <= server_config.out_low_watermark) {
+            client->lagging = 0;
+            recovered = 1;
+        }
+    }
     
-    int bytes = recv(client->client_fd, buffer, (int)buf_size - 1, 0);
+    if (result < 0) {
+        client->is_active = 0;
+        // Sveglia il reactor proprietario che chiuderà la connessione
+        network_wake_client_locked(client);
+    }
+    
+    mutex_unlock(&client->out_mutex);
+    
+    if (recovered) {
+        printf("Client %s di nuovo in pari con la coda di invio\n", client->name);
+#ifndef _WIN32
+        reactor_sync_lagging(client);
+#endif
+    }
+    return result;
+}
+
+/**
+ * Riceve dati TCP da un client nel suo buffer circolare di ricezione.
+ * I byte vengono letti con una sola readv() direttamente nello spazio libero
+ * del ring (anche se spezzato dal wrap-around); l'estrazione dei messaggi
+ * completi avviene con network_next_message().
+ * 
+ * @param client Client da cui ricevere i dati
+ * @return Numero di byte ricevuti, 0 se non ci sono dati disponibili (EAGAIN),
+ *         -1 in caso di errore o disconnessione
+ * 
+ * @note Su Linux il socket è non bloccante (servito dal reactor epoll); su Windows
+ *       la ricezione è bloccante con il timeout impostato dal thread del client
+ * @note Marca il client come inattivo se la ricezione fallisce
+ */
+int network_receive_from_client(Client *client) {
+    if (!client || !client->is_active) {
+        return -1;
+    }
+    
+    RecvRing *ring = &client->recv_ring;
+    size_t used = ring->tail - ring->head;
+    size_t free_space = RECV_RING_SIZE - used;
+    size_t start = ring->tail & (RECV_RING_SIZE - 1);
+    size_t first = RECV_RING_SIZE - start;
+    if (first > free_space) first = free_space;
+    
+#ifdef _WIN32
+    int bytes = recv(client->client_fd, ring->data + start, (int)first, 0);
+#else
+    struct iovec iov[2];
+    iov[0].iov_base = ring->data + start;
+    iov[0].iov_len = first;
+    iov[1].iov_base = ring->data;
+    iov[1].iov_len = free_space - first;
+    int bytes = (int)readv(client->client_fd, iov, iov[1].iov_len > 0 ? 2 : 1);
+#endif
     if (bytes <= 0) {
         if (bytes == 0) {
             printf("Client %s (FD:%d) si è disconnesso correttamente\n", client->name, (int)client->client_fd);
@@ -666,128 +1614,331 @@ int network_receive_from_client(Client *client, char *buffer, size_t buf_size) {
                 printf("Errore ricezione da %s (FD:%d): %d\n", client->name, (int)client->client_fd, error);
             }
 #else
-            if (errno == EAGAIN || errno == EWOULDBLOCK) {
-                printf("Timeout ricezione da %s (FD:%d) - client inattivo\n", client->name, (int)client->client_fd);
-            } else {
-                printf("Errore ricezione da %s (FD:%d): %s\n", client->name, (int)client->client_fd, strerror(errno));
+            if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+                return 0;  // Nessun dato disponibile: il reactor attende il prossimo evento
             }
+            printf("Errore ricezione da %s (FD:%d): %s\n", client->name, (int)client->client_fd, strerror(errno));
 #endif
         }
         client->is_active = 0;
         return -1;
     }
     
-    buffer[bytes] = '\0';
-    // Rimuoviamo la stampa duplicata - viene già stampata in network_handle_client_thread
+    ring->tail += (size_t)bytes;
     return bytes;
 }
 
 /**
- * Thread principale per la gestione di un singolo client.
- * Gestisce registrazione, autenticazione e tutti i messaggi del client.
- * Include timeout di registrazione e pulizia automatica delle risorse.
+ * Estrae il prossimo messaggio completo (terminato da MSG_DELIMITER) dal
+ * buffer circolare di un client.
  * 
- * @param arg Puntatore al Client da gestire
- * @return Valore di ritorno del thread (0 su Windows, NULL su Unix)
+ * @param client Client da cui estrarre il messaggio
+ * @param buffer Buffer dove copiare il messaggio null-terminato (senza terminatore)
+ * @param buf_size Dimensione del buffer (almeno MAX_MSG_SIZE)
+ * @return 1 se è stato estratto un messaggio, 0 se non ci sono messaggi completi,
+ *         -1 se i dati in attesa superano MAX_MSG_SIZE senza terminatore
  * 
- * @note Richiede registrazione entro 30 secondi dalla connessione
- * @note Gestisce automaticamente l'aggiunta/rimozione dalla lobby
- * @note Libera la memoria del client al termine
- * @note Delega i messaggi di gioco alla lobby dopo la registrazione
+ * @note Rimuove un eventuale '\r' finale (client telnet/Windows) e salta le righe vuote
+ * @note La ricerca del terminatore riprende da dove si era fermata (costo lineare)
  */
-thread_return_t THREAD_CALL network_handle_client_thread(thread_param_t arg) {
-    Client *client = (Client*)arg;
-    char buffer[MAX_MSG_SIZE];
-    int bytes;
-    int client_registered = 0;  // Flag per tracciare se il client è registrato
+int network_next_message(Client *client, char *buffer, size_t buf_size) {
+    RecvRing *ring = &client->recv_ring;
     
-    printf("Thread client avviato per %s (FD: %d)\n", client->name, (int)client->client_fd);
+    for (;;) {
+        if (ring->scan < ring->head) ring->scan = ring->head;
+        
+        while (ring->scan < ring->tail &&
+               ring->data[ring->scan & (RECV_RING_SIZE - 1)] != MSG_DELIMITER) {
+            ring->scan++;
+        }
+        
+        if (ring->scan == ring->tail) {
+            // Nessun messaggio completo: verifica che il frame parziale sia lecito
+            return (ring->tail - ring->head >= MAX_MSG_SIZE) ? -1 : 0;
+        }
+        
+        size_t len = ring->scan - ring->head;
+        if (len >= buf_size || len >= MAX_MSG_SIZE) {
+            return -1;
+        }
+        
+        for (size_t i = 0; i < len; i++) {
+            buffer[i] = ring->data[(ring->head + i) & (RECV_RING_SIZE - 1)];
+        }
+        if (len > 0 && buffer[len - 1] == '\r') len--;
+        buffer[len] = '\0';
+        
+        ring->head = ring->scan + 1;
+        ring->scan = ring->head;
+        
+        if (len > 0) return 1;
+    }
+}
+
+/**
+ * Estrae il prossimo frame binario completo ("<lunghezza varint><opcode><dati>")
+ * dal buffer circolare di un client che usa il protocollo binario.
+ * 
+ * @param client Client da cui estrarre il frame
+ * @param buffer Buffer dove copiare opcode e dati
+ * @param buf_size Dimensione del buffer (almeno MAX_MSG_SIZE)
+ * @param len Lunghezza del frame estratto
+ * @return 1 se è stato estratto un frame, 0 se il frame non è ancora completo,
+ *         -1 se la lunghezza non è valida o supera MAX_MSG_SIZE
+ */
+static int network_next_frame(Client *client, unsigned char *buffer, size_t buf_size, size_t *len) {
+    RecvRing *ring = &client->recv_ring;
+    size_t available = ring->tail - ring->head;
+    size_t header = 0;
+    size_t frame_len = 0;
+    
+    for (;;) {
+        if (header == available) return 0;
+        unsigned char byte = (unsigned char)ring->data[(ring->head + header) & (RECV_RING_SIZE - 1)];
+        frame_len |= (size_t)(byte & 0x7F) << (7 * header);
+        header++;
+        if (!(byte & 0x80)) break;
+        if (header == PROTOCOL_FRAME_HEADER_MAX) return -1;
+    }
+    
+    if (frame_len == 0 || frame_len >= MAX_MSG_SIZE || frame_len > buf_size) return -1;
+    if (available - header < frame_len) return 0;
     
-    // Timeout per la registrazione: il client deve registrarsi entro 30 secondi
-    time_t registration_start = time(NULL);
-    const int REGISTRATION_TIMEOUT = 30;
+    for (size_t i = 0; i < frame_len; i++) {
+        buffer[i] = (unsigned char)ring->data[(ring->head + header + i) & (RECV_RING_SIZE - 1)];
+    }
+    ring->head += header + frame_len;
+    ring->scan = ring->head;
+    *len = frame_len;
+    return 1;
+}
+
+/**
+ * Legge i dati disponibili da un client ed elabora tutti i messaggi completi.
+ * Una singola lettura può contenere più comandi (segmenti TCP accorpati)
+ * oppure solo una parte di un comando, che resta nel ring fino alla lettura
+ * successiva.
+ * 
+ * @param client Client con dati in arrivo
+ * @return Numero di messaggi elaborati (>= 0), -1 se il client va disconnesso
+ * 
+ * @note Sul reactor (socket non bloccante) legge fino a EAGAIN come richiesto
+ *       dalla modalità edge-triggered; su Windows esegue una sola lettura bloccante
+ * @note Il formato (righe di testo o frame binari) viene scelto messaggio per
+ *       messaggio: dopo "REGISTER:<nome>:BIN" i byte successivi sono già frame
+ */
+int network_handle_client_input(Client *client) {
+    char buffer[MAX_MSG_SIZE];
+    int processed = 0;
     
     while (client->is_active) {
-        // Controlla timeout di registrazione
-        if (!client_registered && difftime(time(NULL), registration_start) > REGISTRATION_TIMEOUT) {
-            printf("Timeout registrazione per client FD:%d\n", (int)client->client_fd);
-            network_send_to_client(client, "ERROR:Timeout registrazione");
-            break;
-        }
-        
-        bytes = network_receive_from_client(client, buffer, sizeof(buffer));
+        int bytes = network_receive_from_client(client);
+        if (bytes < 0) return -1;
+        if (bytes == 0) break;
         
-        if (bytes <= 0) {
-            if (bytes == 0) {
-                printf("Client %s si è disconnesso correttamente\n", client->name);
+        int rc = 0;
+        while (client->is_active) {
+            if (client->binary) {
+                size_t len;
+                rc = network_next_frame(client, (unsigned char*)buffer, sizeof(buffer), &len);
+                if (rc <= 0) break;
+                network_process_client_frame(client, (const unsigned char*)buffer, len);
             } else {
-                printf("Client %s disconnesso (errore: %d)\n", client->name, bytes);
+                rc = network_next_message(client, buffer, sizeof(buffer));
+                if (rc <= 0) break;
+                network_process_client_message(client, buffer);
             }
-            break;
+            processed++;
         }
         
-        printf("TCP <- %s: %s\n", client->name, buffer);
+        if (rc < 0) {
+            printf("Messaggio troppo lungo da %s (FD:%d), disconnessione\n", client->name, (int)client->client_fd);
+            network_send_message(client, SMSG_ERROR, "Messaggio troppo lungo");
+            client->is_active = 0;
+            return -1;
+        }
         
-        // Gestisci i messaggi di registrazione
-        if (strncmp(buffer, "REGISTER:", 9) == 0) {
-            char name[MAX_NAME_LEN];
-            if (sscanf(buffer, "REGISTER:%49s", name) == 1) {
-                // Controlla se il nome è già in uso
-                if (lobby_find_client_by_name(name) && strcmp(client->name, name) != 0) {
-                    network_send_to_client(client, "ERROR:Nome già in uso");
-                    continue;
-                }
-                
-                // Se è lo stesso nome, conferma la registrazione
-                if (strcmp(client->name, name) == 0 && client_registered) {
-                    network_send_to_client(client, "OK:Già registrato");
-                    continue;
-                }
-                
-                // Aggiorna il nome del client
-                strncpy(client->name, name, sizeof(client->name) - 1);
-                client->name[sizeof(client->name) - 1] = '\0';
-                
-                // Aggiungi il client alla lobby solo dopo la registrazione successful
-                if (!client_registered) {
-                    if (lobby_add_client_reference(client)) {
-                        client_registered = 1;
-                        printf("Client FD:%d aggiunto alla lobby nello slot\n", (int)client->client_fd);
-                        network_send_to_client(client, "OK:Registrazione completata");
-                        printf("Client registrato con nome: %s\n", client->name);
-                    } else {
-                        network_send_to_client(client, "ERROR:Lobby piena");
-                        client->is_active = 0;
-                        break;
-                    }
-                } else {
-                    network_send_to_client(client, "OK:Registrazione completata");
-                    printf("Client aggiornato con nome: %s\n", client->name);
+#ifdef _WIN32
+        break;
+#endif
+    }
+    
+    return client->is_active ? processed : -1;
+}
+
+/**
+ * Gestisce REGISTER:<nome>: registra il client nella lobby oppure, se è
+ * già registrato, ne cambia il nome.
+ * 
+ * @param client Client che ha inviato il comando
+ * @param args Argomenti del comando: il nome (fino al primo spazio o ':')
+ *             e l'eventuale opzione BIN, che attiva il protocollo binario
+ * 
+ * @note Imposta client->is_active a 0 se il nome non è valido o la lobby è piena
+ * @note Il protocollo binario si sceglie solo alla prima registrazione: la
+ *       conferma "OK:BIN" è l'ultimo messaggio di testo inviato al client e
+ *       precede l'ingresso nella lobby, così nessun broadcast può inserirsi
+ *       prima del cambio di formato; un eventuale errore successivo arriva
+ *       quindi già come frame
+ * @note Alla prima registrazione la conferma è preceduta da
+ *       "UDP_SESSION:<token>", che autorizza UDP_REGISTER (vedi udp_channel.h)
+ */
+static void network_handle_register(Client *client, const char *args) {
+    char name[MAX_NAME_LEN];
+    while (*args == ' ' || *args == '\t') args++;
+    const char *field = args;
+    while (*args && *args != ' ' && *args != ':') args++;
+    size_t len = (size_t)(args - field);
+    int binary = (*args == ':' && strcmp(args + 1, PROTOCOL_BINARY_OPTION) == 0);
+    if (len > 0) {
+        // I nomi troppo lunghi vengono troncati
+        if (len >= sizeof(name)) len = sizeof(name) - 1;
+        memcpy(name, field, len);
+        name[len] = '\0';
+        
+        // Controlla se il nome è già in uso
+        if (lobby_find_client_by_name(name) && strcmp(client->name, name) != 0) {
+            network_send_message(client, SMSG_ERROR, "Nome già in uso");
+            return;
+        }
+        
+        // Se è lo stesso nome, conferma la registrazione
+        if (strcmp(client->name, name) == 0 && client->is_registered) {
+            network_send_message(client, SMSG_OK, "Già registrato");
+            return;
+        }
+        
+        // Aggiungi il client alla lobby solo dopo la registrazione successful
+        if (!client->is_registered) {
+            // Il client non è ancora indicizzato: il nome si può aggiornare direttamente
+            strncpy(client->name, name, sizeof(client->name) - 1);
+            client->name[sizeof(client->name) - 1] = '\0';
+            
+            // Il token precede la conferma e, fuori dalla lobby, nessun broadcast
+            // può inserirsi prima: il client lo legge come primo messaggio
+            char session[64];
+            if (!client->udp_token) client->udp_token = udp_channel_new_token();
+            if (message_encode_udp_session(session, sizeof(session), "%016llx", client->udp_token)) {
+                network_send_to_client(client, session);
+            }
+            
+            // Cambio di formato prima di pubblicare il client nella lobby
+            int switched = 0;
+            if (binary && !client->binary) {
+                if (!network_switch_to_binary(client)) return;
+                switched = 1;
+            }
+            
+            if (lobby_add_client_reference(client)) {
+                client->is_registered = 1;
+                if (!switched) {
+                    // Nuovo tentativo dopo un errore: un client binario riceve la conferma come frame
+                    network_send_message(client, SMSG_OK, client->binary ? PROTOCOL_BINARY_OPTION : "Registrazione completata");
                 }
+                printf("Client registrato con nome: %s%s\n", client->name, binary ? " (protocollo binario)" : "");
+            } else if (lobby_find_client_by_name(name)) {
+                // Nome preso da un altro client nel frattempo
+                network_send_message(client, SMSG_ERROR, "Nome già in uso");
             } else {
-                network_send_to_client(client, "ERROR:Nome non valido");
+                network_send_message(client, SMSG_ERROR, "Lobby piena");
                 client->is_active = 0;
-                break;
             }
+        } else if (client_index_rename(client, name)) {
+            // Il nome compare nella voce della partita nella lista giochi
+            if (client->game_id > 0) {
+                game_list_refresh(client->game_id);
+                lobby_broadcast_game_list();
+            }
+            network_send_message(client, SMSG_OK, "Registrazione completata");
+            printf("Client aggiornato con nome: %s\n", client->name);
+        } else {
+            network_send_message(client, SMSG_ERROR, "Nome già in uso");
         }
-        // Gestisci i ping/keep-alive
-        else if (strcmp(buffer, "PING") == 0) {
-            network_send_to_client(client, "PONG");
-        }
-        // Delega altri messaggi alla lobby se il client è registrato
-        else if (client_registered) {
-            lobby_handle_client_message(client, buffer);
-        }
-        // Se il client non è ancora registrato e non è un comando REGISTER o PING
-        else {
-            network_send_to_client(client, "ERROR:Devi prima registrarti con REGISTER:nome");
-        }
+    } else {
+        network_send_message(client, SMSG_ERROR, "Nome non valido");
+        client->is_active = 0;
+    }
+}
+
+/**
+ * Esegue un comando di un client: registrazione e keep-alive sono gestiti
+ * qui, tutti gli altri comandi vengono smistati da lobby_handle_command()
+ * una volta che il client è registrato.
+ * 
+ * @param client Client che ha inviato il comando
+ * @param cmd Comando analizzato (da testo o da frame binario)
+ */
+static void network_process_command(Client *client, const Command *cmd) {
+    if (cmd->id == CMD_REGISTER) {
+        network_handle_register(client, cmd->args);
+    }
+    // Gestisci i ping/keep-alive
+    else if (cmd->id == CMD_PING) {
+        network_send_message(client, SMSG_PONG, NULL);
+    }
+    // Delega altri messaggi alla lobby se il client è registrato
+    else if (client->is_registered) {
+        lobby_handle_command(client, cmd);
     }
+    // Se il client non è ancora registrato e non è un comando REGISTER o PING
+    else {
+        network_send_message(client, SMSG_ERROR, "Devi prima registrarti con REGISTER:nome");
+    }
+}
+
+/**
+ * Elabora un singolo messaggio di testo ricevuto da un client.
+ * Il messaggio viene analizzato una sola volta (protocol_parse()) e poi
+ * eseguito da network_process_command().
+ * Condivisa dal reactor epoll (Linux) e dal thread per client (Windows).
+ * 
+ * @param client Client che ha inviato il messaggio
+ * @param message Messaggio ricevuto (null-terminato)
+ * 
+ * @note Imposta client->is_active a 0 in caso di errore fatale di registrazione
+ */
+void network_process_client_message(Client *client, const char *message) {
+    if (!client || !message) return;
+    
+    Command cmd;
+    protocol_parse(message, &cmd);
+    network_process_command(client, &cmd);
+}
+
+/**
+ * Elabora un frame ricevuto da un client che usa il protocollo binario.
+ * Il frame viene tradotto nel comando equivalente e segue lo stesso
+ * percorso dei messaggi di testo.
+ * 
+ * @param client Client che ha inviato il frame
+ * @param frame Opcode e dati del frame
+ * @param len Lunghezza del frame
+ */
+void network_process_client_frame(Client *client, const unsigned char *frame, size_t len) {
+    if (!client || !frame) return;
+    
+    Command cmd;
+    char args[MAX_MSG_SIZE];
+    protocol_decode_binary(frame, len, &cmd, args, sizeof(args));
+    network_process_command(client, &cmd);
+}
+
+/**
+ * Rilascia tutte le risorse associate a un client disconnesso.
+ * Rimuove il client dalla lobby e da eventuali partite, chiude il socket,
+ * scarta la coda di invio e lascia il riferimento della connessione.
+ * 
+ * @param client Client da rilasciare (non più utilizzabile dopo la chiamata)
+ * 
+ * @note La struttura torna al pool quando anche gli altri riferimenti
+ *       (broadcast o invii in corso da altri thread) sono stati lasciati
+ */
+void network_cleanup_client(Client *client) {
+    if (!client) return;
     
-    printf("Client %s sta uscendo dal thread\n", client->name);
+    printf("Client %s sta uscendo\n", client->name);
     
-    // Pulizia finale
-    if (client_registered) {
+    if (client->is_registered) {
         // Rimuovi dalla lobby
         lobby_remove_client_reference(client);
         
@@ -797,19 +1948,149 @@ thread_return_t THREAD_CALL network_handle_client_thread(thread_param_t arg) {
         }
     }
     
-    // Chiudi socket e libera memoria
-    closesocket(client->client_fd);
+    // Chiude il socket sotto out_mutex: da qui gli invii vengono rifiutati
+    // e nessun writev può usare un descrittore già riassegnato
+    mutex_lock(&client->out_mutex);
+    if (client->client_fd != INVALID_SOCKET_VALUE) {
+        closesocket(client->client_fd);
+        client->client_fd = INVALID_SOCKET_VALUE;
+    }
     client->is_active = 0;
-    free(client);
+    OutMsg *msg = client->out_head;
+    client->out_head = client->out_tail = NULL;
+    client->out_bytes = 0;
+    client->out_offset = 0;
+    mutex_unlock(&client->out_mutex);
     
-    printf("Thread client terminato\n");
+    while (msg) {
+        OutMsg *next = msg->next;
+        network_free_out_msg(msg);
+        msg = next;
+    }
+    
+    // Gli eventi UDP in attesa non hanno più un destinatario
+    udp_channel_close(client);
     
+#ifndef _WIN32
+    reactor_forget_client(client);
+#endif
+    network_release_client(client);
+}
+
+/**
+ * Prende un riferimento a un client: la struttura resta valida (anche a
+ * connessione chiusa) fino al corrispondente network_release_client().
+ * Va chiamata da chi possiede già un riferimento o sotto il lock della
+ * struttura che ne tiene uno (lobby, partita, indice).
+ * 
+ * @param client Client da referenziare (NULL ignorato)
+ */
+void network_retain_client(Client *client) {
+    if (client) __atomic_add_fetch(&client->refcount, 1, __ATOMIC_RELAXED);
+}
+
+/**
+ * Restituisce la memoria di un client al pool: coda di invio residua e mutex.
+ * Chiamata solo quando non restano riferimenti.
+ * 
+ * @param client Client da liberare
+ */
+static void network_free_client(Client *client) {
+    OutMsg *msg = client->out_head;
+    while (msg) {
+        OutMsg *next = msg->next;
+        network_free_out_msg(msg);
+        msg = next;
+    }
+    client->out_head = client->out_tail = NULL;
+    
+    mutex_destroy(&client->out_mutex);
+    udp_channel_destroy(client);
+    
+    int is_bot = client->is_bot;
+    pool_free(&client_pool, client);
+    if (!is_bot) __atomic_sub_fetch(&connected_clients, 1, __ATOMIC_RELAXED);
+}
+
+/**
+ * Lascia un riferimento a un client; l'ultimo restituisce la struttura al pool.
+ * Non chiude il socket, che resta a carico di chi possiede la connessione.
+ * 
+ * @param client Client da rilasciare (NULL ignorato; non usarlo dopo la chiamata)
+ */
+void network_release_client(Client *client) {
+    if (!client) return;
+    
+    if (__atomic_sub_fetch(&client->refcount, 1, __ATOMIC_ACQ_REL) == 0) {
+        network_free_client(client);
+    }
+}
+
+/**
+ * Libera i pool di client e messaggi. Da chiamare a spegnimento completato,
+ * quando nessun thread può più accedere ai client.
+ */
+void network_clients_cleanup(void) {
+    pool_destroy(&client_pool);
+    pool_destroy(&node_pool);
+    pool_destroy(&small_msg_pool);
+    pool_destroy(&large_msg_pool);
+}
+
+/**
+ * Copia i contatori dei pool di client, di elementi delle code e di buffer dei messaggi.
+ * 
+ * @param clients Contatori del pool dei Client
+ * @param nodes Contatori del pool degli elementi delle code di invio
+ * @param small_msgs Contatori del pool dei messaggi brevi
+ * @param large_msgs Contatori del pool dei messaggi lunghi
+ */
+void network_get_pool_stats(PoolStats *clients, PoolStats *nodes, PoolStats *small_msgs, PoolStats *large_msgs) {
+    pool_get_stats(&client_pool, clients);
+    pool_get_stats(&node_pool, nodes);
+    pool_get_stats(&small_msg_pool, small_msgs);
+    pool_get_stats(&large_msg_pool, large_msgs);
+}
+
 #ifdef _WIN32
+/**
+ * Thread per la gestione di un singolo client (solo Windows).
+ * Su Linux le connessioni sono servite dal reactor epoll (reactor.c).
+ * 
+ * @param arg Puntatore al Client da gestire
+ * @return Valore di ritorno del thread
+ * 
+ * @note Richiede registrazione entro REGISTRATION_TIMEOUT secondi dalla connessione
+ * @note Libera la memoria del client al termine
+ */
+thread_return_t THREAD_CALL network_handle_client_thread(thread_param_t arg) {
+    Client *client = (Client*)arg;
+    printf("Thread client avviato per %s (FD: %d)\n", client->name, (int)client->client_fd);
+    
+    DWORD timeout_ms = CLIENT_IDLE_TIMEOUT * 1000;
+    setsockopt(client->client_fd, SOL_SOCKET, SO_RCVTIMEO, (char*)&timeout_ms, sizeof(timeout_ms));
+    
+    while (client->is_active) {
+        // Controlla timeout di registrazione
+        if (!client->is_registered &&
+            difftime(time(NULL), client->connect_time) > REGISTRATION_TIMEOUT) {
+            printf("Timeout registrazione per client FD:%d\n", (int)client->client_fd);
+            network_send_message(client, SMSG_ERROR, "Timeout registrazione");
+            break;
+        }
+        
+        if (network_handle_client_input(client) < 0) {
+            printf("Client %s disconnesso\n", client->name);
+            break;
+        }
+    }
+    
+    network_cleanup_client(client);
+    pool_thread_flush();    // Le cache del thread tornano ai pool prima che termini
+    printf("Thread client terminato\n");
     return 0;
-#else
-    return NULL;
-#endif
 }
+#endif
 
 /**
  * Funzione di utilità per creare thread cross-platform.
@@ -840,4 +2121,21 @@ int create_thread(thread_t *thread, thread_return_t (THREAD_CALL *start_routine)
 #endif
     printf("Thread %s creato con successo\n", thread_name);
     return 0;
-}
\ No newline at end of file
+}
+
+/**
+ * Imposta un socket in modalità non bloccante.
+ * 
+ * @param sock Socket da configurare
+ * @return 0 in caso di successo, -1 in caso di errore
+ */
+int network_set_socket_nonblocking(socket_t sock) {
+#ifdef _WIN32
+    u_long mode = 1;
+    return ioctlsocket(sock, FIONBIO, &mode) == 0 ? 0 : -1;
+#else
+    int flags = fcntl(sock, F_GETFL, 0);
+    if (flags == -1) return -1;
+    return fcntl(sock, F_SETFL, flags | O_NONBLOCK) == -1 ? -1 : 0;
+#endif
+}
@@ -0,0 +1,212 @@
+#include "headers/pool.h"
+#include "headers/game_manager.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _MSC_VER
+    #define POOL_THREAD_LOCAL __declspec(thread)
+#else
+    #define POOL_THREAD_LOCAL __thread
+#endif
+
+/**
+ * Cache privata di un thread per un pool.
+ */
+typedef struct {
+    void *items[POOL_CACHE_SIZE];   // Oggetti liberi pronti all'uso
+    int count;                      // Oggetti presenti
+} PoolCache;
+
+static POOL_THREAD_LOCAL PoolCache thread_caches[POOL_MAX_POOLS];
+static ObjectPool *registered_pools[POOL_MAX_POOLS];
+
+// Il primo campo di un oggetto libero collega la lista globale
+#define POOL_NEXT(obj) (*(void**)(obj))
+
+/**
+ * Aggiorna il massimo di oggetti in uso contemporaneamente.
+ */
+static void pool_update_high_water(ObjectPool *pool, unsigned long in_use) {
+    unsigned long seen = __atomic_load_n(&pool->stats.high_water, __ATOMIC_RELAXED);
+    while (in_use > seen &&
+           !__atomic_compare_exchange_n(&pool->stats.high_water, &seen, in_use, 1,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+}
+
+/**
+ * Alloca un nuovo blocco di oggetti e li aggiunge alla lista globale.
+ * NOTA: deve essere chiamata con pool->mutex acquisito.
+ *
+ * @return 1 in caso di successo, 0 se manca memoria
+ */
+static int pool_grow(ObjectPool *pool) {
+    unsigned char *chunk = (unsigned char*)malloc(POOL_ALIGN + pool->chunk_objs * pool->obj_size);
+    if (!chunk) {
+        printf("Errore allocazione blocco del pool %s\n", pool->name);
+        return 0;
+    }
+
+    POOL_NEXT(chunk) = pool->chunks;
+    pool->chunks = chunk;
+
+    unsigned char *objs = chunk + POOL_ALIGN;
+    for (size_t i = pool->chunk_objs; i > 0; i--) {
+        void *obj = objs + (i - 1) * pool->obj_size;
+        POOL_NEXT(obj) = pool->free_list;
+        pool->free_list = obj;
+    }
+    __atomic_fetch_add(&pool->stats.capacity, (unsigned long)pool->chunk_objs, __ATOMIC_RELAXED);
+    return 1;
+}
+
+/**
+ * Riempie la cache del thread con un lotto di oggetti della lista globale.
+ */
+static void pool_refill(ObjectPool *pool, PoolCache *cache) {
+    mutex_lock(&pool->mutex);
+    if (!pool->free_list) pool_grow(pool);
+
+    while (pool->free_list && cache->count < POOL_CACHE_BATCH) {
+        void *obj = pool->free_list;
+        pool->free_list = POOL_NEXT(obj);
+        cache->items[cache->count++] = obj;
+    }
+    mutex_unlock(&pool->mutex);
+}
+
+/**
+ * Restituisce alla lista globale gli oggetti della cache oltre keep.
+ */
+static void pool_spill(ObjectPool *pool, PoolCache *cache, int keep) {
+    mutex_lock(&pool->mutex);
+    while (cache->count > keep) {
+        void *obj = cache->items[--cache->count];
+        POOL_NEXT(obj) = pool->free_list;
+        pool->free_list = obj;
+    }
+    mutex_unlock(&pool->mutex);
+}
+
+/**
+ * Inizializza un pool e lo registra per le cache dei thread.
+ * Va chiamata prima che altri thread usino il pool.
+ *
+ * @param pool Pool da inizializzare
+ * @param name Nome del pool (per i log)
+ * @param obj_size Dimensione di un oggetto
+ * @param chunk_objs Oggetti allocati a ogni crescita del pool
+ * @return 1 in caso di successo, 0 se non ci sono più pool registrabili
+ */
+int pool_init(ObjectPool *pool, const char *name, size_t obj_size, size_t chunk_objs) {
+    int id = -1;
+    for (int i = 0; i < POOL_MAX_POOLS; i++) {
+        if (!registered_pools[i]) {
+            id = i;
+            break;
+        }
+    }
+    if (id < 0) return 0;
+
+    memset(pool, 0, sizeof(ObjectPool));
+    pool->name = name;
+    pool->id = id;
+    if (obj_size < sizeof(void*)) obj_size = sizeof(void*);
+    pool->obj_size = (obj_size + POOL_ALIGN - 1) & ~(size_t)(POOL_ALIGN - 1);
+    pool->chunk_objs = chunk_objs > 0 ? chunk_objs : 1;
+    if (mutex_init(&pool->mutex) != 0) return 0;
+
+    thread_caches[id].count = 0;
+    registered_pools[id] = pool;
+    return 1;
+}
+
+/**
+ * Libera tutta la memoria del pool.
+ * Da chiamare allo spegnimento, quando nessun altro thread usa il pool:
+ * gli oggetti nelle cache degli altri thread vengono abbandonati.
+ *
+ * @param pool Pool da distruggere
+ */
+void pool_destroy(ObjectPool *pool) {
+    if (!pool || registered_pools[pool->id] != pool) return;
+
+    thread_caches[pool->id].count = 0;
+    registered_pools[pool->id] = NULL;
+
+    void *chunk = pool->chunks;
+    while (chunk) {
+        void *next = POOL_NEXT(chunk);
+        free(chunk);
+        chunk = next;
+    }
+    pool->chunks = NULL;
+    pool->free_list = NULL;
+    mutex_destroy(&pool->mutex);
+}
+
+/**
+ * Restituisce alle liste globali tutti gli oggetti in cache nel thread
+ * chiamante. Da chiamare prima che un thread termini.
+ */
+void pool_thread_flush(void) {
+    for (int i = 0; i < POOL_MAX_POOLS; i++) {
+        if (registered_pools[i] && thread_caches[i].count > 0) {
+            pool_spill(registered_pools[i], &thread_caches[i], 0);
+        }
+    }
+}
+
+/**
+ * Alloca un oggetto dal pool. Il contenuto non è inizializzato.
+ *
+ * @param pool Pool da cui allocare
+ * @return Oggetto allocato, NULL se manca memoria
+ */
+void* pool_alloc(ObjectPool *pool) {
+    PoolCache *cache = &thread_caches[pool->id];
+
+    if (cache->count > 0) {
+        __atomic_fetch_add(&pool->stats.hits, 1, __ATOMIC_RELAXED);
+    } else {
+        __atomic_fetch_add(&pool->stats.misses, 1, __ATOMIC_RELAXED);
+        pool_refill(pool, cache);
+        if (cache->count == 0) return NULL;
+    }
+
+    void *obj = cache->items[--cache->count];
+    pool_update_high_water(pool, __atomic_add_fetch(&pool->stats.in_use, 1, __ATOMIC_RELAXED));
+    return obj;
+}
+
+/**
+ * Restituisce un oggetto al pool (nella cache del thread chiamante).
+ *
+ * @param pool Pool di provenienza dell'oggetto
+ * @param obj Oggetto da liberare (NULL ignorato)
+ */
+void pool_free(ObjectPool *pool, void *obj) {
+    if (!obj) return;
+
+    PoolCache *cache = &thread_caches[pool->id];
+    if (cache->count == POOL_CACHE_SIZE) {
+        pool_spill(pool, cache, POOL_CACHE_SIZE - POOL_CACHE_BATCH);
+    }
+    cache->items[cache->count++] = obj;
+    __atomic_sub_fetch(&pool->stats.in_use, 1, __ATOMIC_RELAXED);
+}
+
+/**
+ * Copia i contatori del pool.
+ *
+ * @param pool Pool da consultare
+ * @param stats Struttura da riempire
+ */
+void pool_get_stats(ObjectPool *pool, PoolStats *stats) {
+    stats->hits = __atomic_load_n(&pool->stats.hits, __ATOMIC_RELAXED);
+    stats->misses = __atomic_load_n(&pool->stats.misses, __ATOMIC_RELAXED);
+    stats->in_use = __atomic_load_n(&pool->stats.in_use, __ATOMIC_RELAXED);
+    stats->high_water = __atomic_load_n(&pool->stats.high_water, __ATOMIC_RELAXED);
+    stats->capacity = __atomic_load_n(&pool->stats.capacity, __ATOMIC_RELAXED);
+}
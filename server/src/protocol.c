@@ -0,0 +1,391 @@
+#include "headers/protocol.h"
+#include <limits.h>
+#include <string.h>
+
+/**
+ * Traduce un verbo nel suo codice. I confronti sono generati dalla tabella
+ * CLIENT_COMMANDS: le lunghezze dei verbi sono costanti, quindi si confronta
+ * il testo solo dei verbi lunghi quanto quello ricevuto.
+ *
+ * @param verb Inizio del verbo (non null-terminato)
+ * @param len Lunghezza del verbo
+ * @return Codice del comando, CMD_UNKNOWN se il verbo non esiste
+ */
+static CommandId protocol_lookup(const char *verb, size_t len) {
+#define COMMAND_MATCH(name, lower, payload) \
+    if (len == sizeof(#name) - 1 && memcmp(verb, #name, sizeof(#name) - 1) == 0) return CMD_##name;
+    CLIENT_COMMANDS(COMMAND_MATCH)
+#undef COMMAND_MATCH
+    return CMD_UNKNOWN;
+}
+
+/**
+ * Verifica se un carattere è uno spazio o un fine riga residuo.
+ */
+static int protocol_is_space(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+/**
+ * Analizza un messaggio "VERBO[:argomenti]" in una sola passata.
+ * Spazi e fine riga dopo un verbo senza argomenti vengono ignorati.
+ *
+ * @param message Messaggio ricevuto (null-terminato)
+ * @param cmd Comando da riempire; args punta dentro message
+ * @return 1 se il verbo è riconosciuto, 0 altrimenti (cmd->id = CMD_UNKNOWN)
+ */
+int protocol_parse(const char *message, Command *cmd) {
+    const char *p = message;
+    while (*p && *p != ':' && !protocol_is_space(*p)) p++;
+
+    cmd->id = protocol_lookup(message, (size_t)(p - message));
+    cmd->value_count = 0;
+    if (*p == ':') {
+        cmd->args = p + 1;
+    } else {
+        while (protocol_is_space(*p)) p++;
+        if (*p) cmd->id = CMD_UNKNOWN;
+        cmd->args = p;
+    }
+    return cmd->id != CMD_UNKNOWN;
+}
+
+/**
+ * Legge un intero decimale (con segno facoltativo) terminato dal separatore
+ * o dalla fine della stringa, e avanza il cursore oltre il separatore.
+ *
+ * @param cursor Posizione corrente negli argomenti (aggiornata solo in caso di successo)
+ * @param separator Carattere che chiude il campo
+ * @param value Intero letto
+ * @return 1 in caso di successo, 0 se il campo non è un intero valido o esce dal range di int
+ */
+int protocol_next_int(const char **cursor, char separator, int *value) {
+    const char *p = *cursor;
+    int negative = 0;
+    long result = 0;
+
+    if (*p == '-' || *p == '+') negative = *p++ == '-';
+    if (*p < '0' || *p > '9') return 0;
+
+    while (*p >= '0' && *p <= '9') {
+        result = result * 10 + (*p++ - '0');
+        if (result > (long)INT_MAX + 1) return 0;
+    }
+    if (negative) result = -result;
+    if (result > INT_MAX || result < INT_MIN) return 0;
+
+    if (*p == separator) p++;
+    else if (*p != '\0') return 0;
+
+    *value = (int)result;
+    *cursor = p;
+    return 1;
+}
+
+/**
+ * Delimita il campo successivo, terminato dal separatore o dalla fine della
+ * stringa, e avanza il cursore oltre il separatore. Il campo non viene copiato.
+ *
+ * @param cursor Posizione corrente negli argomenti
+ * @param separator Carattere che chiude il campo
+ * @param field Inizio del campo (dentro il messaggio)
+ * @return Lunghezza del campo (0 se vuoto)
+ */
+size_t protocol_next_field(const char **cursor, char separator, const char **field) {
+    const char *p = *cursor;
+    *field = p;
+    while (*p && *p != separator) p++;
+
+    size_t len = (size_t)(p - *field);
+    *cursor = *p ? p + 1 : p;
+    return len;
+}
+
+/**
+ * Legge gli argomenti interi di un comando: quelli già decodificati da un
+ * frame binario, altrimenti quelli testuali separati da separator.
+ *
+ * @param cmd Comando analizzato
+ * @param separator Separatore tra gli interi nella forma testuale
+ * @param values Interi letti
+ * @param count Interi attesi (al più PROTOCOL_MAX_VALUES per i frame binari)
+ * @return 1 se il comando ha esattamente count interi validi, 0 altrimenti
+ */
+int protocol_int_args(const Command *cmd, char separator, int *values, int count) {
+    if (cmd->value_count > 0) {
+        if (cmd->value_count != count) return 0;
+        memcpy(values, cmd->values, (size_t)count * sizeof(int));
+        return 1;
+    }
+
+    const char *cursor = cmd->args;
+    for (int i = 0; i < count; i++) {
+        // L'ultimo intero deve chiudere la stringa
+        if (!protocol_next_int(&cursor, i + 1 < count ? separator : '\0', &values[i])) return 0;
+    }
+    return 1;
+}
+
+// ========== PROTOCOLLO BINARIO ==========
+
+/**
+ * Scrive un intero senza segno in formato varint.
+ *
+ * @param out Destinazione (almeno 10 byte liberi)
+ * @param value Valore da scrivere
+ * @return Byte scritti
+ */
+size_t protocol_put_varint(unsigned char *out, unsigned long value) {
+    size_t n = 0;
+    while (value >= 0x80) {
+        out[n++] = (unsigned char)(value | 0x80);
+        value >>= 7;
+    }
+    out[n++] = (unsigned char)value;
+    return n;
+}
+
+/**
+ * Legge un intero varint e avanza il cursore.
+ *
+ * @param cursor Posizione corrente nei dati
+ * @param end Fine dei dati
+ * @param value Valore letto
+ * @return 1 in caso di successo, 0 se i dati finiscono prima o il valore non sta in 32 bit
+ */
+int protocol_get_varint(const unsigned char **cursor, const unsigned char *end, unsigned long *value) {
+    const unsigned char *p = *cursor;
+    unsigned long result = 0;
+
+    for (int shift = 0; shift < 32; shift += 7) {
+        if (p == end) return 0;
+        unsigned char byte = *p++;
+        result |= (unsigned long)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            if (result > 0xFFFFFFFFUL) return 0;
+            *value = result;
+            *cursor = p;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Traduce un frame binario ricevuto da un client nel comando equivalente.
+ * Gli argomenti numerici vanno direttamente in cmd->values (senza passare
+ * dal testo); solo il nome di REGISTER viene copiato in args.
+ *
+ * @param frame Opcode e dati del frame (senza la lunghezza)
+ * @param len Lunghezza del frame
+ * @param cmd Comando da riempire; args punta al buffer args
+ * @param args Buffer per il nome di REGISTER
+ * @param args_size Dimensione del buffer (almeno MAX_MSG_SIZE per i nomi)
+ * @return 1 se il frame è un comando valido, 0 altrimenti (cmd->id = CMD_UNKNOWN)
+ *
+ * @note Dati: REGISTER <nome>, LIST_GAMES [<filtro> <offset varint> <limite varint>],
+ *       CREATE_GAME [<righe> <colonne> <allineamento>], JOIN <id varint>, MOVE <cella>,
+ *       APPROVE <0|1>, PLAY_BOT [<livello>] (un byte, BotLevel); gli altri comandi
+ *       non hanno dati
+ */
+int protocol_decode_binary(const unsigned char *frame, size_t len, Command *cmd, char *args, size_t args_size) {
+    const unsigned char *p = frame + 1;
+    const unsigned char *end = frame + len;
+    unsigned long offset, limit, value;
+
+    args[0] = '\0';
+    cmd->args = args;
+    cmd->value_count = 0;
+    cmd->id = (len > 0 && frame[0] > CMD_UNKNOWN && frame[0] < CMD_COUNT) ? (CommandId)frame[0] : CMD_UNKNOWN;
+
+    switch (cmd->id) {
+        case CMD_REGISTER:
+            if ((size_t)(end - p) >= args_size || memchr(p, '\0', (size_t)(end - p))) {
+                cmd->id = CMD_UNKNOWN;
+            } else {
+                memcpy(args, p, (size_t)(end - p));
+                args[end - p] = '\0';
+            }
+            break;
+        case CMD_LIST_GAMES:
+            if (p == end) break;
+            if (*p >= PROTOCOL_LIST_FILTERS) {
+                cmd->id = CMD_UNKNOWN;
+                break;
+            }
+            value = *p++;
+            if (!protocol_get_varint(&p, end, &offset) || !protocol_get_varint(&p, end, &limit) ||
+                offset > INT_MAX || limit > INT_MAX) {
+                cmd->id = CMD_UNKNOWN;
+                break;
+            }
+            cmd->values[0] = (int)value;
+            cmd->values[1] = (int)offset;
+            cmd->values[2] = (int)limit;
+            cmd->value_count = 3;
+            break;
+        case CMD_CREATE_GAME:
+            if (p == end) break;
+            if (end - p != 3) {
+                cmd->id = CMD_UNKNOWN;
+                break;
+            }
+            cmd->values[0] = p[0];
+            cmd->values[1] = p[1];
+            cmd->values[2] = p[2];
+            cmd->value_count = 3;
+            break;
+        case CMD_JOIN:
+            if (!protocol_get_varint(&p, end, &value) || value > INT_MAX) {
+                cmd->id = CMD_UNKNOWN;
+                break;
+            }
+            cmd->values[0] = (int)value;
+            cmd->value_count = 1;
+            break;
+        case CMD_MOVE:
+            if (p == end) {
+                cmd->id = CMD_UNKNOWN;
+                break;
+            }
+            cmd->values[0] = PROTOCOL_CELL_ROW(*p);
+            cmd->values[1] = PROTOCOL_CELL_COL(*p);
+            cmd->value_count = 2;
+            break;
+        case CMD_APPROVE:
+            if (p == end) {
+                cmd->id = CMD_UNKNOWN;
+                break;
+            }
+            cmd->values[0] = *p ? 1 : 0;
+            cmd->value_count = 1;
+            break;
+        case CMD_PLAY_BOT:
+            // Il livello è facoltativo; il gestore ne verifica il valore
+            if (p == end) break;
+            if (end - p != 1) {
+                cmd->id = CMD_UNKNOWN;
+                break;
+            }
+            cmd->values[0] = *p;
+            cmd->value_count = 1;
+            break;
+        default:
+            break;
+    }
+
+    return cmd->id != CMD_UNKNOWN;
+}
+
+/**
+ * Scrive i dati binari di un messaggio del server secondo la forma del suo tipo.
+ *
+ * @param msg Messaggio decodificato da message_decode()
+ * @param out Destinazione
+ * @param max Spazio disponibile
+ * @return Byte scritti, -1 se i dati non hanno codifica binaria o non c'è spazio
+ *
+ * @note Dati: TEXT il testo, INT un varint, SYMBOL un byte e la nota, RESULT un byte
+ *       ('D' per il pareggio), MOVE cella e simbolo, REQUEST ID varint e nome, LIST sequenza
+ *       varint e testo, VARIANT righe, colonne e allineamento in un byte ciascuno;
+ *       NOTE e NONE nessun dato
+ */
+static long protocol_encode_payload(const Message *msg, unsigned char *out, size_t max) {
+    size_t len;
+
+    switch (message_payload(msg->type)) {
+        case PAYLOAD_NONE:
+        case PAYLOAD_NOTE:
+            return 0;
+        case PAYLOAD_TEXT:
+            if (msg->text_len > max) return -1;
+            memcpy(out, msg->text, msg->text_len);
+            return (long)msg->text_len;
+        case PAYLOAD_INT:
+            if (max < 10) return -1;
+            return (long)protocol_put_varint(out, (unsigned long)msg->value);
+        case PAYLOAD_SYMBOL:
+            if (msg->text_len + 1 > max) return -1;
+            out[0] = (unsigned char)msg->symbol;
+            memcpy(out + 1, msg->text, msg->text_len);
+            return (long)msg->text_len + 1;
+        case PAYLOAD_RESULT:
+            if (max < 1) return -1;
+            out[0] = (unsigned char)msg->symbol;
+            return 1;
+        case PAYLOAD_MOVE:
+            if (msg->row > 15 || msg->col > 15 || max < 2) return -1;
+            out[0] = PROTOCOL_CELL(msg->row, msg->col);
+            out[1] = (unsigned char)msg->symbol;
+            return 2;
+        case PAYLOAD_REQUEST:
+        case PAYLOAD_LIST:
+            if (max < 10 + msg->text_len) return -1;
+            len = protocol_put_varint(out, msg->type == SMSG_JOIN_REQUEST ? (unsigned long)msg->value : msg->seq);
+            memcpy(out + len, msg->text, msg->text_len);
+            return (long)(len + msg->text_len);
+        case PAYLOAD_VARIANT:
+            if (msg->row > 255 || msg->col > 255 || msg->value > 255 || max < 3) return -1;
+            out[0] = (unsigned char)msg->row;
+            out[1] = (unsigned char)msg->col;
+            out[2] = (unsigned char)msg->value;
+            return 3;
+        case PAYLOAD_CELL:
+            return -1;
+    }
+    return -1;
+}
+
+/**
+ * Codifica un messaggio di testo del server come frame binario completo
+ * (lunghezza, opcode e dati). Un messaggio senza codifica dedicata, o con
+ * argomenti di forma inattesa, viene inviato come SMSG_TEXT con il testo intero.
+ *
+ * @param text Messaggio di testo (senza terminatore, non necessariamente null-terminato)
+ * @param len Lunghezza del messaggio
+ * @param out Destinazione del frame
+ * @param max Dimensione della destinazione
+ * @return Lunghezza del frame, 0 se non entra in max
+ */
+size_t protocol_encode_binary(const char *text, size_t len, unsigned char *out, size_t max) {
+    Message msg;
+
+    // Il frame viene scritto lasciando spazio alla lunghezza massima, poi accostato
+    if (max <= PROTOCOL_FRAME_HEADER_MAX + 1) return 0;
+    unsigned char *body = out + PROTOCOL_FRAME_HEADER_MAX;
+    size_t room = max - PROTOCOL_FRAME_HEADER_MAX - 1;
+
+    message_decode(text, len, &msg);
+    long payload = protocol_encode_payload(&msg, body + 1, room);
+    if (payload < 0 && msg.type != SMSG_TEXT) {
+        msg.type = SMSG_TEXT;
+        msg.text = text;
+        msg.text_len = len;
+        payload = protocol_encode_payload(&msg, body + 1, room);
+    }
+    if (payload < 0) return 0;
+    body[0] = (unsigned char)msg.type;
+
+    size_t body_len = (size_t)payload + 1;
+    unsigned char header[10];
+    size_t header_len = protocol_put_varint(header, body_len);
+    if (header_len > PROTOCOL_FRAME_HEADER_MAX) return 0;
+
+    memmove(out + header_len, body, body_len);
+    memcpy(out, header, header_len);
+    return header_len + body_len;
+}
+
+/**
+ * Chiama il gestore del comando nella tabella del canale.
+ *
+ * @param handlers Gestori indicizzati per CommandId (NULL = comando non ammesso sul canale)
+ * @param ctx Contesto passato al gestore
+ * @param cmd Comando analizzato da protocol_parse()
+ * @return 1 se il comando è stato gestito, 0 se è sconosciuto o non ammesso
+ */
+int protocol_dispatch(const CommandHandler handlers[CMD_COUNT], void *ctx, const Command *cmd) {
+    if (cmd->id <= CMD_UNKNOWN || cmd->id >= CMD_COUNT || !handlers[cmd->id]) return 0;
+    handlers[cmd->id](ctx, cmd);
+    return 1;
+}
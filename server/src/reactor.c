@@ -0,0 +1,557 @@
+#include "headers/reactor.h"
+#include "headers/network.h"
+#include "headers/lobby.h"
+#include "headers/game_manager.h"
+#include "headers/config.h"
+#include "headers/pool.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifndef _WIN32
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <stdint.h>
+
+static Reactor reactors[REACTOR_MAX_THREADS];
+static int reactor_count = 0;
+static volatile int reactor_running = 0;
+static unsigned int next_reactor = 0;
+static __thread Reactor *current_reactor = NULL;    // Reactor eseguito dal thread corrente
+
+// ========== LISTE INTRUSIVE (chiamare con list_mutex acquisito) ==========
+
+static void idle_unlink(Reactor *r, Client *client) {
+    if (client->idle_prev) client->idle_prev->idle_next = client->idle_next;
+    else r->idle_head = client->idle_next;
+    if (client->idle_next) client->idle_next->idle_prev = client->idle_prev;
+    else r->idle_tail = client->idle_prev;
+    client->idle_prev = client->idle_next = NULL;
+}
+
+static void idle_append(Reactor *r, Client *client) {
+    client->idle_prev = r->idle_tail;
+    client->idle_next = NULL;
+    if (r->idle_tail) r->idle_tail->idle_next = client;
+    else r->idle_head = client;
+    r->idle_tail = client;
+}
+
+static int reg_is_linked(Reactor *r, Client *client) {
+    return client->reg_prev != NULL || r->reg_head == client;
+}
+
+static void reg_unlink(Reactor *r, Client *client) {
+    if (!reg_is_linked(r, client)) return;
+    if (client->reg_prev) client->reg_prev->reg_next = client->reg_next;
+    else r->reg_head = client->reg_next;
+    if (client->reg_next) client->reg_next->reg_prev = client->reg_prev;
+    else r->reg_tail = client->reg_prev;
+    client->reg_prev = client->reg_next = NULL;
+}
+
+static void reg_append(Reactor *r, Client *client) {
+    client->reg_prev = r->reg_tail;
+    client->reg_next = NULL;
+    if (r->reg_tail) r->reg_tail->reg_next = client;
+    else r->reg_head = client;
+    r->reg_tail = client;
+}
+
+static int lag_is_linked(Reactor *r, Client *client) {
+    return client->lag_prev != NULL || r->lag_head == client;
+}
+
+static void lag_unlink(Reactor *r, Client *client) {
+    if (!lag_is_linked(r, client)) return;
+    if (client->lag_prev) client->lag_prev->lag_next = client->lag_next;
+    else r->lag_head = client->lag_next;
+    if (client->lag_next) client->lag_next->lag_prev = client->lag_prev;
+    else r->lag_tail = client->lag_prev;
+    client->lag_prev = client->lag_next = NULL;
+}
+
+static void lag_append(Reactor *r, Client *client) {
+    client->lag_prev = r->lag_tail;
+    client->lag_next = NULL;
+    if (r->lag_tail) r->lag_tail->lag_next = client;
+    else r->lag_head = client;
+    r->lag_tail = client;
+}
+
+// ========== GESTIONE CONNESSIONI ==========
+
+/**
+ * Aggiorna il timestamp di attività di un client spostandolo in coda alla
+ * lista di inattività. Se il client si è registrato lo toglie dalla lista
+ * dei client in attesa di registrazione.
+ *
+ * @param r Reactor proprietario della connessione
+ * @param client Client che ha appena inviato dati
+ */
+static void reactor_touch(Reactor *r, Client *client) {
+    mutex_lock(&r->list_mutex);
+    client->last_activity = time(NULL);
+    idle_unlink(r, client);
+    idle_append(r, client);
+    if (client->is_registered) {
+        reg_unlink(r, client);
+    }
+    mutex_unlock(&r->list_mutex);
+}
+
+/**
+ * Chiude una connessione servita dal reactor.
+ * Tenta di inviare i messaggi ancora in coda, rimuove il socket da epoll
+ * e dalle liste, poi delega la pulizia di lobby, partite e memoria a
+ * network_cleanup_client().
+ *
+ * @param r Reactor proprietario della connessione
+ * @param client Client da chiudere
+ *
+ * @note Deve essere chiamata solo dal thread del reactor proprietario
+ */
+static void reactor_close_client(Reactor *r, Client *client) {
+    // Ultimo tentativo di consegnare i messaggi in coda (es. errori finali)
+    network_flush_client(client);
+    epoll_ctl(r->epoll_fd, EPOLL_CTL_DEL, client->client_fd, NULL);
+
+    mutex_lock(&r->list_mutex);
+    idle_unlink(r, client);
+    reg_unlink(r, client);
+    lag_unlink(r, client);
+    client->lag_closed = 1;
+    r->conn_count--;
+    mutex_unlock(&r->list_mutex);
+
+    network_cleanup_client(client);
+}
+
+/**
+ * Legge tutti i dati disponibili su un socket in modalità edge-triggered.
+ * network_handle_client_input() legge finché il kernel non segnala EAGAIN
+ * ed elabora ogni messaggio completo presente nel buffer di ricezione.
+ *
+ * @param r Reactor proprietario della connessione
+ * @param client Client con dati in arrivo
+ */
+static void reactor_handle_readable(Reactor *r, Client *client) {
+    if (network_handle_client_input(client) > 0 && client->is_active) {
+        reactor_touch(r, client);
+    }
+}
+
+/**
+ * Svuota le code di invio dei client segnalati dall'ultimo ciclo di eventi.
+ * I client vengono estratti uno alla volta perché altri thread possono
+ * accodarne di nuovi durante il flush. La lista tiene un riferimento a
+ * ogni client, lasciato dopo il flush: un client chiuso nel frattempo
+ * viene solo rilasciato.
+ *
+ * @param r Reactor da servire
+ */
+static void reactor_flush_pending(Reactor *r) {
+    for (;;) {
+        mutex_lock(&r->flush_mutex);
+        Client *client = r->flush_head;
+        if (client) {
+            r->flush_head = client->flush_next;
+            client->flush_next = NULL;
+            client->flush_scheduled = 0;
+        }
+        mutex_unlock(&r->flush_mutex);
+
+        if (!client) break;
+
+        if (client->client_fd != INVALID_SOCKET_VALUE &&
+            (network_flush_client(client) < 0 || !client->is_active)) {
+            reactor_close_client(r, client);
+        }
+        network_release_client(client);
+    }
+}
+
+/**
+ * Consuma le notifiche accumulate sull'eventfd del reactor.
+ *
+ * @param r Reactor svegliato
+ */
+static void reactor_drain_wakeups(Reactor *r) {
+    uint64_t value;
+    while (read(r->wake_fd, &value, sizeof(value)) > 0) {
+    }
+}
+
+/**
+ * Chiude le connessioni scadute: client non registrati entro
+ * REGISTRATION_TIMEOUT, client inattivi da più di CLIENT_IDLE_TIMEOUT e
+ * client in ritardo sulla coda di invio da più di slow_client_timeout.
+ * Le liste sono ordinate nel tempo, quindi si esaminano solo le teste.
+ *
+ * @param r Reactor da controllare
+ * @param now Timestamp corrente
+ */
+static void reactor_expire_connections(Reactor *r, time_t now) {
+    for (;;) {
+        Client *victim = NULL;
+        int registration_expired = 0;
+        int too_slow = 0;
+
+        mutex_lock(&r->list_mutex);
+        if (r->lag_head && difftime(now, r->lag_head->lagging_since) > server_config.slow_client_timeout) {
+            victim = r->lag_head;
+            too_slow = 1;
+        } else if (r->reg_head && difftime(now, r->reg_head->connect_time) > REGISTRATION_TIMEOUT) {
+            victim = r->reg_head;
+            registration_expired = 1;
+        } else if (r->idle_head && difftime(now, r->idle_head->last_activity) > CLIENT_IDLE_TIMEOUT) {
+            victim = r->idle_head;
+        }
+        mutex_unlock(&r->list_mutex);
+
+        if (!victim) break;
+
+        if (too_slow) {
+            network_evict_client(victim, "in ritardo oltre il limite consentito");
+        } else if (registration_expired) {
+            printf("Timeout registrazione per client FD:%d\n", (int)victim->client_fd);
+            network_send_message(victim, SMSG_ERROR, "Timeout registrazione");
+        } else {
+            printf("Timeout ricezione da %s (FD:%d) - client inattivo\n", victim->name, (int)victim->client_fd);
+        }
+        reactor_close_client(r, victim);
+    }
+}
+
+/**
+ * Loop di eventi di un singolo reactor.
+ * Attende eventi epoll con timeout di REACTOR_TICK_MS per poter controllare
+ * i timeout delle connessioni e la richiesta di spegnimento. Al termine di
+ * ogni ciclo svuota le code di invio dei client segnalati.
+ *
+ * @param arg Puntatore al Reactor da eseguire
+ * @return NULL alla terminazione del thread
+ */
+static thread_return_t THREAD_CALL reactor_thread(thread_param_t arg) {
+    Reactor *r = (Reactor*)arg;
+    struct epoll_event events[REACTOR_MAX_EVENTS];
+    time_t last_sweep = time(NULL);
+
+    current_reactor = r;
+    printf("Thread reactor %d avviato\n", r->index);
+
+    while (reactor_running) {
+        int n = epoll_wait(r->epoll_fd, events, REACTOR_MAX_EVENTS, REACTOR_TICK_MS);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            printf("Errore epoll_wait reactor %d: %s\n", r->index, strerror(errno));
+            break;
+        }
+
+        for (int i = 0; i < n; i++) {
+            Client *client = (Client*)events[i].data.ptr;
+            uint32_t ev = events[i].events;
+
+            if (!client) {
+                // Notifica da un altro thread: ci sono client da svuotare
+                reactor_drain_wakeups(r);
+                continue;
+            }
+
+            if (ev & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) {
+                reactor_handle_readable(r, client);
+            }
+            if ((ev & EPOLLOUT) && client->is_active) {
+                network_handle_writable(client);
+            }
+            if (!client->is_active) {
+                reactor_close_client(r, client);
+            }
+        }
+
+        time_t now = time(NULL);
+        if (now != last_sweep) {
+            reactor_expire_connections(r, now);
+            last_sweep = now;
+        }
+
+        // Tutti i messaggi accodati in questo ciclo partono con una writev per client
+        reactor_flush_pending(r);
+    }
+
+    reactor_flush_pending(r);
+    pool_thread_flush();
+
+    printf("Thread reactor %d terminato\n", r->index);
+    return NULL;
+}
+
+// ========== API PUBBLICA ==========
+
+/**
+ * Inizializza i reactor creando un'istanza epoll per ciascun thread.
+ *
+ * @param num_threads Numero di thread reactor, 0 per usare il numero di CPU
+ * @return 1 in caso di successo, 0 in caso di errore
+ *
+ * @note Il numero di thread viene limitato a REACTOR_MAX_THREADS
+ */
+int reactor_init(int num_threads) {
+    if (num_threads <= 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        num_threads = cpus > 0 ? (int)cpus : 1;
+    }
+    if (num_threads > REACTOR_MAX_THREADS) {
+        num_threads = REACTOR_MAX_THREADS;
+    }
+
+    memset(reactors, 0, sizeof(reactors));
+    for (int i = 0; i < num_threads; i++) {
+        reactors[i].index = i;
+        reactors[i].epoll_fd = epoll_create1(0);
+        reactors[i].wake_fd = eventfd(0, EFD_NONBLOCK);
+
+        struct epoll_event ev;
+        memset(&ev, 0, sizeof(ev));
+        ev.events = EPOLLIN;
+        ev.data.ptr = NULL;  // Distingue l'eventfd dai client
+
+        int fds_ok = reactors[i].epoll_fd >= 0 && reactors[i].wake_fd >= 0 &&
+            epoll_ctl(reactors[i].epoll_fd, EPOLL_CTL_ADD, reactors[i].wake_fd, &ev) == 0;
+        int list_ok = fds_ok && mutex_init(&reactors[i].list_mutex) == 0;
+        int flush_ok = list_ok && mutex_init(&reactors[i].flush_mutex) == 0;
+
+        if (!flush_ok) {
+            printf("Errore creazione reactor %d: %s\n", i, strerror(errno));
+            if (list_ok) mutex_destroy(&reactors[i].list_mutex);
+            for (int j = 0; j <= i; j++) {
+                if (reactors[j].epoll_fd >= 0) close(reactors[j].epoll_fd);
+                if (reactors[j].wake_fd >= 0) close(reactors[j].wake_fd);
+                if (j < i) {
+                    mutex_destroy(&reactors[j].list_mutex);
+                    mutex_destroy(&reactors[j].flush_mutex);
+                }
+            }
+            return 0;
+        }
+    }
+
+    reactor_count = num_threads;
+    printf("Reactor inizializzati: %d thread\n", reactor_count);
+    return 1;
+}
+
+/**
+ * Avvia i thread dei reactor.
+ *
+ * @return 1 in caso di successo, 0 se la creazione di un thread fallisce
+ */
+int reactor_start(void) {
+    reactor_running = 1;
+
+    for (int i = 0; i < reactor_count; i++) {
+        if (pthread_create(&reactors[i].thread, NULL, reactor_thread, &reactors[i]) != 0) {
+            printf("Errore creazione thread reactor %d: %s\n", i, strerror(errno));
+            reactor_running = 0;
+            for (int j = 0; j < i; j++) {
+                pthread_join(reactors[j].thread, NULL);
+            }
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/**
+ * Affida una connessione appena accettata a uno dei reactor (round-robin).
+ * Il client viene inserito nelle liste dei timeout e registrato in epoll
+ * in modalità edge-triggered, anche per la scrivibilità (EPOLLOUT) così
+ * che le code di invio rimaste a metà riprendano appena il peer legge.
+ *
+ * @param client Client appena accettato (socket già non bloccante)
+ * @return 1 in caso di successo, 0 in caso di errore (il chiamante libera il client)
+ */
+int reactor_add_client(Client *client) {
+    if (!client || reactor_count == 0) return 0;
+
+    Reactor *r = &reactors[next_reactor++ % (unsigned int)reactor_count];
+    client->reactor = r;
+    client->connect_time = time(NULL);
+    client->last_activity = client->connect_time;
+
+    mutex_lock(&r->list_mutex);
+    idle_append(r, client);
+    reg_append(r, client);
+    r->conn_count++;
+    mutex_unlock(&r->list_mutex);
+
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+    ev.data.ptr = client;
+
+    if (epoll_ctl(r->epoll_fd, EPOLL_CTL_ADD, client->client_fd, &ev) != 0) {
+        printf("Errore epoll_ctl per FD:%d: %s\n", (int)client->client_fd, strerror(errno));
+        mutex_lock(&r->list_mutex);
+        idle_unlink(r, client);
+        reg_unlink(r, client);
+        r->conn_count--;
+        mutex_unlock(&r->list_mutex);
+        client->reactor = NULL;
+        return 0;
+    }
+
+    return 1;
+}
+
+/**
+ * Ferma tutti i reactor e attende la terminazione dei thread.
+ * Dopo questa chiamata nessun thread legge più dai socket dei client.
+ */
+void reactor_shutdown(void) {
+    if (!reactor_running) return;
+
+    reactor_running = 0;
+    for (int i = 0; i < reactor_count; i++) {
+        pthread_join(reactors[i].thread, NULL);
+    }
+    printf("Reactor fermati\n");
+}
+
+/**
+ * Libera le connessioni rimaste nei reactor e chiude le istanze epoll.
+ * Da chiamare dopo reactor_shutdown(), lobby_cleanup() e game_manager_cleanup():
+ * qui si chiudono solo i socket ancora aperti e si lasciano i riferimenti
+ * delle connessioni e della lista di flush, gli ultimi rimasti.
+ */
+void reactor_cleanup(void) {
+    for (int i = 0; i < reactor_count; i++) {
+        Reactor *r = &reactors[i];
+        Client *client = r->flush_head;
+        while (client) {
+            Client *next = client->flush_next;
+            client->flush_scheduled = 0;
+            network_release_client(client);
+            client = next;
+        }
+        client = r->idle_head;
+        while (client) {
+            Client *next = client->idle_next;
+            if (client->client_fd != INVALID_SOCKET_VALUE) {
+                closesocket(client->client_fd);
+            }
+            network_release_client(client);
+            client = next;
+        }
+        r->idle_head = r->idle_tail = NULL;
+        r->reg_head = r->reg_tail = NULL;
+        r->lag_head = r->lag_tail = NULL;
+        r->flush_head = NULL;
+        r->conn_count = 0;
+
+        close(r->epoll_fd);
+        close(r->wake_fd);
+        mutex_destroy(&r->list_mutex);
+        mutex_destroy(&r->flush_mutex);
+    }
+    reactor_count = 0;
+}
+
+// ========== INVIO ==========
+
+/**
+ * Affida al reactor proprietario lo svuotamento della coda di invio di un
+ * client. Se il chiamante è lo stesso reactor il flush avviene a fine ciclo
+ * di eventi, accorpando tutti i messaggi prodotti; altrimenti il reactor
+ * viene svegliato tramite eventfd.
+ *
+ * @param client Client con messaggi in coda
+ * @return 1 se il flush è stato programmato, 0 se il chiamante deve
+ *         eseguirlo direttamente (nessun reactor attivo per il client)
+ */
+int reactor_request_flush(Client *client) {
+    Reactor *r = client->reactor;
+    if (!r || !reactor_running) return 0;
+
+    int wake = 0;
+    mutex_lock(&r->flush_mutex);
+    if (!client->flush_scheduled) {
+        network_retain_client(client);  // Lasciato da reactor_flush_pending()
+        client->flush_scheduled = 1;
+        client->flush_next = r->flush_head;
+        // Basta una notifica quando la lista passa da vuota a non vuota
+        wake = (r->flush_head == NULL && current_reactor != r);
+        r->flush_head = client;
+    }
+    mutex_unlock(&r->flush_mutex);
+
+    if (wake) {
+        uint64_t one = 1;
+        if (write(r->wake_fd, &one, sizeof(one)) < 0 && errno != EAGAIN) {
+            printf("Errore notifica reactor %d: %s\n", r->index, strerror(errno));
+        }
+    }
+    return 1;
+}
+
+/**
+ * Allinea la lista dei client in ritardo del reactor allo stato del client.
+ * Chiamata dopo ogni cambio di client->lagging; idempotente, quindi l'ordine
+ * delle chiamate da thread diversi non conta.
+ *
+ * @param client Client entrato o uscito dallo stato di ritardo
+ *
+ * @note La lista non tiene riferimenti: un client chiuso o in chiusura
+ *       (reactor_close_client() l'ha già tolto dalla lista) non viene
+ *       riaccodato, altrimenti resterebbe nella lista dopo il ritorno al pool
+ */
+void reactor_sync_lagging(Client *client) {
+    Reactor *r = client->reactor;
+    if (!r || reactor_count == 0) return;
+
+    mutex_lock(&r->list_mutex);
+    mutex_lock(&client->out_mutex);
+    int lagging = client->lagging;
+    int open = client->is_active && client->client_fd != INVALID_SOCKET_VALUE;
+    mutex_unlock(&client->out_mutex);
+
+    if (lagging && open && !client->lag_closed && !lag_is_linked(r, client)) {
+        lag_append(r, client);
+    } else if (!lagging) {
+        lag_unlink(r, client);
+    }
+    mutex_unlock(&r->list_mutex);
+}
+
+/**
+ * Rimuove un client dalla lista di flush del suo reactor alla chiusura
+ * della connessione, lasciando il riferimento tenuto dalla lista.
+ *
+ * @param client Client in chiusura
+ */
+void reactor_forget_client(Client *client) {
+    Reactor *r = client->reactor;
+    if (!r || reactor_count == 0) return;
+
+    int unlinked = 0;
+    mutex_lock(&r->flush_mutex);
+    if (client->flush_scheduled) {
+        Client **link = &r->flush_head;
+        while (*link && *link != client) {
+            link = &(*link)->flush_next;
+        }
+        if (*link) {
+            *link = client->flush_next;
+            unlinked = 1;
+        }
+        client->flush_scheduled = 0;
+        client->flush_next = NULL;
+    }
+    mutex_unlock(&r->flush_mutex);
+
+    if (unlinked) network_release_client(client);
+}
+
+#endif
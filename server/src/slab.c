@@ -0,0 +1,103 @@
+#include "headers/slab.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * Inizializza una tabella a blocchi vuota.
+ *
+ * @param slab Tabella da inizializzare
+ * @param elem_size Dimensione di un elemento in byte
+ * @param chunk_elems Elementi per blocco (arrotondato alla potenza di 2 superiore)
+ * @param max_elems Numero massimo di elementi della tabella
+ * @return 1 in caso di successo, 0 in caso di errore
+ */
+int slab_init(Slab *slab, size_t elem_size, size_t chunk_elems, size_t max_elems) {
+    if (!slab || elem_size == 0 || max_elems == 0) return 0;
+
+    memset(slab, 0, sizeof(Slab));
+    while (((size_t)1 << slab->chunk_shift) < chunk_elems) {
+        slab->chunk_shift++;
+    }
+
+    size_t per_chunk = (size_t)1 << slab->chunk_shift;
+    slab->elem_size = elem_size;
+    slab->max_elems = max_elems;
+    slab->max_chunks = (max_elems + per_chunk - 1) / per_chunk;
+    slab->chunks = (unsigned char**)calloc(slab->max_chunks, sizeof(unsigned char*));
+    return slab->chunks != NULL;
+}
+
+/**
+ * Libera tutti i blocchi e la directory.
+ * Nessun altro thread deve accedere alla tabella.
+ *
+ * @param slab Tabella da distruggere
+ */
+void slab_destroy(Slab *slab) {
+    if (!slab || !slab->chunks) return;
+
+    for (size_t i = 0; i < slab->max_chunks; i++) {
+        free(slab->chunks[i]);
+    }
+    free(slab->chunks);
+    memset(slab, 0, sizeof(Slab));
+}
+
+/**
+ * Aggiunge un blocco di elementi azzerati in coda alla tabella.
+ * Il blocco viene pubblicato prima della nuova capacità, quindi un lettore
+ * che vede la capacità aggiornata vede anche il blocco.
+ *
+ * @param slab Tabella da far crescere
+ * @param first_index Ricevi l'indice del primo nuovo elemento
+ * @param count Ricevi il numero di nuovi elementi
+ * @return 1 in caso di successo, 0 se la tabella è al massimo o manca memoria
+ *
+ * @note Le chiamate concorrenti vanno serializzate dal chiamante
+ */
+int slab_grow(Slab *slab, size_t *first_index, size_t *count) {
+    size_t capacity = slab->capacity;
+    if (capacity >= slab->max_elems) return 0;
+
+    size_t per_chunk = (size_t)1 << slab->chunk_shift;
+    size_t chunk = capacity >> slab->chunk_shift;
+    unsigned char *block = (unsigned char*)calloc(per_chunk, slab->elem_size);
+    if (!block) {
+        printf("Errore allocazione blocco di %zu elementi\n", per_chunk);
+        return 0;
+    }
+
+    size_t added = slab->max_elems - capacity;
+    if (added > per_chunk) added = per_chunk;
+
+    slab->chunks[chunk] = block;
+    __atomic_store_n(&slab->capacity, capacity + added, __ATOMIC_RELEASE);
+
+    *first_index = capacity;
+    *count = added;
+    return 1;
+}
+
+/**
+ * Restituisce il numero di elementi attualmente utilizzabili.
+ *
+ * @param slab Tabella
+ * @return Capacità corrente (cresce nel tempo, non diminuisce)
+ */
+size_t slab_capacity(const Slab *slab) {
+    return __atomic_load_n(&slab->capacity, __ATOMIC_ACQUIRE);
+}
+
+/**
+ * Restituisce l'elemento di indice dato.
+ *
+ * @param slab Tabella
+ * @param index Indice dell'elemento
+ * @return Puntatore all'elemento, NULL se l'indice non è ancora allocato
+ */
+void* slab_at(const Slab *slab, size_t index) {
+    if (index >= slab_capacity(slab)) return NULL;
+    return slab->chunks[index >> slab->chunk_shift] +
+           (index & (((size_t)1 << slab->chunk_shift) - 1)) * slab->elem_size;
+}
@@ -0,0 +1,435 @@
+#define _GNU_SOURCE
+#include "headers/udp_channel.h"
+#include "headers/game_manager.h"
+#include "headers/pool.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static thread_t retransmit_thread;
+static int retransmit_running;                  // 1 mentre il thread di ritrasmissione è attivo (atomico)
+static mutex_t retransmit_mutex;                // Protegge retransmit_list
+static Client *retransmit_list;                 // Client con eventi in attesa di conferma (con un riferimento)
+static unsigned long long token_seed;           // Seme dei token di sessione
+static unsigned long long token_counter;        // Token generati (atomico)
+
+/**
+ * Restituisce il tempo monotono in millisecondi.
+ * Usato anche dalle scadenze delle partite in attesa (game_check_timeouts()).
+ */
+long long udp_channel_now_ms(void) {
+#ifdef _WIN32
+    return (long long)GetTickCount64();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+#endif
+}
+
+/**
+ * Mescola un valore a 64 bit (finalizzatore di splitmix64).
+ */
+static unsigned long long udp_channel_mix(unsigned long long x) {
+    x ^= x >> 30;
+    x *= 0xBF58476D1CE4E5B9ULL;
+    x ^= x >> 27;
+    x *= 0x94D049BB133111EBULL;
+    x ^= x >> 31;
+    return x;
+}
+
+/**
+ * Attende un tick del thread di ritrasmissione (UDP_CHANNEL_TICK_MS).
+ */
+static void udp_channel_tick_sleep(void) {
+#ifdef _WIN32
+    Sleep(UDP_CHANNEL_TICK_MS);
+#else
+    struct timespec ts;
+    ts.tv_sec = UDP_CHANNEL_TICK_MS / 1000;
+    ts.tv_nsec = (long)(UDP_CHANNEL_TICK_MS % 1000) * 1000000L;
+    while (nanosleep(&ts, &ts) == -1 && errno == EINTR) {}
+#endif
+}
+
+/**
+ * Invia (o ritrasmette) un evento al client.
+ * NOTA: deve essere chiamata con il mutex del canale acquisito.
+ *
+ * @param channel Canale del client
+ * @param pending Evento da inviare
+ * @param now Tempo corrente (udp_channel_now_ms())
+ */
+static void udp_channel_transmit(UdpChannel *channel, UdpPending *pending, long long now) {
+    if (sendto(channel->sock, pending->data, (int)pending->len, 0,
+               (struct sockaddr*)&channel->addr, sizeof(channel->addr)) == SOCKET_ERROR_VALUE) {
+        // Trattato come un datagramma perso: ci pensa la ritrasmissione
+        printf("Errore invio evento UDP: %s\n", get_socket_error());
+    }
+    pending->sent_ms = now;
+}
+
+/**
+ * Svuota gli eventi in attesa inviandoli in ordine sulla connessione TCP
+ * e chiude il canale: anche gli eventi successivi passeranno da TCP.
+ * NOTA: deve essere chiamata con il mutex del canale acquisito.
+ *
+ * @param client Client del canale
+ */
+static void udp_channel_fall_back(Client *client) {
+    UdpChannel *channel = &client->udp_channel;
+
+    for (int i = 0; i < channel->count; i++) {
+        UdpPending *pending = &channel->pending[(channel->head + i) % UDP_CHANNEL_WINDOW];
+        network_send_to_client(client, pending->data + pending->text);
+    }
+    channel->head = 0;
+    channel->count = 0;
+    channel->active = 0;
+}
+
+/**
+ * Aggiunge il client alla lista di ritrasmissione, se non vi è già.
+ * NOTA: deve essere chiamata con il mutex del canale acquisito.
+ *
+ * @param client Client con eventi in attesa di conferma
+ */
+static void udp_channel_schedule(Client *client) {
+    UdpChannel *channel = &client->udp_channel;
+    if (channel->scheduled) return;
+
+    channel->scheduled = 1;
+    network_retain_client(client);
+    mutex_lock(&retransmit_mutex);
+    channel->retransmit_next = retransmit_list;
+    retransmit_list = client;
+    mutex_unlock(&retransmit_mutex);
+}
+
+/**
+ * Ritrasmette gli eventi scaduti di un client.
+ *
+ * @param client Client della lista di ritrasmissione
+ * @param now Tempo corrente
+ * @return 1 se restano eventi in attesa (il client resta in lista), 0 altrimenti
+ */
+static int udp_channel_retransmit(Client *client, long long now) {
+    UdpChannel *channel = &client->udp_channel;
+    int keep;
+
+    mutex_lock(&channel->mutex);
+    if (!client->is_active) {
+        // Connessione chiusa: gli eventi non servono più
+        channel->count = 0;
+        channel->active = 0;
+    }
+    for (int i = 0; i < channel->count; i++) {
+        UdpPending *pending = &channel->pending[(channel->head + i) % UDP_CHANNEL_WINDOW];
+        // Attesa raddoppiata a ogni ritrasmissione (backoff esponenziale)
+        if (now - pending->sent_ms < ((long long)UDP_CHANNEL_RTO_MS << pending->retries)) continue;
+        if (pending->retries >= UDP_CHANNEL_MAX_RETRIES) {
+            printf("Client %s non conferma gli eventi UDP, passo a TCP\n", client->name);
+            udp_channel_fall_back(client);
+            break;
+        }
+        pending->retries++;
+        udp_channel_transmit(channel, pending, now);
+    }
+    keep = channel->count > 0;
+    if (!keep) channel->scheduled = 0;
+    mutex_unlock(&channel->mutex);
+    return keep;
+}
+
+/**
+ * Thread di ritrasmissione: a ogni tick ritrasmette gli eventi non
+ * confermati dei client in lista e lascia quelli ormai in pari.
+ *
+ * @param arg Non usato
+ * @return 0 alla terminazione
+ */
+static thread_return_t THREAD_CALL udp_channel_thread(thread_param_t arg) {
+    (void)arg;
+    while (__atomic_load_n(&retransmit_running, __ATOMIC_ACQUIRE)) {
+        udp_channel_tick_sleep();
+
+        mutex_lock(&retransmit_mutex);
+        Client *client = retransmit_list;
+        retransmit_list = NULL;
+        mutex_unlock(&retransmit_mutex);
+
+        long long now = udp_channel_now_ms();
+        while (client) {
+            Client *next = client->udp_channel.retransmit_next;
+            if (udp_channel_retransmit(client, now)) {
+                mutex_lock(&retransmit_mutex);
+                client->udp_channel.retransmit_next = retransmit_list;
+                retransmit_list = client;
+                mutex_unlock(&retransmit_mutex);
+            } else {
+                network_release_client(client);
+            }
+            client = next;
+        }
+    }
+    pool_thread_flush();
+    return 0;
+}
+
+/**
+ * Avvia il thread di ritrasmissione e prepara il seme dei token di sessione.
+ *
+ * @return 1 in caso di successo, 0 in caso di errore
+ */
+int udp_channel_init(void) {
+    if (mutex_init(&retransmit_mutex) != 0) return 0;
+    retransmit_list = NULL;
+
+    token_seed = udp_channel_mix((unsigned long long)time(NULL) ^
+                                 ((unsigned long long)udp_channel_now_ms() << 20) ^
+                                 (unsigned long long)(size_t)&token_seed);
+#ifndef _WIN32
+    token_seed ^= (unsigned long long)getpid() << 40;
+    FILE *urandom = fopen("/dev/urandom", "rb");
+    if (urandom) {
+        unsigned long long random_seed;
+        if (fread(&random_seed, sizeof(random_seed), 1, urandom) == 1) token_seed ^= random_seed;
+        fclose(urandom);
+    }
+#endif
+
+    __atomic_store_n(&retransmit_running, 1, __ATOMIC_RELEASE);
+    if (create_thread(&retransmit_thread, udp_channel_thread, NULL, "ritrasmissione UDP") != 0) {
+        __atomic_store_n(&retransmit_running, 0, __ATOMIC_RELEASE);
+        mutex_destroy(&retransmit_mutex);
+        return 0;
+    }
+    return 1;
+}
+
+/**
+ * Ferma il thread di ritrasmissione e lascia i client ancora in lista.
+ * Da qui in poi udp_channel_send() rifiuta gli eventi, che passano da TCP.
+ *
+ * @note Va chiamata dopo reactor_shutdown() e prima di lobby_cleanup()
+ */
+void udp_channel_shutdown(void) {
+    if (!__atomic_exchange_n(&retransmit_running, 0, __ATOMIC_ACQ_REL)) return;
+#ifdef _WIN32
+    WaitForSingleObject(retransmit_thread, INFINITE);
+    CloseHandle(retransmit_thread);
+#else
+    pthread_join(retransmit_thread, NULL);
+#endif
+
+    mutex_lock(&retransmit_mutex);
+    Client *client = retransmit_list;
+    retransmit_list = NULL;
+    mutex_unlock(&retransmit_mutex);
+
+    while (client) {
+        Client *next = client->udp_channel.retransmit_next;
+        mutex_lock(&client->udp_channel.mutex);
+        client->udp_channel.count = 0;
+        client->udp_channel.scheduled = 0;
+        mutex_unlock(&client->udp_channel.mutex);
+        network_release_client(client);
+        client = next;
+    }
+}
+
+/**
+ * Genera un token di sessione UDP opaco e non nullo.
+ *
+ * @return Nuovo token
+ *
+ * @note I token non si ripetono: il contatore avanza di un passo dispari e
+ *       il finalizzatore di splitmix64 è una biiezione, quindi l'indice dei
+ *       token non può incontrare duplicati
+ */
+unsigned long long udp_channel_new_token(void) {
+    unsigned long long token;
+    do {
+        unsigned long long n = __atomic_add_fetch(&token_counter, 1, __ATOMIC_RELAXED);
+        token = udp_channel_mix(token_seed + n * 0x9E3779B97F4A7C15ULL);
+    } while (token == 0);
+    return token;
+}
+
+/**
+ * Prepara il canale di un client appena allocato (chiuso, senza eventi).
+ *
+ * @param client Client appena allocato (struttura azzerata)
+ */
+void udp_channel_reset(Client *client) {
+    memset(&client->udp_channel, 0, sizeof(UdpChannel));
+    client->udp_channel.sock = INVALID_SOCKET_VALUE;
+    mutex_init(&client->udp_channel.mutex);
+}
+
+/**
+ * Libera le risorse del canale quando la struttura del client torna al pool.
+ *
+ * @param client Client senza più riferimenti
+ */
+void udp_channel_destroy(Client *client) {
+    mutex_destroy(&client->udp_channel.mutex);
+}
+
+/**
+ * Apre (o riapre) il canale verso l'indirizzo UDP del client.
+ * Eventuali eventi di una sessione precedente ancora in attesa vengono
+ * consegnati su TCP. Le sequenze non ripartono da zero: entrambe le
+ * direzioni proseguono dalla più alta già usata, così un ACK o un comando
+ * ritardatario della sessione precedente non può confermare o ripetere
+ * un evento della nuova.
+ *
+ * @param client Client che ha completato UDP_REGISTER
+ * @param sock Socket UDP da cui inviare gli eventi
+ * @param addr Indirizzo UDP del client
+ * @return Sequenza di partenza, da comunicare con UDP_REGISTERED:<base>
+ */
+unsigned long udp_channel_open(Client *client, socket_t sock, const struct sockaddr_in *addr) {
+    UdpChannel *channel = &client->udp_channel;
+    unsigned long base;
+
+    mutex_lock(&channel->mutex);
+    if (channel->count > 0) udp_channel_fall_back(client);
+    base = channel->send_seq > channel->recv_seq ? channel->send_seq : channel->recv_seq;
+    channel->sock = sock;
+    channel->addr = *addr;
+    channel->send_seq = base;
+    channel->recv_seq = base;
+    channel->active = 1;
+    mutex_unlock(&channel->mutex);
+    return base;
+}
+
+/**
+ * Aggiorna l'indirizzo del canale quando un datagramma con il token del
+ * client arriva da un indirizzo diverso (rebinding NAT, cambio di rete).
+ * Sequenze ed eventi in attesa restano validi: le ritrasmissioni
+ * successive partono verso il nuovo indirizzo.
+ *
+ * @param client Client identificato dal token del datagramma
+ * @param sock Socket UDP che ha ricevuto il datagramma
+ * @param addr Indirizzo sorgente del datagramma
+ * @return 1 se l'indirizzo è cambiato, 0 altrimenti
+ */
+int udp_channel_rebind(Client *client, socket_t sock, const struct sockaddr_in *addr) {
+    UdpChannel *channel = &client->udp_channel;
+    int changed = 0;
+
+    mutex_lock(&channel->mutex);
+    if (channel->sock != INVALID_SOCKET_VALUE &&
+        (channel->addr.sin_addr.s_addr != addr->sin_addr.s_addr ||
+         channel->addr.sin_port != addr->sin_port)) {
+        channel->sock = sock;
+        channel->addr = *addr;
+        changed = 1;
+    }
+    mutex_unlock(&channel->mutex);
+    return changed;
+}
+
+/**
+ * Chiude il canale: gli eventi in attesa e i successivi passano da TCP.
+ *
+ * @param client Client del canale
+ */
+void udp_channel_close(Client *client) {
+    UdpChannel *channel = &client->udp_channel;
+
+    mutex_lock(&channel->mutex);
+    udp_channel_fall_back(client);
+    mutex_unlock(&channel->mutex);
+}
+
+/**
+ * Invia un evento di partita sul canale UDP del client.
+ * Non blocca: può essere chiamata con game->mutex acquisito.
+ *
+ * @param client Client di destinazione
+ * @param message Messaggio da incapsulare in "SEQ:<n>:<messaggio>"
+ * @return 1 se l'evento è partito su UDP, 0 se va inviato su TCP
+ *         (canale chiuso, finestra piena, messaggio troppo lungo o
+ *         ritrasmissione non attiva)
+ *
+ * @note Con la finestra piena il canale degrada a TCP prima di restituire 0,
+ *       così l'evento segue su TCP quelli ancora in attesa
+ */
+int udp_channel_send(Client *client, const char *message) {
+    UdpChannel *channel = &client->udp_channel;
+    int sent = 0;
+
+    if (!__atomic_load_n(&retransmit_running, __ATOMIC_ACQUIRE)) return 0;
+
+    mutex_lock(&channel->mutex);
+    if (channel->active && channel->count == UDP_CHANNEL_WINDOW) {
+        printf("Finestra UDP di %s piena, passo a TCP\n", client->name);
+        udp_channel_fall_back(client);
+    } else if (channel->active) {
+        UdpPending *pending = &channel->pending[(channel->head + channel->count) % UDP_CHANNEL_WINDOW];
+        int len = message_encode_seq(pending->data, sizeof(pending->data), channel->send_seq + 1, "%s", message);
+        if (len > 0) {
+            pending->seq = ++channel->send_seq;
+            pending->len = (size_t)len;
+            pending->text = (size_t)len - strlen(message);
+            pending->retries = 0;
+            channel->count++;
+            udp_channel_transmit(channel, pending, udp_channel_now_ms());
+            udp_channel_schedule(client);
+            sent = 1;
+        }
+    }
+    mutex_unlock(&channel->mutex);
+    return sent;
+}
+
+/**
+ * Registra una conferma cumulativa: gli eventi fino a seq sono arrivati.
+ *
+ * @param client Client che ha inviato "ACK:<seq>"
+ * @param seq Ultima sequenza ricevuta in ordine dal client
+ */
+void udp_channel_ack(Client *client, unsigned long seq) {
+    UdpChannel *channel = &client->udp_channel;
+
+    mutex_lock(&channel->mutex);
+    while (channel->count > 0 && channel->pending[channel->head].seq <= seq) {
+        channel->head = (channel->head + 1) % UDP_CHANNEL_WINDOW;
+        channel->count--;
+    }
+    mutex_unlock(&channel->mutex);
+}
+
+/**
+ * Verifica la sequenza di un comando ricevuto dal client sul canale.
+ *
+ * @param client Client mittente
+ * @param seq Sequenza del comando
+ * @param ack Ultima sequenza eseguita, da confermare con "ACK:<ack>"
+ * @return 1 se il comando è più recente dell'ultimo eseguito e va eseguito,
+ *         0 se è un duplicato o un ritardatario
+ *
+ * @note Il client attende la conferma di ogni comando prima del successivo,
+ *       quindi un salto di sequenza indica solo un comando abbandonato
+ *       (ripiegato su TCP) e non va atteso
+ * @note Vale anche con il canale degradato a TCP: i comandi del client
+ *       continuano ad arrivare su UDP finché non ripete UDP_REGISTER
+ */
+int udp_channel_accept(Client *client, unsigned long seq, unsigned long *ack) {
+    UdpChannel *channel = &client->udp_channel;
+    int fresh = 0;
+
+    mutex_lock(&channel->mutex);
+    if (seq > channel->recv_seq) {
+        channel->recv_seq = seq;
+        fresh = 1;
+    }
+    *ack = channel->recv_seq;
+    mutex_unlock(&channel->mutex);
+    return fresh;
+}